@@ -54,9 +54,10 @@
 /* USER CODE BEGIN 0 */
   extern void configureTimerForRunTimeStats(void);
   extern unsigned long getRunTimeCounterValue(void);
+  extern void fpu_monitor_task_switched_out(unsigned long task_number, const uint32_t *top_of_stack);
 /* USER CODE END 0 */
 #endif
-#define configENABLE_FPU                         0
+#define configENABLE_FPU                         1
 #define configENABLE_MPU                         0
 
 #define configUSE_PREEMPTION                     1
@@ -68,7 +69,7 @@
 #define configTICK_RATE_HZ                       ((TickType_t)1000)
 #define configMAX_PRIORITIES                     ( 7 )
 #define configMINIMAL_STACK_SIZE                 ((uint16_t)128)
-#define configTOTAL_HEAP_SIZE                    ((size_t)15360)
+#define configTOTAL_HEAP_SIZE                    ((size_t)32768)
 #define configMAX_TASK_NAME_LEN                  ( 16 )
 #define configGENERATE_RUN_TIME_STATS            1
 #define configUSE_TRACE_FACILITY                 1
@@ -105,6 +106,7 @@ to exclude the API function. */
 #define INCLUDE_vTaskDelayUntil              1
 #define INCLUDE_vTaskDelay                   1
 #define INCLUDE_xTaskGetSchedulerState       1
+#define INCLUDE_uxTaskGetStackHighWaterMark  1
 
 /* Cortex-M specific definitions. */
 #ifdef __NVIC_PRIO_BITS
@@ -155,6 +157,12 @@ standard names. */
 
 /* USER CODE BEGIN Defines */
 /* Section where parameter definitions can be added (for instance, to override default ones in FreeRTOS.h) */
+/* Needed by ulTaskGetIdleRunTimeCounter(), used for the CPU load */
+#define INCLUDE_xTaskGetIdleTaskHandle           1
+
+/* Per-task FPU usage, see fpu_monitor.h. PendSV has already saved the
+   outgoing context, including EXC_RETURN, below pxTopOfStack. */
+#define traceTASK_SWITCHED_OUT() fpu_monitor_task_switched_out(pxCurrentTCB->uxTCBNumber, (const uint32_t *)pxCurrentTCB->pxTopOfStack)
 /* USER CODE END Defines */
 
 #endif /* FREERTOS_CONFIG_H */
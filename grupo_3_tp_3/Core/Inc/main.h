@@ -53,6 +53,9 @@ extern "C" {
 void Error_Handler(void);
 
 /* USER CODE BEGIN EFP */
+/* Not called from main(): initialised in the background, see boot.h */
+void MX_ETH_Init(void);
+void MX_USB_OTG_FS_PCD_Init(void);
 
 /* USER CODE END EFP */
 
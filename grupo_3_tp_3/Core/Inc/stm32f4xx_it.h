@@ -52,9 +52,20 @@ void MemManage_Handler(void);
 void BusFault_Handler(void);
 void UsageFault_Handler(void);
 void DebugMon_Handler(void);
-void TIM1_UP_TIM10_IRQHandler(void);
-void TIM2_IRQHandler(void);
 /* USER CODE BEGIN EFP */
+void TIM1_UP_TIM10_IRQHandler(void);
+void TIM5_IRQHandler(void);
+void TIM7_IRQHandler(void);
+void DMA1_Stream1_IRQHandler(void);
+void USART3_IRQHandler(void);
+void DMA2_Stream1_IRQHandler(void);
+void DMA2_Stream0_IRQHandler(void);
+void DMA2_Stream4_IRQHandler(void);
+void ETH_IRQHandler(void);
+void DMA2_Stream2_IRQHandler(void);
+void DMA1_Stream0_IRQHandler(void);
+void DMA1_Stream2_IRQHandler(void);
+void DMA1_Stream6_IRQHandler(void);
 
 /* USER CODE END EFP */
 
@@ -30,6 +30,8 @@
 
 /* Application includes. */
 #include "app.h"
+#include "monoclock.h"
+#include "boot.h"
 
 /* USER CODE END Includes */
 
@@ -56,25 +58,21 @@ ETH_DMADescTypeDef  DMATxDscrTab[ETH_TX_DESC_CNT]; /* Ethernet Tx DMA Descriptor
 
 ETH_HandleTypeDef heth;
 
-TIM_HandleTypeDef htim2;
-
 UART_HandleTypeDef huart3;
 
 PCD_HandleTypeDef hpcd_USB_OTG_FS;
 
 osThreadId defaultTaskHandle;
 /* USER CODE BEGIN PV */
-volatile unsigned long ulHighFrequencyTimerTicks;
 
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
 void SystemClock_Config(void);
 static void MX_GPIO_Init(void);
-static void MX_ETH_Init(void);
+void MX_ETH_Init(void);
 static void MX_USART3_UART_Init(void);
-static void MX_USB_OTG_FS_PCD_Init(void);
-static void MX_TIM2_Init(void);
+void MX_USB_OTG_FS_PCD_Init(void);
 void StartDefaultTask(void const * argument);
 
 /* USER CODE BEGIN PFP */
@@ -94,7 +92,9 @@ extern void initialise_monitor_handles(void);
 int main(void)
 {
   /* USER CODE BEGIN 1 */
+	boot_mark(BOOT_PHASE_START);
 	initialise_monitor_handles();
+	boot_mark(BOOT_PHASE_MONITOR);
 
   /* USER CODE END 1 */
 
@@ -104,6 +104,7 @@ int main(void)
   HAL_Init();
 
   /* USER CODE BEGIN Init */
+	boot_mark(BOOT_PHASE_HAL);
 
   /* USER CODE END Init */
 
@@ -111,21 +112,21 @@ int main(void)
   SystemClock_Config();
 
   /* USER CODE BEGIN SysInit */
+	boot_mark(BOOT_PHASE_CLOCK);
 
   /* USER CODE END SysInit */
 
   /* Initialize all configured peripherals */
   MX_GPIO_Init();
-  MX_ETH_Init();
   MX_USART3_UART_Init();
-  MX_USB_OTG_FS_PCD_Init();
-  MX_TIM2_Init();
   /* USER CODE BEGIN 2 */
-  /* Start timer */
-	HAL_TIM_Base_Start_IT(&htim2);
-	
+	boot_mark(BOOT_PHASE_PERIPHERALS);
+
+    /* ETH and USB OTG are initialised after the scheduler starts, see boot.h */
+
     /* add application, ... */
 	app_init();
+	boot_mark(BOOT_PHASE_APP);
 
   /* USER CODE END 2 */
 
@@ -223,7 +224,7 @@ void SystemClock_Config(void)
   * @param None
   * @retval None
   */
-static void MX_ETH_Init(void)
+void MX_ETH_Init(void)
 {
 
   /* USER CODE BEGIN ETH_Init 0 */
@@ -267,51 +268,6 @@ static void MX_ETH_Init(void)
 
 }
 
-/**
-  * @brief TIM2 Initialization Function
-  * @param None
-  * @retval None
-  */
-static void MX_TIM2_Init(void)
-{
-
-  /* USER CODE BEGIN TIM2_Init 0 */
-
-  /* USER CODE END TIM2_Init 0 */
-
-  TIM_ClockConfigTypeDef sClockSourceConfig = {0};
-  TIM_MasterConfigTypeDef sMasterConfig = {0};
-
-  /* USER CODE BEGIN TIM2_Init 1 */
-
-  /* USER CODE END TIM2_Init 1 */
-  htim2.Instance = TIM2;
-  htim2.Init.Prescaler = 2-1;
-  htim2.Init.CounterMode = TIM_COUNTERMODE_UP;
-  htim2.Init.Period = 84000-1;
-  htim2.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
-  htim2.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
-  if (HAL_TIM_Base_Init(&htim2) != HAL_OK)
-  {
-    Error_Handler();
-  }
-  sClockSourceConfig.ClockSource = TIM_CLOCKSOURCE_INTERNAL;
-  if (HAL_TIM_ConfigClockSource(&htim2, &sClockSourceConfig) != HAL_OK)
-  {
-    Error_Handler();
-  }
-  sMasterConfig.MasterOutputTrigger = TIM_TRGO_RESET;
-  sMasterConfig.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
-  if (HAL_TIMEx_MasterConfigSynchronization(&htim2, &sMasterConfig) != HAL_OK)
-  {
-    Error_Handler();
-  }
-  /* USER CODE BEGIN TIM2_Init 2 */
-
-  /* USER CODE END TIM2_Init 2 */
-
-}
-
 /**
   * @brief USART3 Initialization Function
   * @param None
@@ -350,7 +306,7 @@ static void MX_USART3_UART_Init(void)
   * @param None
   * @retval None
   */
-static void MX_USB_OTG_FS_PCD_Init(void)
+void MX_USB_OTG_FS_PCD_Init(void)
 {
 
   /* USER CODE BEGIN USB_OTG_FS_Init 0 */
@@ -437,14 +393,15 @@ static void MX_GPIO_Init(void)
 
 /* USER CODE BEGIN 4 */
 /* Functions needed when configGENERATE_RUN_TIME_STATS is on */
+/* Run time stats share the monoclock timebase (1 us resolution), which is
+   already running when the scheduler starts. */
 void configureTimerForRunTimeStats(void)
 {
-    ulHighFrequencyTimerTicks = 0;
 }
 
 unsigned long getRunTimeCounterValue(void)
 {
-	return ulHighFrequencyTimerTicks;
+	return now_us32();
 }
 
 /* Hook Functions */
@@ -526,10 +483,6 @@ void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
     HAL_IncTick();
   }
   /* USER CODE BEGIN Callback 1 */
-	if (htim->Instance == TIM2)
-	{
-		ulHighFrequencyTimerTicks++;
-	}
 
   /* USER CODE END Callback 1 */
 }
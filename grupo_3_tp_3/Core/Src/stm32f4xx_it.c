@@ -22,6 +22,16 @@
 #include "stm32f4xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "monoclock.h"
+#include "hrtimer.h"
+#include "uart_rx.h"
+#include "crc.h"
+#include "dmacopy.h"
+#include "eth_frame.h"
+#include "led_wave.h"
+#include "led_pwm.h"
+#include "fastio.h"
+#include "cyclic.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -55,9 +65,6 @@
 /* USER CODE END 0 */
 
 /* External variables --------------------------------------------------------*/
-extern TIM_HandleTypeDef htim2;
-extern TIM_HandleTypeDef htim1;
-
 /* USER CODE BEGIN EV */
 
 /* USER CODE END EV */
@@ -160,34 +167,114 @@ void DebugMon_Handler(void)
 /* please refer to the startup file (startup_stm32f4xx.s).                    */
 /******************************************************************************/
 
+/* USER CODE BEGIN 1 */
 /**
   * @brief This function handles TIM1 update interrupt and TIM10 global interrupt.
   */
 void TIM1_UP_TIM10_IRQHandler(void)
 {
-  /* USER CODE BEGIN TIM1_UP_TIM10_IRQn 0 */
+  // HAL timebase: only the update interrupt is enabled and TIM10 is unused
+  if (fastio_tim_update(TIM1))
+  {
+    HAL_IncTick();
+  }
+}
+
+/**
+  * @brief This function handles TIM5 global interrupt.
+  */
+void TIM5_IRQHandler(void)
+{
+  monoclock_irq_handler();
+  hrtimer_irq_handler();
+}
 
-  /* USER CODE END TIM1_UP_TIM10_IRQn 0 */
-  HAL_TIM_IRQHandler(&htim1);
-  /* USER CODE BEGIN TIM1_UP_TIM10_IRQn 1 */
+/**
+  * @brief This function handles TIM7 global interrupt.
+  */
+void TIM7_IRQHandler(void)
+{
+  cyclic_irq_handler();
+}
 
-  /* USER CODE END TIM1_UP_TIM10_IRQn 1 */
+/**
+  * @brief This function handles DMA1 stream1 global interrupt.
+  */
+void DMA1_Stream1_IRQHandler(void)
+{
+  uart_rx_dma_irq_handler();
 }
 
 /**
-  * @brief This function handles TIM2 global interrupt.
+  * @brief This function handles USART3 global interrupt.
   */
-void TIM2_IRQHandler(void)
+void USART3_IRQHandler(void)
 {
-  /* USER CODE BEGIN TIM2_IRQn 0 */
+  uart_rx_uart_irq_handler();
+}
 
-  /* USER CODE END TIM2_IRQn 0 */
-  HAL_TIM_IRQHandler(&htim2);
-  /* USER CODE BEGIN TIM2_IRQn 1 */
+/**
+  * @brief This function handles DMA2 stream1 global interrupt.
+  */
+void DMA2_Stream1_IRQHandler(void)
+{
+  crc_dma_irq_handler();
+}
 
-  /* USER CODE END TIM2_IRQn 1 */
+/**
+  * @brief This function handles DMA2 stream0 global interrupt.
+  */
+void DMA2_Stream0_IRQHandler(void)
+{
+  dmacopy_stream0_irq_handler();
 }
 
-/* USER CODE BEGIN 1 */
+/**
+  * @brief This function handles DMA2 stream4 global interrupt.
+  */
+void DMA2_Stream4_IRQHandler(void)
+{
+  dmacopy_stream4_irq_handler();
+}
+
+/**
+  * @brief This function handles Ethernet global interrupt.
+  */
+void ETH_IRQHandler(void)
+{
+  eth_frame_irq_handler();
+}
+
+/**
+  * @brief This function handles DMA2 stream2 global interrupt.
+  */
+void DMA2_Stream2_IRQHandler(void)
+{
+  led_wave_dma_irq_handler();
+}
+
+/**
+  * @brief This function handles DMA1 stream0 global interrupt.
+  */
+void DMA1_Stream0_IRQHandler(void)
+{
+  led_pwm_stream0_irq_handler();
+}
+
+/**
+  * @brief This function handles DMA1 stream2 global interrupt.
+  */
+void DMA1_Stream2_IRQHandler(void)
+{
+  led_pwm_stream2_irq_handler();
+}
+
+/**
+  * @brief This function handles DMA1 stream6 global interrupt.
+  */
+void DMA1_Stream6_IRQHandler(void)
+{
+  led_pwm_stream6_irq_handler();
+}
 
 /* USER CODE END 1 */
@@ -47,9 +47,12 @@ extern "C" {
 #include "stm32f4xx_hal.h"
 #include "cmsis_os.h"
 #include "priority_queue.h"
+#include "led_wave.h"
+#include "led_pwm.h"
 
 /********************** macros ***********************************************/
 #define NUMBER_OF_LEDS 3U
+#define AO_LED_LATENCY_BUCKETS 7U   // decades: < 100 us, < 1 ms, ... < 10 s, longer
 /********************** typedef **********************************************/
 typedef enum
 {
@@ -71,13 +74,28 @@ typedef struct
 	uint16_t 	   pin;
 	GPIO_PinState  state;
 	char 		   colour[10];
+	led_pwm_led_t  pwm;
 } led_info_t;
 
+/* Counters of a run, e.g. a scripted scenario: cleared by ao_led_reset_stats() */
+typedef struct
+{
+	uint32_t events;                            // served
+	uint32_t dropped;                           // queue full
+	uint32_t queue_max;                         // events waiting, high-water mark
+	uint32_t latency_max_us;                    // queued time
+	uint32_t latency[AO_LED_LATENCY_BUCKETS];   // queued time histogram
+} ao_led_stats_t;
+
 typedef struct
 {
 	pq_handle_t   *hpq;
     TaskHandle_t  htask;
+    SemaphoreHandle_t hmode;            // mode changes vs. starting an output
     led_info_t	  info[NUMBER_OF_LEDS]; // use led_t to reference
+    led_wave_pattern_t pattern;         // played per event, channel[0] on the event LED
+    uint8_t       brightness[NUMBER_OF_LEDS]; // PWM mode level per event priority
+    ao_led_stats_t stats;
 } ao_led_handle_t;
 
 /********************** external data declaration ****************************/
@@ -89,6 +107,29 @@ void ao_led_init(ao_led_handle_t* hao_led);
 
 bool ao_led_send(ao_led_handle_t* hao_led, pq_event_t evt);
 
+/* The pattern must end (repeat != 0) and be in range, see led_wave_valid();
+   channel[0] drives the LED of each event, whatever its pin, and the other
+   channels are not used. */
+bool ao_led_set_pattern(ao_led_handle_t* hao_led, const led_wave_pattern_t *pattern);
+
+void ao_led_get_pattern(ao_led_handle_t* hao_led, led_wave_pattern_t *pattern);
+
+/* Shorthands for a pattern keeping the LED steadily on for on_period */
+void ao_led_set_on_period(ao_led_handle_t* hao_led, TickType_t on_period);
+
+TickType_t ao_led_get_on_period(ao_led_handle_t* hao_led);
+
+/* PWM mode: each event fades its LED in to the brightness of its priority,
+   holds it for the pattern duration and fades it out. Task context, takes
+   effect on the event being served. */
+void ao_led_set_pwm_mode(ao_led_handle_t* hao_led, bool enable);
+
+void ao_led_set_brightness(ao_led_handle_t* hao_led, pq_priority_t priority, uint8_t level);
+
+void ao_led_get_stats(ao_led_handle_t* hao_led, ao_led_stats_t *stats);
+
+void ao_led_reset_stats(ao_led_handle_t* hao_led);
+
 /********************** End of CPP guard *************************************/
 #ifdef __cplusplus
 }
@@ -42,6 +42,7 @@ extern "C" {
 
 /********************** inclusions *******************************************/
 #include "ao_led.h"
+#include "elastic_queue.h"
 /********************** macros ***********************************************/
 
 /********************** typedef **********************************************/
@@ -55,7 +56,7 @@ typedef enum
 
 typedef struct
 {
-	QueueHandle_t hqueue;
+	elastic_queue_t queue;
 	TaskHandle_t  htask;
 } ao_ui_handle_t;
 
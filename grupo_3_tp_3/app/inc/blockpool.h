@@ -0,0 +1,73 @@
+/**
+ * @file blockpool.h
+ * @brief Pool of fixed-size blocks shared by the elastic queues
+ *
+ * The queues of the application take their storage from this pool one block
+ * at a time as they fill, and give the blocks back as they drain, so the RAM
+ * is sized for what they hold together rather than for the worst case of
+ * each one. Allocation and release are O(1), from a free list under a
+ * critical section.
+ *
+ * Users: elastic_queue.h (the UI AO queue) and priority_queue.h (the LED AO
+ * queue).
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+#ifndef BLOCKPOOL_H_
+#define BLOCKPOOL_H_
+
+/********************** CPP guard ********************************************/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/********************** inclusions *******************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+/********************** macros ***********************************************/
+#define BLOCKPOOL_CONFIG_BLOCK_SIZE     (32)    /**< Bytes, a multiple of 4 */
+#define BLOCKPOOL_CONFIG_BLOCKS         (16)
+
+/********************** typedef **********************************************/
+
+typedef struct
+{
+  uint32_t used;            /**< Blocks allocated now */
+  uint32_t used_max;
+  uint32_t exhausted;       /**< Allocations refused, the pool was empty */
+} blockpool_stats_t;
+
+/********************** external data declaration ****************************/
+
+/********************** external functions declaration ***********************/
+
+/**
+ * @brief Takes a block, BLOCKPOOL_CONFIG_BLOCK_SIZE bytes, word aligned.
+ *        Task context.
+ *
+ * @return NULL if the pool is empty.
+ */
+void *blockpool_alloc(void);
+
+/**
+ * @brief Gives a block back. Task context.
+ */
+void blockpool_free(void *block);
+
+/**
+ * @brief Copies the statistics.
+ */
+void blockpool_get_stats(blockpool_stats_t *stats);
+
+/********************** End of CPP guard *************************************/
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BLOCKPOOL_H_ */
+/********************** end of file ******************************************/
@@ -0,0 +1,85 @@
+/**
+ * @file boot.h
+ * @brief Boot-time profiler and deferred peripheral initialisation
+ *
+ * Every boot phase ends with boot_mark(), which stamps the cycle counter
+ * (started by the first mark, at the top of main()). Phases are consecutive:
+ * each one lasts from the previous mark to its own, converted to
+ * microseconds with the core clock in force when it started.
+ *
+ * Only what the application needs right away is initialised before the
+ * scheduler. The USB OTG and ETH peripherals are initialised by a
+ * background task once the application is running, which then logs the
+ * breakdown. Time to the first button poll is the sum of the phases up to
+ * BOOT_PHASE_KERNEL.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+#ifndef BOOT_H_
+#define BOOT_H_
+
+/********************** CPP guard ********************************************/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/********************** inclusions *******************************************/
+#include <stdint.h>
+
+/********************** macros ***********************************************/
+#define BOOT_CONFIG_ENABLE              (1)   /**< Profiling only, the deferred init always runs */
+#define BOOT_CONFIG_REPORT              (1)   /**< Log the breakdown once booted */
+
+/********************** typedef **********************************************/
+
+typedef enum
+{
+  BOOT_PHASE_START,         /**< main() entry, the reference */
+  BOOT_PHASE_MONITOR,       /**< Semihosting handles */
+  BOOT_PHASE_HAL,           /**< HAL_Init() */
+  BOOT_PHASE_CLOCK,         /**< SystemClock_Config() */
+  BOOT_PHASE_PERIPHERALS,   /**< Peripherals needed right away: GPIO, USART3 */
+  BOOT_PHASE_APP,           /**< app_init() */
+  BOOT_PHASE_KERNEL,        /**< Scheduler start, up to the first button poll */
+  BOOT_PHASE_WAIT,          /**< Until the background task runs */
+  BOOT_PHASE_USB,           /**< Deferred: MX_USB_OTG_FS_PCD_Init() */
+  BOOT_PHASE_ETH,           /**< Deferred: MX_ETH_Init(), eth_frame_init() */
+  BOOT_PHASE__N,
+} boot_phase_t;
+
+/********************** external data declaration ****************************/
+
+/********************** external functions declaration ***********************/
+
+/**
+ * @brief Marks the end of a phase. BOOT_PHASE_START starts the cycle counter.
+ */
+void boot_mark(boot_phase_t phase);
+
+/**
+ * @brief Duration of a phase in microseconds, 0 if not reached yet.
+ */
+uint32_t boot_phase_us(boot_phase_t phase);
+
+/**
+ * @brief Time from main() to the end of a phase, in microseconds.
+ */
+uint32_t boot_elapsed_us(boot_phase_t phase);
+
+/**
+ * @brief Creates the task initialising the deferred peripherals. Call from
+ *        app_init().
+ */
+void boot_background_init(void);
+
+/********************** End of CPP guard *************************************/
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BOOT_H_ */
+/********************** end of file ******************************************/
@@ -0,0 +1,126 @@
+/**
+ * @file crc.h
+ * @brief CRC-32 service on the CRC peripheral
+ *
+ * Two flavours of CRC-32 (polynomial 0x04C11DB7, initial value 0xFFFFFFFF):
+ *
+ * - crc_calc32(): the standard, reflected CRC-32 of zlib, Ethernet and PNG, over
+ *   any byte buffer. The CRC unit only takes whole words MSB first, so each
+ *   word is bit reversed (__RBIT, one cycle) on its way in and the result on
+ *   its way out. Unaligned head and tail bytes go through the table.
+ * - crc_stm32(): the unit's native CRC (CRC-32/MPEG-2 over little endian
+ *   words, no final XOR), over whole words. Nothing needs reversing, so
+ *   from CRC_CONFIG_DMA_MIN_WORDS on, and from a task, DMA2 feeds the unit
+ *   while the caller sleeps.
+ *
+ * There is a single CRC unit and no mutex: a caller reserves it with an
+ * atomic flag and releases it when done. A caller that finds it reserved,
+ * e.g. an interrupt that preempted a task using it, computes in software
+ * instead, with the same result. Everything can be called from interrupts
+ * except the DMA path, which is never taken there.
+ *
+ * crc_sw.c holds the software versions. It only depends on this header, so
+ * it also builds on a host as the reference for the hardware results.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+#ifndef CRC_H_
+#define CRC_H_
+
+/********************** CPP guard ********************************************/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/********************** inclusions *******************************************/
+#include <stdint.h>
+#include <stddef.h>
+
+/********************** macros ***********************************************/
+#define CRC_CONFIG_ENABLE               (1)
+#define CRC_CONFIG_HW_MIN_BYTES         (16)   /**< Below this crc_calc32() stays in software */
+#define CRC_CONFIG_DMA_MIN_WORDS        (256)  /**< From this crc_stm32() uses the DMA */
+#define CRC_CONFIG_IRQ_PRIORITY         (5)    /**< Highest allowed to call FromISR APIs */
+#define CRC_CONFIG_BENCHMARK            (1)    /**< Log MB/s of each path once at boot */
+
+#define CRC32_CHECK                     (0xCBF43926U)  /**< crc_calc32("123456789") */
+
+/********************** typedef **********************************************/
+
+typedef struct
+{
+  uint32_t hw_calls;      /**< Fed by the CPU */
+  uint32_t dma_calls;     /**< Fed by the DMA */
+  uint32_t sw_fallbacks;  /**< Unit reserved by someone else */
+  uint32_t dma_errors;    /**< DMA failed or timed out, redone by the CPU */
+} crc_stats_t;
+
+/********************** external data declaration ****************************/
+
+/********************** external functions declaration ***********************/
+
+/**
+ * @brief Enables the unit and its DMA stream. Call before osKernelStart().
+ */
+void crc_init(void);
+
+/**
+ * @brief Standard CRC-32 of a buffer.
+ */
+uint32_t crc_calc32(const void *data, size_t len);
+
+/**
+ * @brief Continues a standard CRC-32, zlib style.
+ *
+ * @param crc Result over the previous data, 0 to start.
+ */
+uint32_t crc_update32(uint32_t crc, const void *data, size_t len);
+
+/**
+ * @brief Native CRC of the unit over 32-bit words.
+ */
+uint32_t crc_stm32(const uint32_t *words, size_t count);
+
+/**
+ * @brief Copies the usage statistics.
+ */
+void crc_get_stats(crc_stats_t *stats);
+
+/**
+ * @brief DMA2 stream 1 interrupt.
+ */
+void crc_dma_irq_handler(void);
+
+/* Software versions, crc_sw.c */
+
+/**
+ * @brief Standard CRC-32, table driven.
+ */
+uint32_t crc_update32_sw(uint32_t crc, const void *data, size_t len);
+
+/**
+ * @brief Native CRC of the unit, bit by bit. Reference only.
+ */
+uint32_t crc_stm32_sw(const uint32_t *words, size_t count);
+
+/**
+ * @brief Reverses the bits of a word.
+ */
+uint32_t crc_reflect32(uint32_t value);
+
+/**
+ * @brief Reverses the bits of a byte.
+ */
+uint8_t crc_reflect8(uint8_t value);
+
+/********************** End of CPP guard *************************************/
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CRC_H_ */
+/********************** end of file ******************************************/
@@ -0,0 +1,108 @@
+/**
+ * @file cyclic.h
+ * @brief Time-triggered cyclic executive on TIM7
+ *
+ * A major frame of CYCLIC_CONFIG_MINOR_FRAMES minor frames, each
+ * CYCLIC_CONFIG_MINOR_US long, repeats forever. The update interrupt of TIM7
+ * starts every minor frame and runs, in that interrupt, the jobs the static
+ * schedule in cyclic.c places in it, in job order. A job is released at the
+ * start of its frame, whatever the tasks are doing: its release jitter is
+ * the interrupt latency, not the scheduling of a task.
+ *
+ * The minor frame is the greatest common divisor of the job periods and the
+ * major frame their least common multiple: a shorter minor frame would only
+ * add interrupts with no job to release. With the button sample alone both
+ * are its 50 ms period.
+ *
+ * The time the jobs leave in each minor frame is the slack; FreeRTOS tasks
+ * and lower priority interrupts get it. Jobs must be short and may only use
+ * FromISR APIs. A job running past its budget, and a frame running into the
+ * next one, are counted as overruns.
+ *
+ * A job is in the schedule at build time and does nothing until a module
+ * registers its function, e.g. task_button.c samples the button from
+ * CYCLIC_JOB_BUTTON instead of polling it with vTaskDelay().
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+#ifndef CYCLIC_H_
+#define CYCLIC_H_
+
+/********************** CPP guard ********************************************/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/********************** inclusions *******************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+/********************** macros ***********************************************/
+#define CYCLIC_CONFIG_ENABLE            (1)
+#define CYCLIC_CONFIG_MINOR_US          (50000) /**< Minor frame, GCD of the job periods */
+#define CYCLIC_CONFIG_MINOR_FRAMES      (1)     /**< Per major frame, LCM of the periods / minor */
+#define CYCLIC_CONFIG_IRQ_PRIORITY      (5)     /**< Highest allowed to call FromISR APIs */
+
+/********************** typedef **********************************************/
+
+typedef void (*cyclic_job_fn_t)(void *arg);
+
+typedef enum
+{
+  CYCLIC_JOB_BUTTON,        /**< Button sample, at the task_button.c poll period */
+  CYCLIC_JOB__N,
+} cyclic_job_t;
+
+typedef struct
+{
+  uint32_t frames;          /**< Minor frames run */
+  uint32_t overruns;        /**< Frames whose jobs ran into the next frame */
+  uint32_t job_overruns;    /**< Jobs over their budget */
+  uint32_t release_max_ns;  /**< Worst delay from a frame start to its first job */
+  uint32_t busy_max_ns;     /**< Longest time a frame spent in its jobs */
+  uint32_t slack_min_ns;    /**< Minor frame minus busy_max_ns */
+} cyclic_stats_t;
+
+/********************** external data declaration ****************************/
+
+/********************** external functions declaration ***********************/
+
+/**
+ * @brief Builds the frames from the schedule and starts TIM7.
+ */
+void cyclic_init(void);
+
+/**
+ * @brief Binds the function of a job. Its next release calls it.
+ *
+ * @return false if the job is unknown or already registered.
+ */
+bool cyclic_register(cyclic_job_t job, cyclic_job_fn_t fn, void *arg);
+
+/**
+ * @brief Whether the executive is running; a job registered otherwise is
+ *        never called.
+ */
+bool cyclic_running(void);
+
+/**
+ * @brief Copies the statistics.
+ */
+void cyclic_get_stats(cyclic_stats_t *stats);
+
+/**
+ * @brief TIM7 interrupt handler.
+ */
+void cyclic_irq_handler(void);
+
+/********************** End of CPP guard *************************************/
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CYCLIC_H_ */
+/********************** end of file ******************************************/
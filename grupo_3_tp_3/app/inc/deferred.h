@@ -0,0 +1,106 @@
+/**
+ * @file deferred.h
+ * @brief Deferred interrupt work service
+ *
+ * Lets interrupt handlers stay minimal without each one owning a task and a
+ * stack, and without going through the shared timer daemon
+ * (xTimerPendFunctionCallFromISR()). An ISR posts a function and an argument
+ * into one of three lock-free rings, one per priority, and a worker task per
+ * ring, at a fixed priority, runs them in FIFO order.
+ *
+ * Posting never blocks and never masks interrupts: slots are reserved with
+ * LDREX/STREX, so ISRs of any priority that may use FromISR APIs can post,
+ * and so can tasks. When a ring is full the item is dropped and counted.
+ *
+ * Every item is stamped when posted; the worker records the queueing latency
+ * (post to start of execution) per ring.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+#ifndef DEFERRED_H_
+#define DEFERRED_H_
+
+/********************** CPP guard ********************************************/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/********************** inclusions *******************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "cmsis_os.h"
+
+/********************** macros ***********************************************/
+#define DEFERRED_CONFIG_ENABLE          (1)
+#define DEFERRED_CONFIG_RING_SIZE       (16)   /**< Items per ring, power of two */
+
+/********************** typedef **********************************************/
+
+typedef void (*deferred_fn_t)(void *arg);
+
+/**
+ * @brief Rings, each drained by its own worker task.
+ */
+typedef enum
+{
+  DEFERRED_PRIO_HIGH,    /**< tskIDLE_PRIORITY + 5 */
+  DEFERRED_PRIO_MEDIUM,  /**< tskIDLE_PRIORITY + 3 */
+  DEFERRED_PRIO_LOW,     /**< tskIDLE_PRIORITY + 2 */
+  DEFERRED_PRIO__N,
+} deferred_prio_t;
+
+typedef struct
+{
+  uint32_t posted;
+  uint32_t dropped;        /**< Ring full */
+  uint32_t executed;
+  uint32_t max_depth;      /**< High-water mark of the ring */
+  uint32_t latency_min_us;
+  uint32_t latency_max_us;
+  uint64_t latency_sum_us; /**< latency_sum_us / executed is the mean */
+} deferred_stats_t;
+
+/********************** external data declaration ****************************/
+
+/********************** external functions declaration ***********************/
+
+/**
+ * @brief Creates the worker tasks. Call before osKernelStart().
+ */
+void deferred_init(void);
+
+/**
+ * @brief Posts work from an interrupt.
+ *
+ * @param prio  Ring / worker.
+ * @param fn    Function to run in the worker task.
+ * @param arg   Its argument.
+ * @param woken Set to pdTRUE if portYIELD_FROM_ISR() is required.
+ * @return false if the ring was full.
+ */
+bool deferred_post_from_isr(deferred_prio_t prio, deferred_fn_t fn, void *arg, BaseType_t *woken);
+
+/**
+ * @brief Posts work from a task.
+ *
+ * @return false if the ring was full.
+ */
+bool deferred_post(deferred_prio_t prio, deferred_fn_t fn, void *arg);
+
+/**
+ * @brief Copies the statistics of a ring.
+ */
+void deferred_get_stats(deferred_prio_t prio, deferred_stats_t *stats);
+
+/********************** End of CPP guard *************************************/
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DEFERRED_H_ */
+/********************** end of file ******************************************/
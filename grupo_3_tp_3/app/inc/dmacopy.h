@@ -0,0 +1,144 @@
+/**
+ * @file dmacopy.h
+ * @brief Asynchronous memory copies on DMA2
+ *
+ * Bulk copies (log flushes, frame assembly, buffer snapshots) are handed to
+ * the memory-to-memory streams of DMA2 so the CPU is free while the data
+ * moves. Requests are queued in FIFO order and started on whichever stream
+ * becomes free.
+ *
+ * The request is owned by the caller and must stay valid until completion.
+ * On completion the callback, if any, runs in interrupt context (in the
+ * caller's context for CPU copies) and the submitting task, if any, gets a
+ * task notification (xTaskNotifyGive()).
+ * dmacopy_wait() consumes notifications until its request is done, so a
+ * task that also takes notifications for other purposes must re-check its
+ * own conditions afterwards.
+ *
+ * Copies shorter than the crossover size, which is measured at boot, are
+ * done by the CPU right away, as are copies touching the CCM RAM, which the
+ * DMA cannot reach. Either way the request completes the same way.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+#ifndef DMACOPY_H_
+#define DMACOPY_H_
+
+/********************** CPP guard ********************************************/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/********************** inclusions *******************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "cmsis_os.h"
+
+/********************** macros ***********************************************/
+#define DMACOPY_CONFIG_ENABLE           (1)
+#define DMACOPY_CONFIG_CROSSOVER_BYTES  (256)  /**< Until measured at boot */
+#define DMACOPY_CONFIG_IRQ_PRIORITY     (5)    /**< Highest allowed to call FromISR APIs */
+#define DMACOPY_CONFIG_MEASURE          (1)    /**< Measure the crossover at boot */
+
+/********************** typedef **********************************************/
+
+typedef void (*dmacopy_callback_t)(void *arg);
+
+typedef struct dmacopy_request
+{
+  struct dmacopy_request *next;
+  uint8_t                *dst;
+  const uint8_t          *src;
+  size_t                  remaining;   /**< Bytes not yet started */
+  dmacopy_callback_t      callback;
+  void                   *arg;
+  TaskHandle_t            htask;       /**< Notified on completion */
+  volatile bool           done;
+} dmacopy_request_t;
+
+typedef struct
+{
+  uint32_t dma_copies;
+  uint32_t cpu_copies;
+  uint32_t dma_bytes;
+  uint32_t cpu_bytes;
+  uint32_t queued;         /**< Had to wait for a free stream */
+  uint32_t errors;         /**< DMA transfer errors, finished by the CPU */
+  uint32_t crossover;      /**< Bytes, current */
+} dmacopy_stats_t;
+
+/********************** external data declaration ****************************/
+
+/********************** external functions declaration ***********************/
+
+/**
+ * @brief Sets up the streams. Call before osKernelStart().
+ */
+void dmacopy_init(void);
+
+/**
+ * @brief Starts a copy.
+ *
+ * Callable from tasks and from interrupts. From a task, that task is
+ * notified on completion.
+ *
+ * @param req      Request, owned by the caller until done.
+ * @param dst      Destination, must not overlap src.
+ * @param src      Source.
+ * @param len      Bytes.
+ * @param callback Run in interrupt context on completion, may be NULL.
+ * @param arg      Its argument.
+ */
+void dmacopy_submit(dmacopy_request_t *req, void *dst, const void *src, size_t len,
+                    dmacopy_callback_t callback, void *arg);
+
+/**
+ * @brief Whether a request has completed.
+ */
+bool dmacopy_done(const dmacopy_request_t *req);
+
+/**
+ * @brief Blocks the submitting task until the request completes.
+ *
+ * @return false on timeout.
+ */
+bool dmacopy_wait(dmacopy_request_t *req, TickType_t timeout);
+
+/**
+ * @brief Synchronous copy: CPU below the crossover, DMA above it.
+ */
+void dmacopy_copy(void *dst, const void *src, size_t len);
+
+/**
+ * @brief CPU copy, word at a time when both pointers allow it.
+ */
+void dmacopy_cpu(void *dst, const void *src, size_t len);
+
+/**
+ * @brief Copies the statistics.
+ */
+void dmacopy_get_stats(dmacopy_stats_t *stats);
+
+/**
+ * @brief DMA2 stream 0 interrupt.
+ */
+void dmacopy_stream0_irq_handler(void);
+
+/**
+ * @brief DMA2 stream 4 interrupt.
+ */
+void dmacopy_stream4_irq_handler(void);
+
+/********************** End of CPP guard *************************************/
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DMACOPY_H_ */
+/********************** end of file ******************************************/
@@ -0,0 +1,95 @@
+/**
+ * @file dsp_kernels.h
+ * @brief Float and fixed-point (Q15/Q31) signal processing kernels
+ *
+ * Small building blocks for signal math on the Cortex-M4F. The float
+ * versions use the single precision FPU; the Q15 versions process two
+ * samples per instruction with the SIMD multiply-accumulate (SMLALD) and the
+ * Q31 versions use the 32x32->64 multiply (SMULL) and a 64-bit add.
+ *
+ * Q15 and Q31 follow the usual CMSIS-DSP conventions:
+ * - q15_t: 1.15 signed fraction, q31_t: 1.31 signed fraction.
+ * - Q15 dot products accumulate 2.30 products in a 64-bit 34.30 result.
+ * - Q31 dot products truncate each 2.62 product to 2.48 before adding it to
+ *   a 16.48 result: the low 14 bits of every product are lost, in exchange
+ *   for headroom for 2^14 full scale products. A full 2.62 accumulator, the
+ *   one SMLAL would allow, overflows after two.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+#ifndef DSP_KERNELS_H_
+#define DSP_KERNELS_H_
+
+/********************** CPP guard ********************************************/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/********************** inclusions *******************************************/
+#include <stdint.h>
+
+/********************** macros ***********************************************/
+
+/********************** typedef **********************************************/
+typedef int16_t q15_t;
+typedef int32_t q31_t;
+typedef int64_t q63_t;
+
+/********************** external data declaration ****************************/
+
+/********************** external functions declaration ***********************/
+
+/**
+ * @brief Converts a float in [-1, 1) to Q15, with saturation; NaN gives 0.
+ */
+q15_t dsp_float_to_q15(float value);
+
+/**
+ * @brief Converts a float in [-1, 1) to Q31, with saturation; NaN gives 0.
+ */
+q31_t dsp_float_to_q31(float value);
+
+/**
+ * @brief Dot product of two float vectors.
+ */
+float dsp_dot_f32(const float *a, const float *b, uint32_t n);
+
+/**
+ * @brief Dot product of two Q15 vectors, 34.30 result.
+ */
+q63_t dsp_dot_q15(const q15_t *a, const q15_t *b, uint32_t n);
+
+/**
+ * @brief Dot product of two Q31 vectors, 16.48 result.
+ */
+q63_t dsp_dot_q31(const q31_t *a, const q31_t *b, uint32_t n);
+
+/**
+ * @brief Direct form FIR over a block of float samples.
+ *
+ * @param coeffs Filter taps, in reverse time order.
+ * @param taps   Number of taps.
+ * @param in     Input, holding (taps - 1) history samples followed by n new ones.
+ * @param out    n output samples.
+ * @param n      Block size.
+ */
+void dsp_fir_f32(const float *coeffs, uint32_t taps, const float *in, float *out, uint32_t n);
+
+/**
+ * @brief Direct form FIR over a block of Q15 samples, Q15 saturated output.
+ *
+ * Same layout as dsp_fir_f32().
+ */
+void dsp_fir_q15(const q15_t *coeffs, uint32_t taps, const q15_t *in, q15_t *out, uint32_t n);
+
+/********************** End of CPP guard *************************************/
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DSP_KERNELS_H_ */
+/********************** end of file ******************************************/
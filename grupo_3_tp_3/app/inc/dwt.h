@@ -60,6 +60,7 @@ extern "C" {
  	})
 
 /* reset cycle counter */
+/* Not to be used by the application: monoclock.h owns the cycle counter */
 /*!< DWT Cycle Counter register */
 #define cycle_counter_reset() (DWT->CYCCNT = 0)
 
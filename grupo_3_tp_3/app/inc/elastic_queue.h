@@ -0,0 +1,90 @@
+/**
+ * @file elastic_queue.h
+ * @brief FIFO queue stored in a chain of blockpool.h blocks
+ *
+ * Unlike a FreeRTOS queue, whose storage is reserved for its full length at
+ * creation, an elastic queue holds one block while it has few items, links
+ * another when the last one fills, and gives each one back as soon as it is
+ * drained. Its capacity is a cap, not a reservation: a send also fails when
+ * the shared pool is empty.
+ *
+ * Every operation is O(1). Any task may send, one task receives.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+#ifndef ELASTIC_QUEUE_H_
+#define ELASTIC_QUEUE_H_
+
+/********************** CPP guard ********************************************/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/********************** inclusions *******************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "cmsis_os.h"
+
+/********************** macros ***********************************************/
+
+/********************** typedef **********************************************/
+
+typedef struct elastic_segment_s elastic_segment_t;
+
+typedef struct
+{
+  elastic_segment_t *head;        /**< Oldest item, NULL empty */
+  elastic_segment_t *tail;        /**< Newest item */
+  uint32_t          head_index;   /**< Items of the head segment received */
+  uint32_t          tail_index;   /**< Items of the tail segment sent */
+  uint32_t          item_size;
+  uint32_t          per_segment;  /**< Items a segment holds */
+  uint32_t          capacity;
+  uint32_t          count;
+  uint32_t          count_max;
+  uint32_t          segments;     /**< Held now */
+  SemaphoreHandle_t hitems;       /**< Counts the items */
+} elastic_queue_t;
+
+/********************** external data declaration ****************************/
+
+/********************** external functions declaration ***********************/
+
+/**
+ * @brief Initialises an empty queue. It holds no block until the first send.
+ *
+ * @param capacity  Most items it may hold.
+ * @param item_size Bytes, at most a block less its link.
+ */
+void elastic_queue_init(elastic_queue_t *queue, uint32_t capacity, uint32_t item_size);
+
+/**
+ * @brief Copies an item to the back of the queue. Task context, never blocks.
+ *
+ * @return false if the queue is at its capacity or the pool is empty.
+ */
+bool elastic_queue_send(elastic_queue_t *queue, const void *item);
+
+/**
+ * @brief Takes the item at the front of the queue, waiting for one up to
+ *        the given ticks.
+ */
+bool elastic_queue_receive(elastic_queue_t *queue, void *item, TickType_t ticks);
+
+/**
+ * @brief Items in the queue, a snapshot for monitoring.
+ */
+uint32_t elastic_queue_count(const elastic_queue_t *queue);
+
+/********************** End of CPP guard *************************************/
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ELASTIC_QUEUE_H_ */
+/********************** end of file ******************************************/
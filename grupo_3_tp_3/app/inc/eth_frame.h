@@ -0,0 +1,141 @@
+/**
+ * @file eth_frame.h
+ * @brief Zero-copy raw Ethernet frame driver
+ *
+ * Receive: the ETH DMA writes straight into buffers of a fixed pool, handed
+ * to the HAL through HAL_ETH_RxAllocateCallback(). HAL_ETH_RxLinkCallback()
+ * chains the buffers of a frame (a single one for any standard frame) and the
+ * frame is passed to the registered handler as it is, in the buffer the DMA
+ * wrote. The handler owns it until eth_frame_release(). When the pool is
+ * empty the DMA has no buffer and the MAC drops frames, which is counted.
+ *
+ * Transmit: the caller describes the frame as a list of ETH_BufferTypeDef
+ * (header, payload, ...) and each buffer becomes a DMA descriptor, so the
+ * pieces are never assembled. The buffers belong to the DMA until the done
+ * callback. Checksums are inserted by the MAC as configured in TxConfig.
+ *
+ * The interrupt only notifies task_eth, which reads frames, runs the handler,
+ * releases sent packets and, while idle, polls the PHY to follow the link.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+#ifndef ETH_FRAME_H_
+#define ETH_FRAME_H_
+
+/********************** CPP guard ********************************************/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/********************** inclusions *******************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "main.h"
+
+/********************** macros ***********************************************/
+#define ETH_FRAME_CONFIG_ENABLE         (1)
+#define ETH_FRAME_CONFIG_RX_BUFFERS     (8)      /**< Pool size, at least ETH_RX_DESC_CNT */
+#define ETH_FRAME_CONFIG_PHY_ADDRESS    (0)      /**< LAN8742A on the Nucleo-144 */
+#define ETH_FRAME_CONFIG_LINK_POLL_MS   (500)
+#define ETH_FRAME_CONFIG_IRQ_PRIORITY   (5)      /**< Highest allowed to call FromISR APIs */
+
+#define ETH_FRAME_BUFFER_SIZE           (ETH_RX_BUF_SIZE)
+
+/********************** typedef **********************************************/
+
+/**
+ * @brief Received frame, in the buffer the DMA wrote.
+ */
+typedef struct eth_frame
+{
+  uint8_t           data[ETH_FRAME_BUFFER_SIZE] __attribute__((aligned(4)));
+  struct eth_frame *next;   /**< Next buffer of the same frame, or NULL */
+  uint16_t          len;    /**< Bytes in this buffer */
+} eth_frame_t;
+
+typedef void (*eth_frame_rx_handler_t)(eth_frame_t *frame, void *arg);
+
+struct eth_frame_tx;
+typedef void (*eth_frame_tx_done_t)(struct eth_frame_tx *tx);
+
+/**
+ * @brief Frame to send, owned by the caller until done is called.
+ */
+typedef struct eth_frame_tx
+{
+  ETH_BufferTypeDef  *buffers;  /**< Scatter-gather list */
+  uint32_t            len;      /**< Total bytes */
+  eth_frame_tx_done_t done;     /**< Called from task_eth, must not send; may be NULL */
+  void               *arg;
+} eth_frame_tx_t;
+
+typedef struct
+{
+  uint32_t rx_frames;
+  uint32_t rx_bytes;
+  uint32_t rx_errors;
+  uint32_t rx_no_buffer;   /**< Pool empty when the DMA asked for a buffer */
+  uint32_t tx_frames;
+  uint32_t tx_busy;        /**< No free descriptors, caller must retry */
+  uint32_t link_changes;
+  bool     link_up;
+} eth_frame_stats_t;
+
+/********************** external data declaration ****************************/
+extern ETH_HandleTypeDef heth;
+extern ETH_TxPacketConfig TxConfig;
+
+/********************** external functions declaration ***********************/
+
+/**
+ * @brief Builds the pool and creates task_eth. Call after MX_ETH_Init().
+ *
+ * The MAC is started once the PHY reports a link.
+ */
+void eth_frame_init(void);
+
+/**
+ * @brief Sets the consumer of received frames, run by task_eth.
+ */
+void eth_frame_set_rx_handler(eth_frame_rx_handler_t handler, void *arg);
+
+/**
+ * @brief Gives a received frame, all its buffers, back to the pool.
+ */
+void eth_frame_release(eth_frame_t *frame);
+
+/**
+ * @brief Queues a frame for transmission. Task context only.
+ *
+ * @return false if the link is down or there are not enough free
+ *         descriptors; tx is then not used.
+ */
+bool eth_frame_send(eth_frame_tx_t *tx);
+
+/**
+ * @brief Whether the link is up and the MAC started.
+ */
+bool eth_frame_link_up(void);
+
+/**
+ * @brief Copies the statistics.
+ */
+void eth_frame_get_stats(eth_frame_stats_t *stats);
+
+/**
+ * @brief ETH global interrupt.
+ */
+void eth_frame_irq_handler(void);
+
+/********************** End of CPP guard *************************************/
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ETH_FRAME_H_ */
+/********************** end of file ******************************************/
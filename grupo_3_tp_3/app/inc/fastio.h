@@ -0,0 +1,138 @@
+/**
+ * @file fastio.h
+ * @brief Inline register access for hot paths, on the STM32 LL headers
+ *
+ * The HAL stays in charge of initialisation. These helpers replace the HAL
+ * calls that run often: pin reads and writes, which the HAL does through a
+ * function call with parameter checks, and timer interrupt acknowledgement,
+ * where HAL_TIM_IRQHandler() tests every flag and dispatches through
+ * callbacks. An interrupt handler built on them only services the flags its
+ * timer actually has enabled.
+ *
+ * fastio_dma_stop() replaces HAL_DMA_Abort(), which waits for the stream
+ * on HAL_GetTick() and so never returns with the tick interrupt masked, as
+ * it is inside a critical section.
+ *
+ * perf_bench.h measures both against the HAL.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+#ifndef FASTIO_H_
+#define FASTIO_H_
+
+/********************** CPP guard ********************************************/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/********************** inclusions *******************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "stm32f4xx_hal.h"
+#include "stm32f4xx_ll_gpio.h"
+#include "stm32f4xx_ll_tim.h"
+
+/********************** macros ***********************************************/
+#define FASTIO_TIM_IT_MASK      (0x7FU)   /**< DIER interrupt enables match SR flags 0-6 */
+#define FASTIO_DMA_STOP_SPINS   (1000U)   /**< Polls of EN, far more than one beat takes */
+
+/********************** typedef **********************************************/
+
+/********************** external data declaration ****************************/
+
+/********************** external functions declaration ***********************/
+
+/**
+ * @brief Input level of a pin, the GPIO_PIN_x mask of the HAL.
+ */
+static inline bool fastio_read(GPIO_TypeDef *port, uint32_t pin)
+{
+  return (0U != LL_GPIO_IsInputPinSet(port, pin));
+}
+
+static inline void fastio_set(GPIO_TypeDef *port, uint32_t pin)
+{
+  LL_GPIO_SetOutputPin(port, pin);
+}
+
+static inline void fastio_reset(GPIO_TypeDef *port, uint32_t pin)
+{
+  LL_GPIO_ResetOutputPin(port, pin);
+}
+
+static inline void fastio_write(GPIO_TypeDef *port, uint32_t pin, bool on)
+{
+  // one BSRR write either way
+  port->BSRR = on ? pin : (pin << 16);
+}
+
+/**
+ * @brief Acknowledges the update interrupt of a timer with nothing else
+ *        enabled.
+ *
+ * @return true if the update flag was set.
+ */
+static inline bool fastio_tim_update(TIM_TypeDef *tim)
+{
+  if (0U == LL_TIM_IsActiveFlag_UPDATE(tim))
+  {
+    return false;
+  }
+  LL_TIM_ClearFlag_UPDATE(tim);
+  return true;
+}
+
+/**
+ * @brief Acknowledges every flag of a timer whose interrupt is enabled.
+ *
+ * @return The flags acknowledged, TIM_SR bits.
+ */
+static inline uint32_t fastio_tim_ack(TIM_TypeDef *tim)
+{
+  uint32_t pending = tim->SR & tim->DIER & FASTIO_TIM_IT_MASK;
+
+  // rc_w0: ones leave the other flags alone
+  tim->SR = ~pending;
+  return pending;
+}
+
+/**
+ * @brief Stops a DMA stream started with HAL_DMA_Start_IT() and leaves its
+ *        handle ready for the next start. Any context, interrupts masked
+ *        included: it waits a bounded number of polls, not on the tick.
+ *
+ * @return false if the stream was still enabled after the polls.
+ */
+static inline bool fastio_dma_stop(DMA_HandleTypeDef *hdma)
+{
+  DMA_Stream_TypeDef *stream = hdma->Instance;
+  uint32_t spins = FASTIO_DMA_STOP_SPINS;
+
+  CLEAR_BIT(stream->CR, DMA_IT_TC | DMA_IT_TE | DMA_IT_DME | DMA_IT_HT);
+  CLEAR_BIT(stream->FCR, DMA_IT_FE);
+  // the stream finishes the beat in flight before EN reads back 0
+  CLEAR_BIT(stream->CR, DMA_SxCR_EN);
+  while ((0U != (stream->CR & DMA_SxCR_EN)) && (0U < spins))
+  {
+    spins--;
+  }
+  __HAL_DMA_CLEAR_FLAG(hdma, __HAL_DMA_GET_TC_FLAG_INDEX(hdma) | __HAL_DMA_GET_HT_FLAG_INDEX(hdma) |
+                             __HAL_DMA_GET_TE_FLAG_INDEX(hdma) | __HAL_DMA_GET_DME_FLAG_INDEX(hdma) |
+                             __HAL_DMA_GET_FE_FLAG_INDEX(hdma));
+  hdma->State = HAL_DMA_STATE_READY;
+  __HAL_UNLOCK(hdma);
+  return (0U == (stream->CR & DMA_SxCR_EN));
+}
+
+/********************** End of CPP guard *************************************/
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FASTIO_H_ */
+/********************** end of file ******************************************/
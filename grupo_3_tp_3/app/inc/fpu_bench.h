@@ -0,0 +1,49 @@
+/**
+ * @file fpu_bench.h
+ * @brief Boot-time FPU benchmark
+ *
+ * Runs once after the scheduler starts and logs:
+ * - the cost of a context switch between tasks that never touched the FPU
+ *   and between tasks that carry FPU state (s16-s31 plus lazy s0-s15);
+ * - the cost of the float, Q15 and Q31 kernels in dsp_kernels.h;
+ * - the per-task FPU usage collected by fpu_monitor.h.
+ *
+ * The benchmark tasks delete themselves when done.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+#ifndef FPU_BENCH_H_
+#define FPU_BENCH_H_
+
+/********************** CPP guard ********************************************/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/********************** inclusions *******************************************/
+
+/********************** macros ***********************************************/
+#define FPU_BENCH_CONFIG_ENABLE         (1)
+
+/********************** typedef **********************************************/
+
+/********************** external data declaration ****************************/
+
+/********************** external functions declaration ***********************/
+
+/**
+ * @brief Creates the benchmark task. Call before osKernelStart().
+ */
+void fpu_bench_init(void);
+
+/********************** End of CPP guard *************************************/
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FPU_BENCH_H_ */
+/********************** end of file ******************************************/
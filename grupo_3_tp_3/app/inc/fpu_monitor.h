@@ -0,0 +1,82 @@
+/**
+ * @file fpu_monitor.h
+ * @brief Per-task FPU context usage tracking
+ *
+ * The GCC/ARM_CM4F port always runs with lazy FPU state preservation
+ * (FPCCR.ASPEN and FPCCR.LSPEN set by xPortStartScheduler()). A task only
+ * carries the extended (FPU) exception frame after it has executed at least
+ * one floating point instruction; from then on every context switch of that
+ * task also saves and restores s16-s31.
+ *
+ * This module is hooked into traceTASK_SWITCHED_OUT() and inspects the
+ * EXC_RETURN value that PendSV has just pushed on the outgoing task stack, so
+ * it can tell, per task, how many switches carried FPU state.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+#ifndef FPU_MONITOR_H_
+#define FPU_MONITOR_H_
+
+/********************** CPP guard ********************************************/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/********************** inclusions *******************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "cmsis_os.h"
+
+/********************** macros ***********************************************/
+#define FPU_MONITOR_CONFIG_ENABLE       (1)
+#define FPU_MONITOR_MAX_TASKS           (16) /**< Tracked TCB numbers, 1..N-1 */
+
+/********************** typedef **********************************************/
+
+/**
+ * @brief Context switch counters of a single task.
+ */
+typedef struct
+{
+  uint32_t switches;      /**< Times the task was switched out */
+  uint32_t fpu_switches;  /**< Times it was switched out carrying FPU state */
+} fpu_monitor_stats_t;
+
+/********************** external data declaration ****************************/
+
+/********************** external functions declaration ***********************/
+
+/**
+ * @brief Kernel hook, called from traceTASK_SWITCHED_OUT() inside PendSV.
+ *
+ * @param task_number  uxTCBNumber of the outgoing task.
+ * @param top_of_stack Saved stack pointer of the outgoing task.
+ */
+void fpu_monitor_task_switched_out(UBaseType_t task_number, const uint32_t *top_of_stack);
+
+/**
+ * @brief Reads the counters of a task.
+ *
+ * @param htask Task handle, NULL for the calling task.
+ * @param stats Where to copy the counters.
+ * @return true if the task is tracked.
+ */
+bool fpu_monitor_get(TaskHandle_t htask, fpu_monitor_stats_t *stats);
+
+/**
+ * @brief Logs the counters of every task in the system.
+ */
+void fpu_monitor_report(void);
+
+/********************** End of CPP guard *************************************/
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FPU_MONITOR_H_ */
+/********************** end of file ******************************************/
@@ -0,0 +1,140 @@
+/**
+ * @file hrtimer.h
+ * @brief High-resolution timer service on TIM5
+ *
+ * FreeRTOS software timers are limited to the 1 ms tick and run from the
+ * timer daemon. This service uses channel 1 of TIM5, the 32-bit timer that
+ * monoclock.h runs free at 1 MHz, and programs its compare with the earliest
+ * pending expiry of a sorted list of timers, giving microsecond one-shot and
+ * periodic callbacks.
+ *
+ * Callbacks run either directly in the TIM5 interrupt (HRTIMER_CONTEXT_ISR),
+ * where they must be short and only use FromISR APIs, or in the hrtimer task
+ * (HRTIMER_CONTEXT_TASK), the highest priority task of the application.
+ *
+ * Each timer keeps jitter statistics: the lateness between the programmed
+ * expiry and the moment its callback starts.
+ *
+ * Delays and periods must be below 2^31 us (about 35 minutes), and periods at
+ * least HRTIMER_MIN_PERIOD_US. A periodic timer that falls more than a period
+ * behind skips the periods it missed rather than running them back to back.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+#ifndef HRTIMER_H_
+#define HRTIMER_H_
+
+/********************** CPP guard ********************************************/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/********************** inclusions *******************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+/********************** macros ***********************************************/
+#define HRTIMER_CONFIG_ENABLE           (1)
+#define HRTIMER_CONFIG_QUEUE_LENGTH     (8)  /**< Pending task-context callbacks, power of two */
+
+#define HRTIMER_MIN_PERIOD_US           (20) /**< Above the interrupt service time */
+
+/********************** typedef **********************************************/
+
+typedef void (*hrtimer_callback_t)(void *arg);
+
+/**
+ * @brief Where a timer callback runs.
+ */
+typedef enum
+{
+  HRTIMER_CONTEXT_ISR,  /**< TIM5 interrupt */
+  HRTIMER_CONTEXT_TASK, /**< hrtimer task */
+} hrtimer_context_t;
+
+/**
+ * @brief Lateness of the callback with respect to the programmed expiry.
+ */
+typedef struct
+{
+  uint32_t count;        /**< Callbacks run */
+  uint32_t late_min_us;
+  uint32_t late_max_us;
+  uint64_t late_sum_us;  /**< late_sum_us / count is the mean */
+  uint32_t skipped;      /**< Periods missed while late */
+} hrtimer_stats_t;
+
+/**
+ * @brief A timer. Owned by the caller, must stay valid while armed.
+ */
+typedef struct hrtimer_s
+{
+  struct hrtimer_s  *next;       /**< Sorted pending list link */
+  uint32_t           expiry_us;  /**< Absolute TIM5 count */
+  uint32_t           period_us;  /**< 0 for one-shot */
+  hrtimer_callback_t callback;
+  void              *arg;
+  hrtimer_context_t  context;
+  bool               armed;
+  hrtimer_stats_t    stats;
+} hrtimer_t;
+
+/********************** external data declaration ****************************/
+
+/********************** external functions declaration ***********************/
+
+/**
+ * @brief Sets up TIM5 channel 1 and creates the hrtimer task.
+ *
+ * Call after monoclock_init() and before osKernelStart().
+ */
+void hrtimer_service_init(void);
+
+/**
+ * @brief Initialises a timer, disarmed.
+ */
+void hrtimer_init(hrtimer_t *timer, hrtimer_callback_t callback, void *arg, hrtimer_context_t context);
+
+/**
+ * @brief Arms a timer, re-arming it if already pending.
+ *
+ * Callable from tasks and from interrupts that may use FromISR APIs.
+ *
+ * @param timer     Timer to arm.
+ * @param delay_us  First expiry, from now.
+ * @param period_us Reload period, 0 for one-shot.
+ * @return false if delay_us or period_us is out of range.
+ */
+bool hrtimer_start(hrtimer_t *timer, uint32_t delay_us, uint32_t period_us);
+
+/**
+ * @brief Disarms a timer. A task-context callback already queued still runs.
+ */
+void hrtimer_stop(hrtimer_t *timer);
+
+/**
+ * @brief Current TIM5 count, in microseconds (now_us32()). Wraps every 2^32 us.
+ */
+uint32_t hrtimer_now_us(void);
+
+/**
+ * @brief Copies the jitter statistics of a timer.
+ */
+void hrtimer_get_stats(const hrtimer_t *timer, hrtimer_stats_t *stats);
+
+/**
+ * @brief TIM5 channel 1 handler, called from TIM5_IRQHandler().
+ */
+void hrtimer_irq_handler(void);
+
+/********************** End of CPP guard *************************************/
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HRTIMER_H_ */
+/********************** end of file ******************************************/
@@ -0,0 +1,132 @@
+/**
+ * @file journal.h
+ * @brief Journal of the events entering the AO queues, with replay
+ *
+ * Every event sent to the UI AO queue or the LED AO priority queue is
+ * recorded in a RAM ring with its time, source and whether the queue took
+ * it. A host extracts it with REMOTE_CMD_READ_JOURNAL.
+ *
+ * journal_replay() feeds the external inputs of the journal (button and
+ * remote events) back into the queues, in the same order and with the same
+ * spacing, so a field sequence can be reproduced on a bench unit running
+ * the same build. Events produced by the AOs themselves, e.g. the UI AO
+ * posting to the LED AO, are not injected: the replay produces them again,
+ * and they are recorded as it goes, next to the original run.
+ *
+ * journal_replay_records() replays records extracted before instead, e.g.
+ * from a field unit: the host simulation feeds such a dump into the same
+ * build, on its virtual clock, see host/src/main.c.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+#ifndef JOURNAL_H_
+#define JOURNAL_H_
+
+/********************** CPP guard ********************************************/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/********************** inclusions *******************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+/********************** macros ***********************************************/
+#define JOURNAL_CONFIG_ENABLE           (1)
+#define JOURNAL_CONFIG_RECORDS          (256)   /**< Power of two */
+
+/********************** typedef **********************************************/
+
+typedef enum
+{
+  JOURNAL_QUEUE_UI,         /**< value is the ao_ui_message_t */
+  JOURNAL_QUEUE_LED,        /**< value is the pq_priority_t */
+  JOURNAL_QUEUE__N,
+} journal_queue_t;
+
+typedef enum
+{
+  JOURNAL_SOURCE_BUTTON,
+  JOURNAL_SOURCE_REMOTE,
+  JOURNAL_SOURCE_UI,        /**< The UI AO */
+  JOURNAL_SOURCE_WARMBOOT,  /**< Restored after a warm reset */
+  JOURNAL_SOURCE_REPLAY,
+  JOURNAL_SOURCE__N,
+} journal_source_t;
+
+typedef struct
+{
+  uint32_t time_us;         /**< now_us32() */
+  uint8_t  queue;           /**< journal_queue_t */
+  uint8_t  source;          /**< journal_source_t */
+  uint8_t  value;
+  uint8_t  accepted;        /**< 0 the queue was full */
+} journal_record_t;
+
+typedef struct
+{
+  uint32_t recorded;        /**< Total, also the sequence of the next record */
+  uint32_t replays;
+  uint32_t replayed;        /**< Events injected */
+  bool     replaying;
+} journal_stats_t;
+
+/********************** external data declaration ****************************/
+
+/********************** external functions declaration ***********************/
+
+/**
+ * @brief Creates the replay task. Call before osKernelStart().
+ */
+void journal_init(void);
+
+/**
+ * @brief Records an event sent to an AO queue. Task context.
+ */
+void journal_record(journal_queue_t queue, journal_source_t source, uint32_t value, bool accepted);
+
+/**
+ * @brief Copies records, oldest first.
+ *
+ * @param seq     Sequence of the first record wanted. Records already
+ *                overwritten are skipped.
+ * @param records Destination.
+ * @param max     Records that fit in the destination.
+ * @param first   Sequence of the first record copied.
+ * @return Records copied.
+ */
+uint32_t journal_read(uint32_t seq, journal_record_t *records, uint32_t max, uint32_t *first);
+
+/**
+ * @brief Starts replaying the records in the journal.
+ *
+ * @return false if a replay is running or there is nothing to replay.
+ */
+bool journal_replay(void);
+
+/**
+ * @brief Starts replaying records given by the caller, oldest first, as
+ *        journal_read() copies them.
+ *
+ * @param records Records, copied before returning.
+ * @param count   At most JOURNAL_CONFIG_RECORDS.
+ * @return false if a replay is running, or count is 0 or too large.
+ */
+bool journal_replay_records(const journal_record_t *records, uint32_t count);
+
+/**
+ * @brief Copies the statistics.
+ */
+void journal_get_stats(journal_stats_t *stats);
+
+/********************** End of CPP guard *************************************/
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* JOURNAL_H_ */
+/********************** end of file ******************************************/
@@ -0,0 +1,121 @@
+/**
+ * @file kvstore.h
+ * @brief Persistent key-value store on two flash sectors
+ *
+ * Runtime tunables survive a reset without reflashing. The store is a log
+ * of records appended to the active sector of a pair, each one a header word
+ * (key and length), the value and a CRC-32 word programmed last, so a record
+ * torn by a power loss is dropped on the next boot and the previous value of
+ * its key stands. When the active sector fills up, the latest value of every
+ * key is copied to the other one, which only becomes active once its header
+ * is written, and the old sector is erased.
+ *
+ * A table in RAM holds the current value of every key: reads are a copy and
+ * writes only update the table. A background task appends the changes and
+ * does the compactions and erases; the sectors are in bank 2 and the code
+ * runs from bank 1, so nothing else waits for the flash meanwhile. A value
+ * written less than a few milliseconds before a reset may be lost.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+#ifndef KVSTORE_H_
+#define KVSTORE_H_
+
+/********************** CPP guard ********************************************/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/********************** inclusions *******************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+/********************** macros ***********************************************/
+#define KVSTORE_CONFIG_ENABLE           (1)
+#define KVSTORE_CONFIG_VALUE_MAX        (16)    /**< Bytes, multiple of 4 */
+#define KVSTORE_CONFIG_COMPACT_FREE     (1024)  /**< Compact below this many free bytes */
+
+/********************** typedef **********************************************/
+
+/**
+ * @brief Keys. Append new ones at the end, the numbers are stored in flash.
+ */
+typedef enum
+{
+  KVSTORE_KEY_LED_ON_MS,
+  KVSTORE_KEY_LOG_THRESHOLD,
+  KVSTORE_KEY_LED_PWM,
+  KVSTORE_KEY_BUTTON_PULSE_MS,
+  KVSTORE_KEY_BUTTON_SHORT_MS,
+  KVSTORE_KEY_BUTTON_LONG_MS,
+  KVSTORE_KEY__N,
+} kvstore_key_t;
+
+typedef struct
+{
+  uint32_t generation;    /**< Compactions since the sectors were formatted */
+  uint32_t used_bytes;    /**< Of the active sector */
+  uint32_t records;       /**< Appended since boot */
+  uint32_t compactions;
+  uint32_t erases;
+  uint32_t torn;          /**< Records dropped at boot */
+  uint32_t errors;        /**< Failed programs or erases */
+} kvstore_stats_t;
+
+/********************** external data declaration ****************************/
+
+/********************** external functions declaration ***********************/
+
+/**
+ * @brief Loads the table from flash and creates the background task. Call
+ *        from app_init() after crc_init(), before the modules restoring their
+ *        tunables.
+ */
+void kvstore_init(void);
+
+/**
+ * @brief Copies the value of a key. Any context: tasks, and interrupts at or
+ *        below configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY.
+ *
+ * @param key  Key.
+ * @param data Destination, at least KVSTORE_CONFIG_VALUE_MAX bytes.
+ * @return Value length, 0 if the key was never written.
+ */
+uint32_t kvstore_get(kvstore_key_t key, void *data);
+
+/**
+ * @brief Sets the value of a key, written to flash in the background. Task
+ *        context. Writing the value a key already has costs nothing.
+ *
+ * @return false if the key or length are out of range.
+ */
+bool kvstore_set(kvstore_key_t key, const void *data, uint32_t len);
+
+/**
+ * @brief kvstore_get() for 4-byte values.
+ *
+ * @return false if the key was never written as a 4-byte value.
+ */
+bool kvstore_get_u32(kvstore_key_t key, uint32_t *value);
+
+/**
+ * @brief kvstore_set() for 4-byte values.
+ */
+bool kvstore_set_u32(kvstore_key_t key, uint32_t value);
+
+/**
+ * @brief Copies the statistics.
+ */
+void kvstore_get_stats(kvstore_stats_t *stats);
+
+/********************** End of CPP guard *************************************/
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KVSTORE_H_ */
+/********************** end of file ******************************************/
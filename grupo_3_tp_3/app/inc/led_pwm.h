@@ -0,0 +1,126 @@
+/**
+ * @file led_pwm.h
+ * @brief Hardware PWM brightness and fades for LD1, LD2 and LD3
+ *
+ * An alternate way of driving the board LEDs: once enabled, their pins are
+ * taken from GPIO and given to timer PWM channels, at 1 kHz with 1000 steps.
+ * Brightness is a perceived level, 0 to 255, corrected with a gamma curve.
+ *
+ * A fade moves a LED from its current level to another one over a duration.
+ * The compare values of the whole fade are produced in a small ring that a
+ * DMA stream writes into the compare register on every PWM period, so each
+ * step costs nothing; the CPU only refills half of the ring every
+ * LED_PWM_CONFIG_HALF_BUFFER periods.
+ *
+ * While enabled, led_wave.h has no visible effect.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+#ifndef LED_PWM_H_
+#define LED_PWM_H_
+
+/********************** CPP guard ********************************************/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/********************** inclusions *******************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "cmsis_os.h"
+
+/********************** macros ***********************************************/
+#define LED_PWM_CONFIG_ENABLE           (1)
+#define LED_PWM_CONFIG_FREQUENCY_HZ     (1000)  /**< Also the fade step rate */
+#define LED_PWM_CONFIG_RESOLUTION       (1000)  /**< Compare steps per period */
+#define LED_PWM_CONFIG_GAMMA            (2.2f)
+#define LED_PWM_CONFIG_HALF_BUFFER      (32)    /**< Fade steps per refill */
+#define LED_PWM_CONFIG_IRQ_PRIORITY     (5)     /**< Highest allowed to call FromISR APIs */
+
+#define LED_PWM_LEVEL_MAX               (255U)
+
+/********************** typedef **********************************************/
+
+typedef enum
+{
+  LED_PWM_LD1,   /**< PB0, TIM3 channel 3 */
+  LED_PWM_LD2,   /**< PB7, TIM4 channel 2 */
+  LED_PWM_LD3,   /**< PB14, TIM12 channel 1 */
+  LED_PWM__N,
+} led_pwm_led_t;
+
+/********************** external data declaration ****************************/
+
+/********************** external functions declaration ***********************/
+
+/**
+ * @brief Sets up the timers and DMA streams, LEDs still on GPIO. Call before
+ *        osKernelStart().
+ */
+void led_pwm_init(void);
+
+/**
+ * @brief Gives the LED pins to the PWM channels, or back to GPIO (all off).
+ */
+void led_pwm_enable(bool enable);
+
+/**
+ * @brief Whether the LEDs are driven by PWM.
+ */
+bool led_pwm_enabled(void);
+
+/**
+ * @brief Sets a level right away, ending any fade of the LED.
+ */
+void led_pwm_set(led_pwm_led_t led, uint8_t level);
+
+/**
+ * @brief Fades a LED from its current level. Task context only.
+ *
+ * A fade still running on the LED is replaced, starting from where it got.
+ *
+ * @param led         LED.
+ * @param level       Final level.
+ * @param duration_ms Length of the fade, 0 to set the level right away.
+ */
+void led_pwm_fade(led_pwm_led_t led, uint8_t level, uint32_t duration_ms);
+
+/**
+ * @brief Blocks until the fade of a LED ends.
+ *
+ * @return false on timeout.
+ */
+bool led_pwm_wait(led_pwm_led_t led, TickType_t timeout);
+
+/**
+ * @brief Current level of a LED, the one reached so far while fading.
+ */
+uint8_t led_pwm_get(led_pwm_led_t led);
+
+/**
+ * @brief DMA1 stream 0 interrupt (LD3).
+ */
+void led_pwm_stream0_irq_handler(void);
+
+/**
+ * @brief DMA1 stream 2 interrupt (LD1).
+ */
+void led_pwm_stream2_irq_handler(void);
+
+/**
+ * @brief DMA1 stream 6 interrupt (LD2).
+ */
+void led_pwm_stream6_irq_handler(void);
+
+/********************** End of CPP guard *************************************/
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LED_PWM_H_ */
+/********************** end of file ******************************************/
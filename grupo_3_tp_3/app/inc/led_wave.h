@@ -0,0 +1,121 @@
+/**
+ * @file led_wave.h
+ * @brief LED waveform engine: timer-paced DMA writes to GPIOB->BSRR
+ *
+ * A pattern is turned into a buffer of BSRR words, one per step, setting or
+ * resetting every LED of the pattern. TIM8 paces the steps and each of its
+ * periods requests a DMA2 transfer of the next word into GPIOB->BSRR, so
+ * blinking and PWM-like patterns play with no CPU involvement. Patterns
+ * repeated a finite number of times cost one interrupt per repetition and
+ * end with their LEDs off.
+ *
+ * Each LED of a pattern is a square wave in steps: on for `on` steps out of
+ * every `period`, delayed by `phase`. A few examples:
+ * - blink at 1 Hz: step 50 ms, length 20, period 20, on 10;
+ * - 30 % brightness: step 100 us, length 10, period 10, on 3 (1 kHz);
+ * - on for 2 s once: step 2 s, length 1, period 1, on 1, repeat 1.
+ *
+ * Only LD1, LD2 and LD3, all on GPIOB, can be driven. One pattern plays at
+ * a time; starting another one replaces it.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+#ifndef LED_WAVE_H_
+#define LED_WAVE_H_
+
+/********************** CPP guard ********************************************/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/********************** inclusions *******************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "cmsis_os.h"
+
+/********************** macros ***********************************************/
+#define LED_WAVE_CONFIG_ENABLE          (1)
+#define LED_WAVE_CONFIG_MAX_STEPS       (256)  /**< Words of the BSRR buffer */
+#define LED_WAVE_CONFIG_IRQ_PRIORITY    (5)    /**< Highest allowed to call FromISR APIs */
+
+#define LED_WAVE_MAX_CHANNELS           (3U)
+#define LED_WAVE_STEP_MIN_US            (10U)
+#define LED_WAVE_STEP_MAX_US            (6553600U)  /**< Above 65536 us, a multiple of 100 us */
+
+/********************** typedef **********************************************/
+
+typedef struct
+{
+  uint16_t pin;      /**< LD1_Pin, LD2_Pin or LD3_Pin */
+  uint16_t period;   /**< Steps, 0 keeps the LED off */
+  uint16_t on;       /**< Steps on at the start of each period */
+  uint16_t phase;    /**< Steps the wave is delayed by */
+} led_wave_channel_t;
+
+typedef struct
+{
+  uint32_t           step_us;
+  uint16_t           length;     /**< Steps, at most LED_WAVE_CONFIG_MAX_STEPS */
+  uint16_t           repeat;     /**< Times played, 0 forever */
+  uint8_t            channels;   /**< Used entries of channel */
+  led_wave_channel_t channel[LED_WAVE_MAX_CHANNELS];
+} led_wave_pattern_t;
+
+/********************** external data declaration ****************************/
+
+/********************** external functions declaration ***********************/
+
+/**
+ * @brief Sets up TIM8 and the DMA stream. Call before osKernelStart().
+ */
+void led_wave_init(void);
+
+/**
+ * @brief Whether a pattern is in range: step, length, channels, pins and
+ *        on <= period. The check led_wave_play() makes.
+ */
+bool led_wave_valid(const led_wave_pattern_t *pattern);
+
+/**
+ * @brief Builds the buffer of a pattern and starts playing it. Task context only.
+ *
+ * The pattern is not referenced once the call returns.
+ *
+ * @return false if the pattern is out of range.
+ */
+bool led_wave_play(const led_wave_pattern_t *pattern);
+
+/**
+ * @brief Stops the pattern and turns its LEDs off. Task context only.
+ */
+void led_wave_stop(void);
+
+/**
+ * @brief Blocks until the pattern playing ends or is stopped.
+ *
+ * @return false on timeout.
+ */
+bool led_wave_wait(TickType_t timeout);
+
+/**
+ * @brief Total duration of a pattern in microseconds, 0 if it plays forever.
+ */
+uint64_t led_wave_duration_us(const led_wave_pattern_t *pattern);
+
+/**
+ * @brief DMA2 stream 2 interrupt.
+ */
+void led_wave_dma_irq_handler(void);
+
+/********************** End of CPP guard *************************************/
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LED_WAVE_H_ */
+/********************** end of file ******************************************/
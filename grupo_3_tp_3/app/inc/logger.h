@@ -54,6 +54,12 @@ extern "C" {
 #define LOGGER_CONFIG_ENABLE                    (1)
 #define LOGGER_CONFIG_MAXLEN                    (64)
 #define LOGGER_CONFIG_USE_SEMIHOSTING           (1)
+#define LOGGER_CONFIG_USE_TELEMETRY             (1)  /**< Also stream over UDP, see telemetry.h */
+
+/* Message levels, LOGGER_INFO() and LOGGER_WARN() are only printed when their
+   level is at or above the runtime threshold, see logger_set_threshold(). */
+#define LOGGER_LEVEL_INFO                       (0)
+#define LOGGER_LEVEL_WARN                       (1)
 
 #if 1 == LOGGER_CONFIG_ENABLE
 #define LOGGER_LOG(...)\
@@ -67,10 +73,19 @@ extern "C" {
 #define LOGGER_LOG(...)
 #endif
 
-#define LOGGER_INFO(...)\
-    LOGGER_LOG("[info] ");\
-    LOGGER_LOG(__VA_ARGS__);\
-    LOGGER_LOG("\n");
+#define LOGGER_LEVEL_(level, tag, ...)\
+    do\
+    {\
+        if ((level) >= logger_threshold)\
+        {\
+            LOGGER_LOG(tag);\
+            LOGGER_LOG(__VA_ARGS__);\
+            LOGGER_LOG("\n");\
+        }\
+    } while (0)
+
+#define LOGGER_INFO(...)    LOGGER_LEVEL_(LOGGER_LEVEL_INFO, "[info] ", __VA_ARGS__)
+#define LOGGER_WARN(...)    LOGGER_LEVEL_(LOGGER_LEVEL_WARN, "[warn] ", __VA_ARGS__)
 
 #define GET_NAME(var)  #var
 
@@ -78,11 +93,14 @@ extern "C" {
 
 extern char* const logger_msg;
 extern int logger_msg_len; // only for debug information
+extern volatile int logger_threshold;
 
 /********************** external functions declaration ***********************/
 
 void logger_log_print_(char* const msg);
 
+void logger_set_threshold(int level);
+
 /********************** End of CPP guard *************************************/
 #ifdef __cplusplus
 }
@@ -0,0 +1,104 @@
+/**
+ * @file monoclock.h
+ * @brief Unified 64-bit monotonic clock
+ *
+ * Single timebase for instrumentation, logging and timeouts:
+ *
+ * - now_us():     microseconds since monoclock_init(). TIM5 runs free at
+ *                 1 MHz over 32 bits and its update (overflow) interrupt
+ *                 extends it to 64 bits.
+ * - now_cycles(): CPU cycles since monoclock_init(). DWT->CYCCNT wraps every
+ *                 ~25 s at 168 MHz, so TIM5 channel 4 publishes a new
+ *                 64-bit cycle epoch every MONOCLOCK_EPOCH_US.
+ *
+ * Both readers are lock-free (no interrupt masking, they retry if an update
+ * raced with them) and can be called from any task or interrupt.
+ *
+ * monoclock owns TIM5 and the DWT cycle counter: nobody else may reset or
+ * reload them (cycle_counter_reset() and cycle_counter_init() from dwt.h must
+ * not be used any more). Other TIM5 users, such as hrtimer.h, only configure
+ * their own compare channel.
+ *
+ * The HAL tick (HAL_GetTick(), TIM1) and the FreeRTOS tick are unchanged.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+#ifndef MONOCLOCK_H_
+#define MONOCLOCK_H_
+
+/********************** CPP guard ********************************************/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/********************** inclusions *******************************************/
+#include <stdint.h>
+
+#include "main.h"
+
+/********************** macros ***********************************************/
+#define MONOCLOCK_CONFIG_IRQ_PRIORITY   (5)  /**< Highest allowed to call FromISR APIs */
+#define MONOCLOCK_EPOCH_US              (1UL << 23) /**< ~8.4 s, below the CYCCNT wrap */
+
+/********************** typedef **********************************************/
+
+/********************** external data declaration ****************************/
+extern TIM_HandleTypeDef htim5;
+
+/********************** external functions declaration ***********************/
+
+/**
+ * @brief Starts TIM5 and the cycle counter. Call first in app_init().
+ */
+void monoclock_init(void);
+
+/**
+ * @brief Microseconds since monoclock_init().
+ */
+uint64_t now_us(void);
+
+/**
+ * @brief CPU cycles since monoclock_init().
+ */
+uint64_t now_cycles(void);
+
+/**
+ * @brief Low 32 bits of now_us(): a single register read, wraps every ~71 min.
+ */
+static inline uint32_t now_us32(void)
+{
+  return TIM5->CNT;
+}
+
+/**
+ * @brief Low 32 bits of now_cycles(): a single register read, for short deltas.
+ */
+static inline uint32_t now_cycles32(void)
+{
+  return DWT->CYCCNT;
+}
+
+/**
+ * @brief Converts a cycle count to microseconds.
+ */
+static inline uint64_t cycles_to_us(uint64_t cycles)
+{
+  return cycles / (SystemCoreClock / 1000000U);
+}
+
+/**
+ * @brief TIM5 update and channel 4 handler, called from TIM5_IRQHandler().
+ */
+void monoclock_irq_handler(void);
+
+/********************** End of CPP guard *************************************/
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MONOCLOCK_H_ */
+/********************** end of file ******************************************/
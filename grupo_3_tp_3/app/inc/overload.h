@@ -0,0 +1,114 @@
+/**
+ * @file overload.h
+ * @brief Overload controller with progressive load shedding
+ *
+ * A periodic task samples the CPU load (idle task share of the run time
+ * counter), the fill level of the AO UI queue and of the AO LED priority
+ * queue, and the deadline misses reported by the AOs. From those it derives
+ * a target level and moves towards it one level per period on the way up,
+ * and one level every OVERLOAD_CONFIG_RESTORE_PERIODS quiet periods on the
+ * way down. Each level adds an action to the previous ones:
+ *
+ * 1. OVERLOAD_LEVEL_DROP_LOW:  LOW_PRIORITY events are not forwarded.
+ * 2. OVERLOAD_LEVEL_QUIET_LOG: log threshold raised to LOGGER_LEVEL_WARN.
+ * 3. OVERLOAD_LEVEL_SHORT_LED: LED on period cut to OVERLOAD_CONFIG_SHORT_LED_MS.
+ *
+ * Every level change is logged with LOGGER_WARN() and counted.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+#ifndef OVERLOAD_H_
+#define OVERLOAD_H_
+
+/********************** CPP guard ********************************************/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/********************** inclusions *******************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "priority_queue.h"
+
+/********************** macros ***********************************************/
+#define OVERLOAD_CONFIG_ENABLE              (1)
+#define OVERLOAD_CONFIG_PERIOD_MS           (100)
+#define OVERLOAD_CONFIG_RESTORE_PERIODS     (20)   /**< Quiet periods per step down */
+#define OVERLOAD_CONFIG_SHORT_LED_MS        (1000)
+
+/* Thresholds to enter each level, any input above its threshold counts */
+#define OVERLOAD_CONFIG_CPU_PCT_L1          (70)
+#define OVERLOAD_CONFIG_CPU_PCT_L2          (85)
+#define OVERLOAD_CONFIG_CPU_PCT_L3          (95)
+#define OVERLOAD_CONFIG_QUEUE_PCT_L1        (50)
+#define OVERLOAD_CONFIG_QUEUE_PCT_L2        (80)
+#define OVERLOAD_CONFIG_QUEUE_PCT_L3        (100)
+#define OVERLOAD_CONFIG_MISSES_L1           (1)    /**< Per period */
+#define OVERLOAD_CONFIG_MISSES_L3           (3)
+
+/********************** typedef **********************************************/
+
+typedef enum
+{
+  OVERLOAD_LEVEL_NORMAL,
+  OVERLOAD_LEVEL_DROP_LOW,
+  OVERLOAD_LEVEL_QUIET_LOG,
+  OVERLOAD_LEVEL_SHORT_LED,
+  OVERLOAD_LEVEL__N,
+} overload_level_t;
+
+typedef struct
+{
+  overload_level_t level;
+  uint32_t cpu_load_pct;                      /**< Last period */
+  uint32_t queue_fill_pct;                    /**< Last period, fullest queue or block pool */
+  uint32_t deadline_misses;                   /**< Total */
+  uint32_t dropped_low;                       /**< Total LOW events shed */
+  uint32_t entered[OVERLOAD_LEVEL__N];        /**< Times each level was entered */
+} overload_stats_t;
+
+/********************** external data declaration ****************************/
+
+/********************** external functions declaration ***********************/
+
+/**
+ * @brief Creates the controller task. Call after the AOs are initialised.
+ */
+void overload_init(void);
+
+/**
+ * @brief Current level.
+ */
+overload_level_t overload_level(void);
+
+/**
+ * @brief Asks whether an event of the given priority must be shed.
+ *
+ * Counts the event as dropped when it returns true.
+ */
+bool overload_drop(pq_priority_t priority);
+
+/**
+ * @brief Reports an event that missed its deadline or could not be queued.
+ *
+ * Callable from tasks and from interrupts.
+ */
+void overload_deadline_miss(void);
+
+/**
+ * @brief Copies the controller statistics.
+ */
+void overload_get_stats(overload_stats_t *stats);
+
+/********************** End of CPP guard *************************************/
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OVERLOAD_H_ */
+/********************** end of file ******************************************/
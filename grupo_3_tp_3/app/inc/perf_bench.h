@@ -0,0 +1,97 @@
+/**
+ * @file perf_bench.h
+ * @brief Boot-time benchmark of the hot paths
+ *
+ * Runs once after the scheduler starts, as a low priority deferred job, and
+ * times:
+ * - a priority queue send and receive with 1, half and all of the
+ *   PQ_MAX_EVENT_SIZE events queued, the path of every AO dispatch;
+ * - a dispatch of the UI AO, one message through an elastic queue;
+ * - the formatting of a typical log line and its commit, logger_log_print_();
+ * - a poll of the button debouncer, task_button_step();
+ * - a pin read and the timebase interrupt dispatch, through the HAL and
+ *   through fastio.h;
+ * - the USART3 interrupt, the HAL dispatch against the IDLE fast path of
+ *   uart_rx.h.
+ *
+ * Each result, in cycles, is the best of several runs, so interrupts do not
+ * show, and is logged. A case with a baseline in perf_bench.c is checked
+ * against it: a result above the baseline plus
+ * PERF_BENCH_CONFIG_TOLERANCE_PCT is a regression, logged as a warning, and
+ * with PERF_BENCH_CONFIG_STRICT an assertion. No board baselines are checked
+ * in yet, so on target the suite only measures: copy them from the log of a
+ * reference build to turn the check on.
+ *
+ * The regression gate is host/bench, a test of the host build: it runs the
+ * cases that do not need the hardware against baselines of its own.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+#ifndef PERF_BENCH_H_
+#define PERF_BENCH_H_
+
+/********************** CPP guard ********************************************/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/********************** inclusions *******************************************/
+#include <stdint.h>
+
+/********************** macros ***********************************************/
+#define PERF_BENCH_CONFIG_ENABLE        (1)
+#define PERF_BENCH_CONFIG_RUNS          (16)    /**< Best of */
+#define PERF_BENCH_CONFIG_TOLERANCE_PCT (10)
+#define PERF_BENCH_CONFIG_STRICT        (0)     /**< 1 asserts on a regression */
+
+/********************** typedef **********************************************/
+
+typedef enum
+{
+  PERF_BENCH_PQ_1,          /**< Send and receive, queue empty otherwise */
+  PERF_BENCH_PQ_HALF,       /**< Per event, PQ_MAX_EVENT_SIZE / 2 queued */
+  PERF_BENCH_PQ_FULL,       /**< Per event, PQ_MAX_EVENT_SIZE queued */
+  PERF_BENCH_AO_UI,         /**< Per message, elastic queue send and receive */
+  PERF_BENCH_LOG_FORMAT,    /**< snprintf() of a log line */
+  PERF_BENCH_LOG_COMMIT,    /**< logger_log_print_() of a log line */
+  PERF_BENCH_BUTTON_STEP,   /**< Per poll of task_button_step(), half pressed */
+  PERF_BENCH_PIN_HAL,       /**< HAL_GPIO_ReadPin() */
+  PERF_BENCH_PIN_FAST,      /**< fastio_read() */
+  PERF_BENCH_TICK_HAL,      /**< HAL_TIM_IRQHandler() of the timebase, no flag set */
+  PERF_BENCH_TICK_FAST,     /**< fastio_tim_update(), no flag set */
+  PERF_BENCH_UART_HAL,      /**< HAL_UART_IRQHandler() of USART3, no flag set */
+  PERF_BENCH_UART_FAST,     /**< uart_rx_idle_event(), no new byte */
+  PERF_BENCH__N,
+} perf_bench_case_t;
+
+typedef struct
+{
+  uint32_t cycles[PERF_BENCH__N];   /**< 0 until run */
+  uint32_t regressions;             /**< Bit per case over its baseline */
+} perf_bench_results_t;
+
+/********************** external data declaration ****************************/
+
+/********************** external functions declaration ***********************/
+
+/**
+ * @brief Schedules the benchmark. Call from app_init() after deferred_init().
+ */
+void perf_bench_init(void);
+
+/**
+ * @brief Copies the results of the last run.
+ */
+void perf_bench_get_results(perf_bench_results_t *results);
+
+/********************** End of CPP guard *************************************/
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PERF_BENCH_H_ */
+/********************** end of file ******************************************/
@@ -11,6 +11,9 @@
  * and receive events from the queue. The library is thread-safe, utilizing FreeRTOS
  * mutexes and semaphores to synchronize access to the queue.
  *
+ * The heap is stored in segments taken from blockpool.h as it grows and given back
+ * as it shrinks, so PQ_MAX_EVENT_SIZE is a cap rather than a reservation.
+ *
  * @authors 
  * - Marco Rolón Radcenco
  * - Pablo Eduardo Gimenez
@@ -21,6 +24,7 @@
 #define PRIORITY_QUEUE_H
 
 #include "cmsis_os.h"
+#include "blockpool.h"
 
 /**
  * @brief Priority levels for events.
@@ -38,7 +42,8 @@ pq_priority_t;
  */
 typedef struct 
 {
-    pq_priority_t priority; /**< Priority of the event */
+    pq_priority_t priority;     /**< Priority of the event */
+    uint32_t      timestamp_us; /**< Time the event was produced, now_us32() */
 } 
 pq_event_t;
 
@@ -47,19 +52,27 @@ pq_event_t;
  */
 typedef int pq_size_t;
 
-#define PQ_MAX_EVENT_SIZE 10 /**< Maximum size of the priority queue */
+#define PQ_MAX_EVENT_SIZE 16 /**< Maximum size of the priority queue */
+#ifndef PQ_CHECK_HEAP
+#define PQ_CHECK_HEAP     0  /**< 1 asserts the heap order after every operation, on in the host build */
+#endif
+
+#define PQ_SEGMENT_EVENTS ((int)(BLOCKPOOL_CONFIG_BLOCK_SIZE / sizeof(pq_event_t))) /**< Events per segment */
+#define PQ_MAX_SEGMENTS   ((PQ_MAX_EVENT_SIZE + PQ_SEGMENT_EVENTS - 1) / PQ_SEGMENT_EVENTS)
 
 /**
  * @brief Structure representing the priority queue.
  *
- * The priority queue is implemented as a binary heap stored in an array. The queue
+ * The priority queue is implemented as a binary heap stored in a table of segments,
+ * event i at segments[i / PQ_SEGMENT_EVENTS][i % PQ_SEGMENT_EVENTS]. The queue
  * maintains a size indicating the number of events currently in the queue, and
  * uses a mutex and semaphore for thread-safe operations.
  */
 typedef struct 
 {
-    pq_event_t 	events[PQ_MAX_EVENT_SIZE]; /**< Array of events in the queue */
-    pq_size_t 	size;                      /**< Current size of the queue */
+    pq_event_t 	*segments[PQ_MAX_SEGMENTS]; /**< Storage of the heap, blockpool.h blocks */
+    pq_size_t 	segmentCount;               /**< Segments held */
+    pq_size_t 	size;                       /**< Current size of the queue */
 	
     SemaphoreHandle_t mutex;       /**< Mutex for synchronizing access to the queue */
     SemaphoreHandle_t eventSemaphore; /**< Semaphore for signaling event presence */
@@ -81,8 +94,9 @@ pq_handle_t *xPriorityQueueCreate(void);
  * @brief Sends an event to the priority queue.
  *
  * Inserts an event into the priority queue, maintaining the max-heap property.
- * The function is thread-safe and will block if the queue is full, until space
- * becomes available or the specified timeout period expires.
+ * The function is thread-safe and will block while another task holds the queue,
+ * until the specified timeout period expires. It fails if the queue is full or
+ * needs a segment and the block pool is empty.
  *
  * @param pq Pointer to the priority queue.
  * @param event Pointer to an event to send to the queue.
@@ -106,4 +120,27 @@ BaseType_t xPriorityQueueSend(pq_handle_t *pq, pq_event_t *event, TickType_t tic
  */
 BaseType_t xPriorityQueueReceive(pq_handle_t *pq, pq_event_t *event, TickType_t ticksToWait);
 
+/**
+ * @brief Returns the number of events currently stored in the priority queue.
+ *
+ * The value is a snapshot taken without locking, intended for monitoring.
+ *
+ * @param pq Pointer to the priority queue.
+ * @return Number of events in the queue.
+ */
+UBaseType_t uxPriorityQueueMessagesWaiting(const pq_handle_t *pq);
+
+/**
+ * @brief Copies the events stored in the priority queue without removing them.
+ *
+ * The events are copied in heap order, not in priority order.
+ *
+ * @param pq Pointer to the priority queue.
+ * @param events Array of PQ_MAX_EVENT_SIZE events to store the copy.
+ * @param count Pointer to store the number of events copied.
+ * @param ticksToWait Maximum time (in ticks) to wait for the queue to be free.
+ * @return pdPASS if the events were copied, pdFAIL otherwise.
+ */
+BaseType_t xPriorityQueuePeekAll(pq_handle_t *pq, pq_event_t *events, pq_size_t *count, TickType_t ticksToWait);
+
 #endif // PRIORITY_QUEUE_H
@@ -0,0 +1,144 @@
+/**
+ * @file remote.h
+ * @brief Framed remote command protocol over USART3
+ *
+ * Lets a host inject events into the AO pipeline, read counters and change
+ * runtime parameters, e.g. to drive load tests at full rate.
+ *
+ * Every frame is COBS encoded and terminated by a 0x00 byte. Decoded, a
+ * request is:
+ *
+ *     | seq (1) | cmd (1) | payload (0..n) | crc32 (4, little endian) |
+ *
+ * and its response:
+ *
+ *     | seq (1) | cmd | 0x80 (1) | status (1) | payload (0..n) | crc32 (4) |
+ *
+ * The CRC is the standard CRC-32 (as in zlib / Ethernet) over everything
+ * before it. Multi-byte fields are little endian.
+ *
+ * The host increments seq on every new request. A request repeating the
+ * previous seq is a retry: the stored response is sent again and the command
+ * is not executed twice. Any other jump is counted as a gap and accepted.
+ *
+ * Frames are decoded byte by byte straight from the receive ring (uart_rx.h)
+ * into a single frame buffer, and the CRC is accumulated as bytes arrive, so
+ * the only copy is the COBS decoding itself. Invalid frames are counted and
+ * dropped without response; the host times out and retries.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+#ifndef REMOTE_H_
+#define REMOTE_H_
+
+/********************** CPP guard ********************************************/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/********************** inclusions *******************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+/********************** macros ***********************************************/
+#define REMOTE_CONFIG_ENABLE            (1)
+#define REMOTE_CONFIG_MAX_FRAME         (64)    /**< Decoded bytes, seq to crc */
+#define REMOTE_CONFIG_TX_TIMEOUT_MS     (50)
+
+/********************** typedef **********************************************/
+
+typedef enum
+{
+  REMOTE_CMD_PING           = 0x01, /**< -> nothing */
+  REMOTE_CMD_POST_UI        = 0x02, /**< message (1), an ao_ui_message_t */
+  REMOTE_CMD_POST_PQ        = 0x03, /**< priority (1), a pq_priority_t */
+  REMOTE_CMD_READ_COUNTERS  = 0x04, /**< group (1), index (1) -> raw stats struct */
+  REMOTE_CMD_SET_PARAM      = 0x05, /**< param (1), value (4) */
+  REMOTE_CMD_GET_PARAM      = 0x06, /**< param (1) -> value (4) */
+  REMOTE_CMD_PRESS_BUTTON   = 0x07, /**< ms (4), a press of the user button */
+  REMOTE_CMD_WARM_RESET     = 0x08, /**< -> nothing, then a warm reset, see warmboot.h */
+  REMOTE_CMD_READ_JOURNAL   = 0x09, /**< seq (4) -> first seq (4), recorded (4), journal_record_t[] */
+  REMOTE_CMD_REPLAY_JOURNAL = 0x0A, /**< -> nothing, see journal.h; BUSY while one runs */
+} remote_cmd_t;
+
+typedef enum
+{
+  REMOTE_STATUS_OK,
+  REMOTE_STATUS_BAD_CMD,
+  REMOTE_STATUS_BAD_ARG,
+  REMOTE_STATUS_BUSY,       /**< Destination queue full, retry later */
+} remote_status_t;
+
+/**
+ * @brief Counter groups for REMOTE_CMD_READ_COUNTERS.
+ */
+typedef enum
+{
+  REMOTE_COUNTERS_REMOTE,   /**< remote_stats_t */
+  REMOTE_COUNTERS_OVERLOAD, /**< overload_stats_t */
+  REMOTE_COUNTERS_UART_RX,  /**< uart_rx_stats_t */
+  REMOTE_COUNTERS_DEFERRED, /**< deferred_stats_t, index is the deferred_prio_t */
+  REMOTE_COUNTERS_AO_LED,   /**< ao_led_stats_t, index 1 clears them once read */
+  REMOTE_COUNTERS_PERF,     /**< perf_bench_results_t */
+  REMOTE_COUNTERS_WARMBOOT, /**< warmboot_stats_t */
+  REMOTE_COUNTERS_JOURNAL,  /**< journal_stats_t */
+  REMOTE_COUNTERS_CYCLIC,   /**< cyclic_stats_t */
+  REMOTE_COUNTERS_BLOCKPOOL, /**< blockpool_stats_t */
+  REMOTE_COUNTERS__N,
+} remote_counters_t;
+
+/**
+ * @brief Parameters for REMOTE_CMD_SET_PARAM / REMOTE_CMD_GET_PARAM, kept in
+ *        kvstore.h and restored at boot.
+ */
+typedef enum
+{
+  REMOTE_PARAM_LED_ON_MS,       /**< ao_led on period, 1 to 600000 */
+  REMOTE_PARAM_LOG_THRESHOLD,   /**< LOGGER_LEVEL_INFO or LOGGER_LEVEL_WARN */
+  REMOTE_PARAM_LED_PWM,         /**< 0 ao_led on the waveform engine, 1 PWM fades */
+  REMOTE_PARAM_BUTTON_PULSE_MS, /**< Shortest press, pulse < short < long */
+  REMOTE_PARAM_BUTTON_SHORT_MS,
+  REMOTE_PARAM_BUTTON_LONG_MS,
+  REMOTE_PARAM__N,
+} remote_param_t;
+
+typedef struct
+{
+  uint32_t frames;          /**< Valid requests */
+  uint32_t retries;         /**< Repeated seq, answered from the stored response */
+  uint32_t seq_gaps;
+  uint32_t crc_errors;
+  uint32_t framing_errors;  /**< Bad COBS, too long or too short */
+  uint32_t bad_commands;
+  uint32_t busy;            /**< Events refused by a full queue */
+  uint32_t tx_errors;
+} remote_stats_t;
+
+/********************** external data declaration ****************************/
+
+/********************** external functions declaration ***********************/
+
+/**
+ * @brief Creates the protocol task, the consumer of uart_rx.
+ *
+ * Call after uart_rx_init() and after the AOs are initialised. Applies the
+ * parameters kept in kvstore.h.
+ */
+void remote_init(void);
+
+/**
+ * @brief Copies the protocol statistics.
+ */
+void remote_get_stats(remote_stats_t *stats);
+
+/********************** End of CPP guard *************************************/
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* REMOTE_H_ */
+/********************** end of file ******************************************/
@@ -0,0 +1,421 @@
+/**
+ * @file ring.h
+ * @brief Lock-free ring buffers for ISR to task handoff, header only
+ *
+ * Two bounded FIFOs of fixed-size items over caller-provided storage, a
+ * power of two items long, that never mask interrupts:
+ *
+ * - ring_spsc_t: one producer, one consumer. Each side owns its index and
+ *   only reads the other's, ordered by memory barriers.
+ * - ring_mpsc_t: any number of producers, tasks or ISRs of any priority, and
+ *   one consumer. Producers reserve positions by advancing head with
+ *   LDREX/STREX and publish each slot through its sequence number, as
+ *   described in deferred.c.
+ *
+ * Both copy items in batches (write / read) or hand out the storage itself
+ * (spans): a span is the longest contiguous run of free or filled slots, to
+ * be filled or consumed in place and then committed or released.
+ *
+ * A write or commit reports whether the consumer had drained the ring, the
+ * only case it needs waking up; the consumer drains until a read returns 0
+ * before blocking again. The barrier after each index update makes the
+ * wake-up race safe: either the producer sees the ring drained and notifies,
+ * or the consumer sees the new items.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+#ifndef RING_H_
+#define RING_H_
+
+/********************** CPP guard ********************************************/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/********************** inclusions *******************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "main.h"
+#include "cmsis_os.h"
+
+/********************** macros ***********************************************/
+
+/********************** typedef **********************************************/
+
+typedef struct
+{
+  uint8_t           *items;
+  uint32_t          item_size;
+  uint32_t          size;         /**< Items, a power of two */
+  volatile uint32_t head;         /**< Next position to fill, producer only */
+  volatile uint32_t tail;         /**< Next position to read, consumer only */
+} ring_spsc_t;
+
+typedef struct
+{
+  uint8_t           *items;
+  volatile uint32_t *seqs;        /**< One per item: pos + 1 filled, pos + size free */
+  uint32_t          item_size;
+  uint32_t          size;         /**< Items, a power of two */
+  volatile uint32_t head;         /**< Next position to reserve, producers */
+  volatile uint32_t tail;         /**< Next position to read, consumer only */
+} ring_mpsc_t;
+
+/********************** external data declaration ****************************/
+
+/********************** external functions declaration ***********************/
+
+static inline uint32_t ring_min_(uint32_t a, uint32_t b)
+{
+  return (a < b) ? a : b;
+}
+
+/* -------------------------------------------------------------------------- */
+/* Single producer, single consumer                                           */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @param items     size * item_size bytes.
+ * @param size      Items, a power of two.
+ */
+static inline void ring_spsc_init(ring_spsc_t *ring, void *items, uint32_t item_size, uint32_t size)
+{
+  configASSERT((0U < size) && (0U == (size & (size - 1U))));
+  ring->items = items;
+  ring->item_size = item_size;
+  ring->size = size;
+  ring->head = 0U;
+  ring->tail = 0U;
+}
+
+/**
+ * @brief Items in the ring, exact from either side.
+ */
+static inline uint32_t ring_spsc_count(const ring_spsc_t *ring)
+{
+  return ring->head - ring->tail;
+}
+
+/**
+ * @brief Producer: contiguous free slots, to fill in place.
+ *
+ * @return Slots in the span, 0 if the ring is full.
+ */
+static inline uint32_t ring_spsc_write_span(ring_spsc_t *ring, void **span)
+{
+  uint32_t head = ring->head;
+  uint32_t free = ring->size - (head - ring->tail);
+
+  // acquire: the slots the consumer released are not written before it is seen
+  __DMB();
+  *span = &ring->items[(head & (ring->size - 1U)) * ring->item_size];
+  return ring_min_(free, ring->size - (head & (ring->size - 1U)));
+}
+
+/**
+ * @brief Producer: publishes count items filled in the span.
+ *
+ * @return true if the consumer had drained the ring: notify it.
+ */
+static inline bool ring_spsc_commit(ring_spsc_t *ring, uint32_t count)
+{
+  uint32_t head = ring->head;
+
+  // release: the items before the index
+  __DMB();
+  ring->head = head + count;
+  __DMB();
+  return (0U < count) && (ring->tail == head);
+}
+
+/**
+ * @brief Producer: copies up to count items in.
+ *
+ * @param was_empty Set if the consumer had drained the ring: notify it.
+ * @return Items written, fewer than count if the ring filled up.
+ */
+static inline uint32_t ring_spsc_write(ring_spsc_t *ring, const void *items, uint32_t count,
+                                       bool *was_empty)
+{
+  const uint8_t *src = items;
+  uint32_t done = 0U;
+  bool empty = false;
+
+  // at most two spans, before and after the wrap
+  for (uint32_t pass = 0; (pass < 2U) && (done < count); pass++)
+  {
+    void *span;
+    uint32_t n = ring_min_(ring_spsc_write_span(ring, &span), count - done);
+
+    if (0U == n)
+    {
+      break;
+    }
+    memcpy(span, &src[done * ring->item_size], n * ring->item_size);
+    empty = ring_spsc_commit(ring, n) || empty;
+    done += n;
+  }
+  *was_empty = empty;
+  return done;
+}
+
+/**
+ * @brief Consumer: contiguous filled slots, to read in place.
+ *
+ * @return Items in the span, 0 if the ring is empty.
+ */
+static inline uint32_t ring_spsc_read_span(ring_spsc_t *ring, void **span)
+{
+  uint32_t tail = ring->tail;
+  uint32_t count = ring->head - tail;
+
+  // acquire: the items are not read before the index that published them
+  __DMB();
+  *span = &ring->items[(tail & (ring->size - 1U)) * ring->item_size];
+  return ring_min_(count, ring->size - (tail & (ring->size - 1U)));
+}
+
+/**
+ * @brief Consumer: gives back count items of the span.
+ */
+static inline void ring_spsc_release(ring_spsc_t *ring, uint32_t count)
+{
+  // release: the items are read before the producer may reuse them
+  __DMB();
+  ring->tail = ring->tail + count;
+  __DMB();
+}
+
+/**
+ * @brief Consumer: copies up to max items out.
+ *
+ * @return Items read, 0 if the ring is empty.
+ */
+static inline uint32_t ring_spsc_read(ring_spsc_t *ring, void *items, uint32_t max)
+{
+  uint8_t *dst = items;
+  uint32_t done = 0U;
+
+  for (uint32_t pass = 0; (pass < 2U) && (done < max); pass++)
+  {
+    void *span;
+    uint32_t n = ring_min_(ring_spsc_read_span(ring, &span), max - done);
+
+    if (0U == n)
+    {
+      break;
+    }
+    memcpy(&dst[done * ring->item_size], span, n * ring->item_size);
+    ring_spsc_release(ring, n);
+    done += n;
+  }
+  return done;
+}
+
+/* -------------------------------------------------------------------------- */
+/* Multiple producers, single consumer                                        */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @param items     size * item_size bytes.
+ * @param seqs      size sequence numbers.
+ * @param size      Items, a power of two.
+ */
+static inline void ring_mpsc_init(ring_mpsc_t *ring, void *items, volatile uint32_t *seqs,
+                                  uint32_t item_size, uint32_t size)
+{
+  configASSERT((0U < size) && (0U == (size & (size - 1U))));
+  ring->items = items;
+  ring->seqs = seqs;
+  ring->item_size = item_size;
+  ring->size = size;
+  for (uint32_t i = 0; i < size; i++)
+  {
+    seqs[i] = i;
+  }
+  ring->head = 0U;
+  ring->tail = 0U;
+}
+
+/**
+ * @brief Items in the ring, reserved ones included; a snapshot.
+ */
+static inline uint32_t ring_mpsc_count(const ring_mpsc_t *ring)
+{
+  return ring->head - ring->tail;
+}
+
+/**
+ * @brief Producer: reserves up to count positions, contiguous in storage if
+ *        asked to. Internal.
+ *
+ * @return Positions reserved from *pos, 0 if the ring is full.
+ */
+static inline uint32_t ring_mpsc_reserve_(ring_mpsc_t *ring, uint32_t count, bool contiguous,
+                                          uint32_t *pos)
+{
+  uint32_t head;
+  uint32_t n;
+
+  do
+  {
+    head = __LDREXW(&ring->head);
+    // the consumer frees the slots before moving tail, so these are free
+    n = ring_min_(count, ring->size - (head - ring->tail));
+    if (contiguous)
+    {
+      n = ring_min_(n, ring->size - (head & (ring->size - 1U)));
+    }
+    if (0U == n)
+    {
+      __CLREX();
+      return 0U;
+    }
+  } while (0U != __STREXW(head + n, &ring->head));
+
+  // acquire: the slots are not written before they are seen free
+  __DMB();
+  *pos = head;
+  return n;
+}
+
+static inline uint8_t *ring_mpsc_slot_(ring_mpsc_t *ring, uint32_t pos)
+{
+  return &ring->items[(pos & (ring->size - 1U)) * ring->item_size];
+}
+
+/**
+ * @brief Producer: reserves contiguous slots, to fill in place.
+ *
+ * Other producers keep going meanwhile; the consumer stops at the first
+ * slot not yet committed, so keep the span short.
+ *
+ * @param pos Set to the position to commit.
+ * @return Slots in the span, 0 if the ring is full.
+ */
+static inline uint32_t ring_mpsc_write_span(ring_mpsc_t *ring, uint32_t count, void **span,
+                                            uint32_t *pos)
+{
+  uint32_t n = ring_mpsc_reserve_(ring, count, true, pos);
+
+  *span = ring_mpsc_slot_(ring, *pos);
+  return n;
+}
+
+/**
+ * @brief Producer: publishes count items reserved from pos.
+ *
+ * @return true if the consumer had drained the ring: notify it.
+ */
+static inline bool ring_mpsc_commit(ring_mpsc_t *ring, uint32_t pos, uint32_t count)
+{
+  // release: the items before their sequence numbers
+  __DMB();
+  for (uint32_t i = 0; i < count; i++)
+  {
+    ring->seqs[(pos + i) & (ring->size - 1U)] = pos + i + 1U;
+  }
+  __DMB();
+  return (0U < count) && (ring->tail == pos);
+}
+
+/**
+ * @brief Producer: copies up to count items in, in one reservation.
+ *
+ * @param was_empty Set if the consumer had drained the ring: notify it.
+ * @return Items written, fewer than count if the ring filled up.
+ */
+static inline uint32_t ring_mpsc_write(ring_mpsc_t *ring, const void *items, uint32_t count,
+                                       bool *was_empty)
+{
+  const uint8_t *src = items;
+  uint32_t pos;
+  uint32_t n = ring_mpsc_reserve_(ring, count, false, &pos);
+
+  for (uint32_t i = 0; i < n; i++)
+  {
+    memcpy(ring_mpsc_slot_(ring, pos + i), &src[i * ring->item_size], ring->item_size);
+  }
+  *was_empty = ring_mpsc_commit(ring, pos, n);
+  return n;
+}
+
+/**
+ * @brief Consumer: contiguous published slots, to read in place.
+ *
+ * @return Items in the span, 0 if none is published yet.
+ */
+static inline uint32_t ring_mpsc_read_span(ring_mpsc_t *ring, void **span)
+{
+  uint32_t tail = ring->tail;
+  uint32_t limit = ring->size - (tail & (ring->size - 1U));
+  uint32_t n = 0U;
+
+  while ((n < limit) && (ring->seqs[(tail + n) & (ring->size - 1U)] == (tail + n + 1U)))
+  {
+    n++;
+  }
+  // acquire: the items are not read before their sequence numbers
+  __DMB();
+  *span = ring_mpsc_slot_(ring, tail);
+  return n;
+}
+
+/**
+ * @brief Consumer: gives back count items of the span.
+ */
+static inline void ring_mpsc_release(ring_mpsc_t *ring, uint32_t count)
+{
+  uint32_t tail = ring->tail;
+
+  // release: the items are read before the producers may reuse them
+  __DMB();
+  for (uint32_t i = 0; i < count; i++)
+  {
+    ring->seqs[(tail + i) & (ring->size - 1U)] = tail + i + ring->size;
+  }
+  __DMB();
+  ring->tail = tail + count;
+  __DMB();
+}
+
+/**
+ * @brief Consumer: copies up to max items out.
+ *
+ * @return Items read, 0 if none is published yet.
+ */
+static inline uint32_t ring_mpsc_read(ring_mpsc_t *ring, void *items, uint32_t max)
+{
+  uint8_t *dst = items;
+  uint32_t done = 0U;
+
+  for (uint32_t pass = 0; (pass < 2U) && (done < max); pass++)
+  {
+    void *span;
+    uint32_t n = ring_min_(ring_mpsc_read_span(ring, &span), max - done);
+
+    if (0U == n)
+    {
+      break;
+    }
+    memcpy(&dst[done * ring->item_size], span, n * ring->item_size);
+    ring_mpsc_release(ring, n);
+    done += n;
+  }
+  return done;
+}
+
+/********************** End of CPP guard *************************************/
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RING_H_ */
+/********************** end of file ******************************************/
@@ -41,17 +41,68 @@ extern "C" {
 #endif
 
 /********************** inclusions *******************************************/
+#include <stdint.h>
+#include <stdbool.h>
 
 /********************** macros ***********************************************/
 
 /********************** typedef **********************************************/
 
+typedef enum
+{
+  TASK_BUTTON_TIMEOUT_PULSE,
+  TASK_BUTTON_TIMEOUT_SHORT,
+  TASK_BUTTON_TIMEOUT_LONG,
+  TASK_BUTTON_TIMEOUT__N,
+} task_button_timeout_t;
+
+typedef enum
+{
+  BUTTON_TYPE_NONE,
+  BUTTON_TYPE_PULSE,
+  BUTTON_TYPE_SHORT,
+  BUTTON_TYPE_LONG,
+  BUTTON_TYPE__N,
+} button_type_t;
+
+typedef struct
+{
+  uint32_t counter;     /**< Press length so far, ms */
+} task_button_state_t;
+
 /********************** external data declaration ****************************/
 
 /********************** external functions declaration ***********************/
 
 void task_button(void* argument);
 
+/**
+ * @brief Sets the press length classifying a button event.
+ *
+ * @return false unless pulse < short < long, all at least one poll period.
+ */
+bool task_button_set_timeout(task_button_timeout_t timeout, uint32_t ms);
+
+uint32_t task_button_get_timeout(task_button_timeout_t timeout);
+
+/**
+ * @brief One poll of the debouncer, as task_button() runs it every period: a
+ *        pressed button adds the period to the press length, a released one
+ *        classifies it and starts over.
+ *
+ * For the fuzz harness and the benchmarks, on a state of their own; the task
+ * keeps its state private. Start from a zeroed state.
+ */
+button_type_t task_button_step(task_button_state_t *state, bool pressed);
+
+/**
+ * @brief Simulates a press of the given length, classified on the next poll
+ *        as if the button had been released then.
+ *
+ * @return false if the previous one is still pending.
+ */
+bool task_button_press(uint32_t ms);
+
 /********************** End of CPP guard *************************************/
 #ifdef __cplusplus
 }
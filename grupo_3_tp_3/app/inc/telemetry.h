@@ -0,0 +1,116 @@
+/**
+ * @file telemetry.h
+ * @brief Log and trace streams over UDP
+ *
+ * Two rings, filled from anywhere and streamed to a UDP peer by the telemetry
+ * task:
+ * - log: the text printed by the logger, sent as is to TELEMETRY_CONFIG_LOG_PORT;
+ * - trace: fixed-size binary records (telemetry_record_t, little endian) with
+ *   a microsecond timestamp, sent to TELEMETRY_CONFIG_TRACE_PORT. A datagram
+ *   always holds whole records.
+ *
+ * Datagrams point straight into the rings (udp_send() spans), the space is
+ * only given back to the producers once the frame has left. Producers never
+ * wait: what does not fit is dropped and counted.
+ *
+ * On a host in the same subnet, `nc -lu 5001` shows the log. Together with
+ * REMOTE_CMD_PRESS_BUTTON, the button and LED records let a script drive the
+ * application and check what it did without looking at the board.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+/********************** CPP guard ********************************************/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/********************** inclusions *******************************************/
+#include <stdint.h>
+#include <stddef.h>
+
+#include "udp.h"
+
+/********************** macros ***********************************************/
+#define TELEMETRY_CONFIG_ENABLE         (1)
+#define TELEMETRY_CONFIG_PEER           UDP_BROADCAST
+#define TELEMETRY_CONFIG_LOG_PORT       (5001)
+#define TELEMETRY_CONFIG_TRACE_PORT     (5002)
+#define TELEMETRY_CONFIG_LOG_RING       (4096)  /**< Bytes, power of two */
+#define TELEMETRY_CONFIG_TRACE_RING     (4096)  /**< Bytes, power of two */
+#define TELEMETRY_CONFIG_FLUSH_MS       (20)    /**< Longest a byte waits in a ring */
+
+/********************** typedef **********************************************/
+
+/**
+ * @brief Trace record, as found in the trace datagrams.
+ */
+typedef struct
+{
+  uint32_t time_us;   /**< now_us32() */
+  uint32_t id;        /**< telemetry_trace_id_t */
+  uint32_t arg0;
+  uint32_t arg1;
+} telemetry_record_t;
+
+typedef enum
+{
+  TELEMETRY_TRACE_REMOTE_COMMAND = 1,  /**< arg0 command, arg1 status */
+  TELEMETRY_TRACE_BUTTON         = 2,  /**< arg0 1 pulse, 2 short, 3 long, arg1 press ms */
+  TELEMETRY_TRACE_LED            = 3,  /**< arg0 pq_priority_t, arg1 1 on, 0 off */
+} telemetry_trace_id_t;
+
+typedef struct
+{
+  uint32_t log_bytes;
+  uint32_t log_dropped;      /**< Bytes */
+  uint32_t trace_records;
+  uint32_t trace_dropped;    /**< Records */
+  uint32_t datagrams;
+  uint32_t send_failures;    /**< udp_send() refused, retried later */
+} telemetry_stats_t;
+
+/********************** external data declaration ****************************/
+
+/********************** external functions declaration ***********************/
+
+/**
+ * @brief Creates the telemetry task. Call after udp_init().
+ *
+ * The rings can be written before, what was logged at boot is sent first.
+ */
+void telemetry_init(void);
+
+/**
+ * @brief Sets the destination address, UDP_BROADCAST by default.
+ */
+void telemetry_set_peer(uint32_t ip);
+
+/**
+ * @brief Appends text to the log stream. Callable from tasks and interrupts.
+ */
+void telemetry_log(const char *text, size_t len);
+
+/**
+ * @brief Appends a record to the trace stream. Callable from tasks and interrupts.
+ */
+void telemetry_trace(uint32_t id, uint32_t arg0, uint32_t arg1);
+
+/**
+ * @brief Copies the statistics.
+ */
+void telemetry_get_stats(telemetry_stats_t *stats);
+
+/********************** End of CPP guard *************************************/
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TELEMETRY_H_ */
+/********************** end of file ******************************************/
@@ -0,0 +1,137 @@
+/**
+ * @file uart_rx.h
+ * @brief USART3 receive path: circular DMA with IDLE line detection
+ *
+ * DMA1 stream 1 (channel 4) writes every received byte into a ring buffer in
+ * circular mode, so the CPU is not interrupted per character. Received data
+ * is published on three events only:
+ *
+ * - half transfer and transfer complete of the DMA (the ring is half / fully
+ *   written, at most UART_RX_CONFIG_RING_SIZE / 2 bytes between interrupts);
+ * - USART IDLE line (the sender paused for one character time, which is
+ *   normally the end of a frame).
+ *
+ * The consumer reads the data in place: uart_rx_peek() returns up to two
+ * spans pointing into the ring (two when the data wraps around) and
+ * uart_rx_release() gives the bytes back. There is a single consumer, the
+ * task that calls uart_rx_wait().
+ *
+ * The DMA is never stopped to wait for the consumer: if it laps the oldest
+ * unreleased byte that data is lost, which is counted as an overrun and
+ * reported by uart_rx_release().
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+#ifndef UART_RX_H_
+#define UART_RX_H_
+
+/********************** CPP guard ********************************************/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/********************** inclusions *******************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "main.h"
+#include "cmsis_os.h"
+
+/********************** macros ***********************************************/
+#define UART_RX_CONFIG_ENABLE           (1)
+#define UART_RX_CONFIG_RING_SIZE        (1024)     /**< Bytes, power of two */
+#define UART_RX_CONFIG_BAUDRATE         (115200)   /**< Up to 5250000 (APB1 / 8) */
+#define UART_RX_CONFIG_IRQ_PRIORITY     (5)        /**< Highest allowed to call FromISR APIs */
+
+/********************** typedef **********************************************/
+
+typedef struct
+{
+  const uint8_t *data;
+  size_t         len;
+} uart_rx_span_t;
+
+typedef struct
+{
+  uint32_t bytes;        /**< Total received */
+  uint32_t idle_events;
+  uint32_t half_events;
+  uint32_t full_events;
+  uint32_t overruns;     /**< Times the DMA lapped the consumer */
+  uint32_t errors;       /**< UART errors (framing, noise, overrun, parity) */
+  uint32_t max_pending;  /**< High-water mark of unreleased bytes */
+} uart_rx_stats_t;
+
+/********************** external data declaration ****************************/
+extern UART_HandleTypeDef huart3;
+
+/********************** external functions declaration ***********************/
+
+/**
+ * @brief Attaches the DMA to USART3 and starts receiving.
+ *
+ * Call after MX_USART3_UART_Init(), before osKernelStart().
+ */
+void uart_rx_init(void);
+
+/**
+ * @brief Blocks the calling task until there is unreleased data.
+ *
+ * The calling task becomes the consumer notified by the interrupts.
+ *
+ * @return Bytes pending, 0 on timeout.
+ */
+size_t uart_rx_wait(TickType_t timeout);
+
+/**
+ * @brief Returns the pending data without copying it.
+ *
+ * @param spans Filled with up to two spans, in order. Unused ones get len 0.
+ * @return Total bytes in the spans.
+ */
+size_t uart_rx_peek(uart_rx_span_t spans[2]);
+
+/**
+ * @brief Gives back the oldest len bytes to the DMA.
+ *
+ * @return false if the DMA overwrote data that was pending, or a UART error
+ *         restarted the reception since the last call, in which case
+ *         everything pending has been discarded.
+ */
+bool uart_rx_release(size_t len);
+
+/**
+ * @brief Copies the receive statistics.
+ */
+void uart_rx_get_stats(uart_rx_stats_t *stats);
+
+/**
+ * @brief DMA1 stream 1 interrupt.
+ */
+void uart_rx_dma_irq_handler(void);
+
+/**
+ * @brief USART3 interrupt.
+ */
+void uart_rx_uart_irq_handler(void);
+
+/**
+ * @brief What the USART3 interrupt does on an IDLE line event once the flag
+ *        is cleared: publishes the bytes the DMA wrote since the last event.
+ *        Interrupts masked. perf_bench.h times it directly, the flag cannot
+ *        be set by software.
+ */
+void uart_rx_idle_event(void);
+
+/********************** End of CPP guard *************************************/
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UART_RX_H_ */
+/********************** end of file ******************************************/
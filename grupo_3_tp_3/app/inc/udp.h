@@ -0,0 +1,132 @@
+/**
+ * @file udp.h
+ * @brief Minimal static-IP UDP/IPv4 and ARP on the raw frame driver
+ *
+ * Just enough IPv4 to send and receive UDP datagrams: a fixed address,
+ * netmask and gateway, an ARP cache that learns from requests and replies,
+ * and no fragmentation, options or ICMP.
+ *
+ * Send: the Ethernet, IPv4 and UDP headers are built in a transmit slot and
+ * the payload spans are chained after them as DMA descriptors
+ * (eth_frame_send()), so the payload is never copied. Both checksums are left
+ * at zero and inserted by the MAC (ETH_CHECKSUM_IPHDR_PAYLOAD_INSERT_PHDR_CALC
+ * in TxConfig). The payload belongs to the DMA until the sent callback.
+ *
+ * Receive: frames are parsed in the buffer the DMA wrote and the payload is
+ * handed to the handler bound to the destination port, valid during the call
+ * only. Frames with wrong IPv4 or UDP checksums are already dropped by the
+ * MAC.
+ *
+ * Addresses are in host byte order, see UDP_IP4().
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+#ifndef UDP_H_
+#define UDP_H_
+
+/********************** CPP guard ********************************************/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/********************** inclusions *******************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+/********************** macros ***********************************************/
+#define UDP_IP4(a, b, c, d)     ((((uint32_t)(a)) << 24) | (((uint32_t)(b)) << 16) | \
+                                 (((uint32_t)(c)) << 8) | ((uint32_t)(d)))
+
+#define UDP_CONFIG_ENABLE       (1)
+#define UDP_CONFIG_ADDRESS      UDP_IP4(192, 168, 1, 10)
+#define UDP_CONFIG_NETMASK      UDP_IP4(255, 255, 255, 0)
+#define UDP_CONFIG_GATEWAY      UDP_IP4(192, 168, 1, 1)
+#define UDP_CONFIG_ARP_ENTRIES  (4)
+#define UDP_CONFIG_ARP_RETRY_MS (1000)   /**< Between requests for the same address */
+#define UDP_CONFIG_TX_SLOTS     (4)      /**< Datagrams in flight */
+#define UDP_CONFIG_MAX_SPANS    (2)      /**< Payload pieces per datagram */
+#define UDP_CONFIG_BINDINGS     (4)
+
+#define UDP_BROADCAST           UDP_IP4(255, 255, 255, 255)
+#define UDP_PAYLOAD_MAX         (1472U)  /**< 1500 byte MTU, no fragmentation */
+
+/********************** typedef **********************************************/
+
+typedef struct
+{
+  const void *data;
+  uint16_t    len;
+} udp_span_t;
+
+/**
+ * @brief Payload no longer used by the DMA. Runs in task_eth, must not send.
+ */
+typedef void (*udp_sent_t)(void *arg);
+
+/**
+ * @brief Received datagram. Runs in task_eth, payload valid during the call.
+ */
+typedef void (*udp_handler_t)(uint32_t src_ip, uint16_t src_port,
+                              const uint8_t *payload, uint16_t len, void *arg);
+
+typedef struct
+{
+  uint32_t rx_datagrams;
+  uint32_t rx_arp;
+  uint32_t rx_dropped;     /**< Not for us, unbound port or malformed */
+  uint32_t tx_datagrams;
+  uint32_t tx_arp;
+  uint32_t tx_unresolved;  /**< Destination not in the ARP cache yet */
+  uint32_t tx_busy;        /**< No slot, no free descriptors or link down */
+} udp_stats_t;
+
+/********************** external data declaration ****************************/
+
+/********************** external functions declaration ***********************/
+
+/**
+ * @brief Takes over the frames received by eth_frame. Call after eth_frame_init().
+ */
+void udp_init(void);
+
+/**
+ * @brief Runs handler for the datagrams received on port.
+ *
+ * @return false if no binding is left or the port is already bound.
+ */
+bool udp_bind(uint16_t port, udp_handler_t handler, void *arg);
+
+/**
+ * @brief Sends a datagram made of the given payload spans. Task context only.
+ *
+ * When the destination is not in the ARP cache a request is sent and the
+ * call fails; the caller retries later.
+ *
+ * @param dst_ip   Destination address, UDP_BROADCAST allowed.
+ * @param dst_port Destination port.
+ * @param src_port Source port.
+ * @param spans    Payload, at most UDP_CONFIG_MAX_SPANS, UDP_PAYLOAD_MAX bytes.
+ * @param count    Number of spans.
+ * @param sent     Called once the payload is no longer used, may be NULL.
+ * @param arg      Its argument.
+ * @return false if not sent; the payload is then not used.
+ */
+bool udp_send(uint32_t dst_ip, uint16_t dst_port, uint16_t src_port,
+              const udp_span_t *spans, uint32_t count, udp_sent_t sent, void *arg);
+
+/**
+ * @brief Copies the statistics.
+ */
+void udp_get_stats(udp_stats_t *stats);
+
+/********************** End of CPP guard *************************************/
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UDP_H_ */
+/********************** end of file ******************************************/
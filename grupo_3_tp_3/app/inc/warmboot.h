@@ -0,0 +1,91 @@
+/**
+ * @file warmboot.h
+ * @brief Warm reboot: AO state carried over a reset in retained RAM
+ *
+ * The state of the LED AO (pattern, brightness, PWM mode, counters and the
+ * events still queued) is checkpointed every WARMBOOT_CONFIG_PERIOD_MS and
+ * right before warmboot_reset(), into RAM the startup code does not clear.
+ * After any reset but a power-on or brown-out one, a checkpoint with a valid
+ * CRC is restored, so a watchdog or update reset loses at most one period.
+ *
+ * A system reset also resets the peripherals, so they are always initialised
+ * again. A warm boot skips what only matters after a cold one: the boot-time
+ * benchmarks.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+#ifndef WARMBOOT_H_
+#define WARMBOOT_H_
+
+/********************** CPP guard ********************************************/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/********************** inclusions *******************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+/********************** macros ***********************************************/
+#define WARMBOOT_CONFIG_ENABLE          (1)
+#define WARMBOOT_CONFIG_PERIOD_MS       (100)
+
+/********************** typedef **********************************************/
+
+typedef struct
+{
+  bool     warm;            /**< This boot restored a checkpoint */
+  uint32_t warm_boots;      /**< In a row */
+  uint32_t reset_flags;     /**< RCC->CSR of this boot */
+  uint32_t checkpoints;     /**< Taken since boot */
+  uint32_t skipped;         /**< Queue busy, taken next period */
+} warmboot_stats_t;
+
+/********************** external data declaration ****************************/
+
+/********************** external functions declaration ***********************/
+
+/**
+ * @brief Reads the reset cause and validates the checkpoint. Call from
+ *        app_init() right after monoclock_init().
+ */
+void warmboot_init(void);
+
+/**
+ * @brief Whether this boot found a checkpoint to restore.
+ */
+bool warmboot_is_warm(void);
+
+/**
+ * @brief Restores the checkpoint, if any, and starts checkpointing. Call
+ *        from app_init() once the AOs are initialised and the stored
+ *        parameters applied.
+ */
+void warmboot_restore(void);
+
+/**
+ * @brief Takes a checkpoint now. Task context.
+ */
+void warmboot_checkpoint(void);
+
+/**
+ * @brief Takes a checkpoint and resets the MCU. Task context.
+ */
+void warmboot_reset(void);
+
+/**
+ * @brief Copies the statistics.
+ */
+void warmboot_get_stats(warmboot_stats_t *stats);
+
+/********************** End of CPP guard *************************************/
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WARMBOOT_H_ */
+/********************** end of file ******************************************/
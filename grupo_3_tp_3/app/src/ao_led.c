@@ -35,6 +35,7 @@
 /********************** inclusions *******************************************/
 
 #include <stdio.h>
+#include <string.h>
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -44,13 +45,23 @@
 #include "board.h"
 #include "logger.h"
 #include "dwt.h"
+#include "monoclock.h"
+#include "overload.h"
+#include "led_wave.h"
+#include "led_pwm.h"
+#include "telemetry.h"
 
 #include "ao_led.h"
 
 /********************** macros and definitions *******************************/
 #define QUEUE_AO_LED_LENGTH_            (10)
 #define QUEUE_AO_LED_ITEM_SIZE_         (sizeof(ao_led_message_t))
-#define LED_ON_PERIOD_TICKS_			(TickType_t)(5000U / portTICK_PERIOD_MS)
+#define LED_ON_PERIOD_US_				(5000000U)
+#define LED_FADE_MS_					(300U)
+#define EVENT_DEADLINE_US_				(10000000U) // queued + served
+#define LATENCY_FIRST_BUCKET_US_		(100U)
+#define TASK_AO_LED_STACK_				(256)
+#define STACK_MARGIN_WORDS_				(32U)	// warned below, see check_stack_()
 
 #define WAIT_TIME   0U
 
@@ -62,16 +73,29 @@ ao_led_handle_t ao_led =
 					.info[BLUE].pin 	= LD2_Pin,
 					.info[BLUE].state 	= GPIO_PIN_RESET,
 					.info[BLUE].colour 	= "BLUE",
+					.info[BLUE].pwm 	= LED_PWM_LD2,
 
 					.info[GREEN].port 	= LD1_GPIO_Port,
 					.info[GREEN].pin 	= LD1_Pin,
 					.info[GREEN].state 	= GPIO_PIN_RESET,
 					.info[GREEN].colour = "GREEN",
+					.info[GREEN].pwm 	= LED_PWM_LD1,
 					
 					.info[RED].port 	= LD3_GPIO_Port,
 					.info[RED].pin 		= LD3_Pin,
 					.info[RED].state 	= GPIO_PIN_RESET,
-					.info[RED].colour 	= "RED"
+					.info[RED].colour 	= "RED",
+					.info[RED].pwm 		= LED_PWM_LD3,
+
+					.pattern.step_us	= LED_ON_PERIOD_US_,
+					.pattern.length		= 1U,
+					.pattern.repeat		= 1U,
+					.pattern.channels	= 1U,
+					.pattern.channel[0]	= { .pin = LD1_Pin, .period = 1U, .on = 1U, .phase = 0U },
+
+					.brightness[LOW_PRIORITY]		= 32U,
+					.brightness[MEDIUM_PRIORITY]	= 112U,
+					.brightness[HIGH_PRIORITY]		= LED_PWM_LEVEL_MAX,
 				};
 
 /********************** internal functions declaration ***********************/
@@ -82,6 +106,39 @@ ao_led_handle_t ao_led =
 
 /********************** internal functions definition ************************/
 
+static void account_latency_(ao_led_handle_t *hao, uint32_t latency_us)
+{
+	uint32_t bucket = 0U;
+	uint32_t limit = LATENCY_FIRST_BUCKET_US_;
+
+	while ((bucket < (AO_LED_LATENCY_BUCKETS - 1U)) && (latency_us >= limit))
+	{
+		bucket++;
+		limit *= 10U;
+	}
+
+	taskENTER_CRITICAL();
+	hao->stats.events++;
+	hao->stats.latency[bucket]++;
+	if (latency_us > hao->stats.latency_max_us)
+	{
+		hao->stats.latency_max_us = latency_us;
+	}
+	taskEXIT_CRITICAL();
+}
+
+/* Deepest use so far: logging with printf() over semihosting, on top of a
+   context switch with the FPU state saved */
+static void check_stack_(void)
+{
+	UBaseType_t free_words = uxTaskGetStackHighWaterMark(NULL);
+
+	if (STACK_MARGIN_WORDS_ > free_words)
+	{
+		LOGGER_WARN("AO LED \t- Stack %lu words free", (unsigned long)free_words);
+	}
+}
+
 static void ao_task_(void *argument)
 {
   ao_led_handle_t *hao = (ao_led_handle_t *)argument;
@@ -91,19 +148,75 @@ static void ao_task_(void *argument)
   while (true)
   {
 	pq_event_t evt;
+	led_wave_pattern_t pattern;
 
     LOGGER_INFO("AO LED \t- Waiting event");
 
     while (pdPASS == xPriorityQueueReceive(hao->hpq, &evt, portMAX_DELAY))
     {
+		check_stack_();
 		LOGGER_INFO("AO LED \t- Receive AO_LED_MESSAGE_ON message");
 
-		HAL_GPIO_WritePin(hao->info[evt.priority].port, hao->info[evt.priority].pin, GPIO_PIN_SET);
-		LOGGER_INFO("AO LED \t- LED %s ON", hao->info[evt.priority].colour);
-		vTaskDelay(LED_ON_PERIOD_TICKS_);
+		uint32_t latency_us = now_us32() - evt.timestamp_us;
 
-		HAL_GPIO_WritePin(hao->info[evt.priority].port, hao->info[evt.priority].pin, GPIO_PIN_RESET);
+		if (EVENT_DEADLINE_US_ < latency_us)
+		{
+			overload_deadline_miss();
+		}
+		account_latency_(hao, latency_us);
+
+		taskENTER_CRITICAL();
+		pattern = hao->pattern;
+		taskEXIT_CRITICAL();
+		pattern.channels = 1U;
+		pattern.channel[0].pin = hao->info[evt.priority].pin;
+
+		// a mode change must not land between the check and the start
+		(void)xSemaphoreTake(hao->hmode, portMAX_DELAY);
+		if (led_pwm_enabled())
+		{
+			led_pwm_led_t led = hao->info[evt.priority].pwm;
+			bool faded;
+
+			// fades are timed by the hardware, the task only waits for them
+			led_pwm_fade(led, hao->brightness[evt.priority], LED_FADE_MS_);
+			(void)xSemaphoreGive(hao->hmode);
+			LOGGER_INFO("AO LED \t- LED %s ON", hao->info[evt.priority].colour);
+			telemetry_trace(TELEMETRY_TRACE_LED, (uint32_t)evt.priority, 1U);
+			(void)led_pwm_wait(led, portMAX_DELAY);
+			vTaskDelay((TickType_t)(led_wave_duration_us(&pattern) / (1000U * portTICK_PERIOD_MS)));
+
+			// leaving PWM mode has already turned the LED off
+			(void)xSemaphoreTake(hao->hmode, portMAX_DELAY);
+			faded = led_pwm_enabled();
+			if (faded)
+			{
+				led_pwm_fade(led, 0U, LED_FADE_MS_);
+			}
+			(void)xSemaphoreGive(hao->hmode);
+			if (faded)
+			{
+				(void)led_pwm_wait(led, portMAX_DELAY);
+			}
+			LOGGER_INFO("AO LED \t- LED %s OFF", hao->info[evt.priority].colour);
+			telemetry_trace(TELEMETRY_TRACE_LED, (uint32_t)evt.priority, 0U);
+			continue;
+		}
+
+		// the pattern plays on its own, the task only waits for its end
+		if (!led_wave_play(&pattern))
+		{
+			// never started, nothing would end the wait
+			(void)xSemaphoreGive(hao->hmode);
+			LOGGER_WARN("AO LED \t- LED %s pattern out of range", hao->info[evt.priority].colour);
+			continue;
+		}
+		(void)xSemaphoreGive(hao->hmode);
+		LOGGER_INFO("AO LED \t- LED %s ON", hao->info[evt.priority].colour);
+		telemetry_trace(TELEMETRY_TRACE_LED, (uint32_t)evt.priority, 1U);
+		(void)led_wave_wait(portMAX_DELAY);
 		LOGGER_INFO("AO LED \t- LED %s OFF", hao->info[evt.priority].colour);
+		telemetry_trace(TELEMETRY_TRACE_LED, (uint32_t)evt.priority, 0U);
     }
   }
 }
@@ -115,6 +228,8 @@ void ao_led_init(ao_led_handle_t* hao_led)
   // Queues
   hao_led->hpq = xPriorityQueueCreate();
   configASSERT(NULL != hao_led->hpq);
+  hao_led->hmode = xSemaphoreCreateMutex();
+  configASSERT(NULL != hao_led->hmode);
 
   // Tasks
   BaseType_t status;
@@ -122,7 +237,7 @@ void ao_led_init(ao_led_handle_t* hao_led)
 		  (
 			  ao_task_,
 			  "task_ao_led",
-			  128,
+			  TASK_AO_LED_STACK_,
 			  (void* const)hao_led,
 			  (tskIDLE_PRIORITY + 1),
 			  &hao_led->htask
@@ -133,7 +248,112 @@ void ao_led_init(ao_led_handle_t* hao_led)
 
 bool ao_led_send(ao_led_handle_t* hao_led, pq_event_t evt)
 {
-	return (pdPASS == xPriorityQueueSend(hao_led->hpq, (void*)&evt, (TickType_t)1U));
+	uint32_t waiting;
+
+	evt.timestamp_us = now_us32();
+	if (pdPASS != xPriorityQueueSend(hao_led->hpq, (void*)&evt, (TickType_t)1U))
+	{
+		// a dropped event will never meet its deadline
+		overload_deadline_miss();
+		taskENTER_CRITICAL();
+		hao_led->stats.dropped++;
+		taskEXIT_CRITICAL();
+		return false;
+	}
+
+	waiting = (uint32_t)uxPriorityQueueMessagesWaiting(hao_led->hpq);
+	taskENTER_CRITICAL();
+	if (waiting > hao_led->stats.queue_max)
+	{
+		hao_led->stats.queue_max = waiting;
+	}
+	taskEXIT_CRITICAL();
+	return true;
+}
+
+bool ao_led_set_pattern(ao_led_handle_t* hao_led, const led_wave_pattern_t *pattern)
+{
+	led_wave_pattern_t played = *pattern;
+
+	// as the task plays it: channel[0] alone, on the LED of the event
+	played.channels = 1U;
+	played.channel[0].pin = LD1_Pin;
+	if ((0U == pattern->repeat) || (0U == pattern->channels) || !led_wave_valid(&played))
+	{
+		return false;
+	}
+	taskENTER_CRITICAL();
+	hao_led->pattern = *pattern;
+	taskEXIT_CRITICAL();
+	return true;
+}
+
+void ao_led_get_pattern(ao_led_handle_t* hao_led, led_wave_pattern_t *pattern)
+{
+	taskENTER_CRITICAL();
+	*pattern = hao_led->pattern;
+	taskEXIT_CRITICAL();
+}
+
+void ao_led_set_on_period(ao_led_handle_t* hao_led, TickType_t on_period)
+{
+	led_wave_pattern_t pattern;
+	uint64_t on_us = (uint64_t)on_period * portTICK_PERIOD_MS * 1000U;
+	uint64_t repeat;
+
+	// a single step when it fits, repeated otherwise
+	ao_led_get_pattern(hao_led, &pattern);
+	repeat = (on_us / LED_WAVE_STEP_MAX_US) + 1U;
+	pattern.repeat = (uint16_t)((UINT16_MAX < repeat) ? UINT16_MAX : repeat);
+	on_us /= pattern.repeat;
+	on_us = (LED_WAVE_STEP_MAX_US < on_us) ? LED_WAVE_STEP_MAX_US : on_us;
+	pattern.step_us = (LED_WAVE_STEP_MIN_US > on_us) ? LED_WAVE_STEP_MIN_US : (uint32_t)on_us;
+	pattern.length = 1U;
+	pattern.channels = 1U;
+	pattern.channel[0].period = 1U;
+	pattern.channel[0].on = 1U;
+	pattern.channel[0].phase = 0U;
+	(void)ao_led_set_pattern(hao_led, &pattern);
+}
+
+TickType_t ao_led_get_on_period(ao_led_handle_t* hao_led)
+{
+	uint64_t duration_us;
+
+	taskENTER_CRITICAL();
+	duration_us = led_wave_duration_us(&hao_led->pattern);
+	taskEXIT_CRITICAL();
+	return (TickType_t)(duration_us / (1000U * portTICK_PERIOD_MS));
+}
+
+void ao_led_set_pwm_mode(ao_led_handle_t* hao_led, bool enable)
+{
+	// the AO task starts its outputs holding the same mutex, so it never
+	// starts one in the mode being left
+	(void)xSemaphoreTake(hao_led->hmode, portMAX_DELAY);
+	// a pattern playing would fight for the pins
+	led_wave_stop();
+	led_pwm_enable(enable);
+	(void)xSemaphoreGive(hao_led->hmode);
+}
+
+void ao_led_set_brightness(ao_led_handle_t* hao_led, pq_priority_t priority, uint8_t level)
+{
+	hao_led->brightness[priority] = level;
+}
+
+void ao_led_get_stats(ao_led_handle_t* hao_led, ao_led_stats_t *stats)
+{
+	taskENTER_CRITICAL();
+	*stats = hao_led->stats;
+	taskEXIT_CRITICAL();
+}
+
+void ao_led_reset_stats(ao_led_handle_t* hao_led)
+{
+	taskENTER_CRITICAL();
+	memset(&hao_led->stats, 0, sizeof(hao_led->stats));
+	taskEXIT_CRITICAL();
 }
 
 /********************** end of file ******************************************/
@@ -43,10 +43,12 @@
 #include "board.h"
 #include "logger.h"
 #include "dwt.h"
+#include "overload.h"
+#include "journal.h"
 #include "ao_ui.h"
 
 /********************** macros and definitions *******************************/
-#define QUEUE_AO_UI_LENGTH_            (5)
+#define QUEUE_AO_UI_LENGTH_            (16)   /**< Cap, the storage follows the occupancy */
 #define QUEUE_AO_UI_ITEM_SIZE_         (sizeof(ao_ui_message_t))
 
 /********************** internal data declaration ****************************/
@@ -75,27 +77,31 @@ static void ao_task_(void *argument)
 
 		LOGGER_INFO("AO UI\t- Waiting event");
 
-		if(pdPASS == xQueueReceive(hao_ui->hqueue, &rcvEvt, portMAX_DELAY))
+		if(elastic_queue_receive(&hao_ui->queue, &rcvEvt, portMAX_DELAY))
 		{
 			switch(rcvEvt)
 			{
 				case AO_UI_MESSAGE_PULSE:
 					sendEvt.priority = HIGH_PRIORITY;					
-					ao_led_send(&ao_led, sendEvt);
+					journal_record(JOURNAL_QUEUE_LED, JOURNAL_SOURCE_UI, sendEvt.priority, ao_led_send(&ao_led, sendEvt));
 					
 					LOGGER_INFO("AO UI\t- Send a HIGH_PRIORITY event to the priority queue");
 					break;
 
 				case AO_UI_MESSAGE_SHORT:					
 					sendEvt.priority = MEDIUM_PRIORITY;					
-					ao_led_send(&ao_led, sendEvt);
+					journal_record(JOURNAL_QUEUE_LED, JOURNAL_SOURCE_UI, sendEvt.priority, ao_led_send(&ao_led, sendEvt));
 					
 					LOGGER_INFO("AO UI\t- Send a MEDIUM_PRIORITY event to the priority queue");
 					break;
 
 				case AO_UI_MESSAGE_LONG:			
+					if (overload_drop(LOW_PRIORITY))
+					{
+						break;
+					}
 					sendEvt.priority = LOW_PRIORITY;					
-					ao_led_send(&ao_led, sendEvt);
+					journal_record(JOURNAL_QUEUE_LED, JOURNAL_SOURCE_UI, sendEvt.priority, ao_led_send(&ao_led, sendEvt));
 					
 					LOGGER_INFO("AO UI\t- Send a LOW_PRIORITY event to the priority queue");
 					break;
@@ -111,8 +117,7 @@ static void ao_task_(void *argument)
 /********************** internal functions definition ************************/
 void ao_ui_init(ao_ui_handle_t *hao_ui)
 {
-	  hao_ui->hqueue  = xQueueCreate(QUEUE_AO_UI_LENGTH_, QUEUE_AO_UI_ITEM_SIZE_);
-	  configASSERT(NULL != hao_ui->hqueue);
+	  elastic_queue_init(&hao_ui->queue, QUEUE_AO_UI_LENGTH_, QUEUE_AO_UI_ITEM_SIZE_);
 
 	  BaseType_t status;
 	  status = xTaskCreate
@@ -129,7 +134,7 @@ void ao_ui_init(ao_ui_handle_t *hao_ui)
 
 bool ao_ui_send(ao_ui_handle_t *hao_ui, ao_ui_message_t msg)
 {
-	return (pdPASS == xQueueSend(hao_ui->hqueue, (void*)&msg, (TickType_t)0U));
+	return elastic_queue_send(&hao_ui->queue, &msg);
 }
 
 /********************** end of file ******************************************/
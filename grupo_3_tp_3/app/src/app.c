@@ -43,6 +43,26 @@
 #include "task_button.h"
 #include "ao_ui.h"
 #include "ao_led.h"
+#include "fpu_bench.h"
+#include "monoclock.h"
+#include "hrtimer.h"
+#include "overload.h"
+#include "deferred.h"
+#include "uart_rx.h"
+#include "remote.h"
+#include "crc.h"
+#include "dmacopy.h"
+#include "eth_frame.h"
+#include "boot.h"
+#include "udp.h"
+#include "telemetry.h"
+#include "led_wave.h"
+#include "led_pwm.h"
+#include "kvstore.h"
+#include "perf_bench.h"
+#include "warmboot.h"
+#include "journal.h"
+#include "cyclic.h"
 
 /********************** macros and definitions *******************************/
 
@@ -59,6 +79,39 @@ void app_init(void)
 {
   BaseType_t status;
 
+  // Init timebase, must be first
+  monoclock_init();
+
+  // Check for a checkpoint from before the reset, see warmboot.h
+  warmboot_init();
+
+  // Init high-resolution timers
+  hrtimer_service_init();
+
+  // Init deferred interrupt work
+  deferred_init();
+
+  // Init CRC unit
+  crc_init();
+
+  // Init persistent tunables, restored by remote_init()
+  kvstore_init();
+
+  // Init DMA memory copies
+  dmacopy_init();
+
+  // Init UDP/IPv4 on the frame driver
+  udp_init();
+
+  // Init log and trace streaming over UDP
+  telemetry_init();
+
+  // Init USART3 receive path
+  uart_rx_init();
+
+  // Init time-triggered executive, the button task samples from it
+  cyclic_init();
+
   // Init Button
   status = xTaskCreate
 		  (
@@ -74,12 +127,37 @@ void app_init(void)
   // Init UI
   ao_ui_init(&ao_ui);
 
+  // Init LED waveform engine
+  led_wave_init();
+
+  // Init LED PWM brightness and fades, off until selected
+  led_pwm_init();
+
   // Init LEDs
   ao_led_init(&ao_led);
 
-  LOGGER_INFO("Application init ok");
+  // Init overload controller
+  overload_init();
+
+  // Init event journal replay, the AO queues are journaled from now on
+  journal_init();
+
+  // Init remote command protocol, consumes the USART3 receive path
+  remote_init();
 
-  cycle_counter_init();
+  // Restore the AO state of a warm boot, then checkpoint it periodically
+  warmboot_restore();
+
+  // Init FPU benchmark
+  fpu_bench_init();
+
+  // Init hot path benchmark, checked against its baselines
+  perf_bench_init();
+
+  // Init ETH and USB OTG in the background once running, see boot.h
+  boot_background_init();
+
+  LOGGER_INFO("Application init ok");
 }
 
 /********************** end of file ******************************************/
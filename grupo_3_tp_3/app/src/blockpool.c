@@ -0,0 +1,106 @@
+/**
+ * @file blockpool.c
+ * @brief Pool of fixed-size blocks shared by the elastic queues
+ *
+ * A free block holds the link to the next free one in its first word, so
+ * the free list costs no RAM of its own. The list is built on the first
+ * allocation; the pool needs no init call.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+/********************** inclusions *******************************************/
+#include <stddef.h>
+
+#include "main.h"
+#include "cmsis_os.h"
+
+#include "blockpool.h"
+
+/********************** macros and definitions *******************************/
+#define BLOCK_WORDS_            (BLOCKPOOL_CONFIG_BLOCK_SIZE / 4)
+
+/********************** internal data declaration ****************************/
+typedef union block_u
+{
+  union block_u *next;      /**< While free */
+  uint32_t      words[BLOCK_WORDS_];
+} block_t;
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+static struct
+{
+  block_t           blocks[BLOCKPOOL_CONFIG_BLOCKS];
+  block_t           *free;
+  bool              ready;
+  blockpool_stats_t stats;
+} pool_;
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+static void build_(void)
+{
+  for (uint32_t b = 0; b < BLOCKPOOL_CONFIG_BLOCKS; b++)
+  {
+    pool_.blocks[b].next = (b + 1U < BLOCKPOOL_CONFIG_BLOCKS) ? &pool_.blocks[b + 1U] : NULL;
+  }
+  pool_.free = &pool_.blocks[0];
+  pool_.ready = true;
+}
+
+/********************** external functions definition ************************/
+
+void *blockpool_alloc(void)
+{
+  block_t *block;
+
+  taskENTER_CRITICAL();
+  if (!pool_.ready)
+  {
+    build_();
+  }
+  block = pool_.free;
+  if (NULL != block)
+  {
+    pool_.free = block->next;
+    pool_.stats.used++;
+    if (pool_.stats.used > pool_.stats.used_max)
+    {
+      pool_.stats.used_max = pool_.stats.used;
+    }
+  }
+  else
+  {
+    pool_.stats.exhausted++;
+  }
+  taskEXIT_CRITICAL();
+  return block;
+}
+
+void blockpool_free(void *block)
+{
+  block_t *b = block;
+
+  configASSERT((b >= &pool_.blocks[0]) && (b < &pool_.blocks[BLOCKPOOL_CONFIG_BLOCKS]));
+  taskENTER_CRITICAL();
+  b->next = pool_.free;
+  pool_.free = b;
+  pool_.stats.used--;
+  taskEXIT_CRITICAL();
+}
+
+void blockpool_get_stats(blockpool_stats_t *stats)
+{
+  taskENTER_CRITICAL();
+  *stats = pool_.stats;
+  taskEXIT_CRITICAL();
+}
+
+/********************** end of file ******************************************/
@@ -0,0 +1,136 @@
+/**
+ * @file boot.c
+ * @brief Boot-time profiler and deferred peripheral initialisation
+ *
+ * The cycle counter is started here, before the monoclock takes it over, and
+ * is never reset afterwards. It wraps after about 25 s at 168 MHz, far longer
+ * than any phase.
+ *
+ * The clock switch happens inside BOOT_PHASE_CLOCK, which is converted with
+ * the HSI frequency it starts with: most of it is spent waiting for the PLL.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+/********************** inclusions *******************************************/
+#include "main.h"
+#include "cmsis_os.h"
+#include "logger.h"
+#include "eth_frame.h"
+
+#include "boot.h"
+
+/********************** macros and definitions *******************************/
+#define TASK_BOOT_PRIORITY_     (tskIDLE_PRIORITY + 1)
+#define TASK_BOOT_STACK_        (256)
+
+/********************** internal data declaration ****************************/
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+static const char *const names_[BOOT_PHASE__N] =
+{
+  "start", "monitor", "hal", "clock", "periph", "app", "kernel", "wait", "usb", "eth",
+};
+
+static struct
+{
+  uint32_t cycles[BOOT_PHASE__N];
+  uint32_t hz[BOOT_PHASE__N];     /**< Core clock when the mark was taken */
+  uint32_t marked;                /**< Bit per phase */
+} boot_;
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+#if 1 == BOOT_CONFIG_REPORT
+static void report_(void)
+{
+  LOGGER_INFO("BOOT\t- Phase      us      total");
+  for (uint32_t p = BOOT_PHASE_MONITOR; p < BOOT_PHASE__N; p++)
+  {
+    LOGGER_INFO("BOOT\t- %-7s %8lu %8lu", names_[p], (unsigned long)boot_phase_us((boot_phase_t)p),
+                (unsigned long)boot_elapsed_us((boot_phase_t)p));
+  }
+}
+#endif
+
+static void task_boot_(void *argument)
+{
+  boot_mark(BOOT_PHASE_WAIT);
+
+  MX_USB_OTG_FS_PCD_Init();
+  boot_mark(BOOT_PHASE_USB);
+
+  MX_ETH_Init();
+  eth_frame_init();
+  boot_mark(BOOT_PHASE_ETH);
+
+#if 1 == BOOT_CONFIG_REPORT
+  report_();
+#endif
+  vTaskDelete(NULL);
+}
+
+/********************** external functions definition ************************/
+
+void boot_mark(boot_phase_t phase)
+{
+#if 1 == BOOT_CONFIG_ENABLE
+  if (BOOT_PHASE_START == phase)
+  {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+  }
+  boot_.cycles[phase] = DWT->CYCCNT;
+  boot_.hz[phase] = SystemCoreClock;
+  boot_.marked |= (1UL << phase);
+#endif
+}
+
+uint32_t boot_phase_us(boot_phase_t phase)
+{
+  uint32_t mhz;
+
+  if ((BOOT_PHASE_START == phase) || (0U == (boot_.marked & (1UL << phase)))
+      || (0U == (boot_.marked & (1UL << (phase - 1)))))
+  {
+    return 0U;
+  }
+  mhz = boot_.hz[phase - 1] / 1000000U;
+  return (boot_.cycles[phase] - boot_.cycles[phase - 1]) / mhz;
+}
+
+uint32_t boot_elapsed_us(boot_phase_t phase)
+{
+  uint32_t us = 0U;
+
+  for (uint32_t p = BOOT_PHASE_MONITOR; p <= (uint32_t)phase; p++)
+  {
+    us += boot_phase_us((boot_phase_t)p);
+  }
+  return us;
+}
+
+void boot_background_init(void)
+{
+  BaseType_t status;
+
+  status = xTaskCreate
+		  (
+			  task_boot_,
+			  "task_boot",
+			  TASK_BOOT_STACK_,
+			  NULL,
+			  TASK_BOOT_PRIORITY_,
+			  NULL
+		  );
+  configASSERT(pdPASS == status);
+}
+
+/********************** end of file ******************************************/
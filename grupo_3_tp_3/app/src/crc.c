@@ -0,0 +1,358 @@
+/**
+ * @file crc.c
+ * @brief CRC-32 service on the CRC peripheral
+ *
+ * The unit has no initial value register, it always restarts from
+ * 0xFFFFFFFF. Feeding a word is linear in (register ^ word), so continuing
+ * from an arbitrary register R only takes XORing the first word with
+ * (R ^ 0xFFFFFFFF). crc_update32() uses it to pick up after the software
+ * head bytes and after previous calls.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+/********************** inclusions *******************************************/
+#include "main.h"
+#include "cmsis_os.h"
+#include "logger.h"
+
+#include "monoclock.h"
+#include "deferred.h"
+#include "warmboot.h"
+#include "crc.h"
+
+/********************** macros and definitions *******************************/
+#define RESET_VALUE_            (0xFFFFFFFFU)
+#define DMA_MAX_WORDS_          (0xFFFFU)  /**< NDTR is 16 bits */
+#define BENCH_WORDS_            (1024U)
+#define DMA_TIMEOUT_MS_         (10U)      /**< A full chunk takes under 2 ms */
+
+/********************** internal data declaration ****************************/
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+static DMA_HandleTypeDef hdma_crc_;
+
+static struct
+{
+  volatile uint32_t reserved;
+  SemaphoreHandle_t hdone;
+  volatile bool     dma_failed;  /**< Set with hdone on a transfer error */
+  crc_stats_t       stats;
+} crc_;
+
+#if 1 == CRC_CONFIG_BENCHMARK
+static uint32_t bench_buffer_[BENCH_WORDS_];
+#endif
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+static bool reserve_(void)
+{
+  do
+  {
+    if (0U != __LDREXW(&crc_.reserved))
+    {
+      __CLREX();
+      return false;
+    }
+  } while (0U != __STREXW(1U, &crc_.reserved));
+  __DMB();
+  return true;
+}
+
+static void release_(void)
+{
+  __DMB();
+  crc_.reserved = 0U;
+}
+
+static void count_(volatile uint32_t *counter)
+{
+  UBaseType_t mask;
+
+  mask = taskENTER_CRITICAL_FROM_ISR();
+  (*counter)++;
+  taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+/* Standard CRC over whole words, from the reflected register reg. Unit reserved. */
+static uint32_t feed_reflected_(uint32_t reg, const uint32_t *words, size_t count)
+{
+  CRC->CR = CRC_CR_RESET;
+  CRC->DR = __RBIT(words[0]) ^ __RBIT(reg) ^ RESET_VALUE_;
+  for (size_t i = 1; i < count; i++)
+  {
+    CRC->DR = __RBIT(words[i]);
+  }
+  return __RBIT(CRC->DR);
+}
+
+/* Native CRC, CPU fed. Unit reserved. */
+static uint32_t feed_native_(const uint32_t *words, size_t count)
+{
+  CRC->CR = CRC_CR_RESET;
+  for (size_t i = 0; i < count; i++)
+  {
+    CRC->DR = words[i];
+  }
+  return CRC->DR;
+}
+
+/* Native CRC, DMA fed, caller blocked. Unit reserved, task context only.
+ * false on a transfer error or a timeout: the unit has then been fed an
+ * unknown part of the words, the caller starts over on the CPU. */
+static bool feed_native_dma_(const uint32_t *words, size_t count, uint32_t *result)
+{
+  CRC->CR = CRC_CR_RESET;
+  while (0U < count)
+  {
+    uint32_t chunk = (DMA_MAX_WORDS_ < count) ? DMA_MAX_WORDS_ : (uint32_t)count;
+
+    crc_.dma_failed = false;
+    if (HAL_OK != HAL_DMA_Start_IT(&hdma_crc_, (uint32_t)words, (uint32_t)&CRC->DR, chunk))
+    {
+      return false;
+    }
+    if ((pdTRUE != xSemaphoreTake(crc_.hdone, pdMS_TO_TICKS(DMA_TIMEOUT_MS_))) || crc_.dma_failed)
+    {
+      (void)HAL_DMA_Abort(&hdma_crc_);
+      // a completion that raced the abort must not satisfy the next wait
+      (void)xSemaphoreTake(crc_.hdone, 0);
+      return false;
+    }
+    words += chunk;
+    count -= chunk;
+  }
+  *result = CRC->DR;
+  return true;
+}
+
+/* Native CRC, DMA fed when it works, CPU fed otherwise. Unit reserved, task
+ * context only. */
+static uint32_t feed_native_dma_or_cpu_(const uint32_t *words, size_t count)
+{
+  uint32_t result;
+
+  if (feed_native_dma_(words, count, &result))
+  {
+    count_(&crc_.stats.dma_calls);
+    return result;
+  }
+  count_(&crc_.stats.dma_errors);
+  return feed_native_(words, count);
+}
+
+static void dma_done_(DMA_HandleTypeDef *hdma)
+{
+  BaseType_t woken = pdFALSE;
+
+  (void)xSemaphoreGiveFromISR(crc_.hdone, &woken);
+  portYIELD_FROM_ISR(woken);
+}
+
+static void dma_error_(DMA_HandleTypeDef *hdma)
+{
+  BaseType_t woken = pdFALSE;
+
+  // only a transfer error stops the stream
+  if (0U == (hdma->ErrorCode & HAL_DMA_ERROR_TE))
+  {
+    return;
+  }
+  crc_.dma_failed = true;
+  (void)xSemaphoreGiveFromISR(crc_.hdone, &woken);
+  portYIELD_FROM_ISR(woken);
+}
+
+#if 1 == CRC_CONFIG_BENCHMARK
+static uint32_t mbps_x100_(uint32_t bytes, uint32_t cycles)
+{
+  return (0U == cycles) ? 0U : (uint32_t)(((uint64_t)bytes * (SystemCoreClock / 10000U)) / cycles);
+}
+
+static void log_mbps_(const char *name, uint32_t cycles)
+{
+  uint32_t mbps = mbps_x100_(sizeof(bench_buffer_), cycles);
+
+  LOGGER_INFO("CRC\t- %s %lu.%02lu MB/s", name, (unsigned long)(mbps / 100U), (unsigned long)(mbps % 100U));
+}
+
+static void benchmark_(void *arg)
+{
+  uint32_t seed = 0x12345678U;
+  uint32_t start;
+  uint32_t cycles[4];
+  uint32_t results[4];
+
+  for (uint32_t i = 0; i < BENCH_WORDS_; i++)
+  {
+    seed = (seed * 1664525U) + 1013904223U;
+    bench_buffer_[i] = seed;
+  }
+
+  start = now_cycles32();
+  results[0] = crc_update32_sw(0U, bench_buffer_, sizeof(bench_buffer_));
+  cycles[0] = now_cycles32() - start;
+
+  start = now_cycles32();
+  results[1] = crc_calc32(bench_buffer_, sizeof(bench_buffer_));
+  cycles[1] = now_cycles32() - start;
+
+  if (!reserve_())
+  {
+    LOGGER_WARN("CRC\t- Unit busy, benchmark skipped");
+    return;
+  }
+  start = now_cycles32();
+  results[2] = feed_native_(bench_buffer_, BENCH_WORDS_);
+  cycles[2] = now_cycles32() - start;
+
+  start = now_cycles32();
+  results[3] = feed_native_dma_or_cpu_(bench_buffer_, BENCH_WORDS_);
+  cycles[3] = now_cycles32() - start;
+  release_();
+
+  log_mbps_("sw", cycles[0]);
+  log_mbps_("hw", cycles[1]);
+  log_mbps_("hw native", cycles[2]);
+  log_mbps_("hw native dma", cycles[3]);
+
+  if ((results[0] != results[1]) || (results[2] != results[3]) ||
+      (results[2] != crc_stm32_sw(bench_buffer_, BENCH_WORDS_)))
+  {
+    LOGGER_WARN("CRC\t- Hardware and software results differ");
+  }
+}
+#endif
+
+/********************** external functions definition ************************/
+
+void crc_init(void)
+{
+#if 1 == CRC_CONFIG_ENABLE
+  __HAL_RCC_CRC_CLK_ENABLE();
+  __HAL_RCC_DMA2_CLK_ENABLE();
+
+  crc_.reserved = 0U;
+  crc_.hdone = xSemaphoreCreateBinary();
+  configASSERT(NULL != crc_.hdone);
+
+  // memory to memory: the "peripheral" side is the source buffer
+  hdma_crc_.Instance = DMA2_Stream1;
+  hdma_crc_.Init.Channel = DMA_CHANNEL_0;
+  hdma_crc_.Init.Direction = DMA_MEMORY_TO_MEMORY;
+  hdma_crc_.Init.PeriphInc = DMA_PINC_ENABLE;
+  hdma_crc_.Init.MemInc = DMA_MINC_DISABLE;
+  hdma_crc_.Init.PeriphDataAlignment = DMA_PDATAALIGN_WORD;
+  hdma_crc_.Init.MemDataAlignment = DMA_MDATAALIGN_WORD;
+  hdma_crc_.Init.Mode = DMA_NORMAL;
+  hdma_crc_.Init.Priority = DMA_PRIORITY_LOW;
+  hdma_crc_.Init.FIFOMode = DMA_FIFOMODE_ENABLE;
+  hdma_crc_.Init.FIFOThreshold = DMA_FIFO_THRESHOLD_FULL;
+  hdma_crc_.Init.MemBurst = DMA_MBURST_SINGLE;
+  hdma_crc_.Init.PeriphBurst = DMA_PBURST_INC4;
+  if (HAL_OK != HAL_DMA_Init(&hdma_crc_))
+  {
+    Error_Handler();
+  }
+  hdma_crc_.XferCpltCallback = dma_done_;
+  hdma_crc_.XferErrorCallback = dma_error_;
+
+  HAL_NVIC_SetPriority(DMA2_Stream1_IRQn, CRC_CONFIG_IRQ_PRIORITY, 0);
+  HAL_NVIC_EnableIRQ(DMA2_Stream1_IRQn);
+
+  configASSERT(CRC32_CHECK == crc_calc32("123456789", 9U));
+
+#if 1 == CRC_CONFIG_BENCHMARK
+  if (!warmboot_is_warm())
+  {
+    (void)deferred_post(DEFERRED_PRIO_LOW, benchmark_, NULL);
+  }
+#endif
+#endif
+}
+
+uint32_t crc_calc32(const void *data, size_t len)
+{
+  return crc_update32(0U, data, len);
+}
+
+uint32_t crc_update32(uint32_t crc, const void *data, size_t len)
+{
+  const uint8_t *p = (const uint8_t *)data;
+  size_t head = (4U - ((uintptr_t)p & 3U)) & 3U;
+  size_t count;
+
+  if ((CRC_CONFIG_HW_MIN_BYTES > len) || (head + 4U > len))
+  {
+    return crc_update32_sw(crc, p, len);
+  }
+  if (!reserve_())
+  {
+    count_(&crc_.stats.sw_fallbacks);
+    return crc_update32_sw(crc, p, len);
+  }
+
+  crc = crc_update32_sw(crc, p, head);
+  p += head;
+  len -= head;
+  count = len / 4U;
+
+  crc = ~feed_reflected_(~crc, (const uint32_t *)p, count);
+  release_();
+  count_(&crc_.stats.hw_calls);
+
+  return crc_update32_sw(crc, p + (count * 4U), len - (count * 4U));
+}
+
+uint32_t crc_stm32(const uint32_t *words, size_t count)
+{
+  uint32_t result;
+
+  if (0U == count)
+  {
+    return RESET_VALUE_;
+  }
+  if (!reserve_())
+  {
+    count_(&crc_.stats.sw_fallbacks);
+    return crc_stm32_sw(words, count);
+  }
+
+  if ((CRC_CONFIG_DMA_MIN_WORDS <= count) && !xPortIsInsideInterrupt() &&
+      (taskSCHEDULER_RUNNING == xTaskGetSchedulerState()))
+  {
+    result = feed_native_dma_or_cpu_(words, count);
+  }
+  else
+  {
+    result = feed_native_(words, count);
+    count_(&crc_.stats.hw_calls);
+  }
+  release_();
+
+  return result;
+}
+
+void crc_get_stats(crc_stats_t *stats)
+{
+  UBaseType_t mask;
+
+  mask = taskENTER_CRITICAL_FROM_ISR();
+  *stats = crc_.stats;
+  taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+void crc_dma_irq_handler(void)
+{
+  HAL_DMA_IRQHandler(&hdma_crc_);
+}
+
+/********************** end of file ******************************************/
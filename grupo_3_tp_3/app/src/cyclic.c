@@ -0,0 +1,230 @@
+/**
+ * @file cyclic.c
+ * @brief Time-triggered cyclic executive on TIM7
+ *
+ * TIM7 counts from 0 at every minor frame start, so its count when the
+ * interrupt runs is the release delay of the frame, and its count after the
+ * last job the time the frame was busy. The prescaler is the smallest that
+ * fits a minor frame in the 16-bit counter, for the finest resolution.
+ *
+ * Job budgets are checked in CPU cycles. A frame whose jobs end after the
+ * next update is an overrun: that frame start is serviced late, never
+ * skipped, so the schedule keeps its order.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+/********************** inclusions *******************************************/
+#include <stddef.h>
+
+#include "main.h"
+#include "cmsis_os.h"
+#include "logger.h"
+
+#include "monoclock.h"
+#include "fastio.h"
+#include "cyclic.h"
+
+/********************** macros and definitions *******************************/
+#define COUNTER_MAX_            (65536U)
+
+/********************** internal data declaration ****************************/
+typedef struct
+{
+  cyclic_job_t job;
+  uint8_t      offset;      /**< First minor frame */
+  uint8_t      period;      /**< In minor frames, divides CYCLIC_CONFIG_MINOR_FRAMES */
+  uint16_t     budget_us;
+} slot_t;
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+
+/* The static schedule. A job may appear once; jobs sharing a frame run in
+ * cyclic_job_t order. */
+static const slot_t schedule_[] =
+{
+  { CYCLIC_JOB_BUTTON, 0U, 1U, 20U },   /* 50 ms, the poll period of task_button.c */
+};
+
+static TIM_HandleTypeDef htim7_;
+
+static struct
+{
+  uint32_t        frame_jobs[CYCLIC_CONFIG_MINOR_FRAMES];  /**< Bit per job */
+  uint32_t        budget_cycles[CYCLIC_JOB__N];
+  cyclic_job_fn_t volatile fn[CYCLIC_JOB__N];
+  void            *arg[CYCLIC_JOB__N];
+  uint32_t        frame;
+  uint32_t        timclock;
+  uint32_t        prescaler;
+  uint32_t        period;       /**< Timer counts per minor frame */
+  uint32_t        release_max;  /**< Timer counts */
+  uint32_t        busy_max;
+  bool            running;
+  cyclic_stats_t  stats;
+} cyc_;
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+static uint32_t counts_to_ns_(uint32_t counts)
+{
+  return (uint32_t)(((uint64_t)counts * cyc_.prescaler * 1000000000ULL) / cyc_.timclock);
+}
+
+/********************** external functions definition ************************/
+
+void cyclic_init(void)
+{
+#if 1 == CYCLIC_CONFIG_ENABLE
+  uint32_t frame_clocks;
+
+  configASSERT(32U >= CYCLIC_JOB__N);
+  for (uint32_t s = 0; s < (sizeof(schedule_) / sizeof(schedule_[0])); s++)
+  {
+    const slot_t *slot = &schedule_[s];
+
+    configASSERT((CYCLIC_JOB__N > slot->job) && (0U < slot->period)
+                 && (0U == (CYCLIC_CONFIG_MINOR_FRAMES % slot->period)) && (slot->period > slot->offset));
+    for (uint32_t f = slot->offset; f < CYCLIC_CONFIG_MINOR_FRAMES; f += slot->period)
+    {
+      cyc_.frame_jobs[f] |= (1UL << slot->job);
+    }
+    cyc_.budget_cycles[slot->job] = slot->budget_us * (SystemCoreClock / 1000000U);
+  }
+
+  // APB1 timers run at twice PCLK1 whenever APB1 is divided
+  cyc_.timclock = HAL_RCC_GetPCLK1Freq();
+  if (0U != (RCC->CFGR & RCC_CFGR_PPRE1))
+  {
+    cyc_.timclock *= 2U;
+  }
+  frame_clocks = (cyc_.timclock / 1000000U) * CYCLIC_CONFIG_MINOR_US;
+  cyc_.prescaler = ((frame_clocks - 1U) / COUNTER_MAX_) + 1U;
+  while (0U != (frame_clocks % cyc_.prescaler))
+  {
+    cyc_.prescaler++;
+  }
+  cyc_.period = frame_clocks / cyc_.prescaler;
+  cyc_.stats.slack_min_ns = counts_to_ns_(cyc_.period);
+
+  __HAL_RCC_TIM7_CLK_ENABLE();
+
+  htim7_.Instance = TIM7;
+  htim7_.Init.Prescaler = cyc_.prescaler - 1U;
+  htim7_.Init.CounterMode = TIM_COUNTERMODE_UP;
+  htim7_.Init.Period = cyc_.period - 1U;
+  htim7_.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+  if (HAL_OK != HAL_TIM_Base_Init(&htim7_))
+  {
+    Error_Handler();
+  }
+
+  HAL_NVIC_SetPriority(TIM7_IRQn, CYCLIC_CONFIG_IRQ_PRIORITY, 0);
+  HAL_NVIC_EnableIRQ(TIM7_IRQn);
+  cyc_.running = true;
+  if (HAL_OK != HAL_TIM_Base_Start_IT(&htim7_))
+  {
+    Error_Handler();
+  }
+  LOGGER_INFO("CYCLIC\t- %u x %u us frames, %lu ns resolution", (unsigned)CYCLIC_CONFIG_MINOR_FRAMES,
+              (unsigned)CYCLIC_CONFIG_MINOR_US, (unsigned long)counts_to_ns_(1U));
+#endif
+}
+
+bool cyclic_register(cyclic_job_t job, cyclic_job_fn_t fn, void *arg)
+{
+  bool ok;
+
+  if ((CYCLIC_JOB__N <= job) || (NULL == fn))
+  {
+    return false;
+  }
+  taskENTER_CRITICAL();
+  ok = (NULL == cyc_.fn[job]);
+  if (ok)
+  {
+    cyc_.arg[job] = arg;
+    cyc_.fn[job] = fn;
+  }
+  taskEXIT_CRITICAL();
+  return ok;
+}
+
+bool cyclic_running(void)
+{
+  return cyc_.running;
+}
+
+void cyclic_get_stats(cyclic_stats_t *stats)
+{
+  uint32_t release_max;
+  uint32_t busy_max;
+
+  taskENTER_CRITICAL();
+  *stats = cyc_.stats;
+  release_max = cyc_.release_max;
+  busy_max = cyc_.busy_max;
+  taskEXIT_CRITICAL();
+
+  stats->release_max_ns = counts_to_ns_(release_max);
+  stats->busy_max_ns = counts_to_ns_(busy_max);
+  stats->slack_min_ns = counts_to_ns_(cyc_.period - busy_max);
+}
+
+void cyclic_irq_handler(void)
+{
+  uint32_t release = TIM7->CNT;
+  uint32_t jobs;
+  uint32_t busy;
+
+  if (!fastio_tim_update(TIM7))
+  {
+    return;
+  }
+
+  jobs = cyc_.frame_jobs[cyc_.frame];
+  while (0U != jobs)
+  {
+    uint32_t job = (uint32_t)__builtin_ctz(jobs);
+    cyclic_job_fn_t fn = cyc_.fn[job];
+
+    jobs &= jobs - 1U;
+    if (NULL != fn)
+    {
+      uint32_t start = now_cycles32();
+
+      fn(cyc_.arg[job]);
+      if ((now_cycles32() - start) > cyc_.budget_cycles[job])
+      {
+        cyc_.stats.job_overruns++;
+      }
+    }
+  }
+
+  busy = TIM7->CNT;
+  if (0U != LL_TIM_IsActiveFlag_UPDATE(TIM7))
+  {
+    // the count wrapped, the frame used all of it and more
+    cyc_.stats.overruns++;
+    busy = cyc_.period;
+  }
+  if (release > cyc_.release_max)
+  {
+    cyc_.release_max = release;
+  }
+  if (busy > cyc_.busy_max)
+  {
+    cyc_.busy_max = busy;
+  }
+  cyc_.stats.frames++;
+  cyc_.frame = (CYCLIC_CONFIG_MINOR_FRAMES - 1U == cyc_.frame) ? 0U : cyc_.frame + 1U;
+}
+
+/********************** end of file ******************************************/
@@ -0,0 +1,209 @@
+/**
+ * @file deferred.c
+ * @brief Deferred interrupt work service
+ *
+ * Each priority is a ring_mpsc_t of ring.h: ISRs and tasks post into it
+ * without masking interrupts, its worker drains it. A worker is only
+ * notified when its ring goes from drained to not, and drains it to the end
+ * before waiting again, so a burst costs one notification.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+/********************** inclusions *******************************************/
+#include "main.h"
+#include "cmsis_os.h"
+
+#include "monoclock.h"
+#include "ring.h"
+#include "deferred.h"
+
+/********************** macros and definitions *******************************/
+#define RING_MASK_              (DEFERRED_CONFIG_RING_SIZE - 1U)
+#define TASK_WORKER_STACK_      (192)
+
+#if (0 != (DEFERRED_CONFIG_RING_SIZE & RING_MASK_))
+#error "DEFERRED_CONFIG_RING_SIZE must be a power of two"
+#endif
+
+/********************** internal data declaration ****************************/
+typedef struct
+{
+  deferred_fn_t     fn;
+  void             *arg;
+  uint32_t          posted_us;
+} item_t;
+
+typedef struct
+{
+  item_t            items[DEFERRED_CONFIG_RING_SIZE];
+  volatile uint32_t seqs[DEFERRED_CONFIG_RING_SIZE];
+  ring_mpsc_t       ring;
+  TaskHandle_t      htask;
+  deferred_stats_t  stats;
+} ring_t;
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+static ring_t rings_[DEFERRED_PRIO__N];
+
+static const struct
+{
+  const char  *name;
+  UBaseType_t  priority;
+} workers_[DEFERRED_PRIO__N] =
+{
+  [DEFERRED_PRIO_HIGH]   = { "task_dfr_high", tskIDLE_PRIORITY + 5 },
+  [DEFERRED_PRIO_MEDIUM] = { "task_dfr_med",  tskIDLE_PRIORITY + 3 },
+  [DEFERRED_PRIO_LOW]    = { "task_dfr_low",  tskIDLE_PRIORITY + 2 },
+};
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+static void atomic_inc_(volatile uint32_t *value)
+{
+  uint32_t current;
+
+  do
+  {
+    current = __LDREXW(value);
+  } while (0U != __STREXW(current + 1U, value));
+}
+
+static void atomic_max_(volatile uint32_t *value, uint32_t candidate)
+{
+  uint32_t current;
+
+  do
+  {
+    current = __LDREXW(value);
+    if (candidate <= current)
+    {
+      __CLREX();
+      return;
+    }
+  } while (0U != __STREXW(candidate, value));
+}
+
+static bool post_(ring_t *ring, deferred_fn_t fn, void *arg, bool *was_empty)
+{
+  item_t item = { .fn = fn, .arg = arg, .posted_us = now_us32() };
+
+  if (0U == ring_mpsc_write(&ring->ring, &item, 1U, was_empty))
+  {
+    atomic_inc_(&ring->stats.dropped);
+    return false;
+  }
+  atomic_inc_(&ring->stats.posted);
+  atomic_max_(&ring->stats.max_depth, ring_mpsc_count(&ring->ring));
+  return true;
+}
+
+static void run_(ring_t *ring)
+{
+  item_t item;
+
+  while (0U != ring_mpsc_read(&ring->ring, &item, 1U))
+  {
+    uint32_t latency_us = now_us32() - item.posted_us;
+
+    taskENTER_CRITICAL();
+    if ((0U == ring->stats.executed) || (latency_us < ring->stats.latency_min_us))
+    {
+      ring->stats.latency_min_us = latency_us;
+    }
+    if (latency_us > ring->stats.latency_max_us)
+    {
+      ring->stats.latency_max_us = latency_us;
+    }
+    ring->stats.latency_sum_us += latency_us;
+    ring->stats.executed++;
+    taskEXIT_CRITICAL();
+
+    item.fn(item.arg);
+  }
+}
+
+static void task_worker_(void *argument)
+{
+  ring_t *ring = (ring_t *)argument;
+
+  while (true)
+  {
+    (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    run_(ring);
+  }
+}
+
+/********************** external functions definition ************************/
+
+void deferred_init(void)
+{
+#if 1 == DEFERRED_CONFIG_ENABLE
+  for (uint32_t p = 0; p < DEFERRED_PRIO__N; p++)
+  {
+    ring_t *ring = &rings_[p];
+    BaseType_t status;
+
+    ring_mpsc_init(&ring->ring, ring->items, ring->seqs, sizeof(item_t), DEFERRED_CONFIG_RING_SIZE);
+
+    status = xTaskCreate
+		  (
+			  task_worker_,
+			  workers_[p].name,
+			  TASK_WORKER_STACK_,
+			  (void* const)ring,
+			  workers_[p].priority,
+			  &ring->htask
+		  );
+    configASSERT(pdPASS == status);
+  }
+#endif
+}
+
+bool deferred_post_from_isr(deferred_prio_t prio, deferred_fn_t fn, void *arg, BaseType_t *woken)
+{
+  ring_t *ring = &rings_[prio];
+  bool was_empty;
+
+  if (!post_(ring, fn, arg, &was_empty))
+  {
+    return false;
+  }
+  if (was_empty)
+  {
+    vTaskNotifyGiveFromISR(ring->htask, woken);
+  }
+  return true;
+}
+
+bool deferred_post(deferred_prio_t prio, deferred_fn_t fn, void *arg)
+{
+  ring_t *ring = &rings_[prio];
+  bool was_empty;
+
+  if (!post_(ring, fn, arg, &was_empty))
+  {
+    return false;
+  }
+  if (was_empty)
+  {
+    xTaskNotifyGive(ring->htask);
+  }
+  return true;
+}
+
+void deferred_get_stats(deferred_prio_t prio, deferred_stats_t *stats)
+{
+  taskENTER_CRITICAL();
+  *stats = rings_[prio].stats;
+  taskEXIT_CRITICAL();
+}
+
+/********************** end of file ******************************************/
@@ -0,0 +1,416 @@
+/**
+ * @file dmacopy.c
+ * @brief Asynchronous memory copies on DMA2
+ *
+ * Streams 0 and 4 of DMA2 are used (stream 1 belongs to the CRC service).
+ * When source and destination are word aligned the streams move words and a
+ * sub-word tail is copied by the CPU at submission; otherwise they move
+ * bytes. Transfers longer than a stream can count (65535 items) are split
+ * into chunks, restarted from the completion interrupt.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+/********************** inclusions *******************************************/
+#include <string.h>
+
+#include "main.h"
+#include "cmsis_os.h"
+#include "logger.h"
+
+#include "monoclock.h"
+#include "deferred.h"
+#include "dmacopy.h"
+
+/********************** macros and definitions *******************************/
+#define STREAMS_N_              (2U)
+#define DMA_MAX_ITEMS_          (0xFFFFU)  /**< NDTR is 16 bits */
+
+#define IS_ALIGNED_(p)          (0U == ((uintptr_t)(p) & 3U))
+
+#define MEASURE_MIN_BYTES_      (32U)
+#define MEASURE_MAX_BYTES_      (2048U)
+
+/********************** internal data declaration ****************************/
+typedef struct
+{
+  DMA_HandleTypeDef  hdma;     /**< First, the HAL callbacks get its address */
+  dmacopy_request_t *req;      /**< In flight, NULL when idle */
+  uint32_t           chunk;    /**< Bytes in flight */
+  bool               words;
+} stream_t;
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+static stream_t streams_[STREAMS_N_];
+
+static struct
+{
+  dmacopy_request_t *head;     /**< Waiting for a free stream */
+  dmacopy_request_t *tail;
+  dmacopy_stats_t    stats;
+} dmacopy_;
+
+#if 1 == DMACOPY_CONFIG_MEASURE
+static uint32_t measure_src_[MEASURE_MAX_BYTES_ / 4U];
+static uint32_t measure_dst_[MEASURE_MAX_BYTES_ / 4U];
+#endif
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+static bool in_ccm_(const void *p, size_t len)
+{
+  uintptr_t start = (uintptr_t)p;
+
+  return (start <= CCMDATARAM_END) && ((start + len) > CCMDATARAM_BASE);
+}
+
+/* Must be called with interrupts masked. */
+static void start_chunk_(stream_t *stream)
+{
+  dmacopy_request_t *req = stream->req;
+  uint32_t unit = stream->words ? 4U : 1U;
+  uint32_t chunk = (req->remaining > (DMA_MAX_ITEMS_ * unit)) ? (DMA_MAX_ITEMS_ * unit) : (uint32_t)req->remaining;
+
+  MODIFY_REG(stream->hdma.Instance->CR, DMA_SxCR_PSIZE | DMA_SxCR_MSIZE,
+             stream->words ? (DMA_SxCR_PSIZE_1 | DMA_SxCR_MSIZE_1) : 0U);
+
+  stream->chunk = chunk;
+  if (HAL_OK != HAL_DMA_Start_IT(&stream->hdma, (uint32_t)req->src, (uint32_t)req->dst, chunk / unit))
+  {
+    Error_Handler();
+  }
+  req->src += chunk;
+  req->dst += chunk;
+  req->remaining -= chunk;
+}
+
+/* Must be called with interrupts masked. */
+static void start_(stream_t *stream, dmacopy_request_t *req)
+{
+  stream->req = req;
+  stream->words = IS_ALIGNED_(req->dst) && IS_ALIGNED_(req->src);
+  start_chunk_(stream);
+}
+
+static void complete_(dmacopy_request_t *req, BaseType_t *woken)
+{
+  __DMB();
+  req->done = true;
+  if (NULL != req->callback)
+  {
+    req->callback(req->arg);
+  }
+  if ((NULL != woken) && (NULL != req->htask))
+  {
+    vTaskNotifyGiveFromISR(req->htask, woken);
+  }
+}
+
+static void chunk_done_(stream_t *stream)
+{
+  BaseType_t woken = pdFALSE;
+  dmacopy_request_t *req = stream->req;
+  UBaseType_t mask;
+
+  mask = taskENTER_CRITICAL_FROM_ISR();
+  if (0U != req->remaining)
+  {
+    start_chunk_(stream);
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+    return;
+  }
+
+  dmacopy_.stats.dma_copies++;
+  stream->req = NULL;
+  if (NULL != dmacopy_.head)
+  {
+    dmacopy_request_t *next = dmacopy_.head;
+
+    dmacopy_.head = next->next;
+    if (NULL == dmacopy_.head)
+    {
+      dmacopy_.tail = NULL;
+    }
+    start_(stream, next);
+  }
+  taskEXIT_CRITICAL_FROM_ISR(mask);
+
+  complete_(req, &woken);
+  portYIELD_FROM_ISR(woken);
+}
+
+static void xfer_cplt_(DMA_HandleTypeDef *hdma)
+{
+  chunk_done_((stream_t *)hdma);
+}
+
+static void xfer_error_(DMA_HandleTypeDef *hdma)
+{
+  stream_t *stream = (stream_t *)hdma;
+  dmacopy_request_t *req = stream->req;
+
+  // only a transfer error stops the stream
+  if (0U == (hdma->ErrorCode & HAL_DMA_ERROR_TE))
+  {
+    return;
+  }
+
+  // redo the failed chunk on the CPU and carry on
+  dmacopy_cpu(req->dst - stream->chunk, req->src - stream->chunk, stream->chunk);
+  dmacopy_.stats.errors++;
+  chunk_done_(stream);
+}
+
+static void stream_init_(stream_t *stream, DMA_Stream_TypeDef *instance, IRQn_Type irq)
+{
+  // memory to memory: the "peripheral" side is the source
+  stream->hdma.Instance = instance;
+  stream->hdma.Init.Channel = DMA_CHANNEL_0;
+  stream->hdma.Init.Direction = DMA_MEMORY_TO_MEMORY;
+  stream->hdma.Init.PeriphInc = DMA_PINC_ENABLE;
+  stream->hdma.Init.MemInc = DMA_MINC_ENABLE;
+  stream->hdma.Init.PeriphDataAlignment = DMA_PDATAALIGN_WORD;
+  stream->hdma.Init.MemDataAlignment = DMA_MDATAALIGN_WORD;
+  stream->hdma.Init.Mode = DMA_NORMAL;
+  stream->hdma.Init.Priority = DMA_PRIORITY_LOW;
+  stream->hdma.Init.FIFOMode = DMA_FIFOMODE_ENABLE;
+  stream->hdma.Init.FIFOThreshold = DMA_FIFO_THRESHOLD_FULL;
+  stream->hdma.Init.MemBurst = DMA_MBURST_SINGLE;
+  stream->hdma.Init.PeriphBurst = DMA_PBURST_SINGLE;
+  if (HAL_OK != HAL_DMA_Init(&stream->hdma))
+  {
+    Error_Handler();
+  }
+  stream->hdma.XferCpltCallback = xfer_cplt_;
+  stream->hdma.XferErrorCallback = xfer_error_;
+  stream->req = NULL;
+
+  HAL_NVIC_SetPriority(irq, DMACOPY_CONFIG_IRQ_PRIORITY, 0);
+  HAL_NVIC_EnableIRQ(irq);
+}
+
+static void submit_(dmacopy_request_t *req, void *dst, const void *src, size_t len,
+                    dmacopy_callback_t callback, void *arg, bool force_dma)
+{
+  UBaseType_t mask;
+  bool in_isr = (0 != xPortIsInsideInterrupt());
+
+  req->next = NULL;
+  req->dst = (uint8_t *)dst;
+  req->src = (const uint8_t *)src;
+  req->callback = callback;
+  req->arg = arg;
+  req->done = false;
+  req->htask = (!in_isr && (taskSCHEDULER_RUNNING == xTaskGetSchedulerState())) ?
+               xTaskGetCurrentTaskHandle() : NULL;
+
+  if ((!force_dma && (dmacopy_.stats.crossover > len)) || (4U > len) ||
+      in_ccm_(dst, len) || in_ccm_(src, len))
+  {
+    dmacopy_cpu(dst, src, len);
+    mask = taskENTER_CRITICAL_FROM_ISR();
+    dmacopy_.stats.cpu_copies++;
+    dmacopy_.stats.cpu_bytes += len;
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+    complete_(req, NULL);
+    return;
+  }
+
+  // words move by DMA, the tail right now
+  if (IS_ALIGNED_(dst) && IS_ALIGNED_(src) && (0U != (len & 3U)))
+  {
+    size_t words = len & ~(size_t)3U;
+
+    dmacopy_cpu(req->dst + words, req->src + words, len - words);
+    len = words;
+  }
+  req->remaining = len;
+
+  mask = taskENTER_CRITICAL_FROM_ISR();
+  dmacopy_.stats.dma_bytes += len;
+  for (uint32_t i = 0; i < STREAMS_N_; i++)
+  {
+    if (NULL == streams_[i].req)
+    {
+      start_(&streams_[i], req);
+      taskEXIT_CRITICAL_FROM_ISR(mask);
+      return;
+    }
+  }
+  if (NULL == dmacopy_.tail)
+  {
+    dmacopy_.head = req;
+  }
+  else
+  {
+    dmacopy_.tail->next = req;
+  }
+  dmacopy_.tail = req;
+  dmacopy_.stats.queued++;
+  taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+#if 1 == DMACOPY_CONFIG_MEASURE
+/* Smallest size at which a DMA copy, completion included, is as fast as the CPU. */
+static void measure_(void *arg)
+{
+  uint32_t crossover = 0U;
+
+  for (uint32_t len = MEASURE_MIN_BYTES_; len <= MEASURE_MAX_BYTES_; len *= 2U)
+  {
+    dmacopy_request_t req;
+    uint32_t start;
+    uint32_t cpu_cycles;
+    uint32_t dma_cycles;
+
+    start = now_cycles32();
+    dmacopy_cpu(measure_dst_, measure_src_, len);
+    cpu_cycles = now_cycles32() - start;
+
+    start = now_cycles32();
+    submit_(&req, measure_dst_, measure_src_, len, NULL, NULL, true);
+    (void)dmacopy_wait(&req, portMAX_DELAY);
+    dma_cycles = now_cycles32() - start;
+
+    LOGGER_INFO("DMACOPY\t- %lu B cpu %lu dma %lu cycles", (unsigned long)len,
+                (unsigned long)cpu_cycles, (unsigned long)dma_cycles);
+    if ((0U == crossover) && (dma_cycles <= cpu_cycles))
+    {
+      crossover = len;
+    }
+  }
+
+  if (0U == crossover)
+  {
+    crossover = MEASURE_MAX_BYTES_ * 2U;
+  }
+  dmacopy_.stats.crossover = crossover;
+  LOGGER_INFO("DMACOPY\t- Crossover %lu bytes", (unsigned long)crossover);
+}
+#endif
+
+/********************** external functions definition ************************/
+
+void dmacopy_init(void)
+{
+#if 1 == DMACOPY_CONFIG_ENABLE
+  __HAL_RCC_DMA2_CLK_ENABLE();
+
+  dmacopy_.head = NULL;
+  dmacopy_.tail = NULL;
+  dmacopy_.stats.crossover = DMACOPY_CONFIG_CROSSOVER_BYTES;
+
+  stream_init_(&streams_[0], DMA2_Stream0, DMA2_Stream0_IRQn);
+  stream_init_(&streams_[1], DMA2_Stream4, DMA2_Stream4_IRQn);
+
+#if 1 == DMACOPY_CONFIG_MEASURE
+  (void)deferred_post(DEFERRED_PRIO_LOW, measure_, NULL);
+#endif
+#endif
+}
+
+void dmacopy_submit(dmacopy_request_t *req, void *dst, const void *src, size_t len,
+                    dmacopy_callback_t callback, void *arg)
+{
+  submit_(req, dst, src, len, callback, arg, false);
+}
+
+bool dmacopy_done(const dmacopy_request_t *req)
+{
+  return req->done;
+}
+
+bool dmacopy_wait(dmacopy_request_t *req, TickType_t timeout)
+{
+  TickType_t start = xTaskGetTickCount();
+
+  while (!req->done)
+  {
+    TickType_t elapsed = xTaskGetTickCount() - start;
+
+    if (elapsed >= timeout)
+    {
+      return false;
+    }
+    (void)ulTaskNotifyTake(pdTRUE, timeout - elapsed);
+  }
+  return true;
+}
+
+void dmacopy_copy(void *dst, const void *src, size_t len)
+{
+  dmacopy_request_t req;
+
+  if ((dmacopy_.stats.crossover > len) || (0 != xPortIsInsideInterrupt()) ||
+      (taskSCHEDULER_RUNNING != xTaskGetSchedulerState()))
+  {
+    dmacopy_cpu(dst, src, len);
+    return;
+  }
+  dmacopy_submit(&req, dst, src, len, NULL, NULL);
+  (void)dmacopy_wait(&req, portMAX_DELAY);
+}
+
+/* Keep GCC from turning the loops back into a memcpy() call */
+__attribute__((optimize("no-tree-loop-distribute-patterns")))
+void dmacopy_cpu(void *dst, const void *src, size_t len)
+{
+  if (IS_ALIGNED_(dst) && IS_ALIGNED_(src))
+  {
+    uint32_t *d = (uint32_t *)dst;
+    const uint32_t *s = (const uint32_t *)src;
+
+    // four words per iteration, LDM/STM friendly
+    while (16U <= len)
+    {
+      uint32_t w0 = s[0];
+      uint32_t w1 = s[1];
+      uint32_t w2 = s[2];
+      uint32_t w3 = s[3];
+
+      d[0] = w0;
+      d[1] = w1;
+      d[2] = w2;
+      d[3] = w3;
+      d += 4;
+      s += 4;
+      len -= 16U;
+    }
+    while (4U <= len)
+    {
+      *d++ = *s++;
+      len -= 4U;
+    }
+    dst = d;
+    src = s;
+  }
+  memcpy(dst, src, len);
+}
+
+void dmacopy_get_stats(dmacopy_stats_t *stats)
+{
+  UBaseType_t mask;
+
+  mask = taskENTER_CRITICAL_FROM_ISR();
+  *stats = dmacopy_.stats;
+  taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+void dmacopy_stream0_irq_handler(void)
+{
+  HAL_DMA_IRQHandler(&streams_[0].hdma);
+}
+
+void dmacopy_stream4_irq_handler(void)
+{
+  HAL_DMA_IRQHandler(&streams_[1].hdma);
+}
+
+/********************** end of file ******************************************/
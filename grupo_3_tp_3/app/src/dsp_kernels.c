@@ -0,0 +1,160 @@
+/**
+ * @file dsp_kernels.c
+ * @brief Float and fixed-point (Q15/Q31) signal processing kernels
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+/********************** inclusions *******************************************/
+#include <string.h>
+
+#include "main.h"
+
+#include "dsp_kernels.h"
+
+/********************** macros and definitions *******************************/
+#define Q15_SCALE_      (32768.0f)
+#define Q31_SCALE_      (2147483648.0f)
+
+/********************** internal data declaration ****************************/
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+/* Two packed Q15 samples; the M4 handles the unaligned word access. */
+static inline uint32_t read_q15x2_(const q15_t *p)
+{
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+/********************** external functions definition ************************/
+
+q15_t dsp_float_to_q15(float value)
+{
+  float scaled = value * Q15_SCALE_;
+
+  // clamped as a float: the conversion is undefined out of the q31_t range
+  if (Q15_SCALE_ <= scaled)
+  {
+    return INT16_MAX;
+  }
+  if (-Q15_SCALE_ >= scaled)
+  {
+    return INT16_MIN;
+  }
+  if (scaled != scaled)
+  {
+    return 0;   // NaN
+  }
+  return (q15_t)scaled;
+}
+
+q31_t dsp_float_to_q31(float value)
+{
+  float scaled = value * Q31_SCALE_;
+
+  // clamped as a float: the conversion is undefined out of the q31_t range
+  if (Q31_SCALE_ <= scaled)
+  {
+    return INT32_MAX;
+  }
+  if (-Q31_SCALE_ >= scaled)
+  {
+    return INT32_MIN;
+  }
+  if (scaled != scaled)
+  {
+    return 0;   // NaN
+  }
+  return (q31_t)scaled;
+}
+
+float dsp_dot_f32(const float *a, const float *b, uint32_t n)
+{
+  float acc0 = 0.0f;
+  float acc1 = 0.0f;
+
+  // two independent accumulators hide the VMLA latency
+  while (2U <= n)
+  {
+    acc0 += a[0] * b[0];
+    acc1 += a[1] * b[1];
+    a += 2;
+    b += 2;
+    n -= 2U;
+  }
+  if (0U < n)
+  {
+    acc0 += a[0] * b[0];
+  }
+  return acc0 + acc1;
+}
+
+q63_t dsp_dot_q15(const q15_t *a, const q15_t *b, uint32_t n)
+{
+  uint64_t acc = 0;
+
+  while (2U <= n)
+  {
+    acc = __SMLALD(read_q15x2_(a), read_q15x2_(b), acc);
+    a += 2;
+    b += 2;
+    n -= 2U;
+  }
+  if (0U < n)
+  {
+    acc += (uint64_t)((q31_t)a[0] * b[0]);
+  }
+  return (q63_t)acc;
+}
+
+q63_t dsp_dot_q31(const q31_t *a, const q31_t *b, uint32_t n)
+{
+  q63_t acc = 0;
+
+  // the shift between multiply and add rules out SMLAL, see dsp_kernels.h
+  while (0U < n)
+  {
+    acc += ((q63_t)*a++ * *b++) >> 14;
+    n--;
+  }
+  return acc;
+}
+
+void dsp_fir_f32(const float *coeffs, uint32_t taps, const float *in, float *out, uint32_t n)
+{
+  for (uint32_t i = 0; i < n; i++)
+  {
+    out[i] = dsp_dot_f32(coeffs, &in[i], taps);
+  }
+}
+
+void dsp_fir_q15(const q15_t *coeffs, uint32_t taps, const q15_t *in, q15_t *out, uint32_t n)
+{
+  for (uint32_t i = 0; i < n; i++)
+  {
+    q63_t acc = dsp_dot_q15(coeffs, &in[i], taps) >> 15;
+
+    if (INT16_MAX < acc)
+    {
+      acc = INT16_MAX;
+    }
+    else if (INT16_MIN > acc)
+    {
+      acc = INT16_MIN;
+    }
+    out[i] = (q15_t)acc;
+  }
+}
+
+/********************** end of file ******************************************/
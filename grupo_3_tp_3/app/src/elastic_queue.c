@@ -0,0 +1,166 @@
+/**
+ * @file elastic_queue.c
+ * @brief FIFO queue stored in a chain of blockpool.h blocks
+ *
+ * Items are written at tail_index of the tail segment and read at
+ * head_index of the head segment. A segment is linked when the tail one is
+ * full and released when the head one has been read to its end, or when the
+ * queue empties, so a queue holds at most one segment more than its items
+ * need.
+ *
+ * The block is taken before entering the critical section, the pool takes
+ * its own, and given back if the queue turns out not to need it.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+/********************** inclusions *******************************************/
+#include <stddef.h>
+#include <string.h>
+
+#include "main.h"
+#include "cmsis_os.h"
+
+#include "blockpool.h"
+#include "elastic_queue.h"
+
+/********************** macros and definitions *******************************/
+#define DATA_SIZE_              (BLOCKPOOL_CONFIG_BLOCK_SIZE - sizeof(elastic_segment_t *))
+
+/********************** internal data declaration ****************************/
+struct elastic_segment_s
+{
+  elastic_segment_t *next;
+  uint8_t           data[DATA_SIZE_];
+};
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+static bool tail_full_(const elastic_queue_t *queue)
+{
+  return (NULL == queue->tail) || (queue->per_segment == queue->tail_index);
+}
+
+/********************** external functions definition ************************/
+
+void elastic_queue_init(elastic_queue_t *queue, uint32_t capacity, uint32_t item_size)
+{
+  configASSERT(sizeof(elastic_segment_t) == BLOCKPOOL_CONFIG_BLOCK_SIZE);
+  configASSERT((0U < item_size) && (DATA_SIZE_ >= item_size) && (0U < capacity));
+
+  memset(queue, 0, sizeof(*queue));
+  queue->item_size = item_size;
+  queue->per_segment = DATA_SIZE_ / item_size;
+  queue->capacity = capacity;
+  queue->hitems = xSemaphoreCreateCounting(capacity, 0U);
+  configASSERT(NULL != queue->hitems);
+}
+
+bool elastic_queue_send(elastic_queue_t *queue, const void *item)
+{
+  elastic_segment_t *spare = NULL;
+  bool sent = false;
+
+  // cheap unlocked look, rechecked below
+  if (tail_full_(queue))
+  {
+    spare = blockpool_alloc();
+  }
+
+  taskENTER_CRITICAL();
+  if (queue->capacity > queue->count)
+  {
+    if (tail_full_(queue) && (NULL != spare))
+    {
+      spare->next = NULL;
+      if (NULL == queue->tail)
+      {
+        queue->head = spare;
+        queue->head_index = 0U;
+      }
+      else
+      {
+        queue->tail->next = spare;
+      }
+      queue->tail = spare;
+      queue->tail_index = 0U;
+      queue->segments++;
+      spare = NULL;
+    }
+    if (!tail_full_(queue))
+    {
+      memcpy(&queue->tail->data[queue->tail_index * queue->item_size], item, queue->item_size);
+      queue->tail_index++;
+      queue->count++;
+      if (queue->count > queue->count_max)
+      {
+        queue->count_max = queue->count;
+      }
+      sent = true;
+    }
+  }
+  taskEXIT_CRITICAL();
+
+  if (NULL != spare)
+  {
+    blockpool_free(spare);
+  }
+  if (sent)
+  {
+    (void)xSemaphoreGive(queue->hitems);
+  }
+  return sent;
+}
+
+bool elastic_queue_receive(elastic_queue_t *queue, void *item, TickType_t ticks)
+{
+  elastic_segment_t *drained = NULL;
+
+  if (pdTRUE != xSemaphoreTake(queue->hitems, ticks))
+  {
+    return false;
+  }
+
+  taskENTER_CRITICAL();
+  memcpy(item, &queue->head->data[queue->head_index * queue->item_size], queue->item_size);
+  queue->head_index++;
+  queue->count--;
+  if (0U == queue->count)
+  {
+    // one segment left, start over in it next time
+    drained = queue->head;
+    queue->head = NULL;
+    queue->tail = NULL;
+    queue->segments--;
+  }
+  else if (queue->per_segment == queue->head_index)
+  {
+    drained = queue->head;
+    queue->head = drained->next;
+    queue->head_index = 0U;
+    queue->segments--;
+  }
+  taskEXIT_CRITICAL();
+
+  if (NULL != drained)
+  {
+    blockpool_free(drained);
+  }
+  return true;
+}
+
+uint32_t elastic_queue_count(const elastic_queue_t *queue)
+{
+  return queue->count;
+}
+
+/********************** end of file ******************************************/
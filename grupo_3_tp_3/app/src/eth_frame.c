@@ -0,0 +1,369 @@
+/**
+ * @file eth_frame.c
+ * @brief Zero-copy raw Ethernet frame driver
+ *
+ * The pool is a free list of eth_frame_t; data is the first member, so the
+ * buffer address the HAL hands back is the frame itself. The list is used
+ * from task_eth (allocate) and from any task (release), under a critical
+ * section.
+ *
+ * The HAL ETH driver is not reentrant: transmission and the release of sent
+ * packets share a mutex. Reception only happens in task_eth.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+/********************** inclusions *******************************************/
+#include <stddef.h>
+
+#include "main.h"
+#include "cmsis_os.h"
+#include "logger.h"
+
+#include "eth_frame.h"
+
+/********************** macros and definitions *******************************/
+#define TASK_ETH_PRIORITY_      (tskIDLE_PRIORITY + 3)
+#define TASK_ETH_STACK_         (256)
+
+#define NOTIFY_RX_              (1UL << 0)
+#define NOTIFY_TX_              (1UL << 1)
+#define NOTIFY_ERROR_           (1UL << 2)
+
+#define PHY_BSR_                (1U)           /**< Basic status register */
+#define PHY_BSR_LINK_           (1U << 2)
+#define PHY_SCSR_               (31U)          /**< LAN8742A special control / status */
+#define PHY_SCSR_100_           (2U << 2)
+#define PHY_SCSR_FULL_          (4U << 2)
+
+#define LINK_POLL_TICKS_        pdMS_TO_TICKS(ETH_FRAME_CONFIG_LINK_POLL_MS)
+
+#if (ETH_FRAME_CONFIG_RX_BUFFERS < ETH_RX_DESC_CNT)
+#error "ETH_FRAME_CONFIG_RX_BUFFERS must cover every RX descriptor"
+#endif
+
+/********************** internal data declaration ****************************/
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+static eth_frame_t pool_[ETH_FRAME_CONFIG_RX_BUFFERS];
+
+static struct
+{
+  eth_frame_t           *free;
+  TaskHandle_t           htask;
+  SemaphoreHandle_t      htx_mutex;
+  eth_frame_rx_handler_t handler;
+  void                  *handler_arg;
+  volatile bool          starved;    /**< A descriptor was left without buffer */
+  eth_frame_stats_t      stats;
+} eth_;
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+static void count_(uint32_t *counter, uint32_t value)
+{
+  taskENTER_CRITICAL();
+  *counter += value;
+  taskEXIT_CRITICAL();
+}
+
+static void notify_from_isr_(uint32_t bits)
+{
+  BaseType_t woken = pdFALSE;
+
+  if (NULL != eth_.htask)
+  {
+    (void)xTaskNotifyFromISR(eth_.htask, bits, eSetBits, &woken);
+  }
+  portYIELD_FROM_ISR(woken);
+}
+
+static void link_update_(void)
+{
+  uint32_t bsr = 0U;
+  uint32_t scsr = 0U;
+  bool up;
+
+  if (HAL_OK != HAL_ETH_ReadPHYRegister(&heth, ETH_FRAME_CONFIG_PHY_ADDRESS, PHY_BSR_, &bsr))
+  {
+    return;
+  }
+  up = (0U != (bsr & PHY_BSR_LINK_));
+  if (up == eth_.stats.link_up)
+  {
+    return;
+  }
+
+  xSemaphoreTake(eth_.htx_mutex, portMAX_DELAY);
+  if (up)
+  {
+    ETH_MACConfigTypeDef mac;
+
+    // the MAC must follow what autonegotiation settled on
+    (void)HAL_ETH_ReadPHYRegister(&heth, ETH_FRAME_CONFIG_PHY_ADDRESS, PHY_SCSR_, &scsr);
+    (void)HAL_ETH_GetMACConfig(&heth, &mac);
+    mac.Speed = (0U != (scsr & PHY_SCSR_100_)) ? ETH_SPEED_100M : ETH_SPEED_10M;
+    mac.DuplexMode = (0U != (scsr & PHY_SCSR_FULL_)) ? ETH_FULLDUPLEX_MODE : ETH_HALFDUPLEX_MODE;
+    (void)HAL_ETH_SetMACConfig(&heth, &mac);
+    if (HAL_OK != HAL_ETH_Start_IT(&heth))
+    {
+      Error_Handler();
+    }
+  }
+  else
+  {
+    (void)HAL_ETH_Stop_IT(&heth);
+  }
+  xSemaphoreGive(eth_.htx_mutex);
+
+  taskENTER_CRITICAL();
+  eth_.stats.link_up = up;
+  eth_.stats.link_changes++;
+  taskEXIT_CRITICAL();
+
+  LOGGER_INFO("ETH\t- Link %s %s %s", up ? "up" : "down",
+              !up ? "" : ((0U != (scsr & PHY_SCSR_100_)) ? "100M" : "10M"),
+              !up ? "" : ((0U != (scsr & PHY_SCSR_FULL_)) ? "full" : "half"));
+}
+
+static void rx_drain_(void)
+{
+  eth_frame_t *frame;
+
+  while (HAL_OK == HAL_ETH_ReadData(&heth, (void **)&frame))
+  {
+    uint32_t bytes = 0U;
+
+    for (eth_frame_t *part = frame; NULL != part; part = part->next)
+    {
+      bytes += part->len;
+    }
+    count_(&eth_.stats.rx_frames, 1U);
+    count_(&eth_.stats.rx_bytes, bytes);
+
+    if (NULL != eth_.handler)
+    {
+      eth_.handler(frame, eth_.handler_arg);
+    }
+    else
+    {
+      eth_frame_release(frame);
+    }
+  }
+}
+
+static void task_eth_(void *argument)
+{
+  link_update_();
+
+  while (true)
+  {
+    uint32_t bits = 0U;
+
+    if (pdFALSE == xTaskNotifyWait(0U, 0xFFFFFFFFU, &bits, LINK_POLL_TICKS_))
+    {
+      link_update_();
+      continue;
+    }
+
+    if (0U != (bits & NOTIFY_RX_))
+    {
+      rx_drain_();
+    }
+    if (0U != (bits & NOTIFY_TX_))
+    {
+      xSemaphoreTake(eth_.htx_mutex, portMAX_DELAY);
+      (void)HAL_ETH_ReleaseTxPacket(&heth);
+      xSemaphoreGive(eth_.htx_mutex);
+    }
+    if (0U != (bits & NOTIFY_ERROR_))
+    {
+      count_(&eth_.stats.rx_errors, 1U);
+      // a receive buffer unavailable stall is cleared by reading frames
+      rx_drain_();
+    }
+  }
+}
+
+/********************** external functions definition ************************/
+
+void eth_frame_init(void)
+{
+#if 1 == ETH_FRAME_CONFIG_ENABLE
+  BaseType_t status;
+
+  eth_.free = NULL;
+  for (uint32_t i = 0; i < ETH_FRAME_CONFIG_RX_BUFFERS; i++)
+  {
+    pool_[i].next = eth_.free;
+    eth_.free = &pool_[i];
+  }
+
+  eth_.htx_mutex = xSemaphoreCreateMutex();
+  configASSERT(NULL != eth_.htx_mutex);
+
+  HAL_NVIC_SetPriority(ETH_IRQn, ETH_FRAME_CONFIG_IRQ_PRIORITY, 0);
+  HAL_NVIC_EnableIRQ(ETH_IRQn);
+
+  status = xTaskCreate
+		  (
+			  task_eth_,
+			  "task_eth",
+			  TASK_ETH_STACK_,
+			  NULL,
+			  TASK_ETH_PRIORITY_,
+			  &eth_.htask
+		  );
+  configASSERT(pdPASS == status);
+#endif
+}
+
+void eth_frame_set_rx_handler(eth_frame_rx_handler_t handler, void *arg)
+{
+  taskENTER_CRITICAL();
+  eth_.handler = handler;
+  eth_.handler_arg = arg;
+  taskEXIT_CRITICAL();
+}
+
+void eth_frame_release(eth_frame_t *frame)
+{
+  while (NULL != frame)
+  {
+    eth_frame_t *next = frame->next;
+
+    taskENTER_CRITICAL();
+    frame->next = eth_.free;
+    eth_.free = frame;
+    taskEXIT_CRITICAL();
+
+    frame = next;
+  }
+
+  // descriptors are only refilled when reading frames: have task_eth do it
+  if (eth_.starved)
+  {
+    eth_.starved = false;
+    (void)xTaskNotify(eth_.htask, NOTIFY_RX_, eSetBits);
+  }
+}
+
+bool eth_frame_send(eth_frame_tx_t *tx)
+{
+  ETH_TxPacketConfig config;
+  HAL_StatusTypeDef status;
+
+  if (!eth_.stats.link_up)
+  {
+    return false;
+  }
+
+  config = TxConfig;
+  config.Length = tx->len;
+  config.TxBuffer = tx->buffers;
+  config.pData = tx;
+
+  xSemaphoreTake(eth_.htx_mutex, portMAX_DELAY);
+  status = HAL_ETH_Transmit_IT(&heth, &config);
+  xSemaphoreGive(eth_.htx_mutex);
+
+  if (HAL_OK != status)
+  {
+    count_(&eth_.stats.tx_busy, 1U);
+    return false;
+  }
+  count_(&eth_.stats.tx_frames, 1U);
+  return true;
+}
+
+bool eth_frame_link_up(void)
+{
+  return eth_.stats.link_up;
+}
+
+void eth_frame_get_stats(eth_frame_stats_t *stats)
+{
+  taskENTER_CRITICAL();
+  *stats = eth_.stats;
+  taskEXIT_CRITICAL();
+}
+
+void eth_frame_irq_handler(void)
+{
+  HAL_ETH_IRQHandler(&heth);
+}
+
+void HAL_ETH_RxAllocateCallback(uint8_t **buff)
+{
+  eth_frame_t *frame;
+
+  taskENTER_CRITICAL();
+  frame = eth_.free;
+  if (NULL != frame)
+  {
+    eth_.free = frame->next;
+  }
+  taskEXIT_CRITICAL();
+
+  if (NULL == frame)
+  {
+    eth_.starved = true;
+    count_(&eth_.stats.rx_no_buffer, 1U);
+    *buff = NULL;
+    return;
+  }
+  frame->next = NULL;
+  frame->len = 0U;
+  *buff = frame->data;
+}
+
+void HAL_ETH_RxLinkCallback(void **pStart, void **pEnd, uint8_t *buff, uint16_t Length)
+{
+  eth_frame_t *frame = (eth_frame_t *)buff;
+
+  frame->len = Length;
+  frame->next = NULL;
+  if (NULL == *pStart)
+  {
+    *pStart = frame;
+  }
+  else
+  {
+    ((eth_frame_t *)*pEnd)->next = frame;
+  }
+  *pEnd = frame;
+}
+
+void HAL_ETH_TxFreeCallback(uint32_t *buff)
+{
+  eth_frame_tx_t *tx = (eth_frame_tx_t *)buff;
+
+  if ((NULL != tx) && (NULL != tx->done))
+  {
+    tx->done(tx);
+  }
+}
+
+void HAL_ETH_RxCpltCallback(ETH_HandleTypeDef *handle)
+{
+  notify_from_isr_(NOTIFY_RX_);
+}
+
+void HAL_ETH_TxCpltCallback(ETH_HandleTypeDef *handle)
+{
+  notify_from_isr_(NOTIFY_TX_);
+}
+
+void HAL_ETH_ErrorCallback(ETH_HandleTypeDef *handle)
+{
+  notify_from_isr_(NOTIFY_ERROR_);
+}
+
+/********************** end of file ******************************************/
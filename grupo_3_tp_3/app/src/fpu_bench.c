@@ -0,0 +1,224 @@
+/**
+ * @file fpu_bench.c
+ * @brief Boot-time FPU benchmark
+ *
+ * The context switch benchmark ping-pongs task notifications between the
+ * benchmark task and a higher priority peer, so every round trip is exactly
+ * two context switches. Once a task executes a floating point instruction
+ * the core keeps CONTROL.FPCA set for it, therefore the integer-only pass
+ * must run before anything in these tasks touches the FPU.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+/********************** inclusions *******************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "main.h"
+#include "cmsis_os.h"
+#include "logger.h"
+
+#include "monoclock.h"
+#include "dsp_kernels.h"
+#include "fpu_monitor.h"
+#include "warmboot.h"
+#include "fpu_bench.h"
+
+/********************** macros and definitions *******************************/
+#define TASK_BENCH_PRIORITY_        (tskIDLE_PRIORITY + 3)
+#define TASK_BENCH_STACK_           (256)
+#define TASK_PEER_STACK_            (128)
+
+#define ROUND_TRIPS_                (1000U)
+#define SWITCHES_PER_ROUND_TRIP_    (2U)
+
+#define VECTOR_LEN_                 (128U)
+#define FIR_TAPS_                   (16U)
+#define FIR_BLOCK_                  (64U)
+
+/********************** internal data declaration ****************************/
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+static struct
+{
+  TaskHandle_t hbench;
+  TaskHandle_t hpeer;
+  volatile bool use_fpu;
+} bench_;
+
+static float vf_a_[VECTOR_LEN_];
+static float vf_b_[VECTOR_LEN_];
+static q15_t vq15_a_[VECTOR_LEN_];
+static q15_t vq15_b_[VECTOR_LEN_];
+static q31_t vq31_a_[VECTOR_LEN_];
+static q31_t vq31_b_[VECTOR_LEN_];
+
+static float fir_f32_out_[FIR_BLOCK_];
+static q15_t fir_q15_out_[FIR_BLOCK_];
+
+static volatile float sink_f32_;
+static volatile q63_t sink_q63_;
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+/* Kept out of line so no FPU instruction leaks into the integer pass. */
+static __attribute__((noinline)) void touch_fpu_(void)
+{
+  static volatile float f;
+  f += 1.0f;
+}
+
+static void peer_task_(void *argument)
+{
+  while (true)
+  {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    if (bench_.use_fpu)
+    {
+      touch_fpu_();
+    }
+    xTaskNotifyGive(bench_.hbench);
+  }
+}
+
+static uint32_t switch_cycles_(void)
+{
+  uint32_t start = now_cycles32();
+
+  for (uint32_t i = 0; i < ROUND_TRIPS_; i++)
+  {
+    xTaskNotifyGive(bench_.hpeer);
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    if (bench_.use_fpu)
+    {
+      touch_fpu_();
+    }
+  }
+
+  return (now_cycles32() - start) / (ROUND_TRIPS_ * SWITCHES_PER_ROUND_TRIP_);
+}
+
+/* Deterministic values in [-0.5, 0.5) so runs are comparable. */
+static void fill_vectors_(void)
+{
+  uint32_t seed = 0x1234567U;
+
+  for (uint32_t i = 0; i < VECTOR_LEN_; i++)
+  {
+    seed = seed * 1664525U + 1013904223U;
+    vf_a_[i] = (float)((int32_t)seed >> 8) / 16777216.0f;
+    seed = seed * 1664525U + 1013904223U;
+    vf_b_[i] = (float)((int32_t)seed >> 8) / 16777216.0f;
+
+    vq15_a_[i] = dsp_float_to_q15(vf_a_[i]);
+    vq15_b_[i] = dsp_float_to_q15(vf_b_[i]);
+    vq31_a_[i] = dsp_float_to_q31(vf_a_[i]);
+    vq31_b_[i] = dsp_float_to_q31(vf_b_[i]);
+  }
+}
+
+static void bench_kernels_(void)
+{
+  uint32_t t;
+
+  fill_vectors_();
+
+  t = now_cycles32();
+  sink_f32_ = dsp_dot_f32(vf_a_, vf_b_, VECTOR_LEN_);
+  t = now_cycles32() - t;
+  LOGGER_INFO("FPU BENCH\t- dot f32 x%u: %lu cycles", (unsigned)VECTOR_LEN_, (unsigned long)t);
+
+  t = now_cycles32();
+  sink_q63_ = dsp_dot_q15(vq15_a_, vq15_b_, VECTOR_LEN_);
+  t = now_cycles32() - t;
+  LOGGER_INFO("FPU BENCH\t- dot q15 x%u: %lu cycles", (unsigned)VECTOR_LEN_, (unsigned long)t);
+
+  t = now_cycles32();
+  sink_q63_ = dsp_dot_q31(vq31_a_, vq31_b_, VECTOR_LEN_);
+  t = now_cycles32() - t;
+  LOGGER_INFO("FPU BENCH\t- dot q31 x%u: %lu cycles", (unsigned)VECTOR_LEN_, (unsigned long)t);
+
+  // history + block fits in VECTOR_LEN_
+  t = now_cycles32();
+  dsp_fir_f32(vf_b_, FIR_TAPS_, vf_a_, fir_f32_out_, FIR_BLOCK_);
+  t = now_cycles32() - t;
+  LOGGER_INFO("FPU BENCH\t- fir f32 %ux%u: %lu cycles", (unsigned)FIR_TAPS_, (unsigned)FIR_BLOCK_, (unsigned long)t);
+
+  t = now_cycles32();
+  dsp_fir_q15(vq15_b_, FIR_TAPS_, vq15_a_, fir_q15_out_, FIR_BLOCK_);
+  t = now_cycles32() - t;
+  LOGGER_INFO("FPU BENCH\t- fir q15 %ux%u: %lu cycles", (unsigned)FIR_TAPS_, (unsigned)FIR_BLOCK_, (unsigned long)t);
+}
+
+static void bench_task_(void *argument)
+{
+  uint32_t cycles_int;
+  uint32_t cycles_fpu;
+  BaseType_t status;
+
+  // the CM4F port enables lazy stacking when the scheduler starts
+  configASSERT((FPU_FPCCR_ASPEN_Msk | FPU_FPCCR_LSPEN_Msk) ==
+               (FPU->FPCCR & (FPU_FPCCR_ASPEN_Msk | FPU_FPCCR_LSPEN_Msk)));
+
+  status = xTaskCreate
+		  (
+			  peer_task_,
+			  "task_fpu_peer",
+			  TASK_PEER_STACK_,
+			  NULL,
+			  TASK_BENCH_PRIORITY_ + 1,
+			  &bench_.hpeer
+		  );
+  configASSERT(pdPASS == status);
+
+  // integer pass first: neither task has FPU state yet
+  bench_.use_fpu = false;
+  cycles_int = switch_cycles_();
+
+  bench_.use_fpu = true;
+  cycles_fpu = switch_cycles_();
+
+  vTaskDelete(bench_.hpeer);
+
+  LOGGER_INFO("FPU BENCH\t- Context switch: %lu cycles", (unsigned long)cycles_int);
+  LOGGER_INFO("FPU BENCH\t- Context switch with FPU: %lu cycles", (unsigned long)cycles_fpu);
+
+  bench_kernels_();
+  fpu_monitor_report();
+
+  vTaskDelete(NULL);
+}
+
+/********************** external functions definition ************************/
+
+void fpu_bench_init(void)
+{
+#if 1 == FPU_BENCH_CONFIG_ENABLE
+  BaseType_t status;
+
+  if (warmboot_is_warm())
+  {
+    return;
+  }
+  status = xTaskCreate
+		  (
+			  bench_task_,
+			  "task_fpu_bench",
+			  TASK_BENCH_STACK_,
+			  NULL,
+			  TASK_BENCH_PRIORITY_,
+			  &bench_.hbench
+		  );
+  configASSERT(pdPASS == status);
+#endif
+}
+
+/********************** end of file ******************************************/
@@ -0,0 +1,108 @@
+/**
+ * @file fpu_monitor.c
+ * @brief Per-task FPU context usage tracking
+ *
+ * PendSV (see portable/GCC/ARM_CM4F/port.c) saves the outgoing task as
+ *
+ *   [s16-s31]        only when EXC_RETURN bit 4 is clear
+ *   r4-r11, r14      r14 holds EXC_RETURN
+ *
+ * and stores the resulting stack pointer in pxTopOfStack before calling
+ * vTaskSwitchContext(), so EXC_RETURN is always the 9th word above it.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+/********************** inclusions *******************************************/
+#include "main.h"
+#include "cmsis_os.h"
+#include "logger.h"
+
+#include "fpu_monitor.h"
+
+/********************** macros and definitions *******************************/
+#define EXC_RETURN_OFFSET_      (8U)     /* r4-r11 precede r14 */
+#define EXC_RETURN_FTYPE_MSK_   (0x10U)  /* 0: extended (FPU) frame */
+
+/********************** internal data declaration ****************************/
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+static fpu_monitor_stats_t stats_[FPU_MONITOR_MAX_TASKS];
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+/********************** external functions definition ************************/
+
+void fpu_monitor_task_switched_out(UBaseType_t task_number, const uint32_t *top_of_stack)
+{
+#if 1 == FPU_MONITOR_CONFIG_ENABLE
+  if (FPU_MONITOR_MAX_TASKS <= task_number)
+  {
+    return;
+  }
+
+  stats_[task_number].switches++;
+  if (0U == (top_of_stack[EXC_RETURN_OFFSET_] & EXC_RETURN_FTYPE_MSK_))
+  {
+    stats_[task_number].fpu_switches++;
+  }
+#else
+  (void)task_number;
+  (void)top_of_stack;
+#endif
+}
+
+bool fpu_monitor_get(TaskHandle_t htask, fpu_monitor_stats_t *stats)
+{
+  TaskStatus_t status;
+
+  if (NULL == htask)
+  {
+    htask = xTaskGetCurrentTaskHandle();
+  }
+
+  vTaskGetInfo(htask, &status, pdFALSE, eInvalid);
+  if (FPU_MONITOR_MAX_TASKS <= status.xTaskNumber)
+  {
+    return false;
+  }
+
+  taskENTER_CRITICAL();
+  *stats = stats_[status.xTaskNumber];
+  taskEXIT_CRITICAL();
+
+  return true;
+}
+
+void fpu_monitor_report(void)
+{
+  static TaskStatus_t status[FPU_MONITOR_MAX_TASKS]; // too large for task stacks
+  UBaseType_t n;
+
+  if (FPU_MONITOR_MAX_TASKS < uxTaskGetNumberOfTasks())
+  {
+    LOGGER_INFO("FPU MON\t- Too many tasks to report");
+    return;
+  }
+
+  n = uxTaskGetSystemState(status, FPU_MONITOR_MAX_TASKS, NULL);
+  for (UBaseType_t i = 0; i < n; i++)
+  {
+    fpu_monitor_stats_t stats = {0};
+    if (FPU_MONITOR_MAX_TASKS > status[i].xTaskNumber)
+    {
+      stats = stats_[status[i].xTaskNumber];
+    }
+    LOGGER_INFO("FPU MON\t- %s: %lu/%lu fpu", status[i].pcTaskName,
+                (unsigned long)stats.fpu_switches, (unsigned long)stats.switches);
+  }
+}
+
+/********************** end of file ******************************************/
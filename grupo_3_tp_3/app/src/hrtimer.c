@@ -0,0 +1,310 @@
+/**
+ * @file hrtimer.c
+ * @brief High-resolution timer service on TIM5
+ *
+ * Pending timers are kept in a singly linked list sorted by expiry. Channel 1
+ * of TIM5 always holds the expiry of the list head. Insertion is O(n) in the
+ * number of armed timers, which is expected to stay small; expiry and the
+ * interrupt are O(1) per timer.
+ *
+ * Times are 32-bit TIM5 counts, compared with wrap-safe signed differences.
+ *
+ * Task-context expiries reach the hrtimer task through a ring_spsc_t of
+ * ring.h, the interrupt being its only producer; the task is notified once
+ * per interrupt, and only if it had drained the ring.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+/********************** inclusions *******************************************/
+#include <stddef.h>
+
+#include "main.h"
+#include "cmsis_os.h"
+
+#include "monoclock.h"
+#include "ring.h"
+#include "hrtimer.h"
+
+/********************** macros and definitions *******************************/
+#define MAX_DELAY_US_           (0x7FFFFFFFU)
+
+#define TASK_HRTIMER_PRIORITY_  (configMAX_PRIORITIES - 1)
+#define TASK_HRTIMER_STACK_     (128)
+
+#define IS_DUE_(expiry, now)    (0 >= (int32_t)((expiry) - (now)))
+#define IS_BEFORE_(a, b)        (0 > (int32_t)((a) - (b)))
+
+/********************** internal data declaration ****************************/
+typedef struct
+{
+  hrtimer_t *timer;
+  uint32_t   expiry_us;
+} hrtimer_event_t;
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+static struct
+{
+  hrtimer_t       *head;
+  hrtimer_event_t events[HRTIMER_CONFIG_QUEUE_LENGTH];
+  ring_spsc_t     ring;
+  TaskHandle_t    htask;
+} hrtimer_;
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+static void stats_update_(hrtimer_stats_t *stats, uint32_t late_us)
+{
+  if ((0U == stats->count) || (late_us < stats->late_min_us))
+  {
+    stats->late_min_us = late_us;
+  }
+  if (late_us > stats->late_max_us)
+  {
+    stats->late_max_us = late_us;
+  }
+  stats->late_sum_us += late_us;
+  stats->count++;
+}
+
+/* Must be called with interrupts masked. */
+static void unlink_(hrtimer_t *timer)
+{
+  hrtimer_t **link = &hrtimer_.head;
+
+  while (NULL != *link)
+  {
+    if (timer == *link)
+    {
+      *link = timer->next;
+      break;
+    }
+    link = &(*link)->next;
+  }
+  timer->next = NULL;
+  timer->armed = false;
+}
+
+/* Must be called with interrupts masked. Equal expiries keep FIFO order. */
+static void insert_(hrtimer_t *timer)
+{
+  hrtimer_t **link = &hrtimer_.head;
+
+  while ((NULL != *link) && !IS_BEFORE_(timer->expiry_us, (*link)->expiry_us))
+  {
+    link = &(*link)->next;
+  }
+  timer->next = *link;
+  *link = timer;
+  timer->armed = true;
+}
+
+/* Must be called with interrupts masked, after the list head changed. */
+static void program_compare_(void)
+{
+  if (NULL == hrtimer_.head)
+  {
+    __HAL_TIM_DISABLE_IT(&htim5, TIM_IT_CC1);
+    return;
+  }
+
+  __HAL_TIM_SET_COMPARE(&htim5, TIM_CHANNEL_1, hrtimer_.head->expiry_us);
+  __HAL_TIM_ENABLE_IT(&htim5, TIM_IT_CC1);
+
+  // the compare match may already have been missed: raise it by software
+  if (IS_DUE_(hrtimer_.head->expiry_us, __HAL_TIM_GET_COUNTER(&htim5)))
+  {
+    htim5.Instance->EGR = TIM_EGR_CC1G;
+  }
+}
+
+static void task_hrtimer_(void *argument)
+{
+  hrtimer_event_t evt;
+
+  while (true)
+  {
+    (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    while (0U != ring_spsc_read(&hrtimer_.ring, &evt, 1U))
+    {
+      uint32_t late_us = hrtimer_now_us() - evt.expiry_us;
+
+      taskENTER_CRITICAL();
+      stats_update_(&evt.timer->stats, late_us);
+      taskEXIT_CRITICAL();
+
+      evt.timer->callback(evt.timer->arg);
+    }
+  }
+}
+
+/********************** external functions definition ************************/
+
+void hrtimer_service_init(void)
+{
+#if 1 == HRTIMER_CONFIG_ENABLE
+  TIM_OC_InitTypeDef sConfigOC = {0};
+  BaseType_t status;
+
+  // TIM5 itself is owned and started by monoclock
+  sConfigOC.OCMode = TIM_OCMODE_TIMING;
+  sConfigOC.Pulse = 0U;
+  sConfigOC.OCPolarity = TIM_OCPOLARITY_HIGH;
+  sConfigOC.OCFastMode = TIM_OCFAST_DISABLE;
+  if (HAL_OK != HAL_TIM_OC_ConfigChannel(&htim5, &sConfigOC, TIM_CHANNEL_1))
+  {
+    Error_Handler();
+  }
+  __HAL_TIM_CLEAR_FLAG(&htim5, TIM_FLAG_CC1);
+
+  hrtimer_.head = NULL;
+  ring_spsc_init(&hrtimer_.ring, hrtimer_.events, sizeof(hrtimer_event_t), HRTIMER_CONFIG_QUEUE_LENGTH);
+
+  status = xTaskCreate
+		  (
+			  task_hrtimer_,
+			  "task_hrtimer",
+			  TASK_HRTIMER_STACK_,
+			  NULL,
+			  TASK_HRTIMER_PRIORITY_,
+			  &hrtimer_.htask
+		  );
+  configASSERT(pdPASS == status);
+#endif
+}
+
+void hrtimer_init(hrtimer_t *timer, hrtimer_callback_t callback, void *arg, hrtimer_context_t context)
+{
+  timer->next = NULL;
+  timer->expiry_us = 0U;
+  timer->period_us = 0U;
+  timer->callback = callback;
+  timer->arg = arg;
+  timer->context = context;
+  timer->armed = false;
+  timer->stats = (hrtimer_stats_t){0};
+}
+
+bool hrtimer_start(hrtimer_t *timer, uint32_t delay_us, uint32_t period_us)
+{
+  UBaseType_t mask;
+
+  if ((MAX_DELAY_US_ < delay_us) || (MAX_DELAY_US_ < period_us)
+      || ((0U != period_us) && (HRTIMER_MIN_PERIOD_US > period_us)))
+  {
+    return false;
+  }
+
+  mask = taskENTER_CRITICAL_FROM_ISR();
+  if (timer->armed)
+  {
+    unlink_(timer);
+  }
+  timer->expiry_us = hrtimer_now_us() + delay_us;
+  timer->period_us = period_us;
+  insert_(timer);
+  program_compare_();
+  taskEXIT_CRITICAL_FROM_ISR(mask);
+
+  return true;
+}
+
+void hrtimer_stop(hrtimer_t *timer)
+{
+  UBaseType_t mask;
+
+  mask = taskENTER_CRITICAL_FROM_ISR();
+  if (timer->armed)
+  {
+    unlink_(timer);
+    program_compare_();
+  }
+  taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+uint32_t hrtimer_now_us(void)
+{
+  return now_us32();
+}
+
+void hrtimer_get_stats(const hrtimer_t *timer, hrtimer_stats_t *stats)
+{
+  UBaseType_t mask;
+
+  mask = taskENTER_CRITICAL_FROM_ISR();
+  *stats = timer->stats;
+  taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+void hrtimer_irq_handler(void)
+{
+  BaseType_t woken = pdFALSE;
+  UBaseType_t mask;
+  bool notify = false;
+
+  if (!__HAL_TIM_GET_FLAG(&htim5, TIM_FLAG_CC1))
+  {
+    return;
+  }
+  __HAL_TIM_CLEAR_FLAG(&htim5, TIM_FLAG_CC1);
+
+  mask = taskENTER_CRITICAL_FROM_ISR();
+  while ((NULL != hrtimer_.head) && IS_DUE_(hrtimer_.head->expiry_us, hrtimer_now_us()))
+  {
+    hrtimer_t *timer = hrtimer_.head;
+    uint32_t expiry_us = timer->expiry_us;
+
+    hrtimer_.head = timer->next;
+    timer->next = NULL;
+    timer->armed = false;
+
+    // periodic timers reload from the expiry, not from now, so they don't drift
+    if (0U != timer->period_us)
+    {
+      uint32_t now_us = hrtimer_now_us();
+
+      timer->expiry_us = expiry_us + timer->period_us;
+      if (IS_DUE_(timer->expiry_us, now_us))
+      {
+        // fell behind: the first period boundary after now, or this loop never ends
+        uint32_t missed = (now_us - expiry_us) / timer->period_us;
+
+        timer->expiry_us = expiry_us + ((missed + 1U) * timer->period_us);
+        timer->stats.skipped += missed;
+      }
+      insert_(timer);
+    }
+
+    if (HRTIMER_CONTEXT_ISR == timer->context)
+    {
+      stats_update_(&timer->stats, hrtimer_now_us() - expiry_us);
+      timer->callback(timer->arg);
+    }
+    else
+    {
+      hrtimer_event_t evt = { .timer = timer, .expiry_us = expiry_us };
+      bool was_empty;
+
+      // dropped when full, like a full queue
+      (void)ring_spsc_write(&hrtimer_.ring, &evt, 1U, &was_empty);
+      notify = notify || was_empty;
+    }
+  }
+  program_compare_();
+  taskEXIT_CRITICAL_FROM_ISR(mask);
+
+  if (notify)
+  {
+    vTaskNotifyGiveFromISR(hrtimer_.htask, &woken);
+  }
+  portYIELD_FROM_ISR(woken);
+}
+
+/********************** end of file ******************************************/
@@ -0,0 +1,262 @@
+/**
+ * @file journal.c
+ * @brief Journal of the events entering the AO queues, with replay
+ *
+ * The ring keeps the last JOURNAL_CONFIG_RECORDS records, addressed by
+ * sequence: record n lives in slot n % JOURNAL_CONFIG_RECORDS until record
+ * n + JOURNAL_CONFIG_RECORDS takes it.
+ *
+ * A replay works on a copy of the ring taken when it starts, so the records
+ * it produces do not feed it. Only button and remote records are injected,
+ * see journal.h, each at the same offset from the first one as in the
+ * original run, to the tick.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+/********************** inclusions *******************************************/
+#include <string.h>
+
+#include "main.h"
+#include "cmsis_os.h"
+#include "logger.h"
+
+#include "monoclock.h"
+#include "priority_queue.h"
+#include "ao_ui.h"
+#include "ao_led.h"
+#include "journal.h"
+
+/********************** macros and definitions *******************************/
+#define TASK_REPLAY_PRIORITY_   (tskIDLE_PRIORITY + 2)  /**< Same as the button task */
+#define TASK_REPLAY_STACK_      (256)
+#define MASK_                   (JOURNAL_CONFIG_RECORDS - 1U)
+
+/********************** internal data declaration ****************************/
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+static struct
+{
+  journal_record_t ring[JOURNAL_CONFIG_RECORDS];
+  journal_record_t replay[JOURNAL_CONFIG_RECORDS];  /**< Copy being replayed */
+  uint32_t         replay_count;
+  TaskHandle_t     htask;
+  journal_stats_t  stats;
+} journal_;
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+static uint32_t snapshot_(void)
+{
+  uint32_t first;
+  uint32_t count;
+
+  taskENTER_CRITICAL();
+  count = (JOURNAL_CONFIG_RECORDS < journal_.stats.recorded) ? JOURNAL_CONFIG_RECORDS
+                                                             : journal_.stats.recorded;
+  first = journal_.stats.recorded - count;
+  for (uint32_t i = 0; i < count; i++)
+  {
+    journal_.replay[i] = journal_.ring[(first + i) & MASK_];
+  }
+  taskEXIT_CRITICAL();
+  return count;
+}
+
+static void inject_(const journal_record_t *record)
+{
+  bool accepted;
+
+  if (JOURNAL_QUEUE_UI == record->queue)
+  {
+    accepted = ao_ui_send(&ao_ui, (ao_ui_message_t)record->value);
+  }
+  else
+  {
+    pq_event_t evt = {0};
+
+    evt.priority = (pq_priority_t)record->value;
+    accepted = ao_led_send(&ao_led, evt);
+  }
+  journal_record((journal_queue_t)record->queue, JOURNAL_SOURCE_REPLAY, record->value, accepted);
+}
+
+static void task_replay_(void *argument)
+{
+  while (true)
+  {
+    uint32_t count;
+    uint32_t injected = 0U;
+    uint32_t base_us = 0U;
+    TickType_t start;
+
+    (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+    count = journal_.replay_count;
+    start = xTaskGetTickCount();
+    LOGGER_INFO("JOURNAL\t- Replaying %lu records", (unsigned long)count);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+      const journal_record_t *record = &journal_.replay[i];
+      TickType_t target;
+      TickType_t now;
+
+      if ((JOURNAL_SOURCE_BUTTON != record->source) && (JOURNAL_SOURCE_REMOTE != record->source))
+      {
+        continue;
+      }
+      if (0U == injected)
+      {
+        base_us = record->time_us;
+      }
+
+      target = start + pdMS_TO_TICKS((record->time_us - base_us) / 1000U);
+      now = xTaskGetTickCount();
+      if (0 < (int32_t)(target - now))
+      {
+        vTaskDelay(target - now);
+      }
+      inject_(record);
+      injected++;
+    }
+
+    taskENTER_CRITICAL();
+    journal_.stats.replayed += injected;
+    journal_.stats.replaying = false;
+    taskEXIT_CRITICAL();
+    LOGGER_INFO("JOURNAL\t- Replay done, %lu events injected", (unsigned long)injected);
+  }
+}
+
+/********************** external functions definition ************************/
+
+void journal_init(void)
+{
+#if 1 == JOURNAL_CONFIG_ENABLE
+  BaseType_t status;
+
+  configASSERT(0U == (JOURNAL_CONFIG_RECORDS & MASK_));
+
+  status = xTaskCreate
+		  (
+			  task_replay_,
+			  "task_replay",
+			  TASK_REPLAY_STACK_,
+			  NULL,
+			  TASK_REPLAY_PRIORITY_,
+			  &journal_.htask
+		  );
+  configASSERT(pdPASS == status);
+#endif
+}
+
+void journal_record(journal_queue_t queue, journal_source_t source, uint32_t value, bool accepted)
+{
+#if 1 == JOURNAL_CONFIG_ENABLE
+  journal_record_t record;
+
+  record.queue = (uint8_t)queue;
+  record.source = (uint8_t)source;
+  record.value = (uint8_t)value;
+  record.accepted = accepted ? 1U : 0U;
+
+  taskENTER_CRITICAL();
+  // stamped inside, so the ring is in time order
+  record.time_us = now_us32();
+  journal_.ring[journal_.stats.recorded & MASK_] = record;
+  journal_.stats.recorded++;
+  taskEXIT_CRITICAL();
+#endif
+}
+
+uint32_t journal_read(uint32_t seq, journal_record_t *records, uint32_t max, uint32_t *first)
+{
+  uint32_t count = 0U;
+  uint32_t oldest;
+
+  taskENTER_CRITICAL();
+  oldest = (JOURNAL_CONFIG_RECORDS < journal_.stats.recorded)
+           ? (journal_.stats.recorded - JOURNAL_CONFIG_RECORDS) : 0U;
+  if (0 < (int32_t)(oldest - seq))
+  {
+    seq = oldest;
+  }
+  while ((count < max) && (0 < (int32_t)(journal_.stats.recorded - (seq + count))))
+  {
+    records[count] = journal_.ring[(seq + count) & MASK_];
+    count++;
+  }
+  taskEXIT_CRITICAL();
+
+  *first = seq;
+  return count;
+}
+
+bool journal_replay(void)
+{
+#if 1 == JOURNAL_CONFIG_ENABLE
+  bool start;
+
+  taskENTER_CRITICAL();
+  start = !journal_.stats.replaying && (0U < journal_.stats.recorded);
+  if (start)
+  {
+    journal_.stats.replaying = true;
+    journal_.stats.replays++;
+  }
+  taskEXIT_CRITICAL();
+
+  if (start)
+  {
+    journal_.replay_count = snapshot_();
+    xTaskNotifyGive(journal_.htask);
+  }
+  return start;
+#else
+  return false;
+#endif
+}
+
+bool journal_replay_records(const journal_record_t *records, uint32_t count)
+{
+#if 1 == JOURNAL_CONFIG_ENABLE
+  bool start;
+
+  taskENTER_CRITICAL();
+  start = !journal_.stats.replaying && (0U < count) && (JOURNAL_CONFIG_RECORDS >= count);
+  if (start)
+  {
+    journal_.stats.replaying = true;
+    journal_.stats.replays++;
+  }
+  taskEXIT_CRITICAL();
+
+  if (start)
+  {
+    // the task only reads the copy once notified
+    memcpy(journal_.replay, records, count * sizeof(journal_record_t));
+    journal_.replay_count = count;
+    xTaskNotifyGive(journal_.htask);
+  }
+  return start;
+#else
+  return false;
+#endif
+}
+
+void journal_get_stats(journal_stats_t *stats)
+{
+  taskENTER_CRITICAL();
+  *stats = journal_.stats;
+  taskEXIT_CRITICAL();
+}
+
+/********************** end of file ******************************************/
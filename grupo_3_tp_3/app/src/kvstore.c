@@ -0,0 +1,517 @@
+/**
+ * @file kvstore.c
+ * @brief Persistent key-value store on two flash sectors
+ *
+ * The store uses sectors 12 and 13, the first 32 KB of bank 2, left out of
+ * the image by the linker script. Each starts with two header words, the
+ * magic and a generation incremented on every compaction, programmed last:
+ * generation first, magic to commit.
+ *
+ * At boot the valid sector with the newest generation is the active one. A
+ * second valid sector means the erase after a compaction was cut short; a
+ * non-blank invalid one, the compaction itself. Either way the task erases
+ * it before doing anything else.
+ *
+ * Records are programmed one word at a time, in order, so a power loss only
+ * leaves the last record incomplete. Its header holds the length, so the
+ * scan skips the whole record and carries on; unknown data makes it give up
+ * on the rest of the sector, which is compacted right away.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+/********************** inclusions *******************************************/
+#include <string.h>
+
+#include "main.h"
+#include "cmsis_os.h"
+#include "logger.h"
+
+#include "crc.h"
+#include "kvstore.h"
+
+/********************** macros and definitions *******************************/
+#define TASK_KVSTORE_PRIORITY_  (tskIDLE_PRIORITY + 1)
+#define TASK_KVSTORE_STACK_     (256)
+
+#define SECTOR_WORDS_           (16384U / 4U)
+#define HEADER_WORDS_           (2U)        /**< magic, generation */
+#define MAGIC_                  (0x4B565331U)  /**< "KVS1" */
+#define ERASED_                 (0xFFFFFFFFU)
+
+#define TAG_                    (0xA5U)
+#define TAG_SHIFT_              (24U)
+#define KEY_SHIFT_              (16U)
+#define LEN_MASK_               (0xFFFFU)
+
+#define VALUE_WORDS_            (KVSTORE_CONFIG_VALUE_MAX / 4U)
+#define RECORD_WORDS_MAX_       (VALUE_WORDS_ + 2U)   /**< header, value, crc */
+#define COMPACT_FREE_WORDS_     (KVSTORE_CONFIG_COMPACT_FREE / 4U)
+
+/********************** internal data declaration ****************************/
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+static const struct
+{
+  uint32_t address;
+  uint32_t sector;
+} sectors_[2] =
+{
+  { 0x08100000U, FLASH_SECTOR_12 },
+  { 0x08104000U, FLASH_SECTOR_13 },
+};
+
+static struct
+{
+  struct
+  {
+    uint32_t len;                       /**< 0 never written */
+    uint8_t  data[KVSTORE_CONFIG_VALUE_MAX];
+  } value[KVSTORE_KEY__N];
+  volatile uint32_t dirty;              /**< Bit per key not in flash yet */
+  int32_t           active;             /**< Sector index, -1 unformatted */
+  uint32_t          write;              /**< Next free word of the active sector */
+  bool              other_blank;
+  TaskHandle_t      htask;
+  kvstore_stats_t   stats;
+} kv_;
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+static const uint32_t *words_(uint32_t sector)
+{
+  return (const uint32_t *)sectors_[sector].address;
+}
+
+static uint32_t record_words_(uint32_t len)
+{
+  return ((len + 3U) / 4U) + 2U;
+}
+
+static bool blank_(uint32_t sector)
+{
+  const uint32_t *words = words_(sector);
+
+  for (uint32_t i = 0; i < SECTOR_WORDS_; i++)
+  {
+    if (ERASED_ != words[i])
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void unlock_(void)
+{
+  (void)HAL_FLASH_Unlock();
+  __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_EOP | FLASH_FLAG_OPERR | FLASH_FLAG_WRPERR | FLASH_FLAG_PGAERR
+                         | FLASH_FLAG_PGPERR | FLASH_FLAG_PGSERR);
+}
+
+static bool program_(uint32_t sector, uint32_t index, const uint32_t *words, uint32_t count)
+{
+  uint32_t address = sectors_[sector].address + (index * 4U);
+  bool ok = true;
+
+  unlock_();
+  for (uint32_t i = 0; ok && (i < count); i++)
+  {
+    ok = (HAL_OK == HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, address + (i * 4U), words[i]));
+  }
+  (void)HAL_FLASH_Lock();
+  if (!ok)
+  {
+    kv_.stats.errors++;
+  }
+  return ok;
+}
+
+static bool erase_(uint32_t sector)
+{
+  FLASH_EraseInitTypeDef erase = {0};
+  uint32_t bad_sector;
+  bool ok;
+
+  erase.TypeErase = FLASH_TYPEERASE_SECTORS;
+  erase.Sector = sectors_[sector].sector;
+  erase.NbSectors = 1U;
+  erase.VoltageRange = FLASH_VOLTAGE_RANGE_3;
+
+  // busy for a few hundred ms, the code keeps running from bank 1
+  unlock_();
+  ok = (HAL_OK == HAL_FLASHEx_Erase(&erase, &bad_sector));
+  (void)HAL_FLASH_Lock();
+  kv_.stats.erases++;
+  if (!ok)
+  {
+    kv_.stats.errors++;
+  }
+  return ok;
+}
+
+static bool write_header_(uint32_t sector, uint32_t generation)
+{
+  uint32_t magic = MAGIC_;
+
+  return program_(sector, 1U, &generation, 1U) && program_(sector, 0U, &magic, 1U);
+}
+
+/**
+ * @brief Builds the record of a key, less the CRC. Call in a critical section.
+ */
+static uint32_t encode_(uint32_t *record, uint32_t key)
+{
+  uint32_t len = kv_.value[key].len;
+  uint32_t count = record_words_(len);
+
+  record[0] = (TAG_ << TAG_SHIFT_) | (key << KEY_SHIFT_) | len;
+  memset(&record[1], 0xFF, (count - 2U) * 4U);
+  memcpy(&record[1], kv_.value[key].data, len);
+  return count;
+}
+
+static void seal_(uint32_t *record, uint32_t count)
+{
+  record[count - 1U] = crc_calc32(record, (count - 1U) * 4U);
+}
+
+static void scan_(uint32_t sector)
+{
+  const uint32_t *words = words_(sector);
+  uint32_t pos = HEADER_WORDS_;
+
+  while (pos < SECTOR_WORDS_)
+  {
+    uint32_t header = words[pos];
+    uint32_t key = (header >> KEY_SHIFT_) & 0xFFU;
+    uint32_t len = header & LEN_MASK_;
+    uint32_t count;
+
+    if (ERASED_ == header)
+    {
+      break;
+    }
+    count = record_words_(len);
+    if ((TAG_ != (header >> TAG_SHIFT_)) || (KVSTORE_CONFIG_VALUE_MAX < len)
+        || (SECTOR_WORDS_ - pos < count))
+    {
+      // nothing sensible can follow, compact what was read
+      pos = SECTOR_WORDS_;
+      break;
+    }
+
+    if (crc_calc32(&words[pos], (count - 1U) * 4U) != words[pos + count - 1U])
+    {
+      kv_.stats.torn++;
+    }
+    else if (KVSTORE_KEY__N > key)
+    {
+      kv_.value[key].len = len;
+      memcpy(kv_.value[key].data, &words[pos + 1U], len);
+    }
+    pos += count;
+  }
+  kv_.write = pos;
+}
+
+static bool format_(void)
+{
+  for (uint32_t s = 0; s < 2U; s++)
+  {
+    if (!blank_(s) && !erase_(s))
+    {
+      return false;
+    }
+  }
+  if (!write_header_(0U, 1U))
+  {
+    return false;
+  }
+  kv_.active = 0;
+  kv_.write = HEADER_WORDS_;
+  kv_.stats.generation = 1U;
+  kv_.other_blank = true;
+  return true;
+}
+
+/**
+ * @brief Copies the latest value of every key to the other sector, makes it
+ *        the active one and erases the old one.
+ */
+static bool compact_(void)
+{
+  uint32_t other = 1U - (uint32_t)kv_.active;
+  uint32_t pos = HEADER_WORDS_;
+  uint32_t copied = 0U;
+
+  if (!kv_.other_blank)
+  {
+    if (!erase_(other))
+    {
+      return false;
+    }
+  }
+  kv_.other_blank = false;
+
+  for (uint32_t key = 0; key < KVSTORE_KEY__N; key++)
+  {
+    uint32_t record[RECORD_WORDS_MAX_];
+    uint32_t count;
+
+    taskENTER_CRITICAL();
+    if (0U == kv_.value[key].len)
+    {
+      taskEXIT_CRITICAL();
+      continue;
+    }
+    kv_.dirty &= ~(1UL << key);
+    count = encode_(record, key);
+    taskEXIT_CRITICAL();
+    copied |= (1UL << key);
+
+    seal_(record, count);
+    if (!program_(other, pos, record, count))
+    {
+      // the old sector is still the active one, keep the copied keys pending
+      taskENTER_CRITICAL();
+      kv_.dirty |= copied;
+      taskEXIT_CRITICAL();
+      return false;
+    }
+    pos += count;
+  }
+
+  if (!write_header_(other, kv_.stats.generation + 1U))
+  {
+    taskENTER_CRITICAL();
+    kv_.dirty |= copied;
+    taskEXIT_CRITICAL();
+    return false;
+  }
+
+  other = (uint32_t)kv_.active;
+  kv_.active = 1 - kv_.active;
+  kv_.write = pos;
+  kv_.stats.generation++;
+  kv_.stats.compactions++;
+
+  kv_.other_blank = erase_(other);
+  return true;
+}
+
+static void flush_(void)
+{
+  for (uint32_t key = 0; key < KVSTORE_KEY__N; key++)
+  {
+    uint32_t record[RECORD_WORDS_MAX_];
+    uint32_t count;
+
+    taskENTER_CRITICAL();
+    if (0U == (kv_.dirty & (1UL << key)))
+    {
+      taskEXIT_CRITICAL();
+      continue;
+    }
+    kv_.dirty &= ~(1UL << key);
+    count = encode_(record, key);
+    taskEXIT_CRITICAL();
+
+    if (SECTOR_WORDS_ - kv_.write < count)
+    {
+      // the compaction writes the new value too
+      if (!compact_())
+      {
+        taskENTER_CRITICAL();
+        kv_.dirty |= (1UL << key);
+        taskEXIT_CRITICAL();
+        return;
+      }
+      continue;
+    }
+
+    seal_(record, count);
+    if (!program_((uint32_t)kv_.active, kv_.write, record, count))
+    {
+      // the words may be half programmed, leave them and compact next time
+      kv_.write = SECTOR_WORDS_;
+      taskENTER_CRITICAL();
+      kv_.dirty |= (1UL << key);
+      taskEXIT_CRITICAL();
+      return;
+    }
+    kv_.write += count;
+    kv_.stats.records++;
+
+    if (COMPACT_FREE_WORDS_ > (SECTOR_WORDS_ - kv_.write))
+    {
+      (void)compact_();
+    }
+  }
+}
+
+static void task_kvstore_(void *argument)
+{
+  // leftovers of an interrupted compaction or erase, see the file header
+  if (0 > kv_.active)
+  {
+    if (!format_())
+    {
+      LOGGER_INFO("KV\t- Cannot format the flash sectors");
+    }
+  }
+  else
+  {
+    if (!kv_.other_blank)
+    {
+      kv_.other_blank = erase_(1U - (uint32_t)kv_.active);
+    }
+    if (COMPACT_FREE_WORDS_ > (SECTOR_WORDS_ - kv_.write))
+    {
+      (void)compact_();
+    }
+  }
+
+  while (true)
+  {
+    if (0 <= kv_.active)
+    {
+      flush_();
+    }
+    (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  }
+}
+
+/********************** external functions definition ************************/
+
+void kvstore_init(void)
+{
+#if 1 == KVSTORE_CONFIG_ENABLE
+  BaseType_t status;
+  bool valid[2];
+  uint32_t generation[2];
+
+  // a compaction must always fit, with room to spare
+  configASSERT((HEADER_WORDS_ + (KVSTORE_KEY__N * RECORD_WORDS_MAX_) + COMPACT_FREE_WORDS_)
+               < SECTOR_WORDS_);
+  configASSERT((0U == (KVSTORE_CONFIG_VALUE_MAX % 4U)) && (32U >= KVSTORE_KEY__N));
+
+  for (uint32_t s = 0; s < 2U; s++)
+  {
+    valid[s] = (MAGIC_ == words_(s)[0]);
+    generation[s] = words_(s)[1];
+  }
+
+  kv_.active = -1;
+  if (valid[0] && valid[1])
+  {
+    kv_.active = (0 < (int32_t)(generation[1] - generation[0])) ? 1 : 0;
+    kv_.other_blank = false;
+  }
+  else if (valid[0] || valid[1])
+  {
+    kv_.active = valid[0] ? 0 : 1;
+    kv_.other_blank = blank_(1U - (uint32_t)kv_.active);
+  }
+
+  if (0 <= kv_.active)
+  {
+    kv_.stats.generation = generation[kv_.active];
+    scan_((uint32_t)kv_.active);
+    LOGGER_INFO("KV\t- Generation %lu, %lu bytes used", (unsigned long)kv_.stats.generation,
+                (unsigned long)(kv_.write * 4U));
+  }
+  else
+  {
+    LOGGER_INFO("KV\t- Empty, formatting");
+  }
+
+  status = xTaskCreate
+		  (
+			  task_kvstore_,
+			  "task_kvstore",
+			  TASK_KVSTORE_STACK_,
+			  NULL,
+			  TASK_KVSTORE_PRIORITY_,
+			  &kv_.htask
+		  );
+  configASSERT(pdPASS == status);
+#endif
+}
+
+uint32_t kvstore_get(kvstore_key_t key, void *data)
+{
+  uint32_t len;
+  UBaseType_t mask;
+
+  if (KVSTORE_KEY__N <= key)
+  {
+    return 0U;
+  }
+  // the ISR form also masks from a task, and nests in an interrupt
+  mask = taskENTER_CRITICAL_FROM_ISR();
+  len = kv_.value[key].len;
+  memcpy(data, kv_.value[key].data, len);
+  taskEXIT_CRITICAL_FROM_ISR(mask);
+  return len;
+}
+
+bool kvstore_set(kvstore_key_t key, const void *data, uint32_t len)
+{
+  bool changed;
+
+  if ((KVSTORE_KEY__N <= key) || (0U == len) || (KVSTORE_CONFIG_VALUE_MAX < len))
+  {
+    return false;
+  }
+
+  taskENTER_CRITICAL();
+  changed = (len != kv_.value[key].len) || (0 != memcmp(kv_.value[key].data, data, len));
+  if (changed)
+  {
+    kv_.value[key].len = len;
+    memcpy(kv_.value[key].data, data, len);
+    kv_.dirty |= (1UL << key);
+  }
+  taskEXIT_CRITICAL();
+
+  if (changed && (NULL != kv_.htask))
+  {
+    xTaskNotifyGive(kv_.htask);
+  }
+  return true;
+}
+
+bool kvstore_get_u32(kvstore_key_t key, uint32_t *value)
+{
+  uint8_t data[KVSTORE_CONFIG_VALUE_MAX];
+
+  if (sizeof(*value) != kvstore_get(key, data))
+  {
+    return false;
+  }
+  memcpy(value, data, sizeof(*value));
+  return true;
+}
+
+bool kvstore_set_u32(kvstore_key_t key, uint32_t value)
+{
+  return kvstore_set(key, &value, sizeof(value));
+}
+
+void kvstore_get_stats(kvstore_stats_t *stats)
+{
+  taskENTER_CRITICAL();
+  *stats = kv_.stats;
+  stats->used_bytes = kv_.write * 4U;
+  taskEXIT_CRITICAL();
+}
+
+/********************** end of file ******************************************/
@@ -0,0 +1,385 @@
+/**
+ * @file led_pwm.c
+ * @brief Hardware PWM brightness and fades for LD1, LD2 and LD3
+ *
+ * The three LED pins have no timer in common: LD1 is on TIM3, LD2 on TIM4 and
+ * LD3 on TIM12, all at the same rate with preloaded compare registers, so a
+ * new value takes effect at the next period. TIM12 has no DMA request of its
+ * own; its compare register is written by the stream paced by TIM4 channel
+ * 1, which runs at the same rate.
+ *
+ * LED    pin   timer / channel   DMA1 request       stream / channel
+ * LD1    PB0   TIM3 / 3          TIM3_UP            2 / 5
+ * LD2    PB7   TIM4 / 2          TIM4_UP            6 / 2
+ * LD3    PB14  TIM12 / 1         TIM4_CH1 (at 0)    0 / 2
+ *
+ * Each fade runs through a circular ring of compare values. The half
+ * transfer and transfer complete interrupts refill the half just written,
+ * and the transfer stops once the half holding the last step has been
+ * written.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+/********************** inclusions *******************************************/
+#include <math.h>
+
+#include "main.h"
+#include "cmsis_os.h"
+#include "fastio.h"
+
+#include "led_pwm.h"
+
+/********************** macros and definitions *******************************/
+#define HALF_                   (LED_PWM_CONFIG_HALF_BUFFER)
+#define TICK_HZ_                (LED_PWM_CONFIG_FREQUENCY_HZ * LED_PWM_CONFIG_RESOLUTION)
+
+/********************** internal data declaration ****************************/
+typedef struct
+{
+  DMA_HandleTypeDef  hdma;
+  TIM_HandleTypeDef *htim;
+  uint32_t           channel;
+  volatile uint32_t *ccr;
+  uint16_t           pin;
+  uint8_t            af;
+  uint16_t           ring[2U * HALF_];
+  uint8_t            half_level[2];   /**< Level at the end of each half */
+  int32_t            from_q8;         /**< Levels in 1/256 */
+  int32_t            delta_q8;
+  uint32_t           steps;
+  uint32_t           step;            /**< Last step put in the ring */
+  int32_t            ending;          /**< Half holding the last step, -1 before */
+  uint8_t            target;
+  volatile uint8_t   level;
+  volatile bool      fading;
+  SemaphoreHandle_t  hdone;
+} led_t;
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+static TIM_HandleTypeDef htim3_;
+static TIM_HandleTypeDef htim4_;
+static TIM_HandleTypeDef htim12_;
+
+static uint16_t gamma_[LED_PWM_LEVEL_MAX + 1U];
+
+static led_t leds_[LED_PWM__N];
+
+static bool enabled_;
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+static uint16_t ccr_(int32_t level_q8)
+{
+  uint32_t index = (uint32_t)level_q8 >> 8;
+  int32_t frac = level_q8 & 0xFF;
+  int32_t low = gamma_[index];
+  int32_t high = gamma_[(LED_PWM_LEVEL_MAX > index) ? (index + 1U) : index];
+
+  return (uint16_t)(low + (((high - low) * frac) >> 8));
+}
+
+static void fill_(led_t *led, uint32_t half)
+{
+  uint16_t *p = &led->ring[half * HALF_];
+  int32_t level_q8 = (int32_t)led->target << 8;
+
+  for (uint32_t i = 0; i < HALF_; i++)
+  {
+    if (led->step < led->steps)
+    {
+      led->step++;
+      level_q8 = led->from_q8 + (int32_t)(((int64_t)led->delta_q8 * led->step) / led->steps);
+    }
+    else
+    {
+      level_q8 = (int32_t)led->target << 8;
+    }
+    p[i] = ccr_(level_q8);
+  }
+  led->half_level[half] = (uint8_t)((level_q8 + 0x80) >> 8);
+
+  if ((led->step >= led->steps) && (0 > led->ending))
+  {
+    led->ending = (int32_t)half;
+  }
+}
+
+/* Ends the fade of a LED, with interrupts masked or from its own DMA
+ * interrupt. */
+static void stop_(led_t *led)
+{
+  if (HAL_DMA_STATE_BUSY == HAL_DMA_GetState(&led->hdma))
+  {
+    // HAL_DMA_Abort() would wait on the tick, which is masked here
+    (void)fastio_dma_stop(&led->hdma);
+  }
+  led->fading = false;
+}
+
+static void half_done_(led_t *led, uint32_t half)
+{
+  BaseType_t woken = pdFALSE;
+
+  led->level = led->half_level[half];
+  if ((int32_t)half != led->ending)
+  {
+    fill_(led, half);
+    return;
+  }
+
+  stop_(led);
+  *led->ccr = gamma_[led->target];
+  led->level = led->target;
+  xSemaphoreGiveFromISR(led->hdone, &woken);
+  portYIELD_FROM_ISR(woken);
+}
+
+static void dma_half_(DMA_HandleTypeDef *hdma)
+{
+  half_done_((led_t *)hdma->Parent, 0U);
+}
+
+static void dma_full_(DMA_HandleTypeDef *hdma)
+{
+  half_done_((led_t *)hdma->Parent, 1U);
+}
+
+static void timer_init_(TIM_HandleTypeDef *htim, TIM_TypeDef *instance, uint32_t timclock)
+{
+  htim->Instance = instance;
+  htim->Init.Prescaler = (timclock / TICK_HZ_) - 1U;
+  htim->Init.CounterMode = TIM_COUNTERMODE_UP;
+  htim->Init.Period = LED_PWM_CONFIG_RESOLUTION - 1U;
+  htim->Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+  htim->Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_ENABLE;
+  if (HAL_OK != HAL_TIM_PWM_Init(htim))
+  {
+    Error_Handler();
+  }
+}
+
+static void led_init_(led_t *led, TIM_HandleTypeDef *htim, uint32_t channel, volatile uint32_t *ccr,
+                      uint16_t pin, uint8_t af, DMA_Stream_TypeDef *stream, uint32_t dma_channel,
+                      IRQn_Type irq)
+{
+  TIM_OC_InitTypeDef sConfigOC = {0};
+
+  led->htim = htim;
+  led->channel = channel;
+  led->ccr = ccr;
+  led->pin = pin;
+  led->af = af;
+  led->hdone = xSemaphoreCreateBinary();
+  configASSERT(NULL != led->hdone);
+
+  sConfigOC.OCMode = TIM_OCMODE_PWM1;
+  sConfigOC.Pulse = 0U;
+  sConfigOC.OCPolarity = TIM_OCPOLARITY_HIGH;
+  sConfigOC.OCFastMode = TIM_OCFAST_DISABLE;
+  if (HAL_OK != HAL_TIM_PWM_ConfigChannel(htim, &sConfigOC, channel))
+  {
+    Error_Handler();
+  }
+
+  led->hdma.Instance = stream;
+  led->hdma.Init.Channel = dma_channel;
+  led->hdma.Init.Direction = DMA_MEMORY_TO_PERIPH;
+  led->hdma.Init.PeriphInc = DMA_PINC_DISABLE;
+  led->hdma.Init.MemInc = DMA_MINC_ENABLE;
+  led->hdma.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+  led->hdma.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
+  led->hdma.Init.Mode = DMA_CIRCULAR;
+  led->hdma.Init.Priority = DMA_PRIORITY_LOW;
+  led->hdma.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+  if (HAL_OK != HAL_DMA_Init(&led->hdma))
+  {
+    Error_Handler();
+  }
+  led->hdma.Parent = led;
+  led->hdma.XferHalfCpltCallback = dma_half_;
+  led->hdma.XferCpltCallback = dma_full_;
+
+  HAL_NVIC_SetPriority(irq, LED_PWM_CONFIG_IRQ_PRIORITY, 0);
+  HAL_NVIC_EnableIRQ(irq);
+}
+
+static void pins_(bool pwm)
+{
+  GPIO_InitTypeDef init = {0};
+
+  for (uint32_t i = 0; i < LED_PWM__N; i++)
+  {
+    init.Pin = leds_[i].pin;
+    init.Mode = pwm ? GPIO_MODE_AF_PP : GPIO_MODE_OUTPUT_PP;
+    init.Pull = GPIO_NOPULL;
+    init.Speed = GPIO_SPEED_FREQ_LOW;
+    init.Alternate = leds_[i].af;
+    if (!pwm)
+    {
+      HAL_GPIO_WritePin(GPIOB, leds_[i].pin, GPIO_PIN_RESET);
+    }
+    HAL_GPIO_Init(GPIOB, &init);
+  }
+}
+
+/********************** external functions definition ************************/
+
+void led_pwm_init(void)
+{
+#if 1 == LED_PWM_CONFIG_ENABLE
+  TIM_OC_InitTypeDef sConfigOC = {0};
+  uint32_t timclock;
+
+  for (uint32_t i = 0; i <= LED_PWM_LEVEL_MAX; i++)
+  {
+    float x = (float)i / (float)LED_PWM_LEVEL_MAX;
+
+    gamma_[i] = (uint16_t)((powf(x, LED_PWM_CONFIG_GAMMA) * (float)LED_PWM_CONFIG_RESOLUTION) + 0.5f);
+  }
+
+  // APB1 timers run at twice PCLK1 whenever APB1 is divided
+  timclock = HAL_RCC_GetPCLK1Freq();
+  if (RCC_HCLK_DIV1 != (RCC->CFGR & RCC_CFGR_PPRE1))
+  {
+    timclock *= 2U;
+  }
+
+  __HAL_RCC_TIM3_CLK_ENABLE();
+  __HAL_RCC_TIM4_CLK_ENABLE();
+  __HAL_RCC_TIM12_CLK_ENABLE();
+  __HAL_RCC_DMA1_CLK_ENABLE();
+
+  timer_init_(&htim3_, TIM3, timclock);
+  timer_init_(&htim4_, TIM4, timclock);
+  timer_init_(&htim12_, TIM12, timclock);
+
+  led_init_(&leds_[LED_PWM_LD1], &htim3_, TIM_CHANNEL_3, &TIM3->CCR3, LD1_Pin, GPIO_AF2_TIM3,
+            DMA1_Stream2, DMA_CHANNEL_5, DMA1_Stream2_IRQn);
+  led_init_(&leds_[LED_PWM_LD2], &htim4_, TIM_CHANNEL_2, &TIM4->CCR2, LD2_Pin, GPIO_AF2_TIM4,
+            DMA1_Stream6, DMA_CHANNEL_2, DMA1_Stream6_IRQn);
+  led_init_(&leds_[LED_PWM_LD3], &htim12_, TIM_CHANNEL_1, &TIM12->CCR1, LD3_Pin, GPIO_AF9_TIM12,
+            DMA1_Stream0, DMA_CHANNEL_2, DMA1_Stream0_IRQn);
+
+  // TIM4 channel 1 has no output, it only paces the LD3 stream
+  sConfigOC.OCMode = TIM_OCMODE_TIMING;
+  sConfigOC.Pulse = 0U;
+  sConfigOC.OCPolarity = TIM_OCPOLARITY_HIGH;
+  sConfigOC.OCFastMode = TIM_OCFAST_DISABLE;
+  if (HAL_OK != HAL_TIM_OC_ConfigChannel(&htim4_, &sConfigOC, TIM_CHANNEL_1))
+  {
+    Error_Handler();
+  }
+  __HAL_TIM_ENABLE_DMA(&htim3_, TIM_DMA_UPDATE);
+  __HAL_TIM_ENABLE_DMA(&htim4_, TIM_DMA_UPDATE | TIM_DMA_CC1);
+
+  // the pins stay on GPIO until led_pwm_enable()
+  for (uint32_t i = 0; i < LED_PWM__N; i++)
+  {
+    if (HAL_OK != HAL_TIM_PWM_Start(leds_[i].htim, leds_[i].channel))
+    {
+      Error_Handler();
+    }
+  }
+#endif
+}
+
+void led_pwm_enable(bool enable)
+{
+  if (!enable)
+  {
+    for (uint32_t i = 0; i < LED_PWM__N; i++)
+    {
+      led_pwm_set((led_pwm_led_t)i, 0U);
+    }
+  }
+  pins_(enable);
+  enabled_ = enable;
+}
+
+bool led_pwm_enabled(void)
+{
+  return enabled_;
+}
+
+void led_pwm_set(led_pwm_led_t led, uint8_t level)
+{
+  led_t *l = &leds_[led];
+
+  taskENTER_CRITICAL();
+  if (l->fading)
+  {
+    stop_(l);
+    xSemaphoreGive(l->hdone);
+  }
+  l->target = level;
+  l->level = level;
+  *l->ccr = gamma_[level];
+  taskEXIT_CRITICAL();
+}
+
+void led_pwm_fade(led_pwm_led_t led, uint8_t level, uint32_t duration_ms)
+{
+  led_t *l = &leds_[led];
+  uint32_t steps = (uint32_t)(((uint64_t)duration_ms * LED_PWM_CONFIG_FREQUENCY_HZ) / 1000U);
+
+  if (0U == steps)
+  {
+    led_pwm_set(led, level);
+    return;
+  }
+
+  taskENTER_CRITICAL();
+  stop_(l);
+  taskEXIT_CRITICAL();
+  // drop the completion of the fade just replaced
+  (void)xSemaphoreTake(l->hdone, 0);
+
+  l->from_q8 = (int32_t)l->level << 8;
+  l->delta_q8 = ((int32_t)level - (int32_t)l->level) << 8;
+  l->steps = steps;
+  l->step = 0U;
+  l->ending = -1;
+  l->target = level;
+  fill_(l, 0U);
+  fill_(l, 1U);
+  l->fading = true;
+  if (HAL_OK != HAL_DMA_Start_IT(&l->hdma, (uint32_t)l->ring, (uint32_t)l->ccr, 2U * HALF_))
+  {
+    Error_Handler();
+  }
+}
+
+bool led_pwm_wait(led_pwm_led_t led, TickType_t timeout)
+{
+  return (pdTRUE == xSemaphoreTake(leds_[led].hdone, timeout));
+}
+
+uint8_t led_pwm_get(led_pwm_led_t led)
+{
+  return leds_[led].level;
+}
+
+void led_pwm_stream0_irq_handler(void)
+{
+  HAL_DMA_IRQHandler(&leds_[LED_PWM_LD3].hdma);
+}
+
+void led_pwm_stream2_irq_handler(void)
+{
+  HAL_DMA_IRQHandler(&leds_[LED_PWM_LD1].hdma);
+}
+
+void led_pwm_stream6_irq_handler(void)
+{
+  HAL_DMA_IRQHandler(&leds_[LED_PWM_LD2].hdma);
+}
+
+/********************** end of file ******************************************/
@@ -0,0 +1,292 @@
+/**
+ * @file led_wave.c
+ * @brief LED waveform engine: timer-paced DMA writes to GPIOB->BSRR
+ *
+ * Only DMA2 reaches the GPIO ports and the only DMA2 request of a timer
+ * update not taken by the HAL timebase (TIM1) is TIM8_UP, on stream 1, which
+ * the CRC feed uses. The steps are therefore paced by compare channel 1 of
+ * TIM8 at count 0, one request per timer period, on stream 2 channel 7.
+ *
+ * Patterns played forever use a circular transfer. Finite ones use single
+ * transfers restarted from the completion interrupt, the last one extended
+ * with a word turning every LED of the pattern off, so the final step lasts
+ * as long as the others.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+/********************** inclusions *******************************************/
+#include "main.h"
+#include "cmsis_os.h"
+#include "fastio.h"
+
+#include "led_wave.h"
+
+/********************** macros and definitions *******************************/
+#define LEDS_MASK_              (LD1_Pin | LD2_Pin | LD3_Pin)
+#define FINE_TICK_HZ_           (1000000U)   /**< Steps up to 65536 us */
+#define COARSE_TICK_HZ_         (10000U)     /**< Steps up to LED_WAVE_STEP_MAX_US */
+#define FINE_STEP_MAX_US_       (65536U)
+
+/********************** internal data declaration ****************************/
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+static TIM_HandleTypeDef htim8_;
+static DMA_HandleTypeDef hdma_tim8_ch1_;
+
+static uint32_t buffer_[LED_WAVE_CONFIG_MAX_STEPS + 1U];
+
+static struct
+{
+  uint32_t          timclock;
+  uint32_t          mask;        /**< LEDs of the pattern playing */
+  uint32_t          length;
+  volatile uint32_t remaining;   /**< Plays left, 0 forever */
+  volatile bool     playing;
+  SemaphoreHandle_t hdone;
+} wave_;
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+static uint32_t build_(const led_wave_pattern_t *pattern)
+{
+  uint32_t mask = 0U;
+
+  for (uint32_t c = 0; c < pattern->channels; c++)
+  {
+    mask |= pattern->channel[c].pin;
+  }
+
+  for (uint32_t s = 0; s < pattern->length; s++)
+  {
+    uint32_t word = 0U;
+
+    for (uint32_t c = 0; c < pattern->channels; c++)
+    {
+      const led_wave_channel_t *ch = &pattern->channel[c];
+      bool on = false;
+
+      if (0U != ch->period)
+      {
+        on = (((s + ch->period - (ch->phase % ch->period)) % ch->period) < ch->on);
+      }
+      // BSRR: low half sets, high half resets
+      word |= on ? ch->pin : ((uint32_t)ch->pin << 16);
+    }
+    buffer_[s] = word;
+  }
+  buffer_[pattern->length] = mask << 16;
+  return mask;
+}
+
+static void timer_set_step_(uint32_t step_us)
+{
+  uint32_t hz = (FINE_STEP_MAX_US_ >= step_us) ? FINE_TICK_HZ_ : COARSE_TICK_HZ_;
+  uint32_t ticks = (FINE_TICK_HZ_ == hz) ? step_us : (step_us / (FINE_TICK_HZ_ / COARSE_TICK_HZ_));
+
+  __HAL_TIM_SET_PRESCALER(&htim8_, (wave_.timclock / hz) - 1U);
+  __HAL_TIM_SET_AUTORELOAD(&htim8_, ticks - 1U);
+  __HAL_TIM_SET_COUNTER(&htim8_, 0U);
+  // load the prescaler now, not at the next update
+  htim8_.Instance->EGR = TIM_EGR_UG;
+  __HAL_TIM_CLEAR_FLAG(&htim8_, TIM_FLAG_UPDATE | TIM_FLAG_CC1);
+}
+
+static void stop_(void)
+{
+  __HAL_TIM_DISABLE_DMA(&htim8_, TIM_DMA_CC1);
+  __HAL_TIM_DISABLE(&htim8_);
+  if (HAL_DMA_STATE_BUSY == HAL_DMA_GetState(&hdma_tim8_ch1_))
+  {
+    // called with interrupts masked, HAL_DMA_Abort() would wait forever
+    (void)fastio_dma_stop(&hdma_tim8_ch1_);
+  }
+  GPIOB->BSRR = wave_.mask << 16;
+  if (wave_.playing)
+  {
+    wave_.playing = false;
+    xSemaphoreGive(wave_.hdone);
+  }
+}
+
+static void dma_done_(DMA_HandleTypeDef *hdma)
+{
+  BaseType_t woken = pdFALSE;
+
+  // circular: plays forever
+  if (0U == wave_.remaining)
+  {
+    return;
+  }
+
+  wave_.remaining--;
+  if (0U != wave_.remaining)
+  {
+    // the next request comes one step later, plenty of time to restart
+    (void)HAL_DMA_Start_IT(hdma, (uint32_t)buffer_, (uint32_t)&GPIOB->BSRR,
+                           wave_.length + ((1U == wave_.remaining) ? 1U : 0U));
+    return;
+  }
+
+  // the off word has just been written
+  __HAL_TIM_DISABLE_DMA(&htim8_, TIM_DMA_CC1);
+  __HAL_TIM_DISABLE(&htim8_);
+  wave_.playing = false;
+  xSemaphoreGiveFromISR(wave_.hdone, &woken);
+  portYIELD_FROM_ISR(woken);
+}
+
+/********************** external functions definition ************************/
+
+void led_wave_init(void)
+{
+#if 1 == LED_WAVE_CONFIG_ENABLE
+  TIM_OC_InitTypeDef sConfigOC = {0};
+
+  wave_.hdone = xSemaphoreCreateBinary();
+  configASSERT(NULL != wave_.hdone);
+
+  // APB2 timers run at twice PCLK2 whenever APB2 is divided
+  wave_.timclock = HAL_RCC_GetPCLK2Freq();
+  if (0U != (RCC->CFGR & RCC_CFGR_PPRE2))
+  {
+    wave_.timclock *= 2U;
+  }
+
+  __HAL_RCC_TIM8_CLK_ENABLE();
+  __HAL_RCC_DMA2_CLK_ENABLE();
+
+  htim8_.Instance = TIM8;
+  htim8_.Init.Prescaler = (wave_.timclock / FINE_TICK_HZ_) - 1U;
+  htim8_.Init.CounterMode = TIM_COUNTERMODE_UP;
+  htim8_.Init.Period = 1000U - 1U;
+  htim8_.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+  htim8_.Init.RepetitionCounter = 0U;
+  htim8_.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+  if (HAL_OK != HAL_TIM_Base_Init(&htim8_))
+  {
+    Error_Handler();
+  }
+
+  // no output: the compare only paces the DMA requests
+  sConfigOC.OCMode = TIM_OCMODE_TIMING;
+  sConfigOC.Pulse = 0U;
+  sConfigOC.OCPolarity = TIM_OCPOLARITY_HIGH;
+  sConfigOC.OCFastMode = TIM_OCFAST_DISABLE;
+  if (HAL_OK != HAL_TIM_OC_ConfigChannel(&htim8_, &sConfigOC, TIM_CHANNEL_1))
+  {
+    Error_Handler();
+  }
+
+  hdma_tim8_ch1_.Instance = DMA2_Stream2;
+  hdma_tim8_ch1_.Init.Channel = DMA_CHANNEL_7;
+  hdma_tim8_ch1_.Init.Direction = DMA_MEMORY_TO_PERIPH;
+  hdma_tim8_ch1_.Init.PeriphInc = DMA_PINC_DISABLE;
+  hdma_tim8_ch1_.Init.MemInc = DMA_MINC_ENABLE;
+  hdma_tim8_ch1_.Init.PeriphDataAlignment = DMA_PDATAALIGN_WORD;
+  hdma_tim8_ch1_.Init.MemDataAlignment = DMA_MDATAALIGN_WORD;
+  hdma_tim8_ch1_.Init.Mode = DMA_NORMAL;
+  hdma_tim8_ch1_.Init.Priority = DMA_PRIORITY_HIGH;
+  hdma_tim8_ch1_.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+  if (HAL_OK != HAL_DMA_Init(&hdma_tim8_ch1_))
+  {
+    Error_Handler();
+  }
+  hdma_tim8_ch1_.XferCpltCallback = dma_done_;
+
+  HAL_NVIC_SetPriority(DMA2_Stream2_IRQn, LED_WAVE_CONFIG_IRQ_PRIORITY, 0);
+  HAL_NVIC_EnableIRQ(DMA2_Stream2_IRQn);
+#endif
+}
+
+bool led_wave_valid(const led_wave_pattern_t *pattern)
+{
+  if ((LED_WAVE_STEP_MIN_US > pattern->step_us) || (LED_WAVE_STEP_MAX_US < pattern->step_us)
+      || (0U == pattern->length) || (LED_WAVE_CONFIG_MAX_STEPS < pattern->length)
+      || (LED_WAVE_MAX_CHANNELS < pattern->channels))
+  {
+    return false;
+  }
+  for (uint32_t c = 0; c < pattern->channels; c++)
+  {
+    const led_wave_channel_t *ch = &pattern->channel[c];
+
+    if ((0U == ch->pin) || (0U != (ch->pin & ~LEDS_MASK_)) || (ch->on > ch->period))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool led_wave_play(const led_wave_pattern_t *pattern)
+{
+  if (!led_wave_valid(pattern))
+  {
+    return false;
+  }
+
+  taskENTER_CRITICAL();
+  stop_();
+  taskEXIT_CRITICAL();
+  // drop the completion of the pattern just replaced
+  (void)xSemaphoreTake(wave_.hdone, 0);
+
+  wave_.mask = build_(pattern);
+  wave_.length = pattern->length;
+  wave_.remaining = pattern->repeat;
+  wave_.playing = true;
+  timer_set_step_(pattern->step_us);
+
+  // the stream is disabled here, its mode can be changed
+  if (0U == pattern->repeat)
+  {
+    SET_BIT(hdma_tim8_ch1_.Instance->CR, DMA_SxCR_CIRC);
+  }
+  else
+  {
+    CLEAR_BIT(hdma_tim8_ch1_.Instance->CR, DMA_SxCR_CIRC);
+  }
+  if (HAL_OK != HAL_DMA_Start_IT(&hdma_tim8_ch1_, (uint32_t)buffer_, (uint32_t)&GPIOB->BSRR,
+                                 wave_.length + ((1U == pattern->repeat) ? 1U : 0U)))
+  {
+    Error_Handler();
+  }
+  __HAL_TIM_ENABLE_DMA(&htim8_, TIM_DMA_CC1);
+  // the first compare match is one step away: request the first word now,
+  // so the pattern lasts exactly led_wave_duration_us()
+  htim8_.Instance->EGR = TIM_EGR_CC1G;
+  __HAL_TIM_ENABLE(&htim8_);
+  return true;
+}
+
+void led_wave_stop(void)
+{
+  taskENTER_CRITICAL();
+  stop_();
+  taskEXIT_CRITICAL();
+}
+
+bool led_wave_wait(TickType_t timeout)
+{
+  return (pdTRUE == xSemaphoreTake(wave_.hdone, timeout));
+}
+
+uint64_t led_wave_duration_us(const led_wave_pattern_t *pattern)
+{
+  return (uint64_t)pattern->step_us * pattern->length * pattern->repeat;
+}
+
+void led_wave_dma_irq_handler(void)
+{
+  HAL_DMA_IRQHandler(&hdma_tim8_ch1_);
+}
+
+/********************** end of file ******************************************/
@@ -46,6 +46,7 @@
 #include "cmsis_os.h"
 
 #include "logger.h"
+#include "telemetry.h"
 
 /********************** macros and definitions *******************************/
 
@@ -60,20 +61,32 @@
 static char logger_msg_buffer_[LOGGER_CONFIG_MAXLEN];
 char* const logger_msg = logger_msg_buffer_;
 int logger_msg_len;
+volatile int logger_threshold = LOGGER_LEVEL_INFO;
 
 /********************** internal functions definition ************************/
 
 /********************** external functions definition ************************/
 
+void logger_set_threshold(int level)
+{
+    logger_threshold = level;
+}
+
 #if 1 == LOGGER_CONFIG_USE_SEMIHOSTING
 void logger_log_print_(char* const msg)
 {
+#if 1 == LOGGER_CONFIG_USE_TELEMETRY
+	telemetry_log(msg, strlen(msg));
+#endif
 	printf(msg);
 	fflush(stdout);
 }
 #else
 void logger_log_print_(char* const msg)
 {
+#if 1 == LOGGER_CONFIG_USE_TELEMETRY
+    telemetry_log(msg, strlen(msg));
+#endif
     return;
 }
 #endif
@@ -0,0 +1,174 @@
+/**
+ * @file monoclock.c
+ * @brief Unified 64-bit monotonic clock
+ *
+ * now_us() combines a software high word, incremented on TIM5 overflow, with
+ * the counter. If the overflow is pending but not yet serviced (the reader
+ * runs with the TIM5 interrupt masked or at a higher priority), a low counter
+ * value means the wrap already happened and the high word is compensated.
+ *
+ * now_cycles() reads one of two epoch slots {64-bit cycles, CYCCNT at that
+ * moment}. The single writer, the channel 4 interrupt, fills the slot that
+ * is not published and then bumps the sequence number; readers retry when the
+ * sequence changed under them.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+/********************** inclusions *******************************************/
+#include "main.h"
+#include "dwt.h"
+
+#include "monoclock.h"
+
+/********************** macros and definitions *******************************/
+#define TIMER_TICK_HZ_          (1000000U)
+#define COUNTER_HALF_           (0x80000000U)
+
+/********************** internal data declaration ****************************/
+typedef struct
+{
+  uint64_t cycles;  /**< 64-bit cycle count at the epoch */
+  uint32_t cyccnt;  /**< DWT->CYCCNT at the epoch */
+} epoch_t;
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+static volatile uint32_t us_high_;
+static epoch_t epoch_[2];
+static volatile uint32_t epoch_seq_;
+
+/********************** external data definition *****************************/
+TIM_HandleTypeDef htim5;
+
+/********************** internal functions definition ************************/
+
+static void epoch_advance_(void)
+{
+  uint32_t seq = epoch_seq_;
+  const epoch_t *cur = &epoch_[seq & 1U];
+  epoch_t *next = &epoch_[(seq + 1U) & 1U];
+  uint32_t cyccnt = DWT->CYCCNT;
+
+  next->cycles = cur->cycles + (uint32_t)(cyccnt - cur->cyccnt);
+  next->cyccnt = cyccnt;
+  __DMB();
+  epoch_seq_ = seq + 1U;
+}
+
+/********************** external functions definition ************************/
+
+void monoclock_init(void)
+{
+  TIM_OC_InitTypeDef sConfigOC = {0};
+  uint32_t timclock;
+
+  // started at boot by the profiler (boot.h): keep it counting, never reset
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  cycle_counter_enable();
+  epoch_[0].cycles = 0U;
+  epoch_[0].cyccnt = DWT->CYCCNT;
+  epoch_seq_ = 0U;
+  us_high_ = 0U;
+
+  // APB1 timers run at twice PCLK1 whenever APB1 is divided
+  timclock = HAL_RCC_GetPCLK1Freq();
+  if (RCC_HCLK_DIV1 != (RCC->CFGR & RCC_CFGR_PPRE1))
+  {
+    timclock *= 2U;
+  }
+
+  __HAL_RCC_TIM5_CLK_ENABLE();
+
+  htim5.Instance = TIM5;
+  htim5.Init.Prescaler = (timclock / TIMER_TICK_HZ_) - 1U;
+  htim5.Init.CounterMode = TIM_COUNTERMODE_UP;
+  htim5.Init.Period = 0xFFFFFFFFU;
+  htim5.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+  htim5.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+  if (HAL_OK != HAL_TIM_Base_Init(&htim5))
+  {
+    Error_Handler();
+  }
+
+  sConfigOC.OCMode = TIM_OCMODE_TIMING;
+  sConfigOC.Pulse = MONOCLOCK_EPOCH_US;
+  sConfigOC.OCPolarity = TIM_OCPOLARITY_HIGH;
+  sConfigOC.OCFastMode = TIM_OCFAST_DISABLE;
+  if (HAL_OK != HAL_TIM_OC_ConfigChannel(&htim5, &sConfigOC, TIM_CHANNEL_4))
+  {
+    Error_Handler();
+  }
+
+  // the init sequence forces an update event: drop it before enabling
+  __HAL_TIM_CLEAR_FLAG(&htim5, TIM_FLAG_UPDATE | TIM_FLAG_CC4);
+  __HAL_TIM_ENABLE_IT(&htim5, TIM_IT_UPDATE | TIM_IT_CC4);
+
+  HAL_NVIC_SetPriority(TIM5_IRQn, MONOCLOCK_CONFIG_IRQ_PRIORITY, 0);
+  HAL_NVIC_EnableIRQ(TIM5_IRQn);
+
+  __HAL_TIM_ENABLE(&htim5);
+}
+
+uint64_t now_us(void)
+{
+  uint32_t high;
+  uint32_t high_seen;
+  uint32_t low;
+
+  do
+  {
+    high_seen = us_high_;
+    low = TIM5->CNT;
+    high = high_seen;
+    if ((0U != (TIM5->SR & TIM_SR_UIF)) && (COUNTER_HALF_ > low))
+    {
+      high++;
+    }
+  } while (high_seen != us_high_);
+
+  return ((uint64_t)high << 32) | low;
+}
+
+uint64_t now_cycles(void)
+{
+  uint32_t seq;
+  uint32_t cyccnt;
+  uint64_t cycles;
+  uint32_t ref;
+
+  do
+  {
+    seq = epoch_seq_;
+    __DMB();
+    cycles = epoch_[seq & 1U].cycles;
+    ref = epoch_[seq & 1U].cyccnt;
+    cyccnt = DWT->CYCCNT;
+    __DMB();
+  } while (seq != epoch_seq_);
+
+  return cycles + (uint32_t)(cyccnt - ref);
+}
+
+void monoclock_irq_handler(void)
+{
+  if (__HAL_TIM_GET_FLAG(&htim5, TIM_FLAG_UPDATE))
+  {
+    __HAL_TIM_CLEAR_FLAG(&htim5, TIM_FLAG_UPDATE);
+    us_high_++;
+  }
+
+  if (__HAL_TIM_GET_FLAG(&htim5, TIM_FLAG_CC4))
+  {
+    __HAL_TIM_CLEAR_FLAG(&htim5, TIM_FLAG_CC4);
+    __HAL_TIM_SET_COMPARE(&htim5, TIM_CHANNEL_4,
+                          __HAL_TIM_GET_COMPARE(&htim5, TIM_CHANNEL_4) + MONOCLOCK_EPOCH_US);
+    epoch_advance_();
+  }
+}
+
+/********************** end of file ******************************************/
@@ -0,0 +1,260 @@
+/**
+ * @file overload.c
+ * @brief Overload controller with progressive load shedding
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+/********************** inclusions *******************************************/
+#include "main.h"
+#include "cmsis_os.h"
+#include "logger.h"
+
+#include "monoclock.h"
+#include "ao_ui.h"
+#include "ao_led.h"
+#include "blockpool.h"
+#include "overload.h"
+
+/********************** macros and definitions *******************************/
+#define TASK_OVERLOAD_PRIORITY_     (tskIDLE_PRIORITY + 5)
+#define TASK_OVERLOAD_STACK_        (192)
+
+#define PERIOD_TICKS_               ((TickType_t)(OVERLOAD_CONFIG_PERIOD_MS / portTICK_PERIOD_MS))
+#define SHORT_LED_TICKS_            ((TickType_t)(OVERLOAD_CONFIG_SHORT_LED_MS / portTICK_PERIOD_MS))
+
+/********************** internal data declaration ****************************/
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+static struct
+{
+  overload_stats_t stats;
+  uint32_t   period_misses;
+  uint32_t   quiet_periods;
+  uint32_t   last_total_us;
+  uint32_t   last_idle_us;
+  led_wave_pattern_t saved_led_pattern;
+} overload_;
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+static uint32_t fill_pct_(UBaseType_t used, UBaseType_t capacity)
+{
+  return (0U == capacity) ? 0U : (uint32_t)((100U * used) / capacity);
+}
+
+static uint32_t cpu_load_pct_(void)
+{
+  uint32_t total_us = now_us32();
+  uint32_t idle_us = ulTaskGetIdleRunTimeCounter();
+  uint32_t dt = total_us - overload_.last_total_us;
+  uint32_t di = idle_us - overload_.last_idle_us;
+
+  overload_.last_total_us = total_us;
+  overload_.last_idle_us = idle_us;
+
+  if ((0U == dt) || (di >= dt))
+  {
+    return 0U;
+  }
+  return 100U - (uint32_t)(((uint64_t)di * 100U) / dt);
+}
+
+static uint32_t queue_fill_pct_(void)
+{
+  blockpool_stats_t pool;
+  uint32_t ui_pct = fill_pct_(elastic_queue_count(&ao_ui.queue), ao_ui.queue.capacity);
+  uint32_t led_pct = fill_pct_(uxPriorityQueueMessagesWaiting(ao_led.hpq), PQ_MAX_EVENT_SIZE);
+  uint32_t pool_pct;
+  uint32_t pct;
+
+  // the queues share their storage, a full pool refuses events to all of them
+  blockpool_get_stats(&pool);
+  pool_pct = fill_pct_(pool.used, BLOCKPOOL_CONFIG_BLOCKS);
+
+  pct = (ui_pct > led_pct) ? ui_pct : led_pct;
+  return (pool_pct > pct) ? pool_pct : pct;
+}
+
+static overload_level_t target_level_(uint32_t cpu, uint32_t queue, uint32_t misses)
+{
+  if ((OVERLOAD_CONFIG_CPU_PCT_L3 <= cpu) || (OVERLOAD_CONFIG_QUEUE_PCT_L3 <= queue) ||
+      (OVERLOAD_CONFIG_MISSES_L3 <= misses))
+  {
+    return OVERLOAD_LEVEL_SHORT_LED;
+  }
+  if ((OVERLOAD_CONFIG_CPU_PCT_L2 <= cpu) || (OVERLOAD_CONFIG_QUEUE_PCT_L2 <= queue))
+  {
+    return OVERLOAD_LEVEL_QUIET_LOG;
+  }
+  if ((OVERLOAD_CONFIG_CPU_PCT_L1 <= cpu) || (OVERLOAD_CONFIG_QUEUE_PCT_L1 <= queue) ||
+      (OVERLOAD_CONFIG_MISSES_L1 <= misses))
+  {
+    return OVERLOAD_LEVEL_DROP_LOW;
+  }
+  return OVERLOAD_LEVEL_NORMAL;
+}
+
+/* Applies or reverts the action of a single level. */
+static void apply_(overload_level_t level, bool enable)
+{
+  switch (level)
+  {
+    case OVERLOAD_LEVEL_DROP_LOW:
+      // checked by the producers through overload_drop()
+      break;
+
+    case OVERLOAD_LEVEL_QUIET_LOG:
+      logger_set_threshold(enable ? LOGGER_LEVEL_WARN : LOGGER_LEVEL_INFO);
+      break;
+
+    case OVERLOAD_LEVEL_SHORT_LED:
+      if (enable)
+      {
+        ao_led_get_pattern(&ao_led, &overload_.saved_led_pattern);
+        ao_led_set_on_period(&ao_led, SHORT_LED_TICKS_);
+      }
+      else
+      {
+        (void)ao_led_set_pattern(&ao_led, &overload_.saved_led_pattern);
+      }
+      break;
+
+    default:
+      break;
+  }
+}
+
+static void set_level_(overload_level_t level)
+{
+  overload_level_t from = overload_.stats.level;
+
+  if (level > from)
+  {
+    apply_(level, true);
+    overload_.stats.entered[level]++;
+  }
+  else
+  {
+    apply_(from, false);
+  }
+  overload_.stats.level = level;
+
+  LOGGER_WARN("OVERLOAD\t- Level %u -> %u cpu %lu%% queue %lu%%",
+              (unsigned)from, (unsigned)level,
+              (unsigned long)overload_.stats.cpu_load_pct,
+              (unsigned long)overload_.stats.queue_fill_pct);
+  if (OVERLOAD_LEVEL_NORMAL == level)
+  {
+    LOGGER_WARN("OVERLOAD\t- Shed %lu LOW, missed %lu so far",
+                (unsigned long)overload_.stats.dropped_low,
+                (unsigned long)overload_.stats.deadline_misses);
+  }
+}
+
+static void task_overload_(void *argument)
+{
+  TickType_t last_wake = xTaskGetTickCount();
+
+  while (true)
+  {
+    overload_level_t target;
+    uint32_t misses;
+    UBaseType_t mask;
+
+    vTaskDelayUntil(&last_wake, PERIOD_TICKS_);
+
+    mask = taskENTER_CRITICAL_FROM_ISR();
+    misses = overload_.period_misses;
+    overload_.period_misses = 0U;
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+
+    overload_.stats.cpu_load_pct = cpu_load_pct_();
+    overload_.stats.queue_fill_pct = queue_fill_pct_();
+    target = target_level_(overload_.stats.cpu_load_pct, overload_.stats.queue_fill_pct, misses);
+
+    // escalate one step per period, de-escalate only after a quiet spell
+    if (target > overload_.stats.level)
+    {
+      overload_.quiet_periods = 0U;
+      set_level_(overload_.stats.level + 1);
+    }
+    else if (target < overload_.stats.level)
+    {
+      if (OVERLOAD_CONFIG_RESTORE_PERIODS <= ++overload_.quiet_periods)
+      {
+        overload_.quiet_periods = 0U;
+        set_level_(overload_.stats.level - 1);
+      }
+    }
+    else
+    {
+      overload_.quiet_periods = 0U;
+    }
+  }
+}
+
+/********************** external functions definition ************************/
+
+void overload_init(void)
+{
+#if 1 == OVERLOAD_CONFIG_ENABLE
+  BaseType_t status;
+
+  overload_.stats.level = OVERLOAD_LEVEL_NORMAL;
+
+  status = xTaskCreate
+		  (
+			  task_overload_,
+			  "task_overload",
+			  TASK_OVERLOAD_STACK_,
+			  NULL,
+			  TASK_OVERLOAD_PRIORITY_,
+			  NULL
+		  );
+  configASSERT(pdPASS == status);
+#endif
+}
+
+overload_level_t overload_level(void)
+{
+  return overload_.stats.level;
+}
+
+bool overload_drop(pq_priority_t priority)
+{
+  if ((LOW_PRIORITY == priority) && (OVERLOAD_LEVEL_DROP_LOW <= overload_.stats.level))
+  {
+    taskENTER_CRITICAL();
+    overload_.stats.dropped_low++;
+    taskEXIT_CRITICAL();
+    return true;
+  }
+  return false;
+}
+
+void overload_deadline_miss(void)
+{
+  UBaseType_t mask;
+
+  mask = taskENTER_CRITICAL_FROM_ISR();
+  overload_.period_misses++;
+  overload_.stats.deadline_misses++;
+  taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+void overload_get_stats(overload_stats_t *stats)
+{
+  taskENTER_CRITICAL();
+  *stats = overload_.stats;
+  taskEXIT_CRITICAL();
+}
+
+/********************** end of file ******************************************/
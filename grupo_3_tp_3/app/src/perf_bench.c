@@ -0,0 +1,314 @@
+/**
+ * @file perf_bench.c
+ * @brief Boot-time benchmark of the hot paths, see perf_bench.h
+ *
+ * The queue cases use private queues, so the AOs never see the events. They
+ * are created at init and kept: the libraries have no delete. The debouncer
+ * is polled on a state of its own, never released, so the task's press in
+ * progress is untouched and nothing is classified or logged.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+/********************** inclusions *******************************************/
+#include <stdio.h>
+
+#include "main.h"
+#include "cmsis_os.h"
+#include "logger.h"
+#include "board.h"
+
+#include "monoclock.h"
+#include "deferred.h"
+#include "priority_queue.h"
+#include "elastic_queue.h"
+#include "ao_ui.h"
+#include "task_button.h"
+#include "warmboot.h"
+#include "fastio.h"
+#include "uart_rx.h"
+#include "perf_bench.h"
+
+/********************** macros and definitions *******************************/
+#define CALLS_                  (64U)   /**< Per run of the cheap cases */
+#define UI_QUEUE_LENGTH_        (16U)   /**< As the one of ao_ui.c */
+
+/********************** internal data declaration ****************************/
+extern TIM_HandleTypeDef htim1;
+extern UART_HandleTypeDef huart3;
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+static const char *const names_[PERF_BENCH__N] =
+{
+  "pq 1", "pq half", "pq full", "ao ui", "log format", "log commit", "button step", "pin hal",
+  "pin fast", "tick hal", "tick fast", "uart hal", "uart fast",
+};
+
+/**
+ * Cycles of the reference build, from its boot log. Update them in the same
+ * change as an intended slowdown; a 0 leaves the case unchecked.
+ */
+static const uint32_t baselines_[PERF_BENCH__N] =
+{
+  0U, 0U, 0U, 0U, 0U, 0U, 0U, 0U,
+  0U, 0U, 0U, 0U, 0U,
+};
+
+static struct
+{
+  pq_handle_t         *hpq;
+  elastic_queue_t      ui;
+  perf_bench_results_t results;
+} bench_;
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+#if 1 == PERF_BENCH_CONFIG_ENABLE
+static uint32_t pq_round_(uint32_t events)
+{
+  pq_event_t evt = {0};
+  uint32_t start;
+  uint32_t cycles;
+
+  start = now_cycles32();
+  for (uint32_t i = 0; i < events; i++)
+  {
+    // mixed priorities, so the heap is really reordered
+    evt.priority = (pq_priority_t)(i % (HIGH_PRIORITY + 1U));
+    (void)xPriorityQueueSend(bench_.hpq, &evt, 0U);
+  }
+  for (uint32_t i = 0; i < events; i++)
+  {
+    (void)xPriorityQueueReceive(bench_.hpq, &evt, 0U);
+  }
+  cycles = now_cycles32() - start;
+  return cycles / events;
+}
+
+static uint32_t ao_ui_(void)
+{
+  ao_ui_message_t msg = AO_UI_MESSAGE_PULSE;
+  uint32_t start;
+
+  start = now_cycles32();
+  for (uint32_t i = 0; i < CALLS_; i++)
+  {
+    (void)elastic_queue_send(&bench_.ui, &msg);
+    (void)elastic_queue_receive(&bench_.ui, &msg, 0U);
+  }
+  return (now_cycles32() - start) / CALLS_;
+}
+
+static uint32_t log_format_(void)
+{
+  char line[LOGGER_CONFIG_MAXLEN];
+  uint32_t start;
+  uint32_t cycles;
+
+  start = now_cycles32();
+  (void)snprintf(line, sizeof(line), "AO LED \t- LED %s ON, %lu us", "GREEN", (unsigned long)start);
+  cycles = now_cycles32() - start;
+  return cycles;
+}
+
+static uint32_t log_commit_(void)
+{
+  char line[] = "PERF\t- log commit\n";
+  uint32_t start;
+  uint32_t cycles;
+
+  // as LOGGER_LOG() commits
+  taskENTER_CRITICAL();
+  start = now_cycles32();
+  logger_log_print_(line);
+  cycles = now_cycles32() - start;
+  taskEXIT_CRITICAL();
+  return cycles;
+}
+
+static uint32_t button_step_(void)
+{
+  task_button_state_t state = {0};
+  uint32_t start;
+
+  start = now_cycles32();
+  for (uint32_t i = 0; i < CALLS_; i++)
+  {
+    // idle polls, then a press held to the end
+    (void)task_button_step(&state, (CALLS_ / 2U) <= i);
+  }
+  return (now_cycles32() - start) / CALLS_;
+}
+
+static uint32_t pin_(bool fast)
+{
+  volatile uint32_t sink = 0U;
+  uint32_t start;
+
+  start = now_cycles32();
+  for (uint32_t i = 0; i < CALLS_; i++)
+  {
+    sink += fast ? (uint32_t)fastio_read(BUTTON_PORT, BUTTON_PIN)
+                 : (uint32_t)HAL_GPIO_ReadPin(BUTTON_PORT, BUTTON_PIN);
+  }
+  return (now_cycles32() - start) / CALLS_;
+}
+
+static uint32_t tick_(bool fast)
+{
+  uint32_t start;
+  uint32_t cycles;
+
+  // the tick interrupt is masked, a tick due meanwhile is taken here
+  taskENTER_CRITICAL();
+  start = now_cycles32();
+  for (uint32_t i = 0; i < CALLS_; i++)
+  {
+    if (!fast)
+    {
+      HAL_TIM_IRQHandler(&htim1);
+    }
+    else if (fastio_tim_update(TIM1))
+    {
+      HAL_IncTick();
+    }
+  }
+  cycles = now_cycles32() - start;
+  taskEXIT_CRITICAL();
+  return cycles / CALLS_;
+}
+
+static uint32_t uart_(bool fast)
+{
+  uint32_t start;
+  uint32_t cycles;
+
+  // as in the interrupt: the USART3 and DMA interrupts are masked
+  taskENTER_CRITICAL();
+  start = now_cycles32();
+  for (uint32_t i = 0; i < CALLS_; i++)
+  {
+    if (!fast)
+    {
+      HAL_UART_IRQHandler(&huart3);
+    }
+    else
+    {
+      uart_rx_idle_event();
+    }
+  }
+  cycles = now_cycles32() - start;
+  taskEXIT_CRITICAL();
+  return cycles / CALLS_;
+}
+
+static uint32_t run_case_(perf_bench_case_t c)
+{
+  switch (c)
+  {
+    case PERF_BENCH_PQ_1:
+      return pq_round_(1U);
+    case PERF_BENCH_PQ_HALF:
+      return pq_round_(PQ_MAX_EVENT_SIZE / 2U);
+    case PERF_BENCH_PQ_FULL:
+      return pq_round_(PQ_MAX_EVENT_SIZE);
+    case PERF_BENCH_AO_UI:
+      return ao_ui_();
+    case PERF_BENCH_LOG_FORMAT:
+      return log_format_();
+    case PERF_BENCH_LOG_COMMIT:
+      return log_commit_();
+    case PERF_BENCH_BUTTON_STEP:
+      return button_step_();
+    case PERF_BENCH_PIN_HAL:
+      return pin_(false);
+    case PERF_BENCH_PIN_FAST:
+      return pin_(true);
+    case PERF_BENCH_TICK_HAL:
+      return tick_(false);
+    case PERF_BENCH_TICK_FAST:
+      return tick_(true);
+    case PERF_BENCH_UART_HAL:
+      return uart_(false);
+    case PERF_BENCH_UART_FAST:
+      return uart_(true);
+    default:
+      return 0U;
+  }
+}
+
+static void benchmark_(void *arg)
+{
+  perf_bench_results_t results = {0};
+
+  for (uint32_t c = 0; c < PERF_BENCH__N; c++)
+  {
+    uint32_t best = UINT32_MAX;
+    uint32_t limit;
+
+    for (uint32_t r = 0; r < PERF_BENCH_CONFIG_RUNS; r++)
+    {
+      uint32_t cycles = run_case_((perf_bench_case_t)c);
+
+      best = (cycles < best) ? cycles : best;
+    }
+    results.cycles[c] = best;
+
+    limit = baselines_[c] + ((baselines_[c] * PERF_BENCH_CONFIG_TOLERANCE_PCT) / 100U);
+    if (0U == baselines_[c])
+    {
+      LOGGER_INFO("PERF\t- %s: %lu cycles, no baseline", names_[c], (unsigned long)best);
+    }
+    else if (best > limit)
+    {
+      results.regressions |= (1UL << c);
+      LOGGER_WARN("PERF\t- %s: %lu cycles, baseline %lu", names_[c], (unsigned long)best,
+                  (unsigned long)baselines_[c]);
+    }
+    else
+    {
+      LOGGER_INFO("PERF\t- %s: %lu cycles", names_[c], (unsigned long)best);
+    }
+  }
+
+  taskENTER_CRITICAL();
+  bench_.results = results;
+  taskEXIT_CRITICAL();
+
+#if 1 == PERF_BENCH_CONFIG_STRICT
+  configASSERT(0U == results.regressions);
+#endif
+}
+#endif
+
+/********************** external functions definition ************************/
+
+void perf_bench_init(void)
+{
+#if 1 == PERF_BENCH_CONFIG_ENABLE
+  bench_.hpq = xPriorityQueueCreate();
+  configASSERT(NULL != bench_.hpq);
+  elastic_queue_init(&bench_.ui, UI_QUEUE_LENGTH_, sizeof(ao_ui_message_t));
+
+  if (!warmboot_is_warm())
+  {
+    (void)deferred_post(DEFERRED_PRIO_LOW, benchmark_, NULL);
+  }
+#endif
+}
+
+void perf_bench_get_results(perf_bench_results_t *results)
+{
+  taskENTER_CRITICAL();
+  *results = bench_.results;
+  taskEXIT_CRITICAL();
+}
+
+/********************** end of file ******************************************/
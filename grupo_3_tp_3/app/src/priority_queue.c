@@ -13,6 +13,11 @@
  * utilizing FreeRTOS mutexes and semaphores to synchronize access to the
  * queue.
  *
+ * A segment is taken when the heap fills the ones it has, and the last one is
+ * given back once two are empty, or when the queue empties, so an occupancy
+ * going back and forth across a segment boundary does not take and give back
+ * a block on every operation.
+ *
  * @authors 
  * - Marco Rolón Radcenco
  * - Pablo Eduardo Gimenez
@@ -26,6 +31,21 @@
 
 /********************** internal functions declaration ***********************/
 
+/**
+ * @brief Event at a heap index.
+ *
+ * @param pq Pointer to the priority queue.
+ * @param index Heap index, below the segments held.
+ */
+static pq_event_t *_event(const pq_handle_t *pq, int index);
+
+/**
+ * @brief Give back the segments the queue no longer needs.
+ *
+ * @param pq Pointer to the priority queue.
+ */
+static void _shrink(pq_handle_t *pq);
+
 /**
  * @brief Swap two events.
  *
@@ -50,12 +70,35 @@ static void _heapifyUp(pq_handle_t *pq, int index);
  */
 static void _heapifyDown(pq_handle_t *pq, int index);
 
+/**
+ * @brief Assert that no event has a higher priority than its parent.
+ *
+ * @param pq Pointer to the priority queue.
+ */
+static void _checkHeap(const pq_handle_t *pq);
+
 /********************** internal data definition *****************************/
 
 /********************** external data definition *****************************/
 
 /********************** internal functions definition ************************/
 
+static pq_event_t *_event(const pq_handle_t *pq, int index)
+{
+    return &pq->segments[index / PQ_SEGMENT_EVENTS][index % PQ_SEGMENT_EVENTS];
+}
+
+static void _shrink(pq_handle_t *pq)
+{
+    while ((0 < pq->segmentCount)
+           && ((0 == pq->size) || (pq->size <= ((pq->segmentCount - 2) * PQ_SEGMENT_EVENTS))))
+    {
+        pq->segmentCount--;
+        blockpool_free(pq->segments[pq->segmentCount]);
+        pq->segments[pq->segmentCount] = NULL;
+    }
+}
+
 static void _swap(pq_event_t *a, pq_event_t *b) 
 {
     pq_event_t temp = *a;
@@ -66,9 +109,9 @@ static void _swap(pq_event_t *a, pq_event_t *b)
 static void _heapifyUp(pq_handle_t *pq, int index) 
 {
     int parentIndex = (index - 1) / 2;
-    if (parentIndex >= 0 && pq->events[index].priority > pq->events[parentIndex].priority) 
+    if (parentIndex >= 0 && _event(pq, index)->priority > _event(pq, parentIndex)->priority) 
     {
-        _swap(&pq->events[index], &pq->events[parentIndex]);
+        _swap(_event(pq, index), _event(pq, parentIndex));
         _heapifyUp(pq, parentIndex);
     }
 }
@@ -79,23 +122,37 @@ static void _heapifyDown(pq_handle_t *pq, int index)
     int leftChild = 2 * index + 1;
     int rightChild = 2 * index + 2;
 
-    if (leftChild < pq->size && pq->events[leftChild].priority > pq->events[largest].priority) 
+    if (leftChild < pq->size && _event(pq, leftChild)->priority > _event(pq, largest)->priority) 
     {
         largest = leftChild;
     }
 
-    if (rightChild < pq->size && pq->events[rightChild].priority > pq->events[largest].priority) 
+    if (rightChild < pq->size && _event(pq, rightChild)->priority > _event(pq, largest)->priority) 
     {
         largest = rightChild;
     }
 
     if (largest != index) 
     {
-        _swap(&pq->events[index], &pq->events[largest]);
+        _swap(_event(pq, index), _event(pq, largest));
         _heapifyDown(pq, largest);
     }
 }
 
+static void _checkHeap(const pq_handle_t *pq)
+{
+#if 1 == PQ_CHECK_HEAP
+    configASSERT((0 <= pq->size) && (PQ_MAX_EVENT_SIZE >= pq->size));
+    configASSERT(pq->size <= (pq->segmentCount * PQ_SEGMENT_EVENTS));
+    for (int index = 1; index < pq->size; index++)
+    {
+        configASSERT(_event(pq, index)->priority <= _event(pq, (index - 1) / 2)->priority);
+    }
+#else
+    (void)pq;
+#endif
+}
+
 /********************** external functions definition ************************/
 
 pq_handle_t *xPriorityQueueCreate(void) 
@@ -108,6 +165,11 @@ pq_handle_t *xPriorityQueueCreate(void)
 	}
 	
 	pq->size = 0;
+	pq->segmentCount = 0;
+	for (int segment = 0; segment < PQ_MAX_SEGMENTS; segment++)
+	{
+		pq->segments[segment] = NULL;
+	}
 	
 	pq->mutex = xSemaphoreCreateMutex();
 	if (NULL == pq->mutex) 
@@ -119,6 +181,7 @@ pq_handle_t *xPriorityQueueCreate(void)
 	pq->eventSemaphore = xSemaphoreCreateCounting(PQ_MAX_EVENT_SIZE, 0);
 	if (NULL == pq->eventSemaphore) 
 	{
+		vSemaphoreDelete(pq->mutex);
 		vPortFree(pq);
 		return NULL; // Semaphore creation failed
 	}
@@ -137,10 +200,25 @@ BaseType_t xPriorityQueueSend(pq_handle_t *pq, pq_event_t *event, TickType_t tic
             return pdFAIL;
         }
 
+        if (pq->size == (pq->segmentCount * PQ_SEGMENT_EVENTS))
+        {
+            pq_event_t *segment = blockpool_alloc();
+
+            if (NULL == segment)
+            {
+                // Error: no storage left in the shared pool
+                xSemaphoreGive(pq->mutex);
+                return pdFAIL;
+            }
+            pq->segments[pq->segmentCount] = segment;
+            pq->segmentCount++;
+        }
+
         // add a new event at the bottom and rearrange
-        pq->events[pq->size] = *event;
+        *_event(pq, pq->size) = *event;
         pq->size++;
         _heapifyUp(pq, pq->size - 1);
+        _checkHeap(pq);
 		
         xSemaphoreGive(pq->eventSemaphore); // Signal that a new event has been added
         xSemaphoreGive(pq->mutex);
@@ -156,18 +234,46 @@ BaseType_t xPriorityQueueReceive(pq_handle_t *pq, pq_event_t *event, TickType_t
 	{
     	if (pdTRUE == xSemaphoreTake(pq->mutex, (TickType_t)1U))
     	{
+			BaseType_t status = pdFAIL;
+
+			// the counting semaphore matches the size, this is only defensive
 			if (0 < pq->size)
 			{
 				// dequeue the high-priority event from the heap
-				*event = pq->events[0];
+				*event = *_event(pq, 0);
 				// place a low-priority event at the top and rearrange the heap
-				pq->events[0] = pq->events[pq->size - 1];
+				*_event(pq, 0) = *_event(pq, pq->size - 1);
 				pq->size--;
 				_heapifyDown(pq, 0);
+				_shrink(pq);
+				_checkHeap(pq);
+				status = pdPASS;
 			}
 			xSemaphoreGive(pq->mutex);
-			return pdPASS;
+			return status;
     	}
+		// the event is still queued, give its signal back or it would be lost
+		xSemaphoreGive(pq->eventSemaphore);
+    }
+    return pdFAIL;
+}
+
+UBaseType_t uxPriorityQueueMessagesWaiting(const pq_handle_t *pq)
+{
+    return (UBaseType_t)pq->size;
+}
+
+BaseType_t xPriorityQueuePeekAll(pq_handle_t *pq, pq_event_t *events, pq_size_t *count, TickType_t ticksToWait)
+{
+    if (pdTRUE == xSemaphoreTake(pq->mutex, ticksToWait))
+    {
+        for (pq_size_t index = 0; index < pq->size; index++)
+        {
+            events[index] = *_event(pq, index);
+        }
+        *count = pq->size;
+        xSemaphoreGive(pq->mutex);
+        return pdPASS;
     }
     return pdFAIL;
 }
@@ -0,0 +1,656 @@
+/**
+ * @file remote.c
+ * @brief Framed remote command protocol over USART3
+ *
+ * COBS decoding is a small state machine: a code byte n announces n - 1 data
+ * bytes, followed by an implicit zero unless n is 0xFF or the frame ends. The
+ * implicit zero is only written when the next block starts, so the one after
+ * the last block is never produced.
+ *
+ * The CRC runs over the whole decoded frame, CRC field included; for a
+ * correct frame it ends at the CRC-32 residue, so the frame does not need a
+ * second pass.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+/********************** inclusions *******************************************/
+#include <string.h>
+
+#include "main.h"
+#include "cmsis_os.h"
+#include "logger.h"
+
+#include "uart_rx.h"
+#include "ao_ui.h"
+#include "ao_led.h"
+#include "overload.h"
+#include "deferred.h"
+#include "crc.h"
+#include "telemetry.h"
+#include "task_button.h"
+#include "kvstore.h"
+#include "perf_bench.h"
+#include "warmboot.h"
+#include "journal.h"
+#include "cyclic.h"
+#include "blockpool.h"
+#include "remote.h"
+
+/********************** macros and definitions *******************************/
+#define TASK_REMOTE_PRIORITY_   (tskIDLE_PRIORITY + 2)
+#define TASK_REMOTE_STACK_      (256)
+
+#define CRC_RESIDUE_            (0x2144DF1CU)
+#define CRC_SIZE_               (4U)
+
+#define LED_ON_MS_MAX_          (600000U) /**< 10 min, far below pdMS_TO_TICKS() overflow */
+
+#define HEADER_SIZE_            (2U)    /**< seq, cmd */
+#define RESPONSE_FLAG_          (0x80U)
+#define RESPONSE_HEADER_SIZE_   (3U)    /**< seq, cmd | 0x80, status */
+#define RESPONSE_PAYLOAD_MAX_   (REMOTE_CONFIG_MAX_FRAME - RESPONSE_HEADER_SIZE_ - CRC_SIZE_)
+#define JOURNAL_READ_MAX_       ((RESPONSE_PAYLOAD_MAX_ - 8U) / sizeof(journal_record_t))
+
+/* One code byte per 254 data bytes, plus the delimiter */
+#define TX_BUFFER_SIZE_         (REMOTE_CONFIG_MAX_FRAME + (REMOTE_CONFIG_MAX_FRAME / 254U) + 2U)
+
+/********************** internal data declaration ****************************/
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+static bool reset_pending_;
+
+static const kvstore_key_t param_keys_[REMOTE_PARAM__N] =
+{
+  KVSTORE_KEY_LED_ON_MS,
+  KVSTORE_KEY_LOG_THRESHOLD,
+  KVSTORE_KEY_LED_PWM,
+  KVSTORE_KEY_BUTTON_PULSE_MS,
+  KVSTORE_KEY_BUTTON_SHORT_MS,
+  KVSTORE_KEY_BUTTON_LONG_MS,
+};
+
+static struct
+{
+  uint8_t  frame[REMOTE_CONFIG_MAX_FRAME];
+  uint32_t len;
+  uint32_t crc;
+  uint8_t  block_left;  /**< Data bytes left in the current COBS block */
+  bool     block_zero;  /**< The current block ends with an implicit zero */
+  bool     started;
+  bool     bad;         /**< Skip until the next delimiter */
+} rx_;
+
+static struct
+{
+  uint8_t  response[REMOTE_CONFIG_MAX_FRAME];
+  uint8_t  buffer[TX_BUFFER_SIZE_];
+  uint32_t len;
+  uint8_t  last_seq;
+  bool     have_last;
+} tx_;
+
+static remote_stats_t stats_;
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+static uint32_t get_u32_(const uint8_t *src)
+{
+  return (uint32_t)src[0] | ((uint32_t)src[1] << 8) | ((uint32_t)src[2] << 16) | ((uint32_t)src[3] << 24);
+}
+
+static void put_u32_(uint8_t *dst, uint32_t value)
+{
+  dst[0] = (uint8_t)value;
+  dst[1] = (uint8_t)(value >> 8);
+  dst[2] = (uint8_t)(value >> 16);
+  dst[3] = (uint8_t)(value >> 24);
+}
+
+static uint32_t cobs_encode_(const uint8_t *src, uint32_t len, uint8_t *dst)
+{
+  uint32_t code_at = 0U;
+  uint32_t out = 1U;
+  uint8_t code = 1U;
+
+  for (uint32_t i = 0; i < len; i++)
+  {
+    if (0U == src[i])
+    {
+      dst[code_at] = code;
+      code_at = out++;
+      code = 1U;
+    }
+    else
+    {
+      dst[out++] = src[i];
+      if (0xFFU == ++code)
+      {
+        dst[code_at] = code;
+        code_at = out++;
+        code = 1U;
+      }
+    }
+  }
+  dst[code_at] = code;
+  dst[out++] = 0U;
+  return out;
+}
+
+static void transmit_(void)
+{
+  if (HAL_OK != HAL_UART_Transmit(&huart3, tx_.buffer, (uint16_t)tx_.len, REMOTE_CONFIG_TX_TIMEOUT_MS))
+  {
+    stats_.tx_errors++;
+  }
+}
+
+static remote_status_t read_counters_(uint8_t group, uint8_t index, uint8_t *out, uint32_t *out_len)
+{
+  union
+  {
+    remote_stats_t   remote;
+    overload_stats_t overload;
+    uart_rx_stats_t  uart_rx;
+    deferred_stats_t deferred;
+    ao_led_stats_t   ao_led;
+    perf_bench_results_t perf;
+    warmboot_stats_t warmboot;
+    journal_stats_t  journal;
+    cyclic_stats_t   cyclic;
+    blockpool_stats_t blockpool;
+  } counters;
+  uint32_t size;
+
+  switch (group)
+  {
+    case REMOTE_COUNTERS_REMOTE:
+      remote_get_stats(&counters.remote);
+      size = sizeof(counters.remote);
+      break;
+
+    case REMOTE_COUNTERS_OVERLOAD:
+      overload_get_stats(&counters.overload);
+      size = sizeof(counters.overload);
+      break;
+
+    case REMOTE_COUNTERS_UART_RX:
+      uart_rx_get_stats(&counters.uart_rx);
+      size = sizeof(counters.uart_rx);
+      break;
+
+    case REMOTE_COUNTERS_AO_LED:
+      if (1U < index)
+      {
+        return REMOTE_STATUS_BAD_ARG;
+      }
+      ao_led_get_stats(&ao_led, &counters.ao_led);
+      if (1U == index)
+      {
+        // a scenario boundary: what happens next is counted afresh
+        ao_led_reset_stats(&ao_led);
+      }
+      size = sizeof(counters.ao_led);
+      break;
+
+    case REMOTE_COUNTERS_PERF:
+      perf_bench_get_results(&counters.perf);
+      size = sizeof(counters.perf);
+      break;
+
+    case REMOTE_COUNTERS_WARMBOOT:
+      warmboot_get_stats(&counters.warmboot);
+      size = sizeof(counters.warmboot);
+      break;
+
+    case REMOTE_COUNTERS_JOURNAL:
+      journal_get_stats(&counters.journal);
+      size = sizeof(counters.journal);
+      break;
+
+    case REMOTE_COUNTERS_CYCLIC:
+      cyclic_get_stats(&counters.cyclic);
+      size = sizeof(counters.cyclic);
+      break;
+
+    case REMOTE_COUNTERS_BLOCKPOOL:
+      blockpool_get_stats(&counters.blockpool);
+      size = sizeof(counters.blockpool);
+      break;
+
+    case REMOTE_COUNTERS_DEFERRED:
+      if (DEFERRED_PRIO__N <= index)
+      {
+        return REMOTE_STATUS_BAD_ARG;
+      }
+      deferred_get_stats((deferred_prio_t)index, &counters.deferred);
+      size = sizeof(counters.deferred);
+      break;
+
+    default:
+      return REMOTE_STATUS_BAD_ARG;
+  }
+
+  configASSERT(RESPONSE_PAYLOAD_MAX_ >= size);
+  memcpy(out, &counters, size);
+  *out_len = size;
+  return REMOTE_STATUS_OK;
+}
+
+static remote_status_t read_journal_(uint32_t seq, uint8_t *out, uint32_t *out_len)
+{
+  journal_record_t records[JOURNAL_READ_MAX_];
+  journal_stats_t stats;
+  uint32_t first;
+  uint32_t count;
+
+  count = journal_read(seq, records, JOURNAL_READ_MAX_, &first);
+  journal_get_stats(&stats);
+  put_u32_(&out[0], first);
+  put_u32_(&out[4], stats.recorded);
+  memcpy(&out[8], records, count * sizeof(journal_record_t));
+  *out_len = 8U + (count * sizeof(journal_record_t));
+  return REMOTE_STATUS_OK;
+}
+
+static remote_status_t apply_param_(uint8_t param, uint32_t value)
+{
+  switch (param)
+  {
+    case REMOTE_PARAM_LED_ON_MS:
+      // checked before the tick conversion, which wraps above ~4.29e6 ms
+      if ((0U == value) || (LED_ON_MS_MAX_ < value))
+      {
+        return REMOTE_STATUS_BAD_ARG;
+      }
+      ao_led_set_on_period(&ao_led, pdMS_TO_TICKS(value));
+      return REMOTE_STATUS_OK;
+
+    case REMOTE_PARAM_LOG_THRESHOLD:
+      if (LOGGER_LEVEL_WARN < value)
+      {
+        return REMOTE_STATUS_BAD_ARG;
+      }
+      logger_set_threshold((int)value);
+      return REMOTE_STATUS_OK;
+
+    case REMOTE_PARAM_LED_PWM:
+      if (1U < value)
+      {
+        return REMOTE_STATUS_BAD_ARG;
+      }
+      ao_led_set_pwm_mode(&ao_led, (1U == value));
+      return REMOTE_STATUS_OK;
+
+    case REMOTE_PARAM_BUTTON_PULSE_MS:
+    case REMOTE_PARAM_BUTTON_SHORT_MS:
+    case REMOTE_PARAM_BUTTON_LONG_MS:
+      return task_button_set_timeout((task_button_timeout_t)(param - REMOTE_PARAM_BUTTON_PULSE_MS), value)
+             ? REMOTE_STATUS_OK : REMOTE_STATUS_BAD_ARG;
+
+    default:
+      return REMOTE_STATUS_BAD_ARG;
+  }
+}
+
+static remote_status_t set_param_(uint8_t param, uint32_t value)
+{
+  remote_status_t status = apply_param_(param, value);
+
+  if (REMOTE_STATUS_OK == status)
+  {
+    (void)kvstore_set_u32(param_keys_[param], value);
+  }
+  return status;
+}
+
+static void restore_params_(void)
+{
+  uint32_t pending = 0U;
+
+  for (uint32_t p = 0; p < REMOTE_PARAM__N; p++)
+  {
+    uint32_t value;
+
+    if (kvstore_get_u32(param_keys_[p], &value))
+    {
+      pending |= (1UL << p);
+    }
+  }
+
+  // the button timeouts must stay ordered, a pass may enable the next one
+  for (uint32_t pass = 0; (0U != pending) && (pass < REMOTE_PARAM__N); pass++)
+  {
+    for (uint32_t p = 0; p < REMOTE_PARAM__N; p++)
+    {
+      uint32_t value;
+
+      if ((0U != (pending & (1UL << p))) && kvstore_get_u32(param_keys_[p], &value)
+          && (REMOTE_STATUS_OK == apply_param_((uint8_t)p, value)))
+      {
+        pending &= ~(1UL << p);
+      }
+    }
+  }
+  if (0U != pending)
+  {
+    LOGGER_INFO("REMOTE\t- Stored params rejected: 0x%02lx", (unsigned long)pending);
+  }
+}
+
+static remote_status_t get_param_(uint8_t param, uint32_t *value)
+{
+  switch (param)
+  {
+    case REMOTE_PARAM_LED_ON_MS:
+      *value = (uint32_t)ao_led_get_on_period(&ao_led) * portTICK_PERIOD_MS;
+      return REMOTE_STATUS_OK;
+
+    case REMOTE_PARAM_LOG_THRESHOLD:
+      *value = (uint32_t)logger_threshold;
+      return REMOTE_STATUS_OK;
+
+    case REMOTE_PARAM_LED_PWM:
+      *value = led_pwm_enabled() ? 1U : 0U;
+      return REMOTE_STATUS_OK;
+
+    case REMOTE_PARAM_BUTTON_PULSE_MS:
+    case REMOTE_PARAM_BUTTON_SHORT_MS:
+    case REMOTE_PARAM_BUTTON_LONG_MS:
+      *value = task_button_get_timeout((task_button_timeout_t)(param - REMOTE_PARAM_BUTTON_PULSE_MS));
+      return REMOTE_STATUS_OK;
+
+    default:
+      return REMOTE_STATUS_BAD_ARG;
+  }
+}
+
+static remote_status_t execute_(uint8_t cmd, const uint8_t *payload, uint32_t len,
+                                uint8_t *out, uint32_t *out_len)
+{
+  uint32_t value;
+  remote_status_t status;
+
+  *out_len = 0U;
+  switch (cmd)
+  {
+    case REMOTE_CMD_PING:
+      return REMOTE_STATUS_OK;
+
+    case REMOTE_CMD_POST_UI:
+    {
+      bool accepted;
+
+      if ((1U != len) || (AO_UI_MESSAGE__N <= payload[0]))
+      {
+        return REMOTE_STATUS_BAD_ARG;
+      }
+      accepted = ao_ui_send(&ao_ui, (ao_ui_message_t)payload[0]);
+      journal_record(JOURNAL_QUEUE_UI, JOURNAL_SOURCE_REMOTE, payload[0], accepted);
+      return accepted ? REMOTE_STATUS_OK : REMOTE_STATUS_BUSY;
+    }
+
+    case REMOTE_CMD_POST_PQ:
+    {
+      pq_event_t evt = {0};
+      bool accepted;
+
+      if ((1U != len) || (HIGH_PRIORITY < payload[0]))
+      {
+        return REMOTE_STATUS_BAD_ARG;
+      }
+      evt.priority = (pq_priority_t)payload[0];
+      // shed events are accepted, the controller counts them
+      if (overload_drop(evt.priority))
+      {
+        return REMOTE_STATUS_OK;
+      }
+      accepted = ao_led_send(&ao_led, evt);
+      journal_record(JOURNAL_QUEUE_LED, JOURNAL_SOURCE_REMOTE, evt.priority, accepted);
+      return accepted ? REMOTE_STATUS_OK : REMOTE_STATUS_BUSY;
+    }
+
+    case REMOTE_CMD_READ_COUNTERS:
+      if (2U != len)
+      {
+        return REMOTE_STATUS_BAD_ARG;
+      }
+      return read_counters_(payload[0], payload[1], out, out_len);
+
+    case REMOTE_CMD_SET_PARAM:
+      if (5U != len)
+      {
+        return REMOTE_STATUS_BAD_ARG;
+      }
+      return set_param_(payload[0], get_u32_(&payload[1]));
+
+    case REMOTE_CMD_PRESS_BUTTON:
+      if (4U != len)
+      {
+        return REMOTE_STATUS_BAD_ARG;
+      }
+      return task_button_press(get_u32_(payload)) ? REMOTE_STATUS_OK : REMOTE_STATUS_BUSY;
+
+    case REMOTE_CMD_WARM_RESET:
+      // after the response has left, see handle_()
+      reset_pending_ = true;
+      return REMOTE_STATUS_OK;
+
+    case REMOTE_CMD_READ_JOURNAL:
+      if (4U != len)
+      {
+        return REMOTE_STATUS_BAD_ARG;
+      }
+      return read_journal_(get_u32_(payload), out, out_len);
+
+    case REMOTE_CMD_REPLAY_JOURNAL:
+      return journal_replay() ? REMOTE_STATUS_OK : REMOTE_STATUS_BUSY;
+
+    case REMOTE_CMD_GET_PARAM:
+      if (1U != len)
+      {
+        return REMOTE_STATUS_BAD_ARG;
+      }
+      status = get_param_(payload[0], &value);
+      if (REMOTE_STATUS_OK == status)
+      {
+        put_u32_(out, value);
+        *out_len = 4U;
+      }
+      return status;
+
+    default:
+      stats_.bad_commands++;
+      return REMOTE_STATUS_BAD_CMD;
+  }
+}
+
+static void handle_(const uint8_t *frame, uint32_t len)
+{
+  uint8_t seq = frame[0];
+  uint8_t cmd = frame[1];
+  uint32_t out_len;
+  remote_status_t status;
+
+  if (tx_.have_last && (seq == tx_.last_seq))
+  {
+    stats_.retries++;
+    transmit_();
+    return;
+  }
+  if (tx_.have_last && (seq != (uint8_t)(tx_.last_seq + 1U)))
+  {
+    stats_.seq_gaps++;
+  }
+  stats_.frames++;
+
+  status = execute_(cmd, &frame[HEADER_SIZE_], len - HEADER_SIZE_,
+                    &tx_.response[RESPONSE_HEADER_SIZE_], &out_len);
+  if (REMOTE_STATUS_BUSY == status)
+  {
+    stats_.busy++;
+  }
+  telemetry_trace(TELEMETRY_TRACE_REMOTE_COMMAND, cmd, (uint32_t)status);
+
+  tx_.response[0] = seq;
+  tx_.response[1] = cmd | RESPONSE_FLAG_;
+  tx_.response[2] = (uint8_t)status;
+  out_len += RESPONSE_HEADER_SIZE_;
+  put_u32_(&tx_.response[out_len], crc_calc32(tx_.response, out_len));
+  out_len += CRC_SIZE_;
+
+  tx_.len = cobs_encode_(tx_.response, out_len, tx_.buffer);
+  tx_.last_seq = seq;
+  tx_.have_last = true;
+  transmit_();
+
+  if (reset_pending_)
+  {
+    warmboot_reset();
+  }
+}
+
+static void rx_reset_(void)
+{
+  rx_.len = 0U;
+  rx_.crc = 0U;
+  rx_.block_left = 0U;
+  rx_.block_zero = false;
+  rx_.started = false;
+  rx_.bad = false;
+}
+
+static void rx_emit_(uint8_t byte)
+{
+  if (REMOTE_CONFIG_MAX_FRAME <= rx_.len)
+  {
+    rx_.bad = true;
+    return;
+  }
+  rx_.frame[rx_.len++] = byte;
+  rx_.crc = crc_update32_sw(rx_.crc, &byte, 1U);
+}
+
+static void rx_end_(void)
+{
+  if (!rx_.started)
+  {
+    // back to back delimiters
+    return;
+  }
+  if (rx_.bad || (0U != rx_.block_left) || ((HEADER_SIZE_ + CRC_SIZE_) > rx_.len))
+  {
+    stats_.framing_errors++;
+    return;
+  }
+  if (CRC_RESIDUE_ != rx_.crc)
+  {
+    stats_.crc_errors++;
+    return;
+  }
+  handle_(rx_.frame, rx_.len - CRC_SIZE_);
+}
+
+static void rx_feed_(uint8_t byte)
+{
+  if (0U == byte)
+  {
+    rx_end_();
+    rx_reset_();
+    return;
+  }
+
+  rx_.started = true;
+  if (rx_.bad)
+  {
+    return;
+  }
+
+  if (0U == rx_.block_left)
+  {
+    if (rx_.block_zero)
+    {
+      rx_emit_(0U);
+    }
+    rx_.block_left = byte - 1U;
+    rx_.block_zero = (0xFFU != byte);
+    return;
+  }
+
+  rx_emit_(byte);
+  rx_.block_left--;
+}
+
+static void task_remote_(void *argument)
+{
+  LOGGER_INFO("REMOTE\t- Started");
+
+  while (true)
+  {
+    uart_rx_span_t spans[2];
+    size_t pending;
+
+    if (0U == uart_rx_wait(portMAX_DELAY))
+    {
+      continue;
+    }
+
+    pending = uart_rx_peek(spans);
+    for (uint32_t s = 0; s < 2; s++)
+    {
+      for (size_t i = 0; i < spans[s].len; i++)
+      {
+        rx_feed_(spans[s].data[i]);
+      }
+    }
+
+    if (!uart_rx_release(pending))
+    {
+      // part of what was parsed had been overwritten: resync on a delimiter
+      stats_.framing_errors++;
+      rx_reset_();
+      rx_.started = true;
+      rx_.bad = true;
+    }
+  }
+}
+
+/********************** external functions definition ************************/
+
+void remote_init(void)
+{
+#if 1 == REMOTE_CONFIG_ENABLE
+  BaseType_t status;
+
+  rx_reset_();
+  tx_.have_last = false;
+  restore_params_();
+
+  status = xTaskCreate
+		  (
+			  task_remote_,
+			  "task_remote",
+			  TASK_REMOTE_STACK_,
+			  NULL,
+			  TASK_REMOTE_PRIORITY_,
+			  NULL
+		  );
+  configASSERT(pdPASS == status);
+#endif
+}
+
+void remote_get_stats(remote_stats_t *stats)
+{
+  taskENTER_CRITICAL();
+  *stats = stats_;
+  taskEXIT_CRITICAL();
+}
+
+/********************** end of file ******************************************/
@@ -44,6 +44,12 @@
 #include "logger.h"
 #include "dwt.h"
 #include "ao_ui.h"
+#include "boot.h"
+#include "telemetry.h"
+#include "fastio.h"
+#include "journal.h"
+#include "cyclic.h"
+#include "task_button.h"
 
 /********************** macros and definitions *******************************/
 
@@ -64,50 +70,67 @@
 extern ao_ui_handle_t ao_ui;
 /********************** internal functions definition ************************/
 
-typedef enum
-{
-  BUTTON_TYPE_NONE,
-  BUTTON_TYPE_PULSE,
-  BUTTON_TYPE_SHORT,
-  BUTTON_TYPE_LONG,
-  BUTTON_TYPE__N,
-} button_type_t;
-
-static struct
+static task_button_state_t button;
+
+static volatile uint32_t timeouts_[TASK_BUTTON_TIMEOUT__N] =
 {
-    uint32_t counter;
-} button;
+  BUTTON_PULSE_TIMEOUT_,
+  BUTTON_SHORT_TIMEOUT_,
+  BUTTON_LONG_TIMEOUT_,
+};
+
+static volatile uint32_t press_ms_;   /**< Simulated press, 0 none */
+
+static TaskHandle_t htask_;
+static volatile bool sample_;         /**< Taken by the cyclic executive */
 
 static void button_init_(void)
 {
   button.counter = 0;
 }
 
-static button_type_t button_process_state_(bool value)
+static void button_sample_(void *arg)
+{
+  BaseType_t woken = pdFALSE;
+
+  sample_ = fastio_read(BUTTON_PORT, BUTTON_PIN);
+  vTaskNotifyGiveFromISR(htask_, &woken);
+  portYIELD_FROM_ISR(woken);
+}
+
+static button_type_t button_process_state_(task_button_state_t *state, bool value)
 {
   button_type_t ret = BUTTON_TYPE_NONE;
   if(value)
   {
-    button.counter += BUTTON_PERIOD_MS_;
+    // saturate: a wrapped counter would turn a stuck button into a pulse
+    if(UINT32_MAX - BUTTON_PERIOD_MS_ >= state->counter)
+    {
+      state->counter += BUTTON_PERIOD_MS_;
+    }
   }
   else
   {
-    if(BUTTON_LONG_TIMEOUT_ <= button.counter)
+    if(timeouts_[TASK_BUTTON_TIMEOUT_LONG] <= state->counter)
     {
       LOGGER_INFO("BUTTON\t- BUTTON_TYPE_LONG detected");
       ret = BUTTON_TYPE_LONG;
     }
-    else if(BUTTON_SHORT_TIMEOUT_ <= button.counter)
+    else if(timeouts_[TASK_BUTTON_TIMEOUT_SHORT] <= state->counter)
     {
       LOGGER_INFO("BUTTON\t- BUTTON_TYPE_SHORT detected");
       ret = BUTTON_TYPE_SHORT;
     }
-    else if(BUTTON_PULSE_TIMEOUT_ <= button.counter)
+    else if(timeouts_[TASK_BUTTON_TIMEOUT_PULSE] <= state->counter)
     {
       LOGGER_INFO("BUTTON\t- BUTTON_TYPE_PULSE detected");
       ret = BUTTON_TYPE_PULSE;
     }
-    button.counter = 0;
+    if(BUTTON_TYPE_NONE != ret)
+    {
+      telemetry_trace(TELEMETRY_TRACE_BUTTON, (uint32_t)ret, state->counter);
+    }
+    state->counter = 0;
   }
   return ret;
 }
@@ -117,14 +140,33 @@ static button_type_t button_process_state_(bool value)
 void task_button(void* argument)
 {
   button_init_();
+  boot_mark(BOOT_PHASE_KERNEL);
+
+  // sampled at exact times by the cyclic executive when it runs
+  htask_ = xTaskGetCurrentTaskHandle();
+  bool cyclic = cyclic_running() && cyclic_register(CYCLIC_JOB_BUTTON, button_sample_, NULL);
 
   while(true)
   {
-    GPIO_PinState button_state;
-    button_state = HAL_GPIO_ReadPin(BUTTON_PORT, BUTTON_PIN);
+    bool button_state;
+    if(cyclic)
+    {
+      (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      button_state = sample_;
+    }
+    else
+    {
+      button_state = fastio_read(BUTTON_PORT, BUTTON_PIN);
+    }
 
     button_type_t button_type;
-    button_type = button_process_state_(button_state);
+    if(!button_state && (0U != press_ms_) && (0U == button.counter))
+    {
+      // a simulated press, released right now
+      button.counter = press_ms_;
+      press_ms_ = 0U;
+    }
+    button_type = button_process_state_(&button, button_state);
 	
     ao_ui_message_t evt;
 
@@ -135,19 +177,19 @@ void task_button(void* argument)
 
       case BUTTON_TYPE_PULSE:
     	evt = AO_UI_MESSAGE_PULSE;
-    	ao_ui_send(&ao_ui, evt);
+    	journal_record(JOURNAL_QUEUE_UI, JOURNAL_SOURCE_BUTTON, evt, ao_ui_send(&ao_ui, evt));
     	LOGGER_INFO("BUTTON\t- Send AO_UI_MESSAGE_PULSE to UI");
 		break;
 
       case BUTTON_TYPE_SHORT:
     	evt = AO_UI_MESSAGE_SHORT;
-    	ao_ui_send(&ao_ui, evt);
+    	journal_record(JOURNAL_QUEUE_UI, JOURNAL_SOURCE_BUTTON, evt, ao_ui_send(&ao_ui, evt));
     	LOGGER_INFO("BUTTON\t- Send AO_UI_MESSAGE_SHORT to UI");
         break;
 
       case BUTTON_TYPE_LONG:
     	evt = AO_UI_MESSAGE_LONG;
-    	ao_ui_send(&ao_ui, evt);
+    	journal_record(JOURNAL_QUEUE_UI, JOURNAL_SOURCE_BUTTON, evt, ao_ui_send(&ao_ui, evt));
     	LOGGER_INFO("BUTTON\t- Send AO_UI_MESSAGE_LONG to UI");
         break;
 
@@ -156,8 +198,54 @@ void task_button(void* argument)
         break;
     }
 
-    vTaskDelay((TickType_t)(TASK_PERIOD_MS_ / portTICK_PERIOD_MS));
+    if(!cyclic)
+    {
+      vTaskDelay((TickType_t)(TASK_PERIOD_MS_ / portTICK_PERIOD_MS));
+    }
+  }
+}
+
+bool task_button_set_timeout(task_button_timeout_t timeout, uint32_t ms)
+{
+  uint32_t next[TASK_BUTTON_TIMEOUT__N];
+
+  if (TASK_BUTTON_TIMEOUT__N <= timeout)
+  {
+    return false;
+  }
+  for (uint32_t i = 0; i < TASK_BUTTON_TIMEOUT__N; i++)
+  {
+    next[i] = timeouts_[i];
+  }
+  next[timeout] = ms;
+  if ((BUTTON_PERIOD_MS_ > next[TASK_BUTTON_TIMEOUT_PULSE])
+      || (next[TASK_BUTTON_TIMEOUT_PULSE] >= next[TASK_BUTTON_TIMEOUT_SHORT])
+      || (next[TASK_BUTTON_TIMEOUT_SHORT] >= next[TASK_BUTTON_TIMEOUT_LONG]))
+  {
+    return false;
+  }
+  timeouts_[timeout] = ms;
+  return true;
+}
+
+uint32_t task_button_get_timeout(task_button_timeout_t timeout)
+{
+  return (TASK_BUTTON_TIMEOUT__N > timeout) ? timeouts_[timeout] : 0U;
+}
+
+button_type_t task_button_step(task_button_state_t *state, bool pressed)
+{
+  return button_process_state_(state, pressed);
+}
+
+bool task_button_press(uint32_t ms)
+{
+  if(0U != press_ms_)
+  {
+    return false;
   }
+  press_ms_ = ms;
+  return true;
 }
 
 /********************** end of file ******************************************/
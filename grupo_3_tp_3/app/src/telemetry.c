@@ -0,0 +1,225 @@
+/**
+ * @file telemetry.c
+ * @brief Log and trace streams over UDP
+ *
+ * Each ring keeps free-running counters: producers advance written_, the
+ * sent callback advances read_ once the DMA is done with the bytes. At most
+ * one datagram per ring is in flight, and it only covers the contiguous part
+ * up to the end of the ring, so it takes a single descriptor after the
+ * headers and both rings can be in flight at once. The sent callback wakes
+ * the task, so a backlog goes out back to back.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+/********************** inclusions *******************************************/
+#include <string.h>
+
+#include "main.h"
+#include "cmsis_os.h"
+#include "monoclock.h"
+#include "eth_frame.h"
+
+#include "telemetry.h"
+
+/********************** macros and definitions *******************************/
+#define TASK_TELEMETRY_PRIORITY_    (tskIDLE_PRIORITY + 1)
+#define TASK_TELEMETRY_STACK_       (256)
+
+#define FLUSH_TICKS_                pdMS_TO_TICKS(TELEMETRY_CONFIG_FLUSH_MS)
+#define RECORD_SIZE_                (sizeof(telemetry_record_t))
+
+#if (0 != (TELEMETRY_CONFIG_LOG_RING & (TELEMETRY_CONFIG_LOG_RING - 1))) || \
+    (0 != (TELEMETRY_CONFIG_TRACE_RING & (TELEMETRY_CONFIG_TRACE_RING - 1)))
+#error "Telemetry rings must be a power of two"
+#endif
+
+#if (0 != (TELEMETRY_CONFIG_TRACE_RING % 16))
+#error "The trace ring must hold whole records"
+#endif
+
+/********************** internal data declaration ****************************/
+typedef struct
+{
+  uint8_t          *ring;
+  uint32_t          size;
+  uint32_t          granule;     /**< Datagrams hold a multiple of it */
+  uint16_t          port;
+  volatile uint32_t written;     /**< Producers */
+  volatile uint32_t read;        /**< Sent callback */
+  uint32_t          inflight;    /**< Bytes of the datagram in flight, 0 if none */
+  uint32_t         *accepted;    /**< Stats counters of the channel */
+  uint32_t         *dropped;
+} channel_t;
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+static uint8_t log_ring_[TELEMETRY_CONFIG_LOG_RING] __attribute__((aligned(4)));
+static uint8_t trace_ring_[TELEMETRY_CONFIG_TRACE_RING] __attribute__((aligned(4)));
+
+static telemetry_stats_t stats_;
+
+static channel_t log_ =
+{
+  .ring = log_ring_,
+  .size = TELEMETRY_CONFIG_LOG_RING,
+  .granule = 1U,
+  .port = TELEMETRY_CONFIG_LOG_PORT,
+  .accepted = &stats_.log_bytes,
+  .dropped = &stats_.log_dropped,
+};
+
+static channel_t trace_ =
+{
+  .ring = trace_ring_,
+  .size = TELEMETRY_CONFIG_TRACE_RING,
+  .granule = RECORD_SIZE_,
+  .port = TELEMETRY_CONFIG_TRACE_PORT,
+  .accepted = &stats_.trace_records,
+  .dropped = &stats_.trace_dropped,
+};
+
+static TaskHandle_t htask_;
+static volatile uint32_t peer_ = TELEMETRY_CONFIG_PEER;
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+static void write_(channel_t *ch, const void *data, uint32_t len, uint32_t units)
+{
+  UBaseType_t mask;
+  uint32_t index;
+  uint32_t first;
+
+  mask = taskENTER_CRITICAL_FROM_ISR();
+  if ((ch->size - (ch->written - ch->read)) < len)
+  {
+    *ch->dropped += units;
+  }
+  else
+  {
+    index = ch->written & (ch->size - 1U);
+    first = ch->size - index;
+    first = (first < len) ? first : len;
+    memcpy(&ch->ring[index], data, first);
+    memcpy(ch->ring, (const uint8_t *)data + first, len - first);
+    ch->written += len;
+    *ch->accepted += units;
+  }
+  taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+static void sent_(void *arg)
+{
+  channel_t *ch = (channel_t *)arg;
+
+  taskENTER_CRITICAL();
+  ch->read += ch->inflight;
+  ch->inflight = 0U;
+  stats_.datagrams++;
+  taskEXIT_CRITICAL();
+
+  xTaskNotifyGive(htask_);
+}
+
+static void flush_(channel_t *ch)
+{
+  udp_span_t span;
+  uint32_t index;
+  uint32_t len;
+
+  if (0U != ch->inflight)
+  {
+    return;
+  }
+
+  index = ch->read & (ch->size - 1U);
+  len = ch->written - ch->read;
+  len = (len < (ch->size - index)) ? len : (ch->size - index);
+  len = (len < UDP_PAYLOAD_MAX) ? len : UDP_PAYLOAD_MAX;
+  len -= len % ch->granule;
+  if (0U == len)
+  {
+    return;
+  }
+
+  span.data = &ch->ring[index];
+  span.len = (uint16_t)len;
+  ch->inflight = len;
+  if (!udp_send(peer_, ch->port, ch->port, &span, 1U, sent_, ch))
+  {
+    ch->inflight = 0U;
+    taskENTER_CRITICAL();
+    stats_.send_failures++;
+    taskEXIT_CRITICAL();
+  }
+}
+
+static void task_telemetry_(void *argument)
+{
+  while (true)
+  {
+    (void)ulTaskNotifyTake(pdTRUE, FLUSH_TICKS_);
+    if (!eth_frame_link_up())
+    {
+      continue;
+    }
+    flush_(&log_);
+    flush_(&trace_);
+  }
+}
+
+/********************** external functions definition ************************/
+
+void telemetry_init(void)
+{
+#if 1 == TELEMETRY_CONFIG_ENABLE
+  BaseType_t status;
+
+  status = xTaskCreate
+		  (
+			  task_telemetry_,
+			  "task_telemetry",
+			  TASK_TELEMETRY_STACK_,
+			  NULL,
+			  TASK_TELEMETRY_PRIORITY_,
+			  &htask_
+		  );
+  configASSERT(pdPASS == status);
+#endif
+}
+
+void telemetry_set_peer(uint32_t ip)
+{
+  peer_ = ip;
+}
+
+void telemetry_log(const char *text, size_t len)
+{
+  write_(&log_, text, (uint32_t)len, (uint32_t)len);
+}
+
+void telemetry_trace(uint32_t id, uint32_t arg0, uint32_t arg1)
+{
+  telemetry_record_t record;
+
+  record.time_us = now_us32();
+  record.id = id;
+  record.arg0 = arg0;
+  record.arg1 = arg1;
+  write_(&trace_, &record, RECORD_SIZE_, 1U);
+}
+
+void telemetry_get_stats(telemetry_stats_t *stats)
+{
+  taskENTER_CRITICAL();
+  *stats = stats_;
+  taskEXIT_CRITICAL();
+}
+
+/********************** end of file ******************************************/
@@ -0,0 +1,344 @@
+/**
+ * @file uart_rx.c
+ * @brief USART3 receive path: circular DMA with IDLE line detection
+ *
+ * The HAL "receive to idle" DMA mode reports the DMA write position on the
+ * half transfer, transfer complete and IDLE events. Positions are turned
+ * into a free-running byte count (written_), the consumer keeps its own
+ * (read_); both only grow, so pending data is written_ - read_ and the ring
+ * index is the count modulo the ring size.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+/********************** inclusions *******************************************/
+#include "main.h"
+#include "cmsis_os.h"
+#include "stm32f4xx_ll_usart.h"
+
+#include "uart_rx.h"
+
+/********************** macros and definitions *******************************/
+#define RING_MASK_              (UART_RX_CONFIG_RING_SIZE - 1U)
+
+#if (0 != (UART_RX_CONFIG_RING_SIZE & RING_MASK_))
+#error "UART_RX_CONFIG_RING_SIZE must be a power of two"
+#endif
+
+/********************** internal data declaration ****************************/
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+static DMA_HandleTypeDef hdma_usart3_rx_;
+
+static uint8_t ring_[UART_RX_CONFIG_RING_SIZE] __attribute__((aligned(4)));
+
+static struct
+{
+  volatile uint32_t written;      /**< Bytes published, interrupts only */
+  volatile uint32_t read;         /**< Bytes released, consumer only */
+  volatile uint32_t resyncs;      /**< Error restarts, interrupts only */
+  uint32_t          resync_at;    /**< written at the last restart */
+  uint32_t          resyncs_seen; /**< Restarts applied to read, consumer only */
+  uint32_t          last_pos;     /**< Last DMA position seen */
+  TaskHandle_t      hconsumer;
+  uart_rx_stats_t   stats;
+} uart_rx_;
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+static void start_(void)
+{
+  uart_rx_.last_pos = 0U;
+  if (HAL_OK != HAL_UARTEx_ReceiveToIdle_DMA(&huart3, ring_, UART_RX_CONFIG_RING_SIZE))
+  {
+    Error_Handler();
+  }
+}
+
+/* Discards everything pending. Consumer, interrupts masked: only read is
+ * moved, never written. */
+static void drop_pending_(void)
+{
+  uart_rx_.read = uart_rx_.written;
+  uart_rx_.stats.overruns++;
+}
+
+/* Applies an error restart to read. Consumer, interrupts masked: only the
+ * consumer moves read, so a restart never lands inside a release. */
+static bool resync_(void)
+{
+  bool resynced = (uart_rx_.resyncs != uart_rx_.resyncs_seen);
+
+  if (resynced)
+  {
+    uart_rx_.read = uart_rx_.resync_at;
+    uart_rx_.resyncs_seen = uart_rx_.resyncs;
+  }
+  return resynced;
+}
+
+/* Bytes pending, once any error restart is applied */
+static uint32_t pending_(void)
+{
+  UBaseType_t mask;
+  uint32_t pending;
+
+  mask = taskENTER_CRITICAL_FROM_ISR();
+  (void)resync_();
+  pending = uart_rx_.written - uart_rx_.read;
+  taskEXIT_CRITICAL_FROM_ISR(mask);
+  return pending;
+}
+
+static void publish_(uint32_t pos)
+{
+  BaseType_t woken = pdFALSE;
+  uint32_t count;
+  uint32_t pending;
+  uint32_t read;
+
+  count = (pos >= uart_rx_.last_pos) ?
+          (pos - uart_rx_.last_pos) :
+          (UART_RX_CONFIG_RING_SIZE - uart_rx_.last_pos + pos);
+  uart_rx_.last_pos = pos & RING_MASK_;
+  if (0U == count)
+  {
+    return;
+  }
+
+  uart_rx_.written += count;
+  uart_rx_.stats.bytes += count;
+  // read as the consumer will see it once it applies a restart
+  read = (uart_rx_.resyncs != uart_rx_.resyncs_seen) ? uart_rx_.resync_at : uart_rx_.read;
+  pending = uart_rx_.written - read;
+  if (pending > uart_rx_.stats.max_pending)
+  {
+    uart_rx_.stats.max_pending = pending;
+  }
+
+  if (NULL != uart_rx_.hconsumer)
+  {
+    vTaskNotifyGiveFromISR(uart_rx_.hconsumer, &woken);
+  }
+  portYIELD_FROM_ISR(woken);
+}
+
+/********************** external functions definition ************************/
+
+void uart_rx_init(void)
+{
+#if 1 == UART_RX_CONFIG_ENABLE
+  uint32_t pclk = HAL_RCC_GetPCLK1Freq();
+
+  if (UART_RX_CONFIG_BAUDRATE != huart3.Init.BaudRate)
+  {
+    // oversampling by 8 doubles the reachable rate at some noise tolerance
+    huart3.Init.BaudRate = UART_RX_CONFIG_BAUDRATE;
+    huart3.Init.OverSampling = ((pclk / 16U) < UART_RX_CONFIG_BAUDRATE) ?
+                               UART_OVERSAMPLING_8 : UART_OVERSAMPLING_16;
+    if (HAL_OK != HAL_UART_Init(&huart3))
+    {
+      Error_Handler();
+    }
+  }
+
+  __HAL_RCC_DMA1_CLK_ENABLE();
+
+  hdma_usart3_rx_.Instance = DMA1_Stream1;
+  hdma_usart3_rx_.Init.Channel = DMA_CHANNEL_4;
+  hdma_usart3_rx_.Init.Direction = DMA_PERIPH_TO_MEMORY;
+  hdma_usart3_rx_.Init.PeriphInc = DMA_PINC_DISABLE;
+  hdma_usart3_rx_.Init.MemInc = DMA_MINC_ENABLE;
+  hdma_usart3_rx_.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+  hdma_usart3_rx_.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+  hdma_usart3_rx_.Init.Mode = DMA_CIRCULAR;
+  hdma_usart3_rx_.Init.Priority = DMA_PRIORITY_HIGH;
+  hdma_usart3_rx_.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+  if (HAL_OK != HAL_DMA_Init(&hdma_usart3_rx_))
+  {
+    Error_Handler();
+  }
+  __HAL_LINKDMA(&huart3, hdmarx, hdma_usart3_rx_);
+
+  HAL_NVIC_SetPriority(DMA1_Stream1_IRQn, UART_RX_CONFIG_IRQ_PRIORITY, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Stream1_IRQn);
+  HAL_NVIC_SetPriority(USART3_IRQn, UART_RX_CONFIG_IRQ_PRIORITY, 0);
+  HAL_NVIC_EnableIRQ(USART3_IRQn);
+
+  uart_rx_.written = 0U;
+  uart_rx_.read = 0U;
+  uart_rx_.resyncs = 0U;
+  uart_rx_.resyncs_seen = 0U;
+  uart_rx_.hconsumer = NULL;
+  start_();
+#endif
+}
+
+size_t uart_rx_wait(TickType_t timeout)
+{
+  size_t pending;
+
+  uart_rx_.hconsumer = xTaskGetCurrentTaskHandle();
+
+  pending = pending_();
+  if (0U == pending)
+  {
+    (void)ulTaskNotifyTake(pdTRUE, timeout);
+    pending = pending_();
+  }
+  return (pending > UART_RX_CONFIG_RING_SIZE) ? UART_RX_CONFIG_RING_SIZE : pending;
+}
+
+size_t uart_rx_peek(uart_rx_span_t spans[2])
+{
+  UBaseType_t mask;
+  uint32_t read;
+  uint32_t pending;
+  uint32_t index;
+  uint32_t first;
+
+  mask = taskENTER_CRITICAL_FROM_ISR();
+  (void)resync_();
+  if (UART_RX_CONFIG_RING_SIZE < (uart_rx_.written - uart_rx_.read))
+  {
+    drop_pending_();
+  }
+  read = uart_rx_.read;
+  pending = uart_rx_.written - read;
+  taskEXIT_CRITICAL_FROM_ISR(mask);
+
+  index = read & RING_MASK_;
+  first = UART_RX_CONFIG_RING_SIZE - index;
+  if (first > pending)
+  {
+    first = pending;
+  }
+  spans[0].data = &ring_[index];
+  spans[0].len = first;
+  spans[1].data = ring_;
+  spans[1].len = pending - first;
+  return pending;
+}
+
+bool uart_rx_release(size_t len)
+{
+  UBaseType_t mask;
+  uint32_t pending;
+  bool released = false;
+
+  // checked and moved at once: no restart or lap can land in between; a
+  // restart means an error came under the bytes being read
+  mask = taskENTER_CRITICAL_FROM_ISR();
+  if (resync_())
+  {
+    released = false;
+  }
+  else if (UART_RX_CONFIG_RING_SIZE < (uart_rx_.written - uart_rx_.read))
+  {
+    // the DMA reached the bytes the consumer was reading
+    drop_pending_();
+  }
+  else
+  {
+    pending = uart_rx_.written - uart_rx_.read;
+    uart_rx_.read += (len < pending) ? (uint32_t)len : pending;
+    released = true;
+  }
+  taskEXIT_CRITICAL_FROM_ISR(mask);
+  return released;
+}
+
+void uart_rx_get_stats(uart_rx_stats_t *stats)
+{
+  UBaseType_t mask;
+
+  mask = taskENTER_CRITICAL_FROM_ISR();
+  *stats = uart_rx_.stats;
+  taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+void uart_rx_dma_irq_handler(void)
+{
+  HAL_DMA_IRQHandler(&hdma_usart3_rx_);
+}
+
+void uart_rx_uart_irq_handler(void)
+{
+  uint32_t sr = USART3->SR;
+
+  // IDLE alone is the common case: do what the HAL would, without its dispatch
+  if ((0U == (sr & USART_SR_IDLE)) || (0U != (sr & (USART_SR_PE | USART_SR_FE | USART_SR_NE | USART_SR_ORE)))
+      || (HAL_UART_RECEPTION_TOIDLE != huart3.ReceptionType))
+  {
+    HAL_UART_IRQHandler(&huart3);
+    return;
+  }
+
+  LL_USART_ClearFlag_IDLE(USART3);
+  uart_rx_.stats.idle_events++;
+  uart_rx_idle_event();
+}
+
+void uart_rx_idle_event(void)
+{
+  uint32_t remaining = __HAL_DMA_GET_COUNTER(&hdma_usart3_rx_);
+
+  // at the ring end the transfer complete event reports the position
+  if ((0U < remaining) && (UART_RX_CONFIG_RING_SIZE > remaining))
+  {
+    publish_(UART_RX_CONFIG_RING_SIZE - remaining);
+  }
+}
+
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+{
+  if (USART3 != huart->Instance)
+  {
+    return;
+  }
+
+  switch (HAL_UARTEx_GetRxEventType(huart))
+  {
+    case HAL_UART_RXEVENT_IDLE:
+      uart_rx_.stats.idle_events++;
+      break;
+
+    case HAL_UART_RXEVENT_HT:
+      uart_rx_.stats.half_events++;
+      break;
+
+    default:
+      uart_rx_.stats.full_events++;
+      break;
+  }
+  publish_(Size);
+}
+
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+  if (USART3 != huart->Instance)
+  {
+    return;
+  }
+
+  uart_rx_.stats.errors++;
+
+  // blocking errors abort the DMA: restart at the beginning of the ring,
+  // the consumer skips to it on its next call, see resync_()
+  if (HAL_UART_STATE_READY == huart->RxState)
+  {
+    uart_rx_.written = (uart_rx_.written + RING_MASK_) & ~RING_MASK_;
+    uart_rx_.resync_at = uart_rx_.written;
+    uart_rx_.resyncs++;
+    start_();
+  }
+}
+
+/********************** end of file ******************************************/
@@ -0,0 +1,544 @@
+/**
+ * @file udp.c
+ * @brief Minimal static-IP UDP/IPv4 and ARP on the raw frame driver
+ *
+ * Each datagram in flight takes a transmit slot holding its headers and its
+ * descriptor list, from a free list shared by every sending task and given
+ * back from task_eth when the frame is sent. Received frames are only parsed
+ * in task_eth, which is also where the ARP cache is written.
+ *
+ * Multi-byte fields are read and written byte by byte: the IPv4 header is not
+ * aligned in the frame and the wire order is big endian.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+/********************** inclusions *******************************************/
+#include <stddef.h>
+#include <string.h>
+
+#include "main.h"
+#include "cmsis_os.h"
+
+#include "eth_frame.h"
+#include "udp.h"
+
+/********************** macros and definitions *******************************/
+#define MAC_SIZE_               (6U)
+#define ETH_HEADER_             (14U)
+#define IP_HEADER_              (20U)
+#define UDP_HEADER_             (8U)
+#define ARP_PACKET_             (28U)
+#define HEADERS_                (ETH_HEADER_ + IP_HEADER_ + UDP_HEADER_)
+
+#define ETHERTYPE_IP_           (0x0800U)
+#define ETHERTYPE_ARP_          (0x0806U)
+
+#define IP_VERSION_IHL_         (0x45U)
+#define IP_FLAG_DF_             (0x4000U)
+#define IP_FRAGMENT_MASK_       (0x3FFFU)   /**< More fragments and offset */
+#define IP_TTL_                 (64U)
+#define IP_PROTO_UDP_           (17U)
+
+#define ARP_HTYPE_ETHERNET_     (1U)
+#define ARP_REQUEST_            (1U)
+#define ARP_REPLY_              (2U)
+
+#define ARP_RETRY_TICKS_        pdMS_TO_TICKS(UDP_CONFIG_ARP_RETRY_MS)
+
+#if (ARP_PACKET_ + ETH_HEADER_) > HEADERS_
+#error "ARP packets must fit in a transmit slot"
+#endif
+
+/********************** internal data declaration ****************************/
+typedef struct tx_slot
+{
+  uint8_t            header[HEADERS_] __attribute__((aligned(4)));
+  ETH_BufferTypeDef  buffers[1U + UDP_CONFIG_MAX_SPANS];
+  eth_frame_tx_t     tx;
+  udp_sent_t         sent;
+  void              *arg;
+  struct tx_slot    *next;
+} tx_slot_t;
+
+typedef struct
+{
+  uint32_t ip;
+  uint8_t  mac[MAC_SIZE_];
+  bool     valid;
+} arp_entry_t;
+
+typedef struct
+{
+  uint16_t      port;
+  udp_handler_t handler;
+  void         *arg;
+} binding_t;
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+static const uint8_t broadcast_mac_[MAC_SIZE_] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+
+static tx_slot_t slots_[UDP_CONFIG_TX_SLOTS];
+
+static struct
+{
+  tx_slot_t  *free;
+  arp_entry_t arp[UDP_CONFIG_ARP_ENTRIES];
+  uint32_t    arp_victim;        /**< Next entry replaced when the cache is full */
+  uint32_t    arp_pending_ip;    /**< Last address asked for */
+  TickType_t  arp_pending_tick;
+  binding_t   bindings[UDP_CONFIG_BINDINGS];
+  uint16_t    ip_id;
+  udp_stats_t stats;
+} udp_;
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+static uint16_t get16_(const uint8_t *p)
+{
+  return (uint16_t)(((uint16_t)p[0] << 8) | p[1]);
+}
+
+static uint32_t get32_(const uint8_t *p)
+{
+  return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static void put16_(uint8_t *p, uint16_t value)
+{
+  p[0] = (uint8_t)(value >> 8);
+  p[1] = (uint8_t)value;
+}
+
+static void put32_(uint8_t *p, uint32_t value)
+{
+  p[0] = (uint8_t)(value >> 24);
+  p[1] = (uint8_t)(value >> 16);
+  p[2] = (uint8_t)(value >> 8);
+  p[3] = (uint8_t)value;
+}
+
+static const uint8_t *own_mac_(void)
+{
+  return heth.Init.MACAddr;
+}
+
+static void count_(uint32_t *counter)
+{
+  taskENTER_CRITICAL();
+  (*counter)++;
+  taskEXIT_CRITICAL();
+}
+
+static tx_slot_t *slot_take_(void)
+{
+  tx_slot_t *slot;
+
+  taskENTER_CRITICAL();
+  slot = udp_.free;
+  if (NULL != slot)
+  {
+    udp_.free = slot->next;
+  }
+  taskEXIT_CRITICAL();
+  return slot;
+}
+
+static void slot_give_(tx_slot_t *slot)
+{
+  taskENTER_CRITICAL();
+  slot->next = udp_.free;
+  udp_.free = slot;
+  taskEXIT_CRITICAL();
+}
+
+static void tx_done_(eth_frame_tx_t *tx)
+{
+  tx_slot_t *slot = (tx_slot_t *)tx->arg;
+
+  if (NULL != slot->sent)
+  {
+    slot->sent(slot->arg);
+  }
+  slot_give_(slot);
+}
+
+static bool slot_send_(tx_slot_t *slot, uint32_t len, udp_sent_t sent, void *arg)
+{
+  slot->sent = sent;
+  slot->arg = arg;
+  slot->tx.buffers = slot->buffers;
+  slot->tx.len = len;
+  slot->tx.done = tx_done_;
+  slot->tx.arg = slot;
+  if (!eth_frame_send(&slot->tx))
+  {
+    slot_give_(slot);
+    count_(&udp_.stats.tx_busy);
+    return false;
+  }
+  return true;
+}
+
+static void eth_header_(uint8_t *p, const uint8_t *dst_mac, uint16_t type)
+{
+  memcpy(&p[0], dst_mac, MAC_SIZE_);
+  memcpy(&p[MAC_SIZE_], own_mac_(), MAC_SIZE_);
+  put16_(&p[12], type);
+}
+
+static void arp_send_(uint16_t op, const uint8_t *dst_mac, const uint8_t *target_mac, uint32_t target_ip)
+{
+  static const uint8_t unknown_mac[MAC_SIZE_] = { 0 };
+  tx_slot_t *slot = slot_take_();
+  uint8_t *p;
+
+  if (NULL == slot)
+  {
+    count_(&udp_.stats.tx_busy);
+    return;
+  }
+
+  eth_header_(slot->header, dst_mac, ETHERTYPE_ARP_);
+  p = &slot->header[ETH_HEADER_];
+  put16_(&p[0], ARP_HTYPE_ETHERNET_);
+  put16_(&p[2], ETHERTYPE_IP_);
+  p[4] = MAC_SIZE_;
+  p[5] = 4U;
+  put16_(&p[6], op);
+  memcpy(&p[8], own_mac_(), MAC_SIZE_);
+  put32_(&p[14], UDP_CONFIG_ADDRESS);
+  memcpy(&p[18], (NULL != target_mac) ? target_mac : unknown_mac, MAC_SIZE_);
+  put32_(&p[24], target_ip);
+
+  // the MAC pads it to the minimum frame size
+  slot->buffers[0].buffer = slot->header;
+  slot->buffers[0].len = ETH_HEADER_ + ARP_PACKET_;
+  slot->buffers[0].next = NULL;
+  if (slot_send_(slot, ETH_HEADER_ + ARP_PACKET_, NULL, NULL))
+  {
+    count_(&udp_.stats.tx_arp);
+  }
+}
+
+static void arp_learn_(uint32_t ip, const uint8_t *mac)
+{
+  arp_entry_t *entry = NULL;
+
+  taskENTER_CRITICAL();
+  for (uint32_t i = 0; i < UDP_CONFIG_ARP_ENTRIES; i++)
+  {
+    if (udp_.arp[i].valid && (ip == udp_.arp[i].ip))
+    {
+      entry = &udp_.arp[i];
+      break;
+    }
+  }
+  if (NULL == entry)
+  {
+    entry = &udp_.arp[udp_.arp_victim];
+    udp_.arp_victim = (udp_.arp_victim + 1U) % UDP_CONFIG_ARP_ENTRIES;
+  }
+  entry->ip = ip;
+  memcpy(entry->mac, mac, MAC_SIZE_);
+  entry->valid = true;
+  taskEXIT_CRITICAL();
+}
+
+static bool arp_lookup_(uint32_t ip, uint8_t *mac)
+{
+  bool found = false;
+
+  taskENTER_CRITICAL();
+  for (uint32_t i = 0; i < UDP_CONFIG_ARP_ENTRIES; i++)
+  {
+    if (udp_.arp[i].valid && (ip == udp_.arp[i].ip))
+    {
+      memcpy(mac, udp_.arp[i].mac, MAC_SIZE_);
+      found = true;
+      break;
+    }
+  }
+  taskEXIT_CRITICAL();
+  return found;
+}
+
+static bool is_broadcast_(uint32_t ip)
+{
+  return (UDP_BROADCAST == ip) || (UDP_BROADCAST == (ip | UDP_CONFIG_NETMASK));
+}
+
+/* Destination MAC for ip: broadcast, the host itself on the subnet or the
+ * gateway. On a cache miss an ARP request is sent, at most once per retry
+ * period for the same address. */
+static bool resolve_(uint32_t ip, uint8_t *mac)
+{
+  uint32_t hop;
+  TickType_t now;
+  bool ask;
+
+  if (is_broadcast_(ip))
+  {
+    memcpy(mac, broadcast_mac_, MAC_SIZE_);
+    return true;
+  }
+
+  hop = ((ip & UDP_CONFIG_NETMASK) == (UDP_CONFIG_ADDRESS & UDP_CONFIG_NETMASK)) ? ip : UDP_CONFIG_GATEWAY;
+  if (arp_lookup_(hop, mac))
+  {
+    return true;
+  }
+
+  now = xTaskGetTickCount();
+  taskENTER_CRITICAL();
+  ask = (hop != udp_.arp_pending_ip) || ((now - udp_.arp_pending_tick) >= ARP_RETRY_TICKS_);
+  if (ask)
+  {
+    udp_.arp_pending_ip = hop;
+    udp_.arp_pending_tick = now;
+  }
+  taskEXIT_CRITICAL();
+
+  if (ask)
+  {
+    arp_send_(ARP_REQUEST_, broadcast_mac_, NULL, hop);
+  }
+  return false;
+}
+
+static void arp_input_(const uint8_t *p, uint32_t len)
+{
+  uint32_t sender_ip;
+
+  if ((ARP_PACKET_ > len) || (ARP_HTYPE_ETHERNET_ != get16_(&p[0])) || (ETHERTYPE_IP_ != get16_(&p[2]))
+      || (MAC_SIZE_ != p[4]) || (4U != p[5]) || (UDP_CONFIG_ADDRESS != get32_(&p[24])))
+  {
+    udp_.stats.rx_dropped++;
+    return;
+  }
+  udp_.stats.rx_arp++;
+
+  sender_ip = get32_(&p[14]);
+  arp_learn_(sender_ip, &p[8]);
+  if (ARP_REQUEST_ == get16_(&p[6]))
+  {
+    arp_send_(ARP_REPLY_, &p[8], &p[8], sender_ip);
+  }
+}
+
+static void ip_input_(const uint8_t *p, uint32_t len)
+{
+  const uint8_t *udp;
+  uint32_t ihl;
+  uint32_t total;
+  uint32_t udp_len;
+  uint32_t dst_ip;
+  uint16_t dst_port;
+
+  // frames may carry padding: trust the IPv4 total length, not the frame
+  if ((IP_HEADER_ > len) || (4U != (p[0] >> 4)))
+  {
+    udp_.stats.rx_dropped++;
+    return;
+  }
+  ihl = (uint32_t)(p[0] & 0x0FU) * 4U;
+  total = get16_(&p[2]);
+  dst_ip = get32_(&p[16]);
+  if ((IP_HEADER_ > ihl) || ((ihl + UDP_HEADER_) > total) || (total > len)
+      || (0U != (get16_(&p[6]) & IP_FRAGMENT_MASK_)) || (IP_PROTO_UDP_ != p[9])
+      || ((UDP_CONFIG_ADDRESS != dst_ip) && !is_broadcast_(dst_ip)))
+  {
+    udp_.stats.rx_dropped++;
+    return;
+  }
+
+  udp = &p[ihl];
+  udp_len = get16_(&udp[4]);
+  if ((UDP_HEADER_ > udp_len) || (udp_len > (total - ihl)))
+  {
+    udp_.stats.rx_dropped++;
+    return;
+  }
+
+  dst_port = get16_(&udp[2]);
+  for (uint32_t i = 0; i < UDP_CONFIG_BINDINGS; i++)
+  {
+    binding_t *binding = &udp_.bindings[i];
+
+    if ((NULL != binding->handler) && (dst_port == binding->port))
+    {
+      udp_.stats.rx_datagrams++;
+      binding->handler(get32_(&p[12]), get16_(&udp[0]), &udp[UDP_HEADER_],
+                       (uint16_t)(udp_len - UDP_HEADER_), binding->arg);
+      return;
+    }
+  }
+  udp_.stats.rx_dropped++;
+}
+
+static void rx_handler_(eth_frame_t *frame, void *arg)
+{
+  // standard frames always fit in a single buffer
+  if ((NULL != frame->next) || (ETH_HEADER_ > frame->len))
+  {
+    udp_.stats.rx_dropped++;
+  }
+  else
+  {
+    switch (get16_(&frame->data[12]))
+    {
+      case ETHERTYPE_ARP_:
+        arp_input_(&frame->data[ETH_HEADER_], frame->len - ETH_HEADER_);
+        break;
+
+      case ETHERTYPE_IP_:
+        ip_input_(&frame->data[ETH_HEADER_], frame->len - ETH_HEADER_);
+        break;
+
+      default:
+        udp_.stats.rx_dropped++;
+        break;
+    }
+  }
+  eth_frame_release(frame);
+}
+
+/********************** external functions definition ************************/
+
+void udp_init(void)
+{
+#if 1 == UDP_CONFIG_ENABLE
+  udp_.free = NULL;
+  for (uint32_t i = 0; i < UDP_CONFIG_TX_SLOTS; i++)
+  {
+    slots_[i].next = udp_.free;
+    udp_.free = &slots_[i];
+  }
+  eth_frame_set_rx_handler(rx_handler_, NULL);
+#endif
+}
+
+bool udp_bind(uint16_t port, udp_handler_t handler, void *arg)
+{
+  binding_t *slot = NULL;
+
+  configASSERT(NULL != handler);
+
+  taskENTER_CRITICAL();
+  for (uint32_t i = 0; i < UDP_CONFIG_BINDINGS; i++)
+  {
+    binding_t *binding = &udp_.bindings[i];
+
+    if (NULL == binding->handler)
+    {
+      slot = (NULL == slot) ? binding : slot;
+    }
+    else if (port == binding->port)
+    {
+      slot = NULL;
+      break;
+    }
+  }
+  if (NULL != slot)
+  {
+    slot->port = port;
+    slot->arg = arg;
+    slot->handler = handler;
+  }
+  taskEXIT_CRITICAL();
+  return (NULL != slot);
+}
+
+bool udp_send(uint32_t dst_ip, uint16_t dst_port, uint16_t src_port,
+              const udp_span_t *spans, uint32_t count, udp_sent_t sent, void *arg)
+{
+  uint8_t mac[MAC_SIZE_];
+  tx_slot_t *slot;
+  uint8_t *ip;
+  uint8_t *udp;
+  uint32_t payload = 0U;
+  uint32_t n = 1U;
+  uint16_t id;
+
+  configASSERT(UDP_CONFIG_MAX_SPANS >= count);
+  for (uint32_t i = 0; i < count; i++)
+  {
+    payload += spans[i].len;
+  }
+  configASSERT(UDP_PAYLOAD_MAX >= payload);
+
+  if (!resolve_(dst_ip, mac))
+  {
+    count_(&udp_.stats.tx_unresolved);
+    return false;
+  }
+  slot = slot_take_();
+  if (NULL == slot)
+  {
+    count_(&udp_.stats.tx_busy);
+    return false;
+  }
+
+  taskENTER_CRITICAL();
+  id = udp_.ip_id++;
+  taskEXIT_CRITICAL();
+
+  // both checksums stay zero, the MAC computes and inserts them
+  eth_header_(slot->header, mac, ETHERTYPE_IP_);
+  ip = &slot->header[ETH_HEADER_];
+  ip[0] = IP_VERSION_IHL_;
+  ip[1] = 0U;
+  put16_(&ip[2], (uint16_t)(IP_HEADER_ + UDP_HEADER_ + payload));
+  put16_(&ip[4], id);
+  put16_(&ip[6], IP_FLAG_DF_);
+  ip[8] = IP_TTL_;
+  ip[9] = IP_PROTO_UDP_;
+  put16_(&ip[10], 0U);
+  put32_(&ip[12], UDP_CONFIG_ADDRESS);
+  put32_(&ip[16], dst_ip);
+  udp = &ip[IP_HEADER_];
+  put16_(&udp[0], src_port);
+  put16_(&udp[2], dst_port);
+  put16_(&udp[4], (uint16_t)(UDP_HEADER_ + payload));
+  put16_(&udp[6], 0U);
+
+  slot->buffers[0].buffer = slot->header;
+  slot->buffers[0].len = HEADERS_;
+  slot->buffers[0].next = NULL;
+  for (uint32_t i = 0; i < count; i++)
+  {
+    // an empty descriptor would end the frame early
+    if (0U == spans[i].len)
+    {
+      continue;
+    }
+    slot->buffers[n].buffer = (uint8_t *)spans[i].data;
+    slot->buffers[n].len = spans[i].len;
+    slot->buffers[n].next = NULL;
+    slot->buffers[n - 1U].next = &slot->buffers[n];
+    n++;
+  }
+
+  if (!slot_send_(slot, HEADERS_ + payload, sent, arg))
+  {
+    return false;
+  }
+  count_(&udp_.stats.tx_datagrams);
+  return true;
+}
+
+void udp_get_stats(udp_stats_t *stats)
+{
+  taskENTER_CRITICAL();
+  *stats = udp_.stats;
+  taskEXIT_CRITICAL();
+}
+
+/********************** end of file ******************************************/
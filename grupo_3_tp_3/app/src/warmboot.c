@@ -0,0 +1,209 @@
+/**
+ * @file warmboot.c
+ * @brief Warm reboot: AO state carried over a reset in retained RAM
+ *
+ * Checkpoints alternate between two slots in the .noinit section, so a reset
+ * while one is being written still leaves the previous one. The newest slot
+ * with a valid CRC wins. The CRC is the software one: it is checked before
+ * the CRC unit is initialised.
+ *
+ * The queued events are copied without taking them out of the queue; they
+ * are sent again on restore, stamped with the new boot's time. The event the
+ * LED AO was serving when the reset came is not carried over.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+/********************** inclusions *******************************************/
+#include <stddef.h>
+#include <string.h>
+
+#include "main.h"
+#include "cmsis_os.h"
+#include "timers.h"
+#include "logger.h"
+
+#include "crc.h"
+#include "priority_queue.h"
+#include "led_wave.h"
+#include "led_pwm.h"
+#include "ao_led.h"
+#include "journal.h"
+#include "warmboot.h"
+
+/********************** macros and definitions *******************************/
+#define MAGIC_                  (0x5741524DU)  /**< "WARM" */
+#define COLD_RESETS_            (RCC_CSR_PORRSTF | RCC_CSR_BORRSTF)
+#define RESET_WAIT_TICKS_       (pdMS_TO_TICKS(10U))
+
+/********************** internal data declaration ****************************/
+typedef struct
+{
+  uint32_t           magic;
+  uint32_t           seq;
+  uint32_t           warm_boots;
+  led_wave_pattern_t pattern;
+  ao_led_stats_t     led_stats;
+  uint8_t            brightness[NUMBER_OF_LEDS];
+  uint8_t            pwm;
+  pq_size_t          events;
+  pq_event_t         event[PQ_MAX_EVENT_SIZE];
+  uint32_t           crc;
+} checkpoint_t;
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+static checkpoint_t slots_[2] __attribute__((section(".noinit")));
+
+static struct
+{
+  const checkpoint_t *restore;    /**< Slot found at boot, NULL cold */
+  uint32_t           seq;
+  TimerHandle_t      htimer;
+  warmboot_stats_t   stats;
+} warm_;
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+static uint32_t crc_(const checkpoint_t *cp)
+{
+  return crc_update32_sw(0U, cp, offsetof(checkpoint_t, crc));
+}
+
+static bool valid_(const checkpoint_t *cp)
+{
+  return (MAGIC_ == cp->magic) && (PQ_MAX_EVENT_SIZE >= cp->events) && (0 <= cp->events)
+         && (crc_(cp) == cp->crc);
+}
+
+static bool capture_(TickType_t wait)
+{
+  checkpoint_t cp;
+
+  // zeroed, so the padding bytes under the CRC are always the same
+  memset(&cp, 0, sizeof(cp));
+  if (pdPASS != xPriorityQueuePeekAll(ao_led.hpq, cp.event, &cp.events, wait))
+  {
+    taskENTER_CRITICAL();
+    warm_.stats.skipped++;
+    taskEXIT_CRITICAL();
+    return false;
+  }
+  ao_led_get_pattern(&ao_led, &cp.pattern);
+  ao_led_get_stats(&ao_led, &cp.led_stats);
+  memcpy(cp.brightness, ao_led.brightness, sizeof(cp.brightness));
+  cp.pwm = led_pwm_enabled() ? 1U : 0U;
+  cp.magic = MAGIC_;
+  cp.warm_boots = warm_.stats.warm_boots;
+
+  taskENTER_CRITICAL();
+  cp.seq = warm_.seq++;
+  cp.crc = crc_(&cp);
+  slots_[cp.seq & 1U] = cp;
+  warm_.stats.checkpoints++;
+  taskEXIT_CRITICAL();
+  return true;
+}
+
+static void timer_callback_(TimerHandle_t htimer)
+{
+  (void)capture_(0U);
+}
+
+/********************** external functions definition ************************/
+
+void warmboot_init(void)
+{
+#if 1 == WARMBOOT_CONFIG_ENABLE
+  warm_.stats.reset_flags = RCC->CSR;
+  __HAL_RCC_CLEAR_RESET_FLAGS();
+
+  warm_.restore = NULL;
+  warm_.seq = 1U;
+  if (0U == (warm_.stats.reset_flags & COLD_RESETS_))
+  {
+    for (uint32_t s = 0; s < 2U; s++)
+    {
+      if (valid_(&slots_[s])
+          && ((NULL == warm_.restore) || (0 < (int32_t)(slots_[s].seq - warm_.restore->seq))))
+      {
+        warm_.restore = &slots_[s];
+      }
+    }
+  }
+
+  if (NULL != warm_.restore)
+  {
+    warm_.stats.warm = true;
+    warm_.stats.warm_boots = warm_.restore->warm_boots + 1U;
+    warm_.seq = warm_.restore->seq + 1U;
+  }
+  else
+  {
+    // RAM contents after a power-on are random, never trust them later
+    memset(slots_, 0, sizeof(slots_));
+  }
+#endif
+}
+
+bool warmboot_is_warm(void)
+{
+  return warm_.stats.warm;
+}
+
+void warmboot_restore(void)
+{
+#if 1 == WARMBOOT_CONFIG_ENABLE
+  const checkpoint_t *cp = warm_.restore;
+  BaseType_t status;
+
+  if (NULL != cp)
+  {
+    (void)ao_led_set_pattern(&ao_led, &cp->pattern);
+    memcpy(ao_led.brightness, cp->brightness, sizeof(ao_led.brightness));
+    ao_led_set_pwm_mode(&ao_led, (1U == cp->pwm));
+    taskENTER_CRITICAL();
+    ao_led.stats = cp->led_stats;
+    taskEXIT_CRITICAL();
+    for (pq_size_t i = 0; i < cp->events; i++)
+    {
+      journal_record(JOURNAL_QUEUE_LED, JOURNAL_SOURCE_WARMBOOT, cp->event[i].priority,
+                     ao_led_send(&ao_led, cp->event[i]));
+    }
+    LOGGER_INFO("WARM\t- Warm boot %lu, %d events restored", (unsigned long)warm_.stats.warm_boots,
+                (int)cp->events);
+  }
+
+  warm_.htimer = xTimerCreate("warmboot", pdMS_TO_TICKS(WARMBOOT_CONFIG_PERIOD_MS), pdTRUE, NULL,
+                              timer_callback_);
+  configASSERT(NULL != warm_.htimer);
+  status = xTimerStart(warm_.htimer, 0U);
+  configASSERT(pdPASS == status);
+#endif
+}
+
+void warmboot_checkpoint(void)
+{
+  (void)capture_(RESET_WAIT_TICKS_);
+}
+
+void warmboot_reset(void)
+{
+  (void)capture_(RESET_WAIT_TICKS_);
+  NVIC_SystemReset();
+}
+
+void warmboot_get_stats(warmboot_stats_t *stats)
+{
+  taskENTER_CRITICAL();
+  *stats = warm_.stats;
+  taskEXIT_CRITICAL();
+}
+
+/********************** end of file ******************************************/
@@ -0,0 +1,419 @@
+/**
+ * @file bench.c
+ * @brief Host benchmark of the hot paths, checked against baselines
+ *
+ * Usage: bench [-t tolerance %] [-w baselines out] <baselines>
+ *
+ * Times the cases perf_bench.h times on the target that do not need the
+ * hardware, built from the same app/src modules:
+ * - a priority queue send and receive with 1, half and all of the
+ *   PQ_MAX_EVENT_SIZE events queued;
+ * - a dispatch of the UI AO, one message through an elastic queue;
+ * - the formatting of a log line and its commit, logger_log_print_();
+ * - a poll of the button debouncer, task_button_step().
+ *
+ * Each result is the best of RUNS_ batches, so the other processes of the
+ * host do not show, and is given in steps of a fixed calibration loop timed
+ * the same way: a faster or slower host moves both alike, so the baselines
+ * hold on any PC. The batches go round the cases, a pause between rounds,
+ * so the runs of every case spread over the whole bench and a busy spell of
+ * the host, tens of ms on a VM, cannot slow all of them. A result above its baseline plus the tolerance is a
+ * regression, and so is a case missing from the baselines: the run lists
+ * them and fails.
+ *
+ * With -w the results are written as the new baselines instead, to check in
+ * with an intended slowdown or a new case.
+ *
+ * Runs before the scheduler starts, as the fuzz harnesses: every kernel call
+ * returns at once.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+/********************** inclusions *******************************************/
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "main.h"
+#include "cmsis_os.h"
+
+#include "ao_ui.h"
+#include "elastic_queue.h"
+#include "logger.h"
+#include "priority_queue.h"
+#include "task_button.h"
+
+/********************** macros and definitions *******************************/
+#define RUNS_                   (101U)  /**< Best of */
+#define CALLS_                  (256U)  /**< Per batch, well above the clock cost */
+#define BUTTON_ROUNDS_          (64U)   /**< A poll is a few ns: batches of CALLS_ polls are too short */
+#define PAUSE_NS_               (1000000L)  /**< Between rounds */
+#define CALIBRATION_STEPS_      (4096U)
+#define UI_QUEUE_LENGTH_        (16U)   /**< As the one of ao_ui.c */
+#define DEFAULT_TOLERANCE_PCT_  (50)
+#define NAME_LEN_               (32U)
+
+/********************** internal data declaration ****************************/
+typedef enum
+{
+  CASE_PQ_1_,
+  CASE_PQ_HALF_,
+  CASE_PQ_FULL_,
+  CASE_AO_UI_,
+  CASE_LOG_FORMAT_,
+  CASE_LOG_COMMIT_,
+  CASE_BUTTON_STEP_,
+  CASE__N_,
+} case_t;
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+static const char *const names_[CASE__N_] =
+{
+  "pq_1", "pq_half", "pq_full", "ao_ui", "log_format", "log_commit", "button_step",
+};
+
+static struct
+{
+  pq_handle_t    *hpq;
+  elastic_queue_t ui;
+  double          baselines[CASE__N_];  /**< Steps, 0 missing */
+  double          steps[CASE__N_];
+} bench_;
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+static uint64_t now_ns_(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+/* A dependent chain, so the compiler and the CPU cannot shorten it */
+static uint64_t calibration_(uint32_t *ops)
+{
+  volatile uint32_t seed = 1U;
+  uint32_t x = seed;
+  uint64_t start = now_ns_();
+
+  for (uint32_t i = 0; i < CALIBRATION_STEPS_; i++)
+  {
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+  }
+  seed = x;
+  *ops = CALIBRATION_STEPS_;
+  return now_ns_() - start;
+}
+
+static uint64_t pq_round_(uint32_t events, uint32_t *ops)
+{
+  pq_event_t evt = {0};
+  uint32_t rounds = (CALLS_ + events - 1U) / events;
+  uint64_t start = now_ns_();
+
+  for (uint32_t r = 0; r < rounds; r++)
+  {
+    for (uint32_t i = 0; i < events; i++)
+    {
+      // mixed priorities, so the heap is really reordered
+      evt.priority = (pq_priority_t)(i % (HIGH_PRIORITY + 1U));
+      (void)xPriorityQueueSend(bench_.hpq, &evt, 0U);
+    }
+    for (uint32_t i = 0; i < events; i++)
+    {
+      (void)xPriorityQueueReceive(bench_.hpq, &evt, 0U);
+    }
+  }
+  *ops = rounds * events;
+  return now_ns_() - start;
+}
+
+static uint64_t ao_ui_(uint32_t *ops)
+{
+  ao_ui_message_t msg = AO_UI_MESSAGE_PULSE;
+  uint64_t start = now_ns_();
+
+  for (uint32_t i = 0; i < CALLS_; i++)
+  {
+    (void)elastic_queue_send(&bench_.ui, &msg);
+    (void)elastic_queue_receive(&bench_.ui, &msg, 0U);
+  }
+  *ops = CALLS_;
+  return now_ns_() - start;
+}
+
+static uint64_t log_format_(uint32_t *ops)
+{
+  char line[LOGGER_CONFIG_MAXLEN];
+  uint64_t start = now_ns_();
+
+  for (uint32_t i = 0; i < CALLS_; i++)
+  {
+    (void)snprintf(line, sizeof(line), "AO LED \t- LED %s ON, %lu us", "GREEN", (unsigned long)i);
+  }
+  *ops = CALLS_;
+  return now_ns_() - start;
+}
+
+static uint64_t log_commit_(uint32_t *ops)
+{
+  char line[] = "PERF\t- log commit\n";
+  uint64_t start = now_ns_();
+
+  for (uint32_t i = 0; i < CALLS_; i++)
+  {
+    logger_log_print_(line);
+  }
+  *ops = CALLS_;
+  return now_ns_() - start;
+}
+
+static uint64_t button_step_(uint32_t *ops)
+{
+  uint64_t start = now_ns_();
+
+  for (uint32_t r = 0; r < BUTTON_ROUNDS_; r++)
+  {
+    task_button_state_t state = {0};
+
+    for (uint32_t i = 0; i < CALLS_; i++)
+    {
+      // idle polls, then a press held to the end, as perf_bench.c
+      (void)task_button_step(&state, (CALLS_ / 2U) <= i);
+    }
+  }
+  *ops = BUTTON_ROUNDS_ * CALLS_;
+  return now_ns_() - start;
+}
+
+static uint64_t run_case_(case_t c, uint32_t *ops)
+{
+  switch (c)
+  {
+    case CASE_PQ_1_:
+      return pq_round_(1U, ops);
+    case CASE_PQ_HALF_:
+      return pq_round_(PQ_MAX_EVENT_SIZE / 2U, ops);
+    case CASE_PQ_FULL_:
+      return pq_round_(PQ_MAX_EVENT_SIZE, ops);
+    case CASE_AO_UI_:
+      return ao_ui_(ops);
+    case CASE_LOG_FORMAT_:
+      return log_format_(ops);
+    case CASE_LOG_COMMIT_:
+      return log_commit_(ops);
+    case CASE_BUTTON_STEP_:
+      return button_step_(ops);
+    default:
+      *ops = 1U;
+      return 0U;
+  }
+}
+
+static void keep_best_(double *best, uint64_t ns, uint32_t ops, bool first)
+{
+  double per_op = (double)ns / (double)ops;
+
+  *best = (first || (per_op < *best)) ? per_op : *best;
+}
+
+/* Best time of one operation of each case and of a calibration step, ns */
+static void measure_(double ns[CASE__N_], double *step_ns)
+{
+  const struct timespec pause = {0, PAUSE_NS_};
+
+  for (uint32_t r = 0; r < RUNS_; r++)
+  {
+    uint32_t ops;
+
+    for (uint32_t c = 0; c < CASE__N_; c++)
+    {
+      uint64_t t = calibration_(&ops);
+
+      keep_best_(step_ns, t, ops, (0U == r) && (0U == c));
+      t = run_case_((case_t)c, &ops);
+      keep_best_(&ns[c], t, ops, 0U == r);
+    }
+    (void)nanosleep(&pause, NULL);
+  }
+}
+
+static bool load_(const char *path)
+{
+  FILE *in = fopen(path, "r");
+  char line[128];
+
+  if (NULL == in)
+  {
+    fprintf(stderr, "%s: cannot open\n", path);
+    return false;
+  }
+  while (NULL != fgets(line, sizeof(line), in))
+  {
+    char name[NAME_LEN_];
+    double steps;
+
+    if (('#' == line[0]) || (2 != sscanf(line, "%31s %lf", name, &steps)))
+    {
+      continue;
+    }
+    for (uint32_t c = 0; c < CASE__N_; c++)
+    {
+      if (0 == strcmp(name, names_[c]))
+      {
+        bench_.baselines[c] = steps;
+      }
+    }
+  }
+  fclose(in);
+  return true;
+}
+
+static bool save_(const char *path)
+{
+  FILE *out = fopen(path, "w");
+
+  if (NULL == out)
+  {
+    fprintf(stderr, "%s: cannot write\n", path);
+    return false;
+  }
+  fprintf(out, "# Best time of each case, in steps of the calibration loop of bench.c.\n");
+  fprintf(out, "# Written by bench -w, after an intended change only.\n");
+  for (uint32_t c = 0; c < CASE__N_; c++)
+  {
+    fprintf(out, "%-12s %.1f\n", names_[c], bench_.steps[c]);
+  }
+  fclose(out);
+  return true;
+}
+
+/********************** external functions definition ************************/
+
+int main(int argc, char *argv[])
+{
+  const char *baselines = NULL;
+  const char *update = NULL;
+  int tolerance = DEFAULT_TOLERANCE_PCT_;
+  uint32_t failed = 0U;
+  double ns[CASE__N_];
+  double step_ns;
+  FILE *report;
+  int opt;
+
+  while (-1 != (opt = getopt(argc, argv, "t:w:")))
+  {
+    switch (opt)
+    {
+      case 't':
+        tolerance = atoi(optarg);
+        break;
+      case 'w':
+        update = optarg;
+        break;
+      default:
+        fprintf(stderr, "usage: %s [-t tolerance %%] [-w baselines out] <baselines>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+  }
+  if (optind < argc)
+  {
+    baselines = argv[optind];
+  }
+  if ((NULL == update) && ((NULL == baselines) || !load_(baselines)))
+  {
+    fprintf(stderr, "usage: %s [-t tolerance %%] [-w baselines out] <baselines>\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  // the log commit prints: the report goes to the real stdout
+  report = fdopen(dup(STDOUT_FILENO), "w");
+  if ((NULL == report) || (NULL == freopen("/dev/null", "w", stdout)))
+  {
+    return EXIT_FAILURE;
+  }
+
+  bench_.hpq = xPriorityQueueCreate();
+  configASSERT(NULL != bench_.hpq);
+  elastic_queue_init(&bench_.ui, UI_QUEUE_LENGTH_, sizeof(ao_ui_message_t));
+
+  measure_(ns, &step_ns);
+  fprintf(report, "calibration: %.3f ns a step\n", step_ns);
+  for (uint32_t c = 0; c < CASE__N_; c++)
+  {
+    double base = bench_.baselines[c];
+
+    bench_.steps[c] = ns[c] / step_ns;
+    fprintf(report, "%-12s %9.1f ns %9.1f steps", names_[c], ns[c], bench_.steps[c]);
+    if (NULL != update)
+    {
+      fprintf(report, "\n");
+    }
+    else if (0.0 >= base)
+    {
+      failed++;
+      fprintf(report, "   no baseline\n");
+    }
+    else if (bench_.steps[c] > (base * (100.0 + tolerance) / 100.0))
+    {
+      failed++;
+      fprintf(report, "   baseline %.1f: regressed\n", base);
+    }
+    else
+    {
+      fprintf(report, "   baseline %.1f\n", base);
+    }
+  }
+
+  if ((NULL != update) && !save_(update))
+  {
+    failed++;
+  }
+  if (0U != failed)
+  {
+    fprintf(report, "%u of %u cases failed, tolerance %d%%\n", failed, CASE__N_, tolerance);
+  }
+  fclose(report);
+  return (0U != failed) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+void Error_Handler(void)
+{
+  fprintf(stderr, "Error_Handler\n");
+  abort();
+}
+
+void vAssertCalled(const char *file, int line)
+{
+  fprintf(stderr, "%s:%d: assert failed\n", file, line);
+  abort();
+}
+
+void configureTimerForRunTimeStats(void)
+{
+}
+
+unsigned long getRunTimeCounterValue(void)
+{
+  return 0UL;
+}
+
+void vApplicationIdleHook(void)
+{
+}
+
+/********************** end of file ******************************************/
@@ -0,0 +1,390 @@
+/**
+ * @file driver.c
+ * @brief Stand-alone driver of the fuzz harnesses, for compilers without
+ *        libFuzzer
+ *
+ * Usage: fuzz_<name> [-runs=N] [-seed=S] [-max_len=N] <file or directory>...
+ *
+ * The flags are libFuzzer's, so ctest runs either build the same way. Every
+ * file given, and every file in the directories given, is run once as it
+ * is: the corpus, with the regression inputs of past failures. Then N
+ * inputs are made from them by a few random mutations each (bit flips,
+ * bytes set, inserted or erased, pieces copied within an input or from
+ * another one), from the seed, so a run is the same on every host.
+ *
+ * When an input fails, by a harness check, an assert or a sanitizer, it is
+ * written to crash-<run> in the working directory before the process dies.
+ * Once minimised by hand, it goes to the corpus, see README.md.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+/********************** inclusions *******************************************/
+#include <dirent.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "fuzz.h"
+
+/********************** macros and definitions *******************************/
+#define MAX_INPUTS_             (256U)
+#define MAX_LEN_                (4096U)
+#define DEFAULT_MAX_LEN_        (512U)
+#define MAX_MUTATIONS_          (8U)
+#define PATH_LEN_               (512U)
+
+/********************** internal data declaration ****************************/
+typedef struct
+{
+  uint8_t *data;
+  size_t   size;
+} input_t;
+
+/********************** internal functions declaration ***********************/
+
+/* Set by the sanitizers when linked in, called before they end the process */
+void __sanitizer_set_death_callback(void (*callback)(void)) __attribute__((weak));
+
+/********************** internal data definition *****************************/
+static input_t corpus_[MAX_INPUTS_];
+static uint32_t corpus_count_;
+
+static struct
+{
+  const uint8_t *data;
+  size_t         size;
+  unsigned long  run;
+} current_;
+
+static uint32_t random_ = 1U;
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+/* xorshift32: the same sequence on every host */
+static uint32_t next_(void)
+{
+  uint32_t x = random_;
+
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  random_ = x;
+  return x;
+}
+
+static uint32_t below_(uint32_t n)
+{
+  return (0U != n) ? (next_() % n) : 0U;
+}
+
+/* Async-signal-safe: only open(), write() and close() */
+static void save_current_(void)
+{
+  char path[32] = "crash-";
+  char digits[24];
+  uint32_t n = 0U;
+  uint32_t at = 6U;
+  unsigned long run = current_.run;
+  int fd;
+
+  if (NULL == current_.data)
+  {
+    return;
+  }
+  do
+  {
+    digits[n++] = (char)('0' + (run % 10UL));
+    run /= 10UL;
+  } while (0UL != run);
+  while (0U != n)
+  {
+    path[at++] = digits[--n];
+  }
+  path[at] = '\0';
+
+  // the process is dying: a failed write has nobody left to report it to
+  fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (0 <= fd)
+  {
+    (void)!write(fd, current_.data, current_.size);
+    close(fd);
+    (void)!write(STDERR_FILENO, "input written to ", 17U);
+    (void)!write(STDERR_FILENO, path, at);
+    (void)!write(STDERR_FILENO, "\n", 1U);
+  }
+}
+
+static void on_signal_(int sig)
+{
+  save_current_();
+  current_.data = NULL;
+  signal(sig, SIG_DFL);
+  raise(sig);
+}
+
+static void run_(const uint8_t *data, size_t size)
+{
+  current_.data = data;
+  current_.size = size;
+  (void)LLVMFuzzerTestOneInput(data, size);
+  current_.data = NULL;
+  current_.run++;
+}
+
+static bool add_file_(const char *path)
+{
+  FILE *in;
+  uint8_t *data;
+  uint8_t *fit;
+  size_t size;
+
+  if (MAX_INPUTS_ <= corpus_count_)
+  {
+    fprintf(stderr, "%s: more than %u inputs\n", path, MAX_INPUTS_);
+    return false;
+  }
+  in = fopen(path, "rb");
+  if (NULL == in)
+  {
+    fprintf(stderr, "%s: cannot open\n", path);
+    return false;
+  }
+  data = malloc(MAX_LEN_);
+  if (NULL == data)
+  {
+    fclose(in);
+    return false;
+  }
+  size = fread(data, 1U, MAX_LEN_, in);
+  fclose(in);
+  // an exact fit, so the sanitizers see any read past the end
+  fit = realloc(data, (0U != size) ? size : 1U);
+  data = (NULL != fit) ? fit : data;
+
+  corpus_[corpus_count_].data = data;
+  corpus_[corpus_count_].size = size;
+  corpus_count_++;
+  return true;
+}
+
+static int by_name_(const void *a, const void *b)
+{
+  return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+/* Directory entries sorted, so the seed gives the same run on every host */
+static bool add_dir_(const char *path, DIR *dir)
+{
+  char *names[MAX_INPUTS_];
+  uint32_t count = 0U;
+  struct dirent *entry;
+  bool ok = true;
+
+  while (NULL != (entry = readdir(dir)))
+  {
+    if ('.' == entry->d_name[0])
+    {
+      continue;
+    }
+    if (MAX_INPUTS_ <= count)
+    {
+      fprintf(stderr, "%s: more than %u inputs\n", path, MAX_INPUTS_);
+      ok = false;
+      break;
+    }
+    names[count++] = strdup(entry->d_name);
+  }
+  closedir(dir);
+
+  qsort(names, count, sizeof(names[0]), by_name_);
+  for (uint32_t i = 0; i < count; i++)
+  {
+    char file[PATH_LEN_];
+
+    snprintf(file, sizeof(file), "%s/%s", path, names[i]);
+    ok = ok && add_file_(file);
+    free(names[i]);
+  }
+  return ok;
+}
+
+static size_t mutate_(uint8_t *data, size_t size, size_t max_len)
+{
+  static const uint8_t interesting[] = { 0x00U, 0x01U, 0x7FU, 0x80U, 0xFEU, 0xFFU };
+  uint32_t mutations = 1U + below_(MAX_MUTATIONS_);
+
+  for (uint32_t m = 0; m < mutations; m++)
+  {
+    uint32_t at = below_((uint32_t)size);
+
+    switch (below_(6U))
+    {
+      case 0:
+        if (0U != size)
+        {
+          data[at] ^= (uint8_t)(1U << below_(8U));
+        }
+        break;
+
+      case 1:
+        if (0U != size)
+        {
+          data[at] = (0U != below_(2U)) ? (uint8_t)next_() : interesting[below_(sizeof(interesting))];
+        }
+        break;
+
+      case 2:
+        if (size < max_len)
+        {
+          at = below_((uint32_t)size + 1U);
+          memmove(&data[at + 1U], &data[at], size - at);
+          data[at] = (uint8_t)next_();
+          size++;
+        }
+        break;
+
+      case 3:
+        if (0U != size)
+        {
+          uint32_t len = 1U + below_((uint32_t)(size - at));
+
+          memmove(&data[at], &data[at + len], size - at - len);
+          size -= len;
+        }
+        break;
+
+      case 4:
+        // a piece of the input copied over another place of it
+        if (0U != size)
+        {
+          uint32_t len = 1U + below_((uint32_t)(size - at));
+          uint32_t to = below_((uint32_t)(size - len) + 1U);
+
+          memmove(&data[to], &data[at], len);
+        }
+        break;
+
+      default:
+        // a piece of another input inserted
+        if ((0U != corpus_count_) && (size < max_len))
+        {
+          const input_t *other = &corpus_[below_(corpus_count_)];
+          uint32_t from = below_((uint32_t)other->size);
+          size_t len = 1U + below_((uint32_t)(other->size - from));
+
+          if (0U == other->size)
+          {
+            break;
+          }
+          len = (len < (max_len - size)) ? len : (max_len - size);
+          at = below_((uint32_t)size + 1U);
+          memmove(&data[at + len], &data[at], size - at);
+          memcpy(&data[at], &other->data[from], len);
+          size += len;
+        }
+        break;
+    }
+  }
+  return size;
+}
+
+/********************** external functions definition ************************/
+
+int main(int argc, char *argv[])
+{
+  unsigned long runs = 0UL;
+  unsigned long seed = 1UL;
+  unsigned long max_len = DEFAULT_MAX_LEN_;
+  uint8_t *buffer;
+
+  for (int i = 1; i < argc; i++)
+  {
+    const char *arg = argv[i];
+    DIR *dir;
+
+    if (1 == sscanf(arg, "-runs=%lu", &runs) || 1 == sscanf(arg, "-seed=%lu", &seed)
+        || 1 == sscanf(arg, "-max_len=%lu", &max_len))
+    {
+      continue;
+    }
+    if ('-' == arg[0])
+    {
+      fprintf(stderr, "usage: %s [-runs=N] [-seed=S] [-max_len=N] <file or directory>...\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+    dir = opendir(arg);
+    if (!((NULL != dir) ? add_dir_(arg, dir) : add_file_(arg)))
+    {
+      return EXIT_FAILURE;
+    }
+  }
+  if ((0UL == max_len) || (MAX_LEN_ < max_len))
+  {
+    fprintf(stderr, "max_len: 1 to %u\n", MAX_LEN_);
+    return EXIT_FAILURE;
+  }
+
+  signal(SIGABRT, on_signal_);
+  signal(SIGSEGV, on_signal_);
+  signal(SIGBUS, on_signal_);
+  if (NULL != __sanitizer_set_death_callback)
+  {
+    __sanitizer_set_death_callback(save_current_);
+  }
+
+  for (uint32_t i = 0; i < corpus_count_; i++)
+  {
+    run_(corpus_[i].data, corpus_[i].size);
+  }
+
+  random_ = (0UL != seed) ? (uint32_t)seed : 1U;
+  buffer = malloc(MAX_LEN_);
+  if (NULL == buffer)
+  {
+    return EXIT_FAILURE;
+  }
+  for (unsigned long r = 0; r < runs; r++)
+  {
+    // every so often from nothing, otherwise from the corpus
+    uint32_t pick = below_(corpus_count_ + 1U);
+    size_t size = 0U;
+    uint8_t *data;
+
+    if (pick < corpus_count_)
+    {
+      size = (corpus_[pick].size < max_len) ? corpus_[pick].size : max_len;
+      memcpy(buffer, corpus_[pick].data, size);
+    }
+    size = mutate_(buffer, size, max_len);
+
+    data = malloc((0U != size) ? size : 1U);
+    if (NULL == data)
+    {
+      return EXIT_FAILURE;
+    }
+    memcpy(data, buffer, size);
+    run_(data, size);
+    free(data);
+  }
+
+  free(buffer);
+  for (uint32_t i = 0; i < corpus_count_; i++)
+  {
+    free(corpus_[i].data);
+  }
+
+  printf("%lu inputs, %u from the corpus\n", current_.run, corpus_count_);
+  return EXIT_SUCCESS;
+}
+
+/********************** end of file ******************************************/
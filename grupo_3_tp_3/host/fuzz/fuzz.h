@@ -0,0 +1,59 @@
+/**
+ * @file fuzz.h
+ * @brief Fuzz harnesses of the host build
+ *
+ * Every harness is a libFuzzer entry point: it runs one input against the
+ * module, compares what the module did with a model of it and aborts on the
+ * first difference, like a failed configASSERT(). Built with Clang and
+ * HOST_LIBFUZZER, libFuzzer drives it; otherwise driver.c does, from the
+ * corpus and mutations of it, see there.
+ *
+ * The harnesses run before the scheduler starts: every kernel call they make
+ * returns at once, so a blocking one would be a harness bug and asserts.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+#ifndef FUZZ_H_
+#define FUZZ_H_
+
+/********************** CPP guard ********************************************/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/********************** inclusions *******************************************/
+#include <stdint.h>
+#include <stddef.h>
+
+/********************** macros ***********************************************/
+
+/** Checks an invariant of the module under test */
+#define FUZZ_CHECK(x)   do { if (!(x)) { fuzz_failed(#x, __FILE__, __LINE__); } } while (0)
+
+/********************** typedef **********************************************/
+
+/********************** external data declaration ****************************/
+
+/********************** external functions declaration ***********************/
+
+/**
+ * @brief Runs one input. Returns 0, anything else is reported by aborting.
+ */
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+/**
+ * @brief Reports a broken invariant and aborts.
+ */
+void fuzz_failed(const char *expr, const char *file, int line);
+
+/********************** End of CPP guard *************************************/
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FUZZ_H_ */
+/********************** end of file ******************************************/
@@ -0,0 +1,219 @@
+/**
+ * @file fuzz_button.c
+ * @brief Fuzz harness of the button classifier in task_button.c
+ *
+ * The first six bytes are three little endian press lengths, in ms, tried as
+ * the pulse, short and long timeouts; each bit after them, lowest first, is
+ * one poll of the button, 1 pressed, run through task_button_step() on a
+ * state of the harness.
+ *
+ * The timeouts the classifier ends up with must keep pulse < short < long,
+ * all at least one poll period, whatever was asked. Every release must be
+ * classified from the press length so far, one poll period per pressed
+ * sample, and the classification must be monotonic: a longer press never
+ * gets a lower class than a shorter one.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+/********************** inclusions *******************************************/
+#include <stdbool.h>
+
+#include "main.h"
+#include "cmsis_os.h"
+
+#include "ao_ui.h"
+#include "boot.h"
+#include "cyclic.h"
+#include "journal.h"
+#include "logger.h"
+#include "telemetry.h"
+#include "task_button.h"
+#include "fuzz.h"
+
+/********************** macros and definitions *******************************/
+#define PERIOD_MS_              (50U)       /**< Of task_button.c */
+#define TIMEOUTS_SIZE_          (2U * TASK_BUTTON_TIMEOUT__N)
+
+/********************** internal data declaration ****************************/
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+static task_button_state_t state_;
+
+static struct
+{
+  uint32_t counter;
+  uint32_t timeouts[TASK_BUTTON_TIMEOUT__N];
+  uint32_t shortest[BUTTON_TYPE__N];    /**< Press lengths seen per class */
+  uint32_t longest[BUTTON_TYPE__N];
+  bool     seen[BUTTON_TYPE__N];
+} model_;
+
+/********************** external data definition *****************************/
+ao_ui_handle_t ao_ui;
+
+/********************** internal functions definition ************************/
+
+static void set_timeouts_(const uint8_t *data)
+{
+  uint32_t ms[TASK_BUTTON_TIMEOUT__N];
+
+  for (uint32_t t = 0; t < TASK_BUTTON_TIMEOUT__N; t++)
+  {
+    ms[t] = (uint32_t)data[2U * t] | ((uint32_t)data[(2U * t) + 1U] << 8);
+  }
+  // both orders, so a valid set gets through from any previous one
+  for (uint32_t t = 0; t < TASK_BUTTON_TIMEOUT__N; t++)
+  {
+    (void)task_button_set_timeout((task_button_timeout_t)t, ms[t]);
+  }
+  for (uint32_t t = TASK_BUTTON_TIMEOUT__N; 0U != t; t--)
+  {
+    (void)task_button_set_timeout((task_button_timeout_t)(t - 1U), ms[t - 1U]);
+  }
+
+  for (uint32_t t = 0; t < TASK_BUTTON_TIMEOUT__N; t++)
+  {
+    model_.timeouts[t] = task_button_get_timeout((task_button_timeout_t)t);
+  }
+  FUZZ_CHECK(PERIOD_MS_ <= model_.timeouts[TASK_BUTTON_TIMEOUT_PULSE]);
+  FUZZ_CHECK(model_.timeouts[TASK_BUTTON_TIMEOUT_PULSE] < model_.timeouts[TASK_BUTTON_TIMEOUT_SHORT]);
+  FUZZ_CHECK(model_.timeouts[TASK_BUTTON_TIMEOUT_SHORT] < model_.timeouts[TASK_BUTTON_TIMEOUT_LONG]);
+}
+
+static button_type_t classify_(uint32_t counter)
+{
+  if (model_.timeouts[TASK_BUTTON_TIMEOUT_LONG] <= counter)
+  {
+    return BUTTON_TYPE_LONG;
+  }
+  if (model_.timeouts[TASK_BUTTON_TIMEOUT_SHORT] <= counter)
+  {
+    return BUTTON_TYPE_SHORT;
+  }
+  if (model_.timeouts[TASK_BUTTON_TIMEOUT_PULSE] <= counter)
+  {
+    return BUTTON_TYPE_PULSE;
+  }
+  return BUTTON_TYPE_NONE;
+}
+
+static void step_(bool pressed)
+{
+  button_type_t type = task_button_step(&state_, pressed);
+
+  FUZZ_CHECK(BUTTON_TYPE__N > type);
+  if (pressed)
+  {
+    FUZZ_CHECK(BUTTON_TYPE_NONE == type);
+    model_.counter = (UINT32_MAX - PERIOD_MS_ >= model_.counter) ? (model_.counter + PERIOD_MS_) : model_.counter;
+    FUZZ_CHECK(model_.counter == state_.counter);
+    return;
+  }
+
+  FUZZ_CHECK(classify_(model_.counter) == type);
+  if (!model_.seen[type] || (model_.counter < model_.shortest[type]))
+  {
+    model_.shortest[type] = model_.counter;
+  }
+  if (!model_.seen[type] || (model_.counter > model_.longest[type]))
+  {
+    model_.longest[type] = model_.counter;
+  }
+  model_.seen[type] = true;
+  model_.counter = 0U;
+  FUZZ_CHECK(0U == state_.counter);
+
+  // every press of a class shorter than every press of the next ones
+  for (uint32_t lower = 0; lower < BUTTON_TYPE__N; lower++)
+  {
+    for (uint32_t higher = lower + 1U; higher < BUTTON_TYPE__N; higher++)
+    {
+      FUZZ_CHECK(!model_.seen[lower] || !model_.seen[higher]
+                 || (model_.longest[lower] < model_.shortest[higher]));
+    }
+  }
+}
+
+/********************** external functions definition ************************/
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+  if (TIMEOUTS_SIZE_ > size)
+  {
+    return 0;
+  }
+  logger_set_threshold(LOGGER_LEVEL_WARN);
+
+  state_.counter = 0U;
+  model_.counter = 0U;
+  for (uint32_t t = 0; t < BUTTON_TYPE__N; t++)
+  {
+    model_.seen[t] = false;
+  }
+  set_timeouts_(data);
+
+  for (size_t i = TIMEOUTS_SIZE_; i < size; i++)
+  {
+    for (uint32_t bit = 0; bit < 8U; bit++)
+    {
+      step_(0U != (data[i] & (1U << bit)));
+    }
+  }
+  step_(false);
+  return 0;
+}
+
+/* task_button.c only reaches these from the task */
+void boot_mark(boot_phase_t phase)
+{
+  (void)phase;
+}
+
+bool cyclic_running(void)
+{
+  return false;
+}
+
+bool cyclic_register(cyclic_job_t job, cyclic_job_fn_t fn, void *arg)
+{
+  (void)job;
+  (void)fn;
+  (void)arg;
+  return false;
+}
+
+bool ao_ui_send(ao_ui_handle_t *hao_ui, ao_ui_message_t msg)
+{
+  (void)hao_ui;
+  (void)msg;
+  return true;
+}
+
+void journal_record(journal_queue_t queue, journal_source_t source, uint32_t value, bool accepted)
+{
+  (void)queue;
+  (void)source;
+  (void)value;
+  (void)accepted;
+}
+
+void telemetry_trace(uint32_t id, uint32_t arg0, uint32_t arg1)
+{
+  (void)id;
+  (void)arg0;
+  (void)arg1;
+}
+
+void telemetry_log(const char *text, size_t len)
+{
+  (void)text;
+  (void)len;
+}
+
+/********************** end of file ******************************************/
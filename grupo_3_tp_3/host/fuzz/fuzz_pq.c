@@ -0,0 +1,248 @@
+/**
+ * @file fuzz_pq.c
+ * @brief Fuzz harness of priority_queue.c, built with PQ_CHECK_HEAP on
+ *
+ * Each input byte is one operation on a single queue:
+ *
+ *     0x00..0x7F  send, priority the byte modulo 3
+ *     0x80..0xBF  receive
+ *     0xC0..0xDF  peek all
+ *     0xE0..0xEF  take a block of the shared pool, as another queue would
+ *     0xF0..0xFF  give one of those back
+ *
+ * A model keeps the events queued, each one told apart by its timestamp.
+ * After every operation the queue must agree with it: a send fails only
+ * when the queue is full or the pool has no block for a new segment, a
+ * receive returns one of the highest priority events queued, a peek returns
+ * exactly those queued, and the event signal, the size and the segments held
+ * match. The heap order is asserted by the queue itself. At the end the
+ * queue is drained, so every event sent must come out once, and the pool
+ * must be whole again.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+/********************** inclusions *******************************************/
+#include <stdbool.h>
+
+#include "main.h"
+#include "cmsis_os.h"
+
+#include "blockpool.h"
+#include "priority_queue.h"
+#include "fuzz.h"
+
+/********************** macros and definitions *******************************/
+#if 1 != PQ_CHECK_HEAP
+#error "The harness needs the heap order check, build with PQ_CHECK_HEAP=1"
+#endif
+
+#define OP_RECEIVE_             (0x80U)
+#define OP_PEEK_                (0xC0U)
+#define OP_TAKE_BLOCK_          (0xE0U)
+#define OP_GIVE_BLOCK_          (0xF0U)
+
+/********************** internal data declaration ****************************/
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+static pq_handle_t *pq_;
+
+static struct
+{
+  pq_event_t events[PQ_MAX_EVENT_SIZE];
+  uint32_t   count;
+  uint32_t   next_id;
+  void      *blocks[BLOCKPOOL_CONFIG_BLOCKS];   /**< Taken from the queue */
+  uint32_t   block_count;
+} model_;
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+static uint32_t pool_free_(void)
+{
+  blockpool_stats_t stats;
+
+  blockpool_get_stats(&stats);
+  return BLOCKPOOL_CONFIG_BLOCKS - stats.used;
+}
+
+/* Index in the model of the event with this timestamp, or count */
+static uint32_t find_(uint32_t id)
+{
+  uint32_t i = 0U;
+
+  while ((i < model_.count) && (id != model_.events[i].timestamp_us))
+  {
+    i++;
+  }
+  return i;
+}
+
+static pq_priority_t highest_(void)
+{
+  pq_priority_t highest = LOW_PRIORITY;
+
+  for (uint32_t i = 0; i < model_.count; i++)
+  {
+    highest = (model_.events[i].priority > highest) ? model_.events[i].priority : highest;
+  }
+  return highest;
+}
+
+static void check_(void)
+{
+  blockpool_stats_t stats;
+  int needed = (pq_->size + PQ_SEGMENT_EVENTS - 1) / PQ_SEGMENT_EVENTS;
+
+  blockpool_get_stats(&stats);
+  FUZZ_CHECK(model_.count == uxPriorityQueueMessagesWaiting(pq_));
+  FUZZ_CHECK(model_.count == uxSemaphoreGetCount(pq_->eventSemaphore));
+  FUZZ_CHECK(stats.used == (uint32_t)pq_->segmentCount + model_.block_count);
+  // one spare segment at most, none once empty
+  FUZZ_CHECK((needed <= pq_->segmentCount) && (pq_->segmentCount <= needed + 1));
+  FUZZ_CHECK((0 != pq_->size) || (0 == pq_->segmentCount));
+}
+
+static void send_(pq_priority_t priority)
+{
+  pq_event_t evt = {0};
+  bool room = (PQ_MAX_EVENT_SIZE > model_.count)
+              && ((model_.count < (uint32_t)(pq_->segmentCount * PQ_SEGMENT_EVENTS)) || (0U != pool_free_()));
+  BaseType_t status;
+
+  evt.priority = priority;
+  evt.timestamp_us = model_.next_id++;
+  status = xPriorityQueueSend(pq_, &evt, 0U);
+  FUZZ_CHECK((pdPASS == status) == room);
+  if (pdPASS == status)
+  {
+    model_.events[model_.count++] = evt;
+  }
+}
+
+static void receive_(void)
+{
+  pq_event_t evt = {0};
+  BaseType_t status = xPriorityQueueReceive(pq_, &evt, 0U);
+  uint32_t i;
+
+  FUZZ_CHECK((pdPASS == status) == (0U != model_.count));
+  if (pdPASS != status)
+  {
+    return;
+  }
+  i = find_(evt.timestamp_us);
+  FUZZ_CHECK(i < model_.count);
+  FUZZ_CHECK(model_.events[i].priority == evt.priority);
+  FUZZ_CHECK(highest_() == evt.priority);
+  model_.events[i] = model_.events[--model_.count];
+}
+
+static void peek_(void)
+{
+  pq_event_t events[PQ_MAX_EVENT_SIZE];
+  bool seen[PQ_MAX_EVENT_SIZE] = {false};
+  pq_size_t count = -1;
+
+  FUZZ_CHECK(pdPASS == xPriorityQueuePeekAll(pq_, events, &count, 0U));
+  FUZZ_CHECK(model_.count == (uint32_t)count);
+  for (pq_size_t e = 0; e < count; e++)
+  {
+    uint32_t i = find_(events[e].timestamp_us);
+
+    FUZZ_CHECK((i < model_.count) && !seen[i]);
+    FUZZ_CHECK(model_.events[i].priority == events[e].priority);
+    seen[i] = true;
+  }
+  // the root of a max-heap
+  FUZZ_CHECK((0 == count) || (highest_() == events[0].priority));
+}
+
+static void take_block_(void)
+{
+  void *block;
+
+  if (BLOCKPOOL_CONFIG_BLOCKS <= model_.block_count)
+  {
+    return;
+  }
+  block = blockpool_alloc();
+  if (NULL != block)
+  {
+    model_.blocks[model_.block_count++] = block;
+  }
+}
+
+static void give_block_(void)
+{
+  if (0U != model_.block_count)
+  {
+    blockpool_free(model_.blocks[--model_.block_count]);
+  }
+}
+
+/********************** external functions definition ************************/
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+  blockpool_stats_t stats;
+
+  if (NULL == pq_)
+  {
+    pq_ = xPriorityQueueCreate();
+    FUZZ_CHECK(NULL != pq_);
+  }
+  model_.count = 0U;
+  model_.next_id = 0U;
+  model_.block_count = 0U;
+
+  for (size_t i = 0; i < size; i++)
+  {
+    uint8_t op = data[i];
+
+    if (OP_RECEIVE_ > op)
+    {
+      send_((pq_priority_t)(op % 3U));
+    }
+    else if (OP_PEEK_ > op)
+    {
+      receive_();
+    }
+    else if (OP_TAKE_BLOCK_ > op)
+    {
+      peek_();
+    }
+    else if (OP_GIVE_BLOCK_ > op)
+    {
+      take_block_();
+    }
+    else
+    {
+      give_block_();
+    }
+    check_();
+  }
+
+  while (0U != model_.block_count)
+  {
+    give_block_();
+  }
+  while (0U != model_.count)
+  {
+    receive_();
+    check_();
+  }
+  receive_();
+  blockpool_get_stats(&stats);
+  FUZZ_CHECK(0U == stats.used);
+  return 0;
+}
+
+/********************** end of file ******************************************/
@@ -0,0 +1,731 @@
+/**
+ * @file fuzz_remote.c
+ * @brief Fuzz harness of the remote protocol: the COBS/CRC frame decoder of
+ *        remote.c and the commands behind it, the journal read included
+ *
+ * remote.c is built into the harness, so its receive state machine is fed
+ * directly, byte by byte, as task_remote_() does from the ring. The first
+ * input byte picks how the rest is fed:
+ *
+ *     even  as it is, the decoder sees raw bytes
+ *     odd   as requests: a control byte, length in the low 6 bits, then
+ *           that many bytes, seq, cmd and payload; the harness appends the
+ *           CRC and encodes them, bit 6 of the control corrupting the CRC
+ *           and bit 7 leaving out the delimiter
+ *
+ * A reference decoder, written apart from remote.c, splits the same stream.
+ * Every delimited frame must end up counted once: as a framing error, a CRC
+ * error, a retry or a new request, and every request or retry answered once,
+ * in order, with a well formed frame for its seq and cmd, a retry with the
+ * very same bytes as before. For the commands with a side effect, each
+ * accepted one must reach its destination exactly once: posted events to the
+ * AOs and the journal, parameters to the store, presses to the button. A
+ * journal read must return the records the model saw recorded from the
+ * sequence asked for, or the oldest kept.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+/********************** inclusions *******************************************/
+#include "remote.c"     // the decoder and its state are internal
+
+#include "fuzz.h"
+
+/********************** macros and definitions *******************************/
+#define MODE_FRAMED_            (0x01U)
+#define CTL_LEN_MASK_           (0x3FU)
+#define CTL_BAD_CRC_            (0x40U)
+#define CTL_NO_DELIMITER_       (0x80U)
+
+#define CHUNK_MAX_              (1024U)     /**< Encoded bytes kept per frame */
+#define MODEL_RECORDS_          (1024U)
+
+/********************** internal data declaration ****************************/
+typedef struct
+{
+  uint8_t  bytes[REMOTE_CONFIG_MAX_FRAME];
+  uint32_t len;                 /**< Without the CRC */
+  bool     retry;
+} request_t;
+
+typedef struct
+{
+  uint32_t ui_sends;
+  uint32_t led_sends;
+  uint32_t overload_calls;
+  uint32_t kv_sets;
+  uint32_t kv_key;
+  uint32_t kv_value;
+  uint32_t presses;
+  uint32_t press_ms;
+  uint32_t warm_resets;
+} fakes_t;
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+static struct
+{
+  uint8_t          chunk[CHUNK_MAX_];
+  uint32_t         chunk_len;
+  bool             chunk_long;      /**< More than fits, too long anyway */
+  remote_stats_t   stats;
+  uint8_t          last_seq;
+  bool             have_last;
+  request_t        request;         /**< Waiting for its response */
+  bool             pending;
+  uint8_t          last_response[TX_BUFFER_SIZE_];
+  uint32_t         last_response_len;
+  journal_record_t records[MODEL_RECORDS_];
+  uint32_t         records_base;    /**< Journal sequence of records[0] */
+  uint32_t         record_count;
+  fakes_t          before;          /**< The destinations before the request */
+} model_;
+
+static fakes_t fakes_;         /**< What reached the destinations */
+
+static bool ready_;
+
+/********************** external data definition *****************************/
+UART_HandleTypeDef huart3;
+ao_ui_handle_t ao_ui;
+ao_led_handle_t ao_led;
+
+/********************** internal functions definition ************************/
+
+/* Bitwise CRC-32, apart from crc_sw.c's table */
+static uint32_t model_crc_(const uint8_t *data, uint32_t len)
+{
+  uint32_t reg = 0xFFFFFFFFU;
+
+  for (uint32_t i = 0; i < len; i++)
+  {
+    reg ^= data[i];
+    for (uint32_t bit = 0; bit < 8U; bit++)
+    {
+      reg = (0U != (reg & 1U)) ? ((reg >> 1) ^ 0xEDB88320U) : (reg >> 1);
+    }
+  }
+  return ~reg;
+}
+
+static uint32_t model_u32_(const uint8_t *src)
+{
+  return (uint32_t)src[0] | ((uint32_t)src[1] << 8) | ((uint32_t)src[2] << 16) | ((uint32_t)src[3] << 24);
+}
+
+/* Decodes one COBS frame without its delimiter; false if a block is cut
+ * short or the frame is longer than max */
+static bool model_decode_(const uint8_t *src, uint32_t len, uint8_t *dst, uint32_t max, uint32_t *out)
+{
+  uint32_t i = 0U;
+  uint32_t n = 0U;
+
+  while (i < len)
+  {
+    uint32_t code = src[i++];
+
+    if ((0U == code) || ((i + code - 1U) > len))
+    {
+      return false;
+    }
+    for (uint32_t k = 1U; k < code; k++)
+    {
+      if (n >= max)
+      {
+        return false;
+      }
+      dst[n++] = src[i++];
+    }
+    if ((0xFFU != code) && (i < len))
+    {
+      if (n >= max)
+      {
+        return false;
+      }
+      dst[n++] = 0U;
+    }
+  }
+  *out = n;
+  return true;
+}
+
+static uint32_t model_encode_(const uint8_t *src, uint32_t len, uint8_t *dst)
+{
+  uint32_t out = 0U;
+  uint32_t i = 0U;
+
+  // blocks of up to 254 non-zero bytes, each ending at a zero or at the end
+  do
+  {
+    uint32_t code_at = out++;
+    uint8_t code = 1U;
+
+    while ((i < len) && (0U != src[i]) && (0xFFU != code))
+    {
+      dst[out++] = src[i++];
+      code++;
+    }
+    dst[code_at] = code;
+    if ((i < len) && (0U == src[i]) && (0xFFU != code))
+    {
+      i++;
+      if (i == len)
+      {
+        // a trailing zero needs an empty last block
+        dst[out++] = 1U;
+      }
+    }
+  } while (i < len);
+  return out;
+}
+
+static void model_journal_(journal_queue_t queue, uint32_t value, bool accepted)
+{
+  journal_record_t *record;
+
+  FUZZ_CHECK(MODEL_RECORDS_ > model_.record_count);
+  record = &model_.records[model_.record_count++];
+  record->queue = (uint8_t)queue;
+  record->source = JOURNAL_SOURCE_REMOTE;
+  record->value = (uint8_t)value;
+  record->accepted = accepted ? 1U : 0U;
+}
+
+/* A delimiter: what the decoder must make of the frame before it */
+static void model_frame_(void)
+{
+  uint8_t frame[REMOTE_CONFIG_MAX_FRAME];
+  uint32_t len = 0U;
+
+  if (0U == model_.chunk_len)
+  {
+    return;
+  }
+  if (model_.chunk_long
+      || !model_decode_(model_.chunk, model_.chunk_len, frame, REMOTE_CONFIG_MAX_FRAME, &len)
+      || ((HEADER_SIZE_ + CRC_SIZE_) > len))
+  {
+    model_.stats.framing_errors++;
+    return;
+  }
+  len -= CRC_SIZE_;
+  if (model_crc_(frame, len) != model_u32_(&frame[len]))
+  {
+    model_.stats.crc_errors++;
+    return;
+  }
+
+  memcpy(model_.request.bytes, frame, len);
+  model_.request.len = len;
+  model_.request.retry = model_.have_last && (frame[0] == model_.last_seq);
+  model_.pending = true;
+  if (model_.request.retry)
+  {
+    model_.stats.retries++;
+    return;
+  }
+  if (model_.have_last && (frame[0] != (uint8_t)(model_.last_seq + 1U)))
+  {
+    model_.stats.seq_gaps++;
+  }
+  model_.stats.frames++;
+  model_.last_seq = frame[0];
+  model_.have_last = true;
+}
+
+static void feed_(uint8_t byte)
+{
+  if (0U == byte)
+  {
+    model_frame_();
+    rx_feed_(byte);
+    FUZZ_CHECK(!model_.pending);
+    model_.chunk_len = 0U;
+    model_.chunk_long = false;
+    return;
+  }
+  if (CHUNK_MAX_ > model_.chunk_len)
+  {
+    model_.chunk[model_.chunk_len++] = byte;
+  }
+  else
+  {
+    model_.chunk_long = true;
+  }
+  rx_feed_(byte);
+}
+
+static uint32_t counters_size_(uint8_t group, uint8_t index, bool *valid)
+{
+  static const uint32_t sizes[REMOTE_COUNTERS__N] =
+  {
+    [REMOTE_COUNTERS_REMOTE]    = sizeof(remote_stats_t),
+    [REMOTE_COUNTERS_OVERLOAD]  = sizeof(overload_stats_t),
+    [REMOTE_COUNTERS_UART_RX]   = sizeof(uart_rx_stats_t),
+    [REMOTE_COUNTERS_DEFERRED]  = sizeof(deferred_stats_t),
+    [REMOTE_COUNTERS_AO_LED]    = sizeof(ao_led_stats_t),
+    [REMOTE_COUNTERS_PERF]      = sizeof(perf_bench_results_t),
+    [REMOTE_COUNTERS_WARMBOOT]  = sizeof(warmboot_stats_t),
+    [REMOTE_COUNTERS_JOURNAL]   = sizeof(journal_stats_t),
+    [REMOTE_COUNTERS_CYCLIC]    = sizeof(cyclic_stats_t),
+    [REMOTE_COUNTERS_BLOCKPOOL] = sizeof(blockpool_stats_t),
+  };
+
+  *valid = (REMOTE_COUNTERS__N > group)
+           && ((REMOTE_COUNTERS_AO_LED != group) || (1U >= index))
+           && ((REMOTE_COUNTERS_DEFERRED != group) || (DEFERRED_PRIO__N > index));
+  return *valid ? sizes[group] : 0U;
+}
+
+static void check_journal_(const uint8_t *payload, uint32_t len, uint32_t seq)
+{
+  journal_stats_t stats;
+  uint32_t oldest;
+  uint32_t first;
+  uint32_t count;
+
+  journal_get_stats(&stats);
+  FUZZ_CHECK(8U <= len);
+  FUZZ_CHECK(0U == ((len - 8U) % sizeof(journal_record_t)));
+  FUZZ_CHECK(stats.recorded == model_u32_(&payload[4]));
+  FUZZ_CHECK(stats.recorded == model_.records_base + model_.record_count);
+
+  // from seq, or the oldest kept if it was overwritten; as many as fit
+  oldest = (JOURNAL_CONFIG_RECORDS < stats.recorded) ? (stats.recorded - JOURNAL_CONFIG_RECORDS) : 0U;
+  first = (0 < (int32_t)(oldest - seq)) ? oldest : seq;
+  count = (0 < (int32_t)(stats.recorded - first)) ? (stats.recorded - first) : 0U;
+  count = (JOURNAL_READ_MAX_ < count) ? JOURNAL_READ_MAX_ : count;
+  FUZZ_CHECK(first == model_u32_(&payload[0]));
+  FUZZ_CHECK(count == ((len - 8U) / sizeof(journal_record_t)));
+
+  for (uint32_t i = 0; i < count; i++)
+  {
+    journal_record_t record;
+    uint32_t at = first + i - model_.records_base;
+
+    memcpy(&record, &payload[8U + (i * sizeof(record))], sizeof(record));
+    // the ones of earlier inputs are not in the model
+    if (0 <= (int32_t)at)
+    {
+      const journal_record_t *expected = &model_.records[at];
+
+      FUZZ_CHECK((expected->queue == record.queue) && (expected->source == record.source)
+                 && (expected->value == record.value) && (expected->accepted == record.accepted));
+    }
+  }
+}
+
+/* A response to a new request: what the command must have done */
+static void check_command_(const request_t *request, remote_status_t status, const uint8_t *payload,
+                           uint32_t len, const fakes_t *before)
+{
+  const uint8_t *args = &request->bytes[HEADER_SIZE_];
+  uint32_t args_len = request->len - HEADER_SIZE_;
+  bool valid = false;
+
+  switch (request->bytes[1])
+  {
+    case REMOTE_CMD_PING:
+      FUZZ_CHECK((REMOTE_STATUS_OK == status) && (0U == len));
+      break;
+
+    case REMOTE_CMD_POST_UI:
+      valid = (1U == args_len) && (AO_UI_MESSAGE__N > args[0]);
+      FUZZ_CHECK(valid || (REMOTE_STATUS_BAD_ARG == status));
+      FUZZ_CHECK(fakes_.ui_sends == before->ui_sends + (valid ? 1U : 0U));
+      if (valid)
+      {
+        FUZZ_CHECK((REMOTE_STATUS_OK == status) || (REMOTE_STATUS_BUSY == status));
+        model_journal_(JOURNAL_QUEUE_UI, args[0], (REMOTE_STATUS_OK == status));
+      }
+      break;
+
+    case REMOTE_CMD_POST_PQ:
+      valid = (1U == args_len) && (HIGH_PRIORITY >= args[0]);
+      FUZZ_CHECK(valid || (REMOTE_STATUS_BAD_ARG == status));
+      if (valid)
+      {
+        // shed by the overload controller, or sent once
+        bool shed = (fakes_.led_sends == before->led_sends);
+
+        FUZZ_CHECK(fakes_.overload_calls == before->overload_calls + 1U);
+        FUZZ_CHECK(fakes_.led_sends == before->led_sends + (shed ? 0U : 1U));
+        FUZZ_CHECK(!shed || (REMOTE_STATUS_OK == status));
+        if (!shed)
+        {
+          FUZZ_CHECK((REMOTE_STATUS_OK == status) || (REMOTE_STATUS_BUSY == status));
+          model_journal_(JOURNAL_QUEUE_LED, args[0], (REMOTE_STATUS_OK == status));
+        }
+      }
+      else
+      {
+        FUZZ_CHECK(fakes_.led_sends == before->led_sends);
+      }
+      break;
+
+    case REMOTE_CMD_READ_COUNTERS:
+    {
+      uint32_t size = (2U == args_len) ? counters_size_(args[0], args[1], &valid) : 0U;
+
+      valid = valid && (2U == args_len);
+      FUZZ_CHECK(valid ? ((REMOTE_STATUS_OK == status) && (size == len)) : (REMOTE_STATUS_BAD_ARG == status));
+      break;
+    }
+
+    case REMOTE_CMD_SET_PARAM:
+      valid = (5U == args_len);
+      FUZZ_CHECK(valid || (REMOTE_STATUS_BAD_ARG == status));
+      FUZZ_CHECK((REMOTE_STATUS_OK == status) || (REMOTE_STATUS_BAD_ARG == status));
+      // kept only once applied
+      FUZZ_CHECK(fakes_.kv_sets == before->kv_sets + ((REMOTE_STATUS_OK == status) ? 1U : 0U));
+      if (REMOTE_STATUS_OK == status)
+      {
+        FUZZ_CHECK(REMOTE_PARAM__N > args[0]);
+        FUZZ_CHECK((param_keys_[args[0]] == fakes_.kv_key) && (model_u32_(&args[1]) == fakes_.kv_value));
+      }
+      break;
+
+    case REMOTE_CMD_GET_PARAM:
+      valid = (1U == args_len) && (REMOTE_PARAM__N > args[0]);
+      FUZZ_CHECK(valid ? ((REMOTE_STATUS_OK == status) && (4U == len)) : (REMOTE_STATUS_BAD_ARG == status));
+      break;
+
+    case REMOTE_CMD_PRESS_BUTTON:
+      valid = (4U == args_len);
+      FUZZ_CHECK(valid || (REMOTE_STATUS_BAD_ARG == status));
+      FUZZ_CHECK(fakes_.presses == before->presses + (valid ? 1U : 0U));
+      FUZZ_CHECK(!valid || (model_u32_(args) == fakes_.press_ms));
+      break;
+
+    case REMOTE_CMD_WARM_RESET:
+      FUZZ_CHECK((REMOTE_STATUS_OK == status) && reset_pending_);
+      break;
+
+    case REMOTE_CMD_READ_JOURNAL:
+      valid = (4U == args_len);
+      FUZZ_CHECK(valid ? (REMOTE_STATUS_OK == status) : (REMOTE_STATUS_BAD_ARG == status));
+      if (valid)
+      {
+        check_journal_(payload, len, model_u32_(args));
+      }
+      break;
+
+    case REMOTE_CMD_REPLAY_JOURNAL:
+      FUZZ_CHECK((REMOTE_STATUS_OK == status) || (REMOTE_STATUS_BUSY == status));
+      break;
+
+    default:
+      FUZZ_CHECK(REMOTE_STATUS_BAD_CMD == status);
+      model_.stats.bad_commands++;
+      break;
+  }
+}
+
+static void feed_framed_(const uint8_t *data, size_t size)
+{
+  size_t i = 0U;
+
+  while (i < size)
+  {
+    uint8_t ctl = data[i++];
+    uint8_t frame[CTL_LEN_MASK_ + CRC_SIZE_];
+    uint8_t encoded[TX_BUFFER_SIZE_ + CTL_LEN_MASK_];
+    uint32_t len = ctl & CTL_LEN_MASK_;
+    uint32_t crc;
+    uint32_t encoded_len;
+
+    len = ((size - i) < len) ? (uint32_t)(size - i) : len;
+    memcpy(frame, &data[i], len);
+    i += len;
+
+    crc = model_crc_(frame, len) ^ ((0U != (ctl & CTL_BAD_CRC_)) ? 1U : 0U);
+    frame[len++] = (uint8_t)crc;
+    frame[len++] = (uint8_t)(crc >> 8);
+    frame[len++] = (uint8_t)(crc >> 16);
+    frame[len++] = (uint8_t)(crc >> 24);
+
+    encoded_len = model_encode_(frame, len, encoded);
+    for (uint32_t k = 0; k < encoded_len; k++)
+    {
+      feed_(encoded[k]);
+    }
+    if (0U == (ctl & CTL_NO_DELIMITER_))
+    {
+      feed_(0U);
+    }
+  }
+}
+
+static void reset_(void)
+{
+  journal_stats_t stats;
+
+  if (!ready_)
+  {
+    // the replay task is created but never runs: a replay stays pending
+    journal_init();
+    ready_ = true;
+  }
+  logger_set_threshold(LOGGER_LEVEL_WARN);
+
+  rx_reset_();
+  tx_.have_last = false;
+  reset_pending_ = false;
+  memset(&stats_, 0, sizeof(stats_));
+
+  memset(&model_.stats, 0, sizeof(model_.stats));
+  model_.chunk_len = 0U;
+  model_.chunk_long = false;
+  model_.have_last = false;
+  model_.pending = false;
+  model_.last_response_len = 0U;
+  journal_get_stats(&stats);
+  model_.records_base = stats.recorded;
+  model_.record_count = 0U;
+  model_.before = fakes_;
+}
+
+/********************** external functions definition ************************/
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+  remote_stats_t stats;
+
+  if (0U == size)
+  {
+    return 0;
+  }
+  reset_();
+
+  if (0U != (data[0] & MODE_FRAMED_))
+  {
+    feed_framed_(&data[1], size - 1U);
+  }
+  else
+  {
+    for (size_t i = 1U; i < size; i++)
+    {
+      feed_(data[i]);
+    }
+  }
+  // whatever is left is a frame too
+  feed_(0U);
+
+  remote_get_stats(&stats);
+  FUZZ_CHECK(model_.stats.frames == stats.frames);
+  FUZZ_CHECK(model_.stats.retries == stats.retries);
+  FUZZ_CHECK(model_.stats.seq_gaps == stats.seq_gaps);
+  FUZZ_CHECK(model_.stats.crc_errors == stats.crc_errors);
+  FUZZ_CHECK(model_.stats.framing_errors == stats.framing_errors);
+  FUZZ_CHECK(model_.stats.bad_commands == stats.bad_commands);
+  FUZZ_CHECK(0U == stats.tx_errors);
+  return 0;
+}
+
+/* The response of the request the model expects, see handle_() */
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size,
+                                    uint32_t Timeout)
+{
+  uint8_t response[REMOTE_CONFIG_MAX_FRAME];
+  uint32_t len = 0U;
+
+  (void)Timeout;
+  FUZZ_CHECK(&huart3 == huart);
+  FUZZ_CHECK(model_.pending);
+  model_.pending = false;
+
+  // one frame: a single delimiter, at the end
+  FUZZ_CHECK((2U <= Size) && (TX_BUFFER_SIZE_ >= Size) && (0U == pData[Size - 1U]));
+  FUZZ_CHECK(NULL == memchr(pData, 0, Size - 1U));
+  FUZZ_CHECK(model_decode_(pData, Size - 1U, response, sizeof(response), &len));
+  FUZZ_CHECK((RESPONSE_HEADER_SIZE_ + CRC_SIZE_) <= len);
+  len -= CRC_SIZE_;
+  FUZZ_CHECK(model_crc_(response, len) == model_u32_(&response[len]));
+  FUZZ_CHECK(model_.request.bytes[0] == response[0]);
+  FUZZ_CHECK(REMOTE_STATUS_BUSY >= response[2]);
+
+  if (model_.request.retry)
+  {
+    // whatever the command this time, the seq says it was answered
+    FUZZ_CHECK((model_.last_response_len == Size) && (0 == memcmp(model_.last_response, pData, Size)));
+  }
+  else
+  {
+    FUZZ_CHECK((model_.request.bytes[1] | RESPONSE_FLAG_) == response[1]);
+    check_command_(&model_.request, (remote_status_t)response[2], &response[RESPONSE_HEADER_SIZE_],
+                   len - RESPONSE_HEADER_SIZE_, &model_.before);
+    memcpy(model_.last_response, pData, Size);
+    model_.last_response_len = Size;
+  }
+  model_.before = fakes_;
+  return HAL_OK;
+}
+
+/* Destinations of the commands, counting what reaches them */
+bool ao_ui_send(ao_ui_handle_t *hao_ui, ao_ui_message_t msg)
+{
+  FUZZ_CHECK((&ao_ui == hao_ui) && (AO_UI_MESSAGE__N > msg));
+  // now and then the queue is full
+  return (0U != (++fakes_.ui_sends % 4U));
+}
+
+bool ao_led_send(ao_led_handle_t *hao_led, pq_event_t evt)
+{
+  FUZZ_CHECK((&ao_led == hao_led) && (HIGH_PRIORITY >= evt.priority));
+  return (0U != (++fakes_.led_sends % 4U));
+}
+
+bool overload_drop(pq_priority_t priority)
+{
+  FUZZ_CHECK(HIGH_PRIORITY >= priority);
+  return (0U == (++fakes_.overload_calls % 5U));
+}
+
+bool kvstore_set_u32(kvstore_key_t key, uint32_t value)
+{
+  fakes_.kv_sets++;
+  fakes_.kv_key = (uint32_t)key;
+  fakes_.kv_value = value;
+  return true;
+}
+
+bool kvstore_get_u32(kvstore_key_t key, uint32_t *value)
+{
+  (void)key;
+  (void)value;
+  return false;
+}
+
+bool task_button_press(uint32_t ms)
+{
+  fakes_.presses++;
+  fakes_.press_ms = ms;
+  return true;
+}
+
+bool task_button_set_timeout(task_button_timeout_t timeout, uint32_t ms)
+{
+  return (TASK_BUTTON_TIMEOUT__N > timeout) && (0U != ms);
+}
+
+uint32_t task_button_get_timeout(task_button_timeout_t timeout)
+{
+  (void)timeout;
+  return 0U;
+}
+
+void warmboot_reset(void)
+{
+  // on the target it does not come back
+  FUZZ_CHECK(reset_pending_);
+  fakes_.warm_resets++;
+  reset_pending_ = false;
+}
+
+void ao_led_set_on_period(ao_led_handle_t *hao_led, TickType_t on_period)
+{
+  FUZZ_CHECK((&ao_led == hao_led) && (0U != on_period));
+}
+
+TickType_t ao_led_get_on_period(ao_led_handle_t *hao_led)
+{
+  (void)hao_led;
+  return 1U;
+}
+
+void ao_led_set_pwm_mode(ao_led_handle_t *hao_led, bool enable)
+{
+  (void)hao_led;
+  (void)enable;
+}
+
+bool led_pwm_enabled(void)
+{
+  return false;
+}
+
+/* Counters, only their size matters here */
+void overload_get_stats(overload_stats_t *stats)
+{
+  memset(stats, 0, sizeof(*stats));
+}
+
+void uart_rx_get_stats(uart_rx_stats_t *stats)
+{
+  memset(stats, 0, sizeof(*stats));
+}
+
+void deferred_get_stats(deferred_prio_t prio, deferred_stats_t *stats)
+{
+  FUZZ_CHECK(DEFERRED_PRIO__N > prio);
+  memset(stats, 0, sizeof(*stats));
+}
+
+void ao_led_get_stats(ao_led_handle_t *hao_led, ao_led_stats_t *stats)
+{
+  (void)hao_led;
+  memset(stats, 0, sizeof(*stats));
+}
+
+void ao_led_reset_stats(ao_led_handle_t *hao_led)
+{
+  (void)hao_led;
+}
+
+void perf_bench_get_results(perf_bench_results_t *results)
+{
+  memset(results, 0, sizeof(*results));
+}
+
+void warmboot_get_stats(warmboot_stats_t *stats)
+{
+  memset(stats, 0, sizeof(*stats));
+}
+
+void cyclic_get_stats(cyclic_stats_t *stats)
+{
+  memset(stats, 0, sizeof(*stats));
+}
+
+uint32_t crc_calc32(const void *data, size_t len)
+{
+  return crc_update32_sw(0U, data, len);
+}
+
+void telemetry_trace(uint32_t id, uint32_t arg0, uint32_t arg1)
+{
+  (void)id;
+  (void)arg0;
+  (void)arg1;
+}
+
+void telemetry_log(const char *text, size_t len)
+{
+  (void)text;
+  (void)len;
+}
+
+/* The task is never created, the ring never read */
+size_t uart_rx_wait(TickType_t timeout)
+{
+  (void)timeout;
+  return 0U;
+}
+
+size_t uart_rx_peek(uart_rx_span_t spans[2])
+{
+  (void)spans;
+  return 0U;
+}
+
+bool uart_rx_release(size_t len)
+{
+  (void)len;
+  return true;
+}
+
+/********************** end of file ******************************************/
@@ -0,0 +1,361 @@
+/**
+ * @file fuzz_udp.c
+ * @brief Fuzz harness of the UDP/ARP receive path of udp.c
+ *
+ * udp.c is built into the harness, its receive handler called with each
+ * frame as task_eth would. The input is:
+ *
+ *     control (1)     bit 0 the MAC refuses to send, bit 1 the frames sent
+ *                     complete only at the end of the input
+ *     port (2)        bound, big endian, with UDP_PORT_A_ and UDP_PORT_B_
+ *     frames          length (2, big endian: bit 15 chains a second buffer,
+ *                     the low 11 bits the bytes), then the bytes
+ *
+ * The bytes of a frame past its length are poisoned under ASan, so any read
+ * beyond what the MAC received is caught, not only beyond the buffer.
+ *
+ * A reference parser, written apart from udp.c, says what each frame is: a
+ * datagram for a bound port, an ARP packet for this host or something to
+ * drop. Every frame must be counted once, as what the reference says, and
+ * released once; a datagram must reach the handler of its port once, with
+ * the payload the headers describe; an ARP packet must leave its sender in
+ * the cache and a request must be answered, or counted as busy. Every
+ * transmit slot must be back once the frames sent complete.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+/********************** inclusions *******************************************/
+#include <stdlib.h>
+
+#include "udp.c"        // the receive path and its state are internal
+
+#include "fuzz.h"
+
+#if defined(__SANITIZE_ADDRESS__)
+#include <sanitizer/asan_interface.h>
+#define POISON_(addr, size)     ASAN_POISON_MEMORY_REGION((addr), (size))
+#define UNPOISON_(addr, size)   ASAN_UNPOISON_MEMORY_REGION((addr), (size))
+#else
+#define POISON_(addr, size)     ((void)(addr), (void)(size))
+#define UNPOISON_(addr, size)   ((void)(addr), (void)(size))
+#endif
+
+/********************** macros and definitions *******************************/
+#define CTL_TX_REFUSED_         (0x01U)
+#define CTL_TX_DEFERRED_        (0x02U)
+#define FRAME_CHAINED_          (0x8000U)
+#define FRAME_LEN_MASK_         (0x07FFU)
+#define INPUT_HEADER_           (3U)
+
+#define UDP_PORT_A_             (7U)
+#define UDP_PORT_B_             (5000U)
+
+/********************** internal data declaration ****************************/
+typedef enum
+{
+  KIND_DROPPED,
+  KIND_ARP,
+  KIND_DATAGRAM,
+} kind_t;
+
+typedef struct
+{
+  kind_t         kind;
+  uint16_t       port;
+  uint32_t       payload_at;     /**< Offset in the frame */
+  uint16_t       payload_len;
+  uint32_t       src_ip;
+  uint16_t       src_port;
+  bool           arp_request;
+  uint32_t       arp_sender_ip;
+  const uint8_t *arp_sender_mac;
+} expected_t;
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+static uint8_t mac_[MAC_SIZE_] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x10 };
+
+static struct
+{
+  bool           refuse;
+  bool           defer;
+  uint16_t       ports[3];
+  eth_frame_t   *frame;          /**< Being handled */
+  uint32_t       releases;
+  uint32_t       deliveries;
+  expected_t     expected;
+  eth_frame_tx_t *sent[UDP_CONFIG_TX_SLOTS];
+  uint32_t       sent_count;
+  uint32_t       arp_replies;
+} model_;
+
+/********************** external data definition *****************************/
+ETH_HandleTypeDef heth;
+
+/********************** internal functions definition ************************/
+
+static uint16_t be16_(const uint8_t *p)
+{
+  return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static uint32_t be32_(const uint8_t *p)
+{
+  return ((uint32_t)be16_(p) << 16) | be16_(&p[2]);
+}
+
+static bool bound_(uint16_t port)
+{
+  return (model_.ports[0] == port) || (model_.ports[1] == port) || (model_.ports[2] == port);
+}
+
+/* What udp.h promises for a frame, see the header comment */
+static expected_t classify_(const uint8_t *p, uint32_t len, bool chained)
+{
+  expected_t e = { .kind = KIND_DROPPED };
+
+  if (chained || (14U > len))
+  {
+    return e;
+  }
+  if (0x0806U == be16_(&p[12]))
+  {
+    const uint8_t *arp = &p[14];
+
+    if ((14U + 28U <= len) && (1U == be16_(&arp[0])) && (0x0800U == be16_(&arp[2])) && (6U == arp[4])
+        && (4U == arp[5]) && (UDP_CONFIG_ADDRESS == be32_(&arp[24])))
+    {
+      e.kind = KIND_ARP;
+      e.arp_request = (1U == be16_(&arp[6]));
+      e.arp_sender_ip = be32_(&arp[14]);
+      e.arp_sender_mac = &arp[8];
+    }
+  }
+  else if (0x0800U == be16_(&p[12]))
+  {
+    const uint8_t *ip = &p[14];
+    uint32_t ihl;
+    uint32_t total;
+    uint32_t dst;
+
+    if ((14U + 20U > len) || (0x40U != (ip[0] & 0xF0U)))
+    {
+      return e;
+    }
+    ihl = (ip[0] & 0x0FU) * 4U;
+    total = be16_(&ip[2]);
+    dst = be32_(&ip[16]);
+    // host part all ones is a broadcast on any network
+    if ((20U <= ihl) && (ihl + 8U <= total) && (total <= len - 14U) && (0U == (be16_(&ip[6]) & 0x3FFFU))
+        && (17U == ip[9]) && ((UDP_CONFIG_ADDRESS == dst) || (UDP_BROADCAST == (dst | UDP_CONFIG_NETMASK))))
+    {
+      const uint8_t *udp = &ip[ihl];
+      uint16_t udp_len = be16_(&udp[4]);
+
+      if ((8U <= udp_len) && (udp_len <= total - ihl) && bound_(be16_(&udp[2])))
+      {
+        e.kind = KIND_DATAGRAM;
+        e.port = be16_(&udp[2]);
+        e.payload_at = 14U + ihl + 8U;
+        e.payload_len = (uint16_t)(udp_len - 8U);
+        e.src_ip = be32_(&ip[12]);
+        e.src_port = be16_(&udp[0]);
+      }
+    }
+  }
+  return e;
+}
+
+static void handler_(uint32_t src_ip, uint16_t src_port, const uint8_t *payload, uint16_t len, void *arg)
+{
+  const expected_t *e = &model_.expected;
+
+  FUZZ_CHECK(NULL != model_.frame);
+  FUZZ_CHECK(KIND_DATAGRAM == e->kind);
+  FUZZ_CHECK((uintptr_t)arg == e->port);
+  FUZZ_CHECK(&model_.frame->data[e->payload_at] == payload);
+  FUZZ_CHECK((e->payload_len == len) && (e->payload_at + len <= model_.frame->len));
+  FUZZ_CHECK((e->src_ip == src_ip) && (e->src_port == src_port));
+  model_.deliveries++;
+}
+
+static void complete_(void)
+{
+  for (uint32_t i = 0; i < model_.sent_count; i++)
+  {
+    eth_frame_tx_t *tx = model_.sent[i];
+
+    tx->done(tx);
+  }
+  model_.sent_count = 0U;
+}
+
+static uint32_t free_slots_(void)
+{
+  uint32_t count = 0U;
+
+  for (tx_slot_t *slot = udp_.free; NULL != slot; slot = slot->next)
+  {
+    FUZZ_CHECK(UDP_CONFIG_TX_SLOTS > count);
+    FUZZ_CHECK((slot >= &slots_[0]) && (slot < &slots_[UDP_CONFIG_TX_SLOTS]));
+    count++;
+  }
+  return count;
+}
+
+static void frame_(const uint8_t *data, uint32_t len, bool chained)
+{
+  eth_frame_t *frame = malloc(sizeof(eth_frame_t));
+  eth_frame_t *second = chained ? malloc(sizeof(eth_frame_t)) : NULL;
+  udp_stats_t before;
+  udp_stats_t after;
+  uint32_t releases = model_.releases;
+  uint32_t deliveries = model_.deliveries;
+  uint32_t arp_replies = model_.arp_replies;
+  const expected_t *e = &model_.expected;
+
+  FUZZ_CHECK((NULL != frame) && (!chained || (NULL != second)));
+  memcpy(frame->data, data, len);
+  frame->len = (uint16_t)len;
+  frame->next = second;
+  if (NULL != second)
+  {
+    second->len = 0U;
+    second->next = NULL;
+  }
+  POISON_(&frame->data[len], sizeof(frame->data) - len);
+
+  model_.expected = classify_(data, len, chained);
+  udp_get_stats(&before);
+  model_.frame = frame;
+  rx_handler_(frame, NULL);
+  model_.frame = NULL;
+  udp_get_stats(&after);
+
+  // counted once, as what it is
+  FUZZ_CHECK(releases + 1U == model_.releases);
+  FUZZ_CHECK(before.rx_dropped + ((KIND_DROPPED == e->kind) ? 1U : 0U) == after.rx_dropped);
+  FUZZ_CHECK(before.rx_arp + ((KIND_ARP == e->kind) ? 1U : 0U) == after.rx_arp);
+  FUZZ_CHECK(before.rx_datagrams + ((KIND_DATAGRAM == e->kind) ? 1U : 0U) == after.rx_datagrams);
+  FUZZ_CHECK(deliveries + ((KIND_DATAGRAM == e->kind) ? 1U : 0U) == model_.deliveries);
+
+  if (KIND_ARP == e->kind)
+  {
+    uint8_t mac[MAC_SIZE_];
+
+    FUZZ_CHECK(arp_lookup_(e->arp_sender_ip, mac) && (0 == memcmp(mac, e->arp_sender_mac, MAC_SIZE_)));
+    // answered, or the slot or the MAC was busy
+    FUZZ_CHECK((arp_replies + (e->arp_request ? 1U : 0U) == model_.arp_replies)
+               || (e->arp_request && (before.tx_busy + 1U == after.tx_busy)));
+  }
+  else
+  {
+    FUZZ_CHECK(arp_replies == model_.arp_replies);
+  }
+
+  UNPOISON_(&frame->data[len], sizeof(frame->data) - len);
+  free(second);
+  free(frame);
+  if (!model_.defer)
+  {
+    complete_();
+  }
+}
+
+static void reset_(const uint8_t *data)
+{
+  heth.Init.MACAddr = mac_;
+  memset(&udp_, 0, sizeof(udp_));
+  udp_init();
+
+  model_.refuse = (0U != (data[0] & CTL_TX_REFUSED_));
+  model_.defer = (0U != (data[0] & CTL_TX_DEFERRED_));
+  model_.ports[0] = UDP_PORT_A_;
+  model_.ports[1] = UDP_PORT_B_;
+  model_.ports[2] = be16_(&data[1]);
+  model_.sent_count = 0U;
+  for (uint32_t i = 0; i < 3U; i++)
+  {
+    // the port doubles as the handler argument, a port already bound fails
+    bool bound = udp_bind(model_.ports[i], handler_, (void *)(uintptr_t)model_.ports[i]);
+
+    FUZZ_CHECK(bound == ((i < 2U) || ((model_.ports[2] != UDP_PORT_A_) && (model_.ports[2] != UDP_PORT_B_))));
+  }
+}
+
+/********************** external functions definition ************************/
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+  size_t i = INPUT_HEADER_;
+
+  if (INPUT_HEADER_ > size)
+  {
+    return 0;
+  }
+  reset_(data);
+
+  while (i + 2U <= size)
+  {
+    uint16_t header = be16_(&data[i]);
+    uint32_t len = header & FRAME_LEN_MASK_;
+
+    i += 2U;
+    len = (len < ETH_FRAME_BUFFER_SIZE) ? len : ETH_FRAME_BUFFER_SIZE;
+    len = (len < (size - i)) ? len : (uint32_t)(size - i);
+    frame_(&data[i], len, (0U != (header & FRAME_CHAINED_)));
+    i += len;
+  }
+
+  complete_();
+  FUZZ_CHECK(UDP_CONFIG_TX_SLOTS == free_slots_());
+  return 0;
+}
+
+void eth_frame_set_rx_handler(eth_frame_rx_handler_t handler, void *arg)
+{
+  FUZZ_CHECK((rx_handler_ == handler) && (NULL == arg));
+}
+
+void eth_frame_release(eth_frame_t *frame)
+{
+  FUZZ_CHECK(model_.frame == frame);
+  model_.releases++;
+}
+
+/* The MAC: takes the frame, or refuses it as with no free descriptors */
+bool eth_frame_send(eth_frame_tx_t *tx)
+{
+  const uint8_t *p = tx->buffers[0].buffer;
+  const expected_t *e = &model_.expected;
+  uint32_t total = 0U;
+
+  for (const ETH_BufferTypeDef *b = tx->buffers; NULL != b; b = b->next)
+  {
+    FUZZ_CHECK(0U != b->len);
+    total += b->len;
+  }
+  FUZZ_CHECK(total == tx->len);
+  if (model_.refuse)
+  {
+    return false;
+  }
+  FUZZ_CHECK(UDP_CONFIG_TX_SLOTS > model_.sent_count);
+  model_.sent[model_.sent_count++] = tx;
+
+  // only ARP replies are sent from the receive path
+  FUZZ_CHECK((NULL != model_.frame) && (KIND_ARP == e->kind) && e->arp_request);
+  FUZZ_CHECK((ETH_HEADER_ + ARP_PACKET_ == tx->len) && (0x0806U == be16_(&p[12])));
+  FUZZ_CHECK((0 == memcmp(&p[0], e->arp_sender_mac, MAC_SIZE_)) && (0 == memcmp(&p[6], mac_, MAC_SIZE_)));
+  FUZZ_CHECK((ARP_REPLY_ == be16_(&p[20])) && (UDP_CONFIG_ADDRESS == be32_(&p[28])));
+  FUZZ_CHECK((0 == memcmp(&p[32], e->arp_sender_mac, MAC_SIZE_)) && (e->arp_sender_ip == be32_(&p[38])));
+  model_.arp_replies++;
+  return true;
+}
+
+/********************** end of file ******************************************/
@@ -0,0 +1,69 @@
+/**
+ * @file hooks.c
+ * @brief Kernel hooks of the fuzz harnesses, the ones main.c gives the sim
+ *
+ * Any failure aborts, so both libFuzzer and driver.c catch it and keep the
+ * input that caused it.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+/********************** inclusions *******************************************/
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "main.h"
+#include "cmsis_os.h"
+
+#include "fuzz.h"
+
+/********************** macros and definitions *******************************/
+
+/********************** internal data declaration ****************************/
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+/********************** external functions definition ************************/
+
+void fuzz_failed(const char *expr, const char *file, int line)
+{
+  fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expr);
+  abort();
+}
+
+void Error_Handler(void)
+{
+  fprintf(stderr, "Error_Handler\n");
+  abort();
+}
+
+void vAssertCalled(const char *file, int line)
+{
+  fprintf(stderr, "%s:%d: assert failed\n", file, line);
+  abort();
+}
+
+void configureTimerForRunTimeStats(void)
+{
+}
+
+unsigned long getRunTimeCounterValue(void)
+{
+  return 0UL;
+}
+
+/* The scheduler never starts here */
+void vApplicationIdleHook(void)
+{
+}
+
+/********************** end of file ******************************************/
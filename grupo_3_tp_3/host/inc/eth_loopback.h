@@ -0,0 +1,79 @@
+/**
+ * @file eth_loopback.h
+ * @brief Host bridge from the wire of eth_pcap.c to loopback UDP sockets
+ *
+ * The target's subnet gets one more host, the peer, played by this process:
+ * it answers the ARP requests for its address, and the UDP datagrams sent
+ * to it or broadcast go out of a socket to 127.0.0.1, to the same port or
+ * the one given by eth_loopback_map(). So `nc -lu 5001` on the machine
+ * running a host build shows the telemetry log, as on a board's subnet.
+ *
+ * The bridge checks every datagram as the peer's NIC would, before it
+ * forwards it: the IPv4 header and UDP checksums the MAC inserted must be
+ * valid. Datagrams failing are counted and dropped.
+ *
+ * Datagrams from the loopback side are not bridged to the target.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+#ifndef ETH_LOOPBACK_H_
+#define ETH_LOOPBACK_H_
+
+/********************** CPP guard ********************************************/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/********************** inclusions *******************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+/********************** macros ***********************************************/
+#define ETH_LOOPBACK_MAPS       (4U)
+
+/********************** typedef **********************************************/
+
+typedef struct
+{
+  uint32_t forwarded;       /**< Datagrams given to the loopback socket */
+  uint32_t bad_checksum;    /**< IPv4 header or UDP checksum wrong or missing */
+  uint32_t arp_replies;
+  uint32_t ignored;         /**< Not for the peer, or not UDP/IPv4 nor ARP */
+} eth_loopback_stats_t;
+
+/********************** external data declaration ****************************/
+
+/********************** external functions declaration ***********************/
+
+/**
+ * @brief Opens the loopback socket and plugs the peer in the wire, with the
+ *        given address, host byte order as UDP_IP4(). Call after
+ *        MX_ETH_Init(), before the scheduler starts.
+ *
+ * @return false if the socket could not be opened.
+ */
+bool eth_loopback_init(uint32_t peer_ip);
+
+/**
+ * @brief Sends the datagrams to port to 127.0.0.1:loopback_port instead.
+ *
+ * @return false if no map is left.
+ */
+bool eth_loopback_map(uint16_t port, uint16_t loopback_port);
+
+/**
+ * @brief Copies the statistics.
+ */
+void eth_loopback_get_stats(eth_loopback_stats_t *stats);
+
+/********************** End of CPP guard *************************************/
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ETH_LOOPBACK_H_ */
+/********************** end of file ******************************************/
@@ -0,0 +1,118 @@
+/**
+ * @file eth_pcap.h
+ * @brief Host stand-in for the ETH MAC, its DMA and the PHY, over pcap files
+ *
+ * eth_pcap.c implements the HAL ETH API eth_frame.c uses, see
+ * stm32f4xx_hal.h, the way the HAL drives the hardware: ETH_RX_DESC_CNT
+ * receive descriptors refilled through HAL_ETH_RxAllocateCallback() and
+ * read through HAL_ETH_RxLinkCallback(), ETH_TX_DESC_CNT transmit
+ * descriptors, one per buffer of a frame, released through
+ * HAL_ETH_TxFreeCallback().
+ *
+ * The wire is a frame arriving, eth_pcap_receive(), or a capture played on
+ * the virtual clock, eth_pcap_play(). A frame needs as many descriptors
+ * owned by the DMA, with a buffer, as ETH_RX_BUF_SIZE pieces it has; else
+ * it is dropped and the error interrupt raised, as the MAC does when the
+ * receive buffers are unavailable. Frames with a wrong IPv4 header or UDP
+ * checksum are dropped as by the checksum offload.
+ *
+ * A frame sent is gathered from its buffers, padded to the minimum length,
+ * its IPv4 header and UDP, TCP or ICMP checksums inserted as TxConfig asks,
+ * and written to the capture of eth_pcap_record() and to the hook. The
+ * frame then completes at once, or when eth_pcap_hold_tx() lets it.
+ *
+ * The interrupts are raised from the calling task, in a critical section:
+ * as on the target, a task they wake runs once it ends.
+ *
+ * The PHY reports a 100M full duplex link when eth_pcap_set_link() says so,
+ * down until then. MX_ETH_Init() sets up heth and TxConfig as on target.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+#ifndef ETH_PCAP_H_
+#define ETH_PCAP_H_
+
+/********************** CPP guard ********************************************/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/********************** inclusions *******************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "main.h"
+
+/********************** macros ***********************************************/
+#define ETH_PCAP_FRAME_MAX      (ETH_RX_DESC_CNT * ETH_RX_BUF_SIZE)  /**< Largest frame received */
+
+/********************** typedef **********************************************/
+
+typedef void (*eth_pcap_tx_hook_t)(const uint8_t *frame, uint32_t len, void *arg);
+
+typedef struct
+{
+  uint32_t rx_frames;        /**< Written into descriptors */
+  uint32_t rx_dropped;       /**< No descriptors ready, MAC stopped or too long */
+  uint32_t rx_bad_checksum;  /**< Dropped by the checksum offload */
+  uint32_t tx_frames;
+  uint32_t tx_bytes;
+} eth_pcap_stats_t;
+
+/********************** external data declaration ****************************/
+
+/********************** external functions declaration ***********************/
+
+/**
+ * @brief Plugs or unplugs the cable: the PHY reports it from now on.
+ */
+void eth_pcap_set_link(bool up);
+
+/**
+ * @brief A frame arrives on the wire now. Task context.
+ *
+ * @return false if the MAC dropped it.
+ */
+bool eth_pcap_receive(const uint8_t *frame, uint32_t len);
+
+/**
+ * @brief Plays a capture on the wire: each frame arrives at its offset from
+ *        the first one, counted from now, on the virtual clock.
+ *
+ * @return false if the file is not an Ethernet pcap capture.
+ */
+bool eth_pcap_play(const char *path);
+
+/**
+ * @brief Writes every frame sent from now on to a pcap capture, stamped
+ *        with the virtual time. NULL ends the capture.
+ */
+bool eth_pcap_record(const char *path);
+
+/**
+ * @brief Sets a function given every frame sent, as written to the wire.
+ */
+void eth_pcap_set_tx_hook(eth_pcap_tx_hook_t hook, void *arg);
+
+/**
+ * @brief While held, frames sent do not complete and keep their descriptors.
+ *        Releasing the hold completes them.
+ */
+void eth_pcap_hold_tx(bool hold);
+
+/**
+ * @brief Copies the statistics.
+ */
+void eth_pcap_get_stats(eth_pcap_stats_t *stats);
+
+/********************** End of CPP guard *************************************/
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ETH_PCAP_H_ */
+/********************** end of file ******************************************/
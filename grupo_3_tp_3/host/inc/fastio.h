@@ -0,0 +1,67 @@
+/**
+ * @file fastio.h
+ * @brief Host stand-in for app/inc/fastio.h: the pin helpers on the GPIO shim
+ *
+ * Same functions as on the target for the pins; a write goes through
+ * sim_gpio_write() so it reaches the LED trace. The timer and DMA helpers
+ * are only used by modules the host build replaces.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+#ifndef FASTIO_H_
+#define FASTIO_H_
+
+/********************** CPP guard ********************************************/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/********************** inclusions *******************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "stm32f4xx_hal.h"
+#include "sim.h"
+
+/********************** macros ***********************************************/
+
+/********************** typedef **********************************************/
+
+/********************** external data declaration ****************************/
+
+/********************** external functions declaration ***********************/
+
+/**
+ * @brief Input level of a pin, the GPIO_PIN_x mask of the HAL.
+ */
+static inline bool fastio_read(GPIO_TypeDef *port, uint32_t pin)
+{
+  return (0U != (port->IDR & pin));
+}
+
+static inline void fastio_write(GPIO_TypeDef *port, uint32_t pin, bool on)
+{
+  sim_gpio_write(port, on ? pin : (pin << 16), sim_now_us());
+}
+
+static inline void fastio_set(GPIO_TypeDef *port, uint32_t pin)
+{
+  fastio_write(port, pin, true);
+}
+
+static inline void fastio_reset(GPIO_TypeDef *port, uint32_t pin)
+{
+  fastio_write(port, pin, false);
+}
+
+/********************** End of CPP guard *************************************/
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FASTIO_H_ */
+/********************** end of file ******************************************/
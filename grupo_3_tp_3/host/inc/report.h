@@ -0,0 +1,58 @@
+/**
+ * @file report.h
+ * @brief Host simulation: per-scenario report of queues, latencies and drops
+ *
+ * Gathered at the end of a run from the statistics the application keeps
+ * anyway (ao_led.h, overload.h, blockpool.h, the UI elastic queue), plus
+ * the sends the journal recorded, which report_journal() counts as they
+ * come: call it often enough for the journal not to wrap, e.g. on every
+ * scripted input.
+ *
+ * One "key value" line per figure, so two reports compare line by line.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+#ifndef REPORT_H_
+#define REPORT_H_
+
+/********************** CPP guard ********************************************/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/********************** inclusions *******************************************/
+#include <stdint.h>
+#include <stdio.h>
+
+/********************** macros ***********************************************/
+
+/********************** typedef **********************************************/
+
+/********************** external data declaration ****************************/
+
+/********************** external functions declaration ***********************/
+
+/**
+ * @brief Counts the journal records since the previous call. Task context.
+ */
+void report_journal(void);
+
+/**
+ * @brief Writes the report of the run. Once the scheduler has ended.
+ *
+ * @param name    Scenario.
+ * @param presses Button presses the script made.
+ */
+void report_write(FILE *out, const char *name, uint32_t presses);
+
+/********************** End of CPP guard *************************************/
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* REPORT_H_ */
+/********************** end of file ******************************************/
@@ -0,0 +1,76 @@
+/**
+ * @file sim.h
+ * @brief Host simulation: pin stimulus and LED trace of the GPIO shim
+ *
+ * The trace has one line per LED change, in time order:
+ *
+ *     <virtual time in us> <LD1|LD2|LD3> <on|off>
+ *
+ * LD1 is the green LED, LD2 the blue one and LD3 the red one, see board.h.
+ * Two runs of the same script give the same trace, so a scenario is checked
+ * by comparing it with the one expected.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+#ifndef SIM_H_
+#define SIM_H_
+
+/********************** CPP guard ********************************************/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/********************** inclusions *******************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "stm32f4xx_hal.h"
+
+/********************** macros ***********************************************/
+
+/********************** typedef **********************************************/
+
+/********************** external data declaration ****************************/
+
+/********************** external functions declaration ***********************/
+
+/**
+ * @brief Virtual time in microseconds, the tick count times the tick period.
+ */
+uint32_t sim_now_us(void);
+
+/**
+ * @brief Sets the trace output, NULL for none.
+ */
+void sim_trace_open(FILE *out);
+
+/**
+ * @brief LED changes traced so far.
+ */
+uint32_t sim_trace_count(void);
+
+/**
+ * @brief Applies a BSRR word to a port: low half sets, high half resets.
+ *
+ * @param at_us Virtual time the write takes effect, for the trace: a step of
+ *              a LED pattern can fall between two ticks.
+ */
+void sim_gpio_write(GPIO_TypeDef *port, uint32_t bsrr, uint32_t at_us);
+
+/**
+ * @brief Drives an input pin, as the outside world does.
+ */
+void sim_gpio_input(GPIO_TypeDef *port, uint16_t pin, bool level);
+
+/********************** End of CPP guard *************************************/
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_H_ */
+/********************** end of file ******************************************/
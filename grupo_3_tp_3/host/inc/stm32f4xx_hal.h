@@ -0,0 +1,231 @@
+/**
+ * @file stm32f4xx_hal.h
+ * @brief Host stand-in for the STM32F4 HAL: GPIO ports, TIM5, the DWT and ETH
+ *
+ * Shadows the HAL header for the modules built unchanged on the host. The
+ * GPIO ports are plain memory: inputs are driven by the scenario script and
+ * outputs written through HAL_GPIO_WritePin(), HAL_GPIO_TogglePin() or
+ * sim_gpio_write() go to the LED trace, see sim.h.
+ *
+ * TIM5 and the DWT are functions returning registers refreshed on every
+ * read from the virtual clock: TIM5->CNT counts microseconds and
+ * DWT->CYCCNT cycles at SystemCoreClock, both from the tick count.
+ *
+ * The ETH driver API is the part eth_frame.c uses, with the descriptor
+ * counts, the transmit configuration and the callbacks of the HAL; MAC and
+ * PHY are played by eth_pcap.c. The fuzz harnesses only use the types, see
+ * fuzz/driver.c. The other handles only exist for the headers declaring
+ * them.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+#ifndef STM32F4XX_HAL_H
+#define STM32F4XX_HAL_H
+
+/********************** CPP guard ********************************************/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/********************** inclusions *******************************************/
+#include <stdint.h>
+#include <stddef.h>
+
+/********************** macros ***********************************************/
+#define GPIO_PIN_0              ((uint16_t)0x0001)
+#define GPIO_PIN_1              ((uint16_t)0x0002)
+#define GPIO_PIN_2              ((uint16_t)0x0004)
+#define GPIO_PIN_3              ((uint16_t)0x0008)
+#define GPIO_PIN_4              ((uint16_t)0x0010)
+#define GPIO_PIN_5              ((uint16_t)0x0020)
+#define GPIO_PIN_6              ((uint16_t)0x0040)
+#define GPIO_PIN_7              ((uint16_t)0x0080)
+#define GPIO_PIN_8              ((uint16_t)0x0100)
+#define GPIO_PIN_9              ((uint16_t)0x0200)
+#define GPIO_PIN_10             ((uint16_t)0x0400)
+#define GPIO_PIN_11             ((uint16_t)0x0800)
+#define GPIO_PIN_12             ((uint16_t)0x1000)
+#define GPIO_PIN_13             ((uint16_t)0x2000)
+#define GPIO_PIN_14             ((uint16_t)0x4000)
+#define GPIO_PIN_15             ((uint16_t)0x8000)
+
+#define GPIOA                   (&hal_shim_gpio[0])
+#define GPIOB                   (&hal_shim_gpio[1])
+#define GPIOC                   (&hal_shim_gpio[2])
+#define GPIOD                   (&hal_shim_gpio[3])
+#define GPIOE                   (&hal_shim_gpio[4])
+#define GPIOF                   (&hal_shim_gpio[5])
+#define GPIOG                   (&hal_shim_gpio[6])
+#define GPIOH                   (&hal_shim_gpio[7])
+#define HAL_SHIM_GPIO_PORTS     (8U)
+
+#define TIM5                    (hal_shim_tim5())
+#define DWT                     (hal_shim_dwt())
+#define CoreDebug               (&hal_shim_core_debug)
+
+#define ETH_RX_BUF_SIZE         (1524U)   /**< As in stm32f4xx_hal_conf.h */
+#define ETH_RX_DESC_CNT         (4U)      /**< HAL defaults */
+#define ETH_TX_DESC_CNT         (4U)
+
+#define ETH_TX_PACKETS_FEATURES_CSUM                 (0x00000001U)
+#define ETH_TX_PACKETS_FEATURES_CRCPAD               (0x00000020U)
+#define ETH_CHECKSUM_IPHDR_PAYLOAD_INSERT_PHDR_CALC  (0x00C00000U)
+#define ETH_CRC_PAD_INSERT                           (0x00000000U)
+#define ETH_SPEED_10M                                (0x00000000U)
+#define ETH_SPEED_100M                               (0x00004000U)
+#define ETH_HALFDUPLEX_MODE                          (0x00000000U)
+#define ETH_FULLDUPLEX_MODE                          (0x00000800U)
+
+#define CoreDebug_DEMCR_TRCENA_Msk  (1UL << 24)
+#define DWT_CTRL_CYCCNTENA_Msk      (1UL << 0)
+#define TIM_SR_UIF                  (1UL << 0)
+
+/* One core and one thread running at a time: plain accesses are atomic */
+#define __DMB()                 __sync_synchronize()
+#define __LDREXW(addr)          (*(addr))
+#define __STREXW(value, addr)   ((*(addr) = (value)), 0U)
+#define __CLREX()
+
+/********************** typedef **********************************************/
+
+typedef enum
+{
+  HAL_OK       = 0x00U,
+  HAL_ERROR    = 0x01U,
+  HAL_BUSY     = 0x02U,
+  HAL_TIMEOUT  = 0x03U
+} HAL_StatusTypeDef;
+
+typedef enum
+{
+  GPIO_PIN_RESET = 0,
+  GPIO_PIN_SET
+} GPIO_PinState;
+
+typedef struct
+{
+  volatile uint32_t IDR;
+  volatile uint32_t ODR;
+  volatile uint32_t BSRR;   /**< Write through sim_gpio_write(), never read back */
+} GPIO_TypeDef;
+
+typedef struct
+{
+  volatile uint32_t CNT;
+  volatile uint32_t SR;
+} TIM_TypeDef;
+
+typedef struct
+{
+  volatile uint32_t CTRL;
+  volatile uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct
+{
+  volatile uint32_t DEMCR;
+} CoreDebug_Type;
+
+typedef enum
+{
+  ETH_IRQn = 61,
+} IRQn_Type;
+
+typedef struct
+{
+  TIM_TypeDef *Instance;
+} TIM_HandleTypeDef;
+
+typedef struct
+{
+  void *Instance;
+} UART_HandleTypeDef;
+
+typedef struct
+{
+  uint8_t *MACAddr;
+  uint32_t RxBuffLen;
+} ETH_InitTypeDef;
+
+typedef struct
+{
+  void           *Instance;
+  ETH_InitTypeDef Init;
+} ETH_HandleTypeDef;
+
+typedef struct __ETH_BufferTypeDef
+{
+  uint8_t                    *buffer;
+  uint32_t                    len;
+  struct __ETH_BufferTypeDef *next;
+} ETH_BufferTypeDef;
+
+typedef struct
+{
+  uint32_t           Attributes;
+  uint32_t           Length;
+  ETH_BufferTypeDef *TxBuffer;
+  uint32_t           ChecksumCtrl;
+  uint32_t           CRCPadCtrl;
+  void              *pData;
+} ETH_TxPacketConfig;
+
+typedef struct
+{
+  uint32_t Speed;
+  uint32_t DuplexMode;
+} ETH_MACConfigTypeDef;
+
+/********************** external data declaration ****************************/
+extern GPIO_TypeDef hal_shim_gpio[HAL_SHIM_GPIO_PORTS];
+extern CoreDebug_Type hal_shim_core_debug;
+extern uint32_t SystemCoreClock;
+
+/********************** external functions declaration ***********************/
+
+TIM_TypeDef *hal_shim_tim5(void);
+DWT_Type *hal_shim_dwt(void);
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
+void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
+uint32_t HAL_GetTick(void);
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority);
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn);
+
+/* Not in hal.c: defined by whatever host build links a module using it */
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size,
+                                    uint32_t Timeout);
+
+/* eth_pcap.c */
+HAL_StatusTypeDef HAL_ETH_Start_IT(ETH_HandleTypeDef *heth);
+HAL_StatusTypeDef HAL_ETH_Stop_IT(ETH_HandleTypeDef *heth);
+HAL_StatusTypeDef HAL_ETH_ReadData(ETH_HandleTypeDef *heth, void **pAppBuff);
+HAL_StatusTypeDef HAL_ETH_Transmit_IT(ETH_HandleTypeDef *heth, ETH_TxPacketConfig *pTxConfig);
+HAL_StatusTypeDef HAL_ETH_ReleaseTxPacket(ETH_HandleTypeDef *heth);
+HAL_StatusTypeDef HAL_ETH_ReadPHYRegister(ETH_HandleTypeDef *heth, uint32_t PHYAddr, uint32_t PHYReg,
+                                          uint32_t *pRegValue);
+HAL_StatusTypeDef HAL_ETH_GetMACConfig(ETH_HandleTypeDef *heth, ETH_MACConfigTypeDef *macconf);
+HAL_StatusTypeDef HAL_ETH_SetMACConfig(ETH_HandleTypeDef *heth, ETH_MACConfigTypeDef *macconf);
+void HAL_ETH_IRQHandler(ETH_HandleTypeDef *heth);
+
+/* Given by the driver user, eth_frame.c */
+void HAL_ETH_RxAllocateCallback(uint8_t **buff);
+void HAL_ETH_RxLinkCallback(void **pStart, void **pEnd, uint8_t *buff, uint16_t Length);
+void HAL_ETH_TxFreeCallback(uint32_t *buff);
+void HAL_ETH_RxCpltCallback(ETH_HandleTypeDef *heth);
+void HAL_ETH_TxCpltCallback(ETH_HandleTypeDef *heth);
+void HAL_ETH_ErrorCallback(ETH_HandleTypeDef *heth);
+
+/********************** End of CPP guard *************************************/
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STM32F4XX_HAL_H */
+/********************** end of file ******************************************/
@@ -0,0 +1,242 @@
+/**
+ * @file port.c
+ * @brief FreeRTOS port for the host simulation: one POSIX thread per task
+ *
+ * The thread of a task is created with the task, its descriptor kept in the
+ * top word of the task stack, which the stack itself never uses: pxTopOfStack
+ * is the first member of the TCB, so the running task handle leads to it.
+ * Each thread waits for its run flag under a single mutex; a switch sets the
+ * flag of the thread selected by vTaskSwitchContext() and clears its own.
+ *
+ * The clock is virtual. The idle task advances it through vPortIdleTick(),
+ * so time only passes while every task is blocked and the application code
+ * takes no time at all. Runs are repeatable: the order of events depends on
+ * the code and the input, never on the host load.
+ *
+ * With configUSE_TICKLESS_IDLE, the kernel asks the idle task to sleep until
+ * the next task unblocks, and vPortSuppressTicksAndSleep() steps the clock
+ * straight there instead: the ticks skipped are those nothing happens at,
+ * so the run is the same as counting them, only faster. Hours of scripted
+ * traffic take seconds.
+ *
+ * vTaskEndScheduler() returns from vTaskStartScheduler() in the thread that
+ * called it, and leaves every task thread waiting forever. So does a task
+ * deleting itself; the simulation exits long before that matters.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+/********************** inclusions *******************************************/
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+/********************** macros and definitions *******************************/
+#define THREAD_STACK_SIZE_      (256U * 1024U)
+
+/********************** internal data declaration ****************************/
+typedef struct
+{
+  pthread_t      id;
+  pthread_cond_t cond;
+  bool           run;           /**< Its turn, under lock_ */
+  TaskFunction_t code;
+  void           *params;
+} thread_t;
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+static pthread_mutex_t lock_ = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t end_cond_ = PTHREAD_COND_INITIALIZER;
+static __thread thread_t *self_;
+
+static UBaseType_t nesting_;    /**< One core: one count for all tasks */
+static bool yield_pending_;
+static bool started_;
+static bool ended_;
+static bool tickless_ = true;
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+static thread_t *thread_of_(TaskHandle_t task)
+{
+  // pxTopOfStack, the first member of the TCB, points at the descriptor
+  return (thread_t *)**(StackType_t **)task;
+}
+
+static void hand_over_(thread_t *from, thread_t *to)
+{
+  pthread_mutex_lock(&lock_);
+  to->run = true;
+  pthread_cond_signal(&to->cond);
+  if (NULL != from)
+  {
+    from->run = false;
+    while (!from->run)
+    {
+      pthread_cond_wait(&from->cond, &lock_);
+    }
+  }
+  pthread_mutex_unlock(&lock_);
+}
+
+static void switch_(void)
+{
+  thread_t *to;
+
+  yield_pending_ = false;
+  vTaskSwitchContext();
+  to = thread_of_(xTaskGetCurrentTaskHandle());
+  if (to != self_)
+  {
+    hand_over_(self_, to);
+  }
+}
+
+static void *thread_entry_(void *arg)
+{
+  thread_t *thread = arg;
+
+  self_ = thread;
+  pthread_mutex_lock(&lock_);
+  while (!thread->run)
+  {
+    pthread_cond_wait(&thread->cond, &lock_);
+  }
+  pthread_mutex_unlock(&lock_);
+
+  thread->code(thread->params);
+
+  // task functions never return on the target either
+  vTaskDelete(NULL);
+  return NULL;
+}
+
+/********************** external functions definition ************************/
+
+StackType_t *pxPortInitialiseStack(StackType_t *pxTopOfStack, TaskFunction_t pxCode, void *pvParameters)
+{
+  thread_t *thread = calloc(1, sizeof(*thread));
+  pthread_attr_t attr;
+  int status;
+
+  configASSERT(NULL != thread);
+  thread->code = pxCode;
+  thread->params = pvParameters;
+  pthread_cond_init(&thread->cond, NULL);
+
+  pthread_attr_init(&attr);
+  pthread_attr_setstacksize(&attr, THREAD_STACK_SIZE_);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+  status = pthread_create(&thread->id, &attr, thread_entry_, thread);
+  configASSERT(0 == status);
+  pthread_attr_destroy(&attr);
+
+  *pxTopOfStack = (StackType_t)thread;
+  return pxTopOfStack;
+}
+
+BaseType_t xPortStartScheduler(void)
+{
+  nesting_ = 0U;
+  started_ = true;
+  hand_over_(NULL, thread_of_(xTaskGetCurrentTaskHandle()));
+
+  pthread_mutex_lock(&lock_);
+  while (!ended_)
+  {
+    pthread_cond_wait(&end_cond_, &lock_);
+  }
+  pthread_mutex_unlock(&lock_);
+  return pdFALSE;
+}
+
+void vPortEndScheduler(void)
+{
+  pthread_mutex_lock(&lock_);
+  ended_ = true;
+  pthread_cond_signal(&end_cond_);
+  // the task ending the scheduler never runs again, like every other one
+  while (NULL != self_)
+  {
+    pthread_cond_wait(&self_->cond, &lock_);
+  }
+  pthread_mutex_unlock(&lock_);
+}
+
+void vPortYield(void)
+{
+  if (!started_ || ended_)
+  {
+    return;
+  }
+  if (0U != nesting_)
+  {
+    // taken when the critical section ends, like a pended PendSV
+    yield_pending_ = true;
+    return;
+  }
+  switch_();
+}
+
+void vPortEnterCritical(void)
+{
+  nesting_++;
+}
+
+void vPortExitCritical(void)
+{
+  configASSERT(0U != nesting_);
+  nesting_--;
+  if ((0U == nesting_) && yield_pending_)
+  {
+    vPortYield();
+  }
+}
+
+UBaseType_t uxPortSetInterruptMask(void)
+{
+  vPortEnterCritical();
+  return 0U;
+}
+
+void vPortClearInterruptMask(UBaseType_t uxMask)
+{
+  (void)uxMask;
+  vPortExitCritical();
+}
+
+void vPortIdleTick(void)
+{
+  vPortEnterCritical();
+  if (pdFALSE != xTaskIncrementTick())
+  {
+    yield_pending_ = true;
+  }
+  vPortExitCritical();
+}
+
+void vPortSuppressTicksAndSleep(TickType_t xExpectedIdleTime)
+{
+  if (tickless_)
+  {
+    // called with the scheduler suspended, nothing runs in between
+    vTaskStepTick(xExpectedIdleTime - 1U);
+  }
+}
+
+void vPortSetTickless(BaseType_t xTickless)
+{
+  tickless_ = (pdFALSE != xTickless);
+}
+
+/********************** end of file ******************************************/
@@ -0,0 +1,114 @@
+/**
+ * @file portmacro.h
+ * @brief FreeRTOS port for the host simulation: one POSIX thread per task
+ *
+ * Every task runs on a thread of its own, but only the thread of the task
+ * FreeRTOS has selected is ever allowed to run: the others wait on their
+ * condition variable. A context switch hands the turn from one thread to
+ * the next, so the kernel and the application see a single core, as on the
+ * target, and need no locking of their own.
+ *
+ * There are no interrupts: masking them is a nesting count, and a yield
+ * requested inside a critical section is taken when it ends, as PendSV is
+ * on the Cortex-M. The tick is virtual and jumps over the idle time, see
+ * port.c.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+#ifndef PORTMACRO_H
+#define PORTMACRO_H
+
+/********************** CPP guard ********************************************/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/********************** inclusions *******************************************/
+#include <stdint.h>
+
+/********************** macros ***********************************************/
+#define portCHAR                char
+#define portFLOAT               float
+#define portDOUBLE              double
+#define portLONG                long
+#define portSHORT               short
+#define portSTACK_TYPE          uintptr_t
+#define portBASE_TYPE           long
+#define portPOINTER_SIZE_TYPE   uintptr_t
+
+#define portMAX_DELAY           ((TickType_t)0xffffffffUL)
+#define portTICK_TYPE_IS_ATOMIC 1
+
+#define portSTACK_GROWTH        (-1)
+#define portTICK_PERIOD_MS      ((TickType_t)1000 / configTICK_RATE_HZ)
+#define portBYTE_ALIGNMENT      8
+
+#define portYIELD()                             vPortYield()
+#define portEND_SWITCHING_ISR(xSwitchRequired)  if ((xSwitchRequired) != pdFALSE) portYIELD()
+#define portYIELD_FROM_ISR(x)                   portEND_SWITCHING_ISR(x)
+
+#define portSET_INTERRUPT_MASK_FROM_ISR()       uxPortSetInterruptMask()
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR(x)    vPortClearInterruptMask(x)
+#define portDISABLE_INTERRUPTS()
+#define portENABLE_INTERRUPTS()
+#define portENTER_CRITICAL()                    vPortEnterCritical()
+#define portEXIT_CRITICAL()                     vPortExitCritical()
+
+#define portTASK_FUNCTION_PROTO(vFunction, pvParameters) void vFunction(void *pvParameters)
+#define portTASK_FUNCTION(vFunction, pvParameters)       void vFunction(void *pvParameters)
+
+#define portSUPPRESS_TICKS_AND_SLEEP(xExpectedIdleTime) vPortSuppressTicksAndSleep(xExpectedIdleTime)
+
+#define portNOP()
+#define portINLINE              __inline
+#define portFORCE_INLINE        inline __attribute__((always_inline))
+#define portMEMORY_BARRIER()    __asm volatile("" ::: "memory")
+
+/********************** typedef **********************************************/
+typedef portSTACK_TYPE StackType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+
+/********************** external functions declaration ***********************/
+void vPortYield(void);
+void vPortEnterCritical(void);
+void vPortExitCritical(void);
+UBaseType_t uxPortSetInterruptMask(void);
+void vPortClearInterruptMask(UBaseType_t uxMask);
+
+/**
+ * @brief Advances the virtual clock by one tick. Called by the idle task
+ *        only, when no other task can run.
+ */
+void vPortIdleTick(void);
+
+/**
+ * @brief Skips the virtual clock to the tick before the next task unblocks,
+ *        the idle task taking that one. Called by the kernel from the idle
+ *        task when configUSE_TICKLESS_IDLE is set.
+ */
+void vPortSuppressTicksAndSleep(TickType_t xExpectedIdleTime);
+
+/**
+ * @brief Whether the idle task skips the ticks nothing happens at, the
+ *        default, or counts every one of them.
+ */
+void vPortSetTickless(BaseType_t xTickless);
+
+static inline BaseType_t xPortIsInsideInterrupt(void)
+{
+  return 0;
+}
+
+/********************** End of CPP guard *************************************/
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PORTMACRO_H */
+/********************** end of file ******************************************/
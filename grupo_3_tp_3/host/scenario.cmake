@@ -0,0 +1,35 @@
+# Runs one scenario, jumping over the idle time and counting every tick,
+# and checks both runs against each other and against the expected files.
+#
+#   cmake -DSIM=<sim> -DSCRIPT=<script> -DEXPECTED=<prefix> -DOUT=<prefix> -P scenario.cmake
+#
+# <prefix>.trace and <prefix>.report are compared when they exist.
+
+foreach(mode jump step)
+  if(mode STREQUAL "step")
+    set(flags -s)
+  else()
+    set(flags)
+  endif()
+  execute_process(COMMAND ${SIM} ${flags} -t ${OUT}.${mode}.trace -r ${OUT}.${mode}.report ${SCRIPT}
+    RESULT_VARIABLE status
+    OUTPUT_QUIET)
+  if(NOT status EQUAL 0)
+    message(FATAL_ERROR "sim ${flags} failed: ${status}")
+  endif()
+endforeach()
+
+foreach(kind trace report)
+  execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files ${OUT}.jump.${kind} ${OUT}.step.${kind}
+    RESULT_VARIABLE differ)
+  if(NOT differ EQUAL 0)
+    message(FATAL_ERROR "${OUT}.jump.${kind} differs from ${OUT}.step.${kind}")
+  endif()
+  if(EXISTS ${EXPECTED}.${kind})
+    execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files ${OUT}.jump.${kind} ${EXPECTED}.${kind}
+      RESULT_VARIABLE differ)
+    if(NOT differ EQUAL 0)
+      message(FATAL_ERROR "${OUT}.jump.${kind} differs from ${EXPECTED}.${kind}")
+    endif()
+  endif()
+endforeach()
@@ -0,0 +1,288 @@
+/**
+ * @file eth_loopback.c
+ * @brief Host bridge from the wire of eth_pcap.c to loopback UDP sockets
+ *
+ * The frames sent are seen in the eth_pcap.c hook, in the sending task. ARP
+ * replies are queued for task_bridge, which puts them on the wire: below
+ * the application tasks, it never runs inside a send.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+/********************** inclusions *******************************************/
+#include <string.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "main.h"
+#include "cmsis_os.h"
+
+#include "eth_loopback.h"
+#include "eth_pcap.h"
+#include "udp.h"
+
+/********************** macros and definitions *******************************/
+#define TASK_BRIDGE_PRIORITY_   (tskIDLE_PRIORITY + 1)
+#define TASK_BRIDGE_STACK_      (256)
+#define REPLIES_                (4U)
+
+#define MAC_SIZE_               (6U)
+#define ETH_HEADER_             (14U)
+#define ETH_FRAME_MIN_          (60U)
+#define IP_HEADER_MIN_          (20U)
+#define UDP_HEADER_             (8U)
+#define ARP_PACKET_             (28U)
+
+#define ETHERTYPE_IP_           (0x0800U)
+#define ETHERTYPE_ARP_          (0x0806U)
+#define IP_FRAGMENT_MASK_       (0x3FFFU)
+#define IP_PROTO_UDP_           (17U)
+#define ARP_REQUEST_            (1U)
+#define ARP_REPLY_              (2U)
+
+#define SUBNET_BROADCAST_       ((UDP_CONFIG_ADDRESS & UDP_CONFIG_NETMASK) | ~UDP_CONFIG_NETMASK)
+
+/********************** internal data declaration ****************************/
+typedef struct
+{
+  uint8_t frame[ETH_FRAME_MIN_];
+} reply_t;
+
+typedef struct
+{
+  uint16_t port;
+  uint16_t loopback_port;
+} map_t;
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+static const uint8_t peer_mac_[MAC_SIZE_] = { 0x02U, 0x00U, 0x00U, 0x00U, 0x00U, 0x02U };
+
+static struct
+{
+  int                  sock;
+  uint32_t             peer_ip;
+  map_t                map[ETH_LOOPBACK_MAPS];
+  uint32_t             maps;
+  QueueHandle_t        hreplies;
+  eth_loopback_stats_t stats;
+} bridge_;
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+static uint16_t be16_(const uint8_t *p)
+{
+  return (uint16_t)(((uint16_t)p[0] << 8) | p[1]);
+}
+
+static uint32_t be32_(const uint8_t *p)
+{
+  return ((uint32_t)be16_(p) << 16) | be16_(&p[2]);
+}
+
+static void put_be16_(uint8_t *p, uint16_t value)
+{
+  p[0] = (uint8_t)(value >> 8);
+  p[1] = (uint8_t)value;
+}
+
+static uint16_t checksum_(const uint8_t *p, uint32_t len, uint32_t sum)
+{
+  for (uint32_t i = 0; i < len; i++)
+  {
+    sum += (0U == (i & 1U)) ? ((uint32_t)p[i] << 8) : p[i];
+  }
+  while (0U != (sum >> 16))
+  {
+    sum = (sum & 0xFFFFU) + (sum >> 16);
+  }
+  return (uint16_t)sum;
+}
+
+static void count_(uint32_t *counter)
+{
+  taskENTER_CRITICAL();
+  (*counter)++;
+  taskEXIT_CRITICAL();
+}
+
+static uint16_t loopback_port_(uint16_t port)
+{
+  for (uint32_t i = 0; i < bridge_.maps; i++)
+  {
+    if (port == bridge_.map[i].port)
+    {
+      return bridge_.map[i].loopback_port;
+    }
+  }
+  return port;
+}
+
+static void arp_(const uint8_t *frame, uint32_t len)
+{
+  const uint8_t *arp = &frame[ETH_HEADER_];
+  reply_t reply;
+  uint8_t *out = &reply.frame[ETH_HEADER_];
+
+  if ((len < (ETH_HEADER_ + ARP_PACKET_)) || (ARP_REQUEST_ != be16_(&arp[6]))
+      || (bridge_.peer_ip != be32_(&arp[24])))
+  {
+    count_(&bridge_.stats.ignored);
+    return;
+  }
+
+  memset(&reply, 0, sizeof(reply));
+  memcpy(&reply.frame[0], &arp[8], MAC_SIZE_);
+  memcpy(&reply.frame[6], peer_mac_, MAC_SIZE_);
+  put_be16_(&reply.frame[12], ETHERTYPE_ARP_);
+  memcpy(out, arp, 6U);
+  put_be16_(&out[6], ARP_REPLY_);
+  memcpy(&out[8], peer_mac_, MAC_SIZE_);
+  memcpy(&out[14], &arp[24], 4U);
+  memcpy(&out[18], &arp[8], MAC_SIZE_ + 4U);
+
+  if (pdTRUE == xQueueSend(bridge_.hreplies, &reply, 0))
+  {
+    count_(&bridge_.stats.arp_replies);
+  }
+}
+
+static void udp_(const uint8_t *frame, uint32_t len)
+{
+  const uint8_t *ip = &frame[ETH_HEADER_];
+  const uint8_t *udp;
+  uint32_t hlen = (uint32_t)(ip[0] & 0x0FU) * 4U;
+  uint32_t total;
+  uint32_t udp_len;
+  uint32_t dst;
+  struct sockaddr_in to;
+
+  if ((len < (ETH_HEADER_ + IP_HEADER_MIN_)) || (4U != (ip[0] >> 4)) || (hlen < IP_HEADER_MIN_)
+      || (IP_PROTO_UDP_ != ip[9]) || (0U != (be16_(&ip[6]) & IP_FRAGMENT_MASK_)))
+  {
+    count_(&bridge_.stats.ignored);
+    return;
+  }
+  dst = be32_(&ip[16]);
+  if ((dst != bridge_.peer_ip) && (dst != UDP_BROADCAST) && (dst != SUBNET_BROADCAST_))
+  {
+    count_(&bridge_.stats.ignored);
+    return;
+  }
+
+  // as the peer's NIC: the checksums the MAC inserted must hold
+  total = be16_(&ip[2]);
+  udp = &ip[hlen];
+  udp_len = (((ETH_HEADER_ + total) <= len) && ((hlen + UDP_HEADER_) <= total)) ? be16_(&udp[4]) : 0U;
+  if ((udp_len < UDP_HEADER_) || ((hlen + udp_len) > total)
+      || (0xFFFFU != checksum_(ip, hlen, 0U)) || (0U == be16_(&udp[6]))
+      || (0xFFFFU != checksum_(udp, udp_len, checksum_(&ip[12], 8U, IP_PROTO_UDP_ + udp_len))))
+  {
+    count_(&bridge_.stats.bad_checksum);
+    return;
+  }
+
+  memset(&to, 0, sizeof(to));
+  to.sin_family = AF_INET;
+  to.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  to.sin_port = htons(loopback_port_(be16_(&udp[2])));
+  if (0 <= sendto(bridge_.sock, &udp[UDP_HEADER_], udp_len - UDP_HEADER_, 0,
+                  (const struct sockaddr *)&to, sizeof(to)))
+  {
+    count_(&bridge_.stats.forwarded);
+  }
+}
+
+static void hook_(const uint8_t *frame, uint32_t len, void *arg)
+{
+  (void)arg;
+
+  if (len < ETH_HEADER_)
+  {
+    count_(&bridge_.stats.ignored);
+  }
+  else if (ETHERTYPE_ARP_ == be16_(&frame[12]))
+  {
+    arp_(frame, len);
+  }
+  else if (ETHERTYPE_IP_ == be16_(&frame[12]))
+  {
+    udp_(frame, len);
+  }
+  else
+  {
+    count_(&bridge_.stats.ignored);
+  }
+}
+
+static void task_bridge_(void *argument)
+{
+  reply_t reply;
+
+  while (true)
+  {
+    if (pdTRUE == xQueueReceive(bridge_.hreplies, &reply, portMAX_DELAY))
+    {
+      (void)eth_pcap_receive(reply.frame, sizeof(reply.frame));
+    }
+  }
+}
+
+/********************** external functions definition ************************/
+
+bool eth_loopback_init(uint32_t peer_ip)
+{
+  BaseType_t status;
+
+  bridge_.sock = socket(AF_INET, SOCK_DGRAM, 0);
+  if (0 > bridge_.sock)
+  {
+    return false;
+  }
+  bridge_.peer_ip = peer_ip;
+
+  bridge_.hreplies = xQueueCreate(REPLIES_, sizeof(reply_t));
+  configASSERT(NULL != bridge_.hreplies);
+
+  status = xTaskCreate
+		  (
+			  task_bridge_,
+			  "task_bridge",
+			  TASK_BRIDGE_STACK_,
+			  NULL,
+			  TASK_BRIDGE_PRIORITY_,
+			  NULL
+		  );
+  configASSERT(pdPASS == status);
+
+  eth_pcap_set_tx_hook(hook_, NULL);
+  return true;
+}
+
+bool eth_loopback_map(uint16_t port, uint16_t loopback_port)
+{
+  if (bridge_.maps >= ETH_LOOPBACK_MAPS)
+  {
+    return false;
+  }
+  bridge_.map[bridge_.maps].port = port;
+  bridge_.map[bridge_.maps].loopback_port = loopback_port;
+  bridge_.maps++;
+  return true;
+}
+
+void eth_loopback_get_stats(eth_loopback_stats_t *stats)
+{
+  taskENTER_CRITICAL();
+  *stats = bridge_.stats;
+  taskEXIT_CRITICAL();
+}
+
+/********************** end of file ******************************************/
@@ -0,0 +1,769 @@
+/**
+ * @file eth_pcap.c
+ * @brief Host stand-in for the ETH MAC, its DMA and the PHY, over pcap files
+ *
+ * The receive ring follows HAL_ETH_ReadData() and ETH_UpdateDescriptor():
+ * the DMA owns a descriptor with a buffer until it writes a piece of a frame
+ * in it; reading links the pieces for the driver user, then the descriptors
+ * read are refilled, oldest first, and given back to the DMA, stopping at
+ * the first buffer the user has not got. Stopping the MAC only drops what
+ * arrives: the descriptors keep their buffers and the frames not read.
+ *
+ * The transmit ring holds the packets sent, oldest first, and how many
+ * descriptors each takes; HAL_ETH_ReleaseTxPacket() frees the completed
+ * ones in order.
+ *
+ * Only one task runs at a time on the host port, and none is preempted but
+ * by a kernel call, so the critical sections stand for the interrupts and
+ * the DMA, and keep them apart from the driver as on target.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+/********************** inclusions *******************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "main.h"
+#include "cmsis_os.h"
+
+#include "eth_pcap.h"
+#include "sim.h"
+
+/********************** macros and definitions *******************************/
+#define TASK_WIRE_PRIORITY_     (configMAX_PRIORITIES - 1)
+#define TASK_WIRE_STACK_        (256)
+
+#define PCAP_MAGIC_             (0xA1B2C3D4U)
+#define PCAP_MAGIC_SWAPPED_     (0xD4C3B2A1U)
+#define PCAP_VERSION_MAJOR_     (2U)
+#define PCAP_VERSION_MINOR_     (4U)
+#define PCAP_SNAPLEN_           (65535U)
+#define PCAP_LINKTYPE_ETHERNET_ (1U)
+
+#define ETH_HEADER_             (14U)
+#define ETH_FRAME_MIN_          (60U)     /**< Without the FCS, padded up to */
+#define ETH_TX_FRAME_MAX_       (1524U)   /**< Gathered from the buffers */
+#define ETHERTYPE_IPV4_         (0x0800U)
+#define IPV4_HEADER_MIN_        (20U)
+#define IPV4_FRAGMENT_          (0x3FFFU) /**< More fragments and offset */
+#define IP_PROTO_ICMP_          (1U)
+#define IP_PROTO_TCP_           (6U)
+#define IP_PROTO_UDP_           (17U)
+
+#define PHY_BSR_                (1U)
+#define PHY_BSR_LINK_           (1U << 2)
+#define PHY_BSR_AUTONEG_DONE_   (1U << 5)
+#define PHY_SCSR_               (31U)
+#define PHY_SCSR_100_FULL_      (6U << 2)
+
+/********************** internal data declaration ****************************/
+typedef struct
+{
+  uint32_t magic;
+  uint16_t version_major;
+  uint16_t version_minor;
+  int32_t  thiszone;
+  uint32_t sigfigs;
+  uint32_t snaplen;
+  uint32_t network;
+} pcap_header_t;
+
+typedef struct
+{
+  uint32_t ts_sec;
+  uint32_t ts_usec;
+  uint32_t incl_len;
+  uint32_t orig_len;
+} pcap_record_t;
+
+typedef struct
+{
+  uint8_t  *buff;
+  uint16_t len;
+  bool     own;     /**< Owned by the DMA */
+  bool     first;
+  bool     last;
+} rx_desc_t;
+
+typedef struct
+{
+  void     *data;   /**< pData of the packet, given back on release */
+  uint32_t descs;
+} tx_packet_t;
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+static uint8_t mac_addr_[6] = { 0x00U, 0x80U, 0xE1U, 0x00U, 0x00U, 0x00U };
+
+static struct
+{
+  bool                 started;
+  bool                 link;
+  ETH_MACConfigTypeDef mac;
+  struct
+  {
+    rx_desc_t desc[ETH_RX_DESC_CNT];
+    uint32_t  dma_idx;     /**< Next the DMA writes */
+    uint32_t  idx;         /**< Next to read */
+    uint32_t  build_idx;   /**< Next to refill */
+    uint32_t  build_cnt;   /**< Read and not refilled */
+    void      *start;      /**< Frame being linked */
+    void      *end;
+  } rx;
+  struct
+  {
+    tx_packet_t packet[ETH_TX_DESC_CNT];
+    uint32_t    head;      /**< Oldest */
+    uint32_t    count;
+    uint32_t    done;      /**< Completed, from the oldest */
+    uint32_t    descs;     /**< In use */
+    bool        hold;
+    uint8_t     frame[ETH_TX_FRAME_MAX_];
+  } tx;
+  FILE                 *record;
+  bool                 playing;
+  eth_pcap_tx_hook_t   hook;
+  void                 *hook_arg;
+  eth_pcap_stats_t     stats;
+} eth_;
+
+static struct
+{
+  FILE    *in;
+  bool    swapped;
+  uint8_t frame[PCAP_SNAPLEN_];
+} play_;
+
+/********************** external data definition *****************************/
+ETH_HandleTypeDef heth;
+ETH_TxPacketConfig TxConfig;
+
+/********************** internal functions definition ************************/
+
+static uint16_t be16_(const uint8_t *p)
+{
+  return (uint16_t)(((uint16_t)p[0] << 8) | p[1]);
+}
+
+static void put_be16_(uint8_t *p, uint16_t value)
+{
+  p[0] = (uint8_t)(value >> 8);
+  p[1] = (uint8_t)value;
+}
+
+static uint32_t sum_(const uint8_t *p, uint32_t len, uint32_t sum)
+{
+  for (uint32_t i = 0; (i + 1U) < len; i += 2U)
+  {
+    sum += be16_(&p[i]);
+  }
+  if (0U != (len & 1U))
+  {
+    sum += (uint32_t)p[len - 1U] << 8;
+  }
+  return sum;
+}
+
+static uint16_t fold_(uint32_t sum)
+{
+  while (0U != (sum >> 16))
+  {
+    sum = (sum & 0xFFFFU) + (sum >> 16);
+  }
+  return (uint16_t)sum;
+}
+
+/* Offset of a well formed IPv4 packet in the frame, with the header and
+   payload lengths; 0 if there is none */
+static uint32_t ipv4_(const uint8_t *frame, uint32_t len, uint32_t *hlen, uint32_t *plen)
+{
+  const uint8_t *ip = &frame[ETH_HEADER_];
+  uint32_t total;
+
+  if ((len < (ETH_HEADER_ + IPV4_HEADER_MIN_)) || (ETHERTYPE_IPV4_ != be16_(&frame[12])))
+  {
+    return 0U;
+  }
+  *hlen = (uint32_t)(ip[0] & 0x0FU) * 4U;
+  total = be16_(&ip[2]);
+  if ((4U != (ip[0] >> 4)) || (*hlen < IPV4_HEADER_MIN_) || (total < *hlen)
+      || ((ETH_HEADER_ + total) > len))
+  {
+    return 0U;
+  }
+  *plen = total - *hlen;
+  return ETH_HEADER_;
+}
+
+/* Offset of the checksum in the payload, 0 if the MAC does not handle the
+   protocol or the payload is too short */
+static uint32_t l4_checksum_at_(uint8_t proto, uint32_t plen, bool *pseudo)
+{
+  *pseudo = true;
+  if ((IP_PROTO_UDP_ == proto) && (plen >= 8U))
+  {
+    return 6U;
+  }
+  if ((IP_PROTO_TCP_ == proto) && (plen >= 20U))
+  {
+    return 16U;
+  }
+  *pseudo = false;
+  if ((IP_PROTO_ICMP_ == proto) && (plen >= 4U))
+  {
+    return 2U;
+  }
+  return 0U;
+}
+
+static uint32_t l4_sum_(const uint8_t *ip, uint32_t hlen, uint32_t plen, bool pseudo)
+{
+  uint32_t sum = 0U;
+
+  if (pseudo)
+  {
+    sum = sum_(&ip[12], 8U, (uint32_t)ip[9] + plen);
+  }
+  return sum_(&ip[hlen], plen, sum);
+}
+
+static void insert_checksums_(uint8_t *frame, uint32_t len)
+{
+  uint32_t hlen;
+  uint32_t plen;
+  uint32_t at = ipv4_(frame, len, &hlen, &plen);
+  uint8_t *ip = &frame[at];
+  bool pseudo;
+  uint16_t check;
+
+  if (0U == at)
+  {
+    return;
+  }
+  put_be16_(&ip[10], 0U);
+  put_be16_(&ip[10], (uint16_t)~fold_(sum_(ip, hlen, 0U)));
+
+  // fragments only get their header checksum
+  at = l4_checksum_at_(ip[9], plen, &pseudo);
+  if ((0U != (be16_(&ip[6]) & IPV4_FRAGMENT_)) || (0U == at))
+  {
+    return;
+  }
+  put_be16_(&ip[hlen + at], 0U);
+  check = (uint16_t)~fold_(l4_sum_(ip, hlen, plen, pseudo));
+  if ((IP_PROTO_UDP_ == ip[9]) && (0U == check))
+  {
+    check = 0xFFFFU;
+  }
+  put_be16_(&ip[hlen + at], check);
+}
+
+static bool checksums_ok_(const uint8_t *frame, uint32_t len)
+{
+  uint32_t hlen;
+  uint32_t plen;
+  uint32_t at = ipv4_(frame, len, &hlen, &plen);
+  const uint8_t *ip = &frame[at];
+  bool pseudo;
+
+  if (0U == at)
+  {
+    return true;
+  }
+  if (0xFFFFU != fold_(sum_(ip, hlen, 0U)))
+  {
+    return false;
+  }
+  at = l4_checksum_at_(ip[9], plen, &pseudo);
+  if ((0U != (be16_(&ip[6]) & IPV4_FRAGMENT_)) || (0U == at))
+  {
+    return true;
+  }
+  // no UDP checksum was computed
+  if ((IP_PROTO_UDP_ == ip[9]) && (0U == be16_(&ip[hlen + at])))
+  {
+    return true;
+  }
+  return (0xFFFFU == fold_(l4_sum_(ip, hlen, plen, pseudo)));
+}
+
+/* ETH_UpdateDescriptor() */
+static void rx_refill_(void)
+{
+  while (0U < eth_.rx.build_cnt)
+  {
+    rx_desc_t *desc = &eth_.rx.desc[eth_.rx.build_idx];
+
+    if (NULL == desc->buff)
+    {
+      HAL_ETH_RxAllocateCallback(&desc->buff);
+      if (NULL == desc->buff)
+      {
+        break;
+      }
+    }
+
+    taskENTER_CRITICAL();
+    desc->len = 0U;
+    desc->first = false;
+    desc->last = false;
+    desc->own = true;
+    taskEXIT_CRITICAL();
+
+    eth_.rx.build_idx = (eth_.rx.build_idx + 1U) % ETH_RX_DESC_CNT;
+    eth_.rx.build_cnt--;
+  }
+}
+
+static void tx_complete_(void)
+{
+  taskENTER_CRITICAL();
+  if (eth_.tx.done != eth_.tx.count)
+  {
+    eth_.tx.done = eth_.tx.count;
+    HAL_ETH_TxCpltCallback(&heth);
+  }
+  taskEXIT_CRITICAL();
+}
+
+static void record_(const uint8_t *frame, uint32_t len)
+{
+  uint32_t now = sim_now_us();
+  pcap_record_t record =
+  {
+    .ts_sec = now / 1000000U,
+    .ts_usec = now % 1000000U,
+    .incl_len = len,
+    .orig_len = len,
+  };
+
+  if (NULL != eth_.record)
+  {
+    (void)fwrite(&record, sizeof(record), 1U, eth_.record);
+    (void)fwrite(frame, 1U, len, eth_.record);
+  }
+}
+
+static uint32_t play_u32_(uint32_t value)
+{
+  return play_.swapped ? __builtin_bswap32(value) : value;
+}
+
+static void task_wire_(void *argument)
+{
+  TickType_t start = xTaskGetTickCount();
+  TickType_t wake = start;
+  uint64_t first_us = 0U;
+  bool first = true;
+  pcap_record_t record;
+
+  while (1U == fread(&record, sizeof(record), 1U, play_.in))
+  {
+    uint32_t len = play_u32_(record.incl_len);
+    uint64_t at_us = ((uint64_t)play_u32_(record.ts_sec) * 1000000U) + play_u32_(record.ts_usec);
+    TickType_t at;
+
+    if ((len > sizeof(play_.frame)) || (len != fread(play_.frame, 1U, len, play_.in)))
+    {
+      break;
+    }
+    if (first)
+    {
+      first_us = at_us;
+      first = false;
+    }
+    // does not block for a frame already due
+    at = start + pdMS_TO_TICKS((at_us - first_us) / 1000U);
+    if (at != wake)
+    {
+      vTaskDelayUntil(&wake, at - wake);
+    }
+    (void)eth_pcap_receive(play_.frame, len);
+  }
+
+  fclose(play_.in);
+  play_.in = NULL;
+  eth_.playing = false;
+  vTaskDelete(NULL);
+}
+
+/********************** external functions definition ************************/
+
+void MX_ETH_Init(void)
+{
+  heth.Instance = NULL;
+  heth.Init.MACAddr = mac_addr_;
+  heth.Init.RxBuffLen = ETH_RX_BUF_SIZE;
+
+  memset(&TxConfig, 0, sizeof(ETH_TxPacketConfig));
+  TxConfig.Attributes = ETH_TX_PACKETS_FEATURES_CSUM | ETH_TX_PACKETS_FEATURES_CRCPAD;
+  TxConfig.ChecksumCtrl = ETH_CHECKSUM_IPHDR_PAYLOAD_INSERT_PHDR_CALC;
+  TxConfig.CRCPadCtrl = ETH_CRC_PAD_INSERT;
+
+  // no descriptor has a buffer yet
+  eth_.rx.build_cnt = ETH_RX_DESC_CNT;
+}
+
+void eth_pcap_set_link(bool up)
+{
+  taskENTER_CRITICAL();
+  eth_.link = up;
+  taskEXIT_CRITICAL();
+}
+
+bool eth_pcap_receive(const uint8_t *frame, uint32_t len)
+{
+  uint32_t pieces = (len + ETH_RX_BUF_SIZE - 1U) / ETH_RX_BUF_SIZE;
+  bool ok = true;
+
+  taskENTER_CRITICAL();
+  if (!eth_.started || (len < ETH_HEADER_) || (len > ETH_PCAP_FRAME_MAX))
+  {
+    eth_.stats.rx_dropped++;
+    ok = false;
+  }
+  else if (!checksums_ok_(frame, len))
+  {
+    eth_.stats.rx_bad_checksum++;
+    ok = false;
+  }
+  else
+  {
+    for (uint32_t i = 0; i < pieces; i++)
+    {
+      ok = ok && eth_.rx.desc[(eth_.rx.dma_idx + i) % ETH_RX_DESC_CNT].own;
+    }
+    if (!ok)
+    {
+      // receive buffer unavailable
+      eth_.stats.rx_dropped++;
+      HAL_ETH_ErrorCallback(&heth);
+    }
+  }
+
+  for (uint32_t i = 0; ok && (i < pieces); i++)
+  {
+    rx_desc_t *desc = &eth_.rx.desc[eth_.rx.dma_idx];
+    uint32_t offset = i * ETH_RX_BUF_SIZE;
+    uint32_t n = ((len - offset) < ETH_RX_BUF_SIZE) ? (len - offset) : ETH_RX_BUF_SIZE;
+
+    memcpy(desc->buff, &frame[offset], n);
+    desc->len = (uint16_t)n;
+    desc->first = (0U == i);
+    desc->last = ((pieces - 1U) == i);
+    desc->own = false;
+    eth_.rx.dma_idx = (eth_.rx.dma_idx + 1U) % ETH_RX_DESC_CNT;
+  }
+  if (ok)
+  {
+    eth_.stats.rx_frames++;
+    HAL_ETH_RxCpltCallback(&heth);
+  }
+  taskEXIT_CRITICAL();
+
+  return ok;
+}
+
+bool eth_pcap_play(const char *path)
+{
+  pcap_header_t header;
+  BaseType_t status;
+
+  configASSERT(!eth_.playing);
+  play_.in = fopen(path, "rb");
+  if (NULL == play_.in)
+  {
+    return false;
+  }
+  play_.swapped = false;
+  if ((1U != fread(&header, sizeof(header), 1U, play_.in))
+      || ((PCAP_MAGIC_ != header.magic) && (PCAP_MAGIC_SWAPPED_ != header.magic)))
+  {
+    fclose(play_.in);
+    return false;
+  }
+  play_.swapped = (PCAP_MAGIC_SWAPPED_ == header.magic);
+  if (PCAP_LINKTYPE_ETHERNET_ != play_u32_(header.network))
+  {
+    fclose(play_.in);
+    return false;
+  }
+
+  eth_.playing = true;
+  status = xTaskCreate
+		  (
+			  task_wire_,
+			  "task_wire",
+			  TASK_WIRE_STACK_,
+			  NULL,
+			  TASK_WIRE_PRIORITY_,
+			  NULL
+		  );
+  configASSERT(pdPASS == status);
+  return true;
+}
+
+bool eth_pcap_record(const char *path)
+{
+  pcap_header_t header =
+  {
+    .magic = PCAP_MAGIC_,
+    .version_major = PCAP_VERSION_MAJOR_,
+    .version_minor = PCAP_VERSION_MINOR_,
+    .thiszone = 0,
+    .sigfigs = 0U,
+    .snaplen = PCAP_SNAPLEN_,
+    .network = PCAP_LINKTYPE_ETHERNET_,
+  };
+
+  if (NULL != eth_.record)
+  {
+    fclose(eth_.record);
+    eth_.record = NULL;
+  }
+  if (NULL == path)
+  {
+    return true;
+  }
+
+  eth_.record = fopen(path, "wb");
+  if ((NULL == eth_.record) || (1U != fwrite(&header, sizeof(header), 1U, eth_.record)))
+  {
+    return false;
+  }
+  return true;
+}
+
+void eth_pcap_set_tx_hook(eth_pcap_tx_hook_t hook, void *arg)
+{
+  taskENTER_CRITICAL();
+  eth_.hook = hook;
+  eth_.hook_arg = arg;
+  taskEXIT_CRITICAL();
+}
+
+void eth_pcap_hold_tx(bool hold)
+{
+  eth_.tx.hold = hold;
+  if (!hold)
+  {
+    tx_complete_();
+  }
+}
+
+void eth_pcap_get_stats(eth_pcap_stats_t *stats)
+{
+  taskENTER_CRITICAL();
+  *stats = eth_.stats;
+  taskEXIT_CRITICAL();
+}
+
+HAL_StatusTypeDef HAL_ETH_Start_IT(ETH_HandleTypeDef *handle)
+{
+  (void)handle;
+  rx_refill_();
+  taskENTER_CRITICAL();
+  eth_.started = true;
+  taskEXIT_CRITICAL();
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ETH_Stop_IT(ETH_HandleTypeDef *handle)
+{
+  (void)handle;
+  taskENTER_CRITICAL();
+  eth_.started = false;
+  taskEXIT_CRITICAL();
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ETH_ReadData(ETH_HandleTypeDef *handle, void **pAppBuff)
+{
+  uint32_t idx = eth_.rx.idx;
+  uint32_t count = 0U;
+  uint32_t max = ETH_RX_DESC_CNT - eth_.rx.build_cnt;
+  bool ready = false;
+
+  (void)handle;
+  if (!eth_.started)
+  {
+    return HAL_ERROR;
+  }
+
+  while ((count < max) && !ready)
+  {
+    rx_desc_t *desc = &eth_.rx.desc[idx];
+    bool own;
+
+    taskENTER_CRITICAL();
+    own = desc->own;
+    taskEXIT_CRITICAL();
+    if (own)
+    {
+      break;
+    }
+
+    if (desc->first || (NULL != eth_.rx.start))
+    {
+      ready = desc->last;
+      HAL_ETH_RxLinkCallback(&eth_.rx.start, &eth_.rx.end, desc->buff, desc->len);
+      desc->buff = NULL;
+    }
+    idx = (idx + 1U) % ETH_RX_DESC_CNT;
+    count++;
+  }
+
+  eth_.rx.build_cnt += count;
+  eth_.rx.idx = idx;
+  rx_refill_();
+
+  if (!ready)
+  {
+    return HAL_ERROR;
+  }
+  *pAppBuff = eth_.rx.start;
+  eth_.rx.start = NULL;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ETH_Transmit_IT(ETH_HandleTypeDef *handle, ETH_TxPacketConfig *pTxConfig)
+{
+  uint8_t *frame = eth_.tx.frame;
+  uint32_t len = 0U;
+  uint32_t descs = 0U;
+  bool busy;
+
+  (void)handle;
+  if (!eth_.started)
+  {
+    return HAL_ERROR;
+  }
+
+  for (const ETH_BufferTypeDef *b = pTxConfig->TxBuffer; NULL != b; b = b->next)
+  {
+    configASSERT((len + b->len) <= ETH_TX_FRAME_MAX_);
+    memcpy(&frame[len], b->buffer, b->len);
+    len += b->len;
+    descs++;
+  }
+  configASSERT(len == pTxConfig->Length);
+
+  taskENTER_CRITICAL();
+  busy = ((ETH_TX_DESC_CNT - eth_.tx.descs) < descs);
+  if (!busy)
+  {
+    tx_packet_t *packet = &eth_.tx.packet[(eth_.tx.head + eth_.tx.count) % ETH_TX_DESC_CNT];
+
+    packet->data = pTxConfig->pData;
+    packet->descs = descs;
+    eth_.tx.count++;
+    eth_.tx.descs += descs;
+  }
+  taskEXIT_CRITICAL();
+  if (busy)
+  {
+    return HAL_ERROR;
+  }
+
+  if ((0U != (pTxConfig->Attributes & ETH_TX_PACKETS_FEATURES_CRCPAD))
+      && (ETH_CRC_PAD_INSERT == pTxConfig->CRCPadCtrl) && (len < ETH_FRAME_MIN_))
+  {
+    memset(&frame[len], 0, ETH_FRAME_MIN_ - len);
+    len = ETH_FRAME_MIN_;
+  }
+  if ((0U != (pTxConfig->Attributes & ETH_TX_PACKETS_FEATURES_CSUM))
+      && (ETH_CHECKSUM_IPHDR_PAYLOAD_INSERT_PHDR_CALC == pTxConfig->ChecksumCtrl))
+  {
+    insert_checksums_(frame, len);
+  }
+
+  record_(frame, len);
+  if (NULL != eth_.hook)
+  {
+    eth_.hook(frame, len, eth_.hook_arg);
+  }
+  taskENTER_CRITICAL();
+  eth_.stats.tx_frames++;
+  eth_.stats.tx_bytes += len;
+  taskEXIT_CRITICAL();
+
+  if (!eth_.tx.hold)
+  {
+    tx_complete_();
+  }
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ETH_ReleaseTxPacket(ETH_HandleTypeDef *handle)
+{
+  (void)handle;
+
+  while (true)
+  {
+    tx_packet_t packet;
+
+    taskENTER_CRITICAL();
+    if (0U == eth_.tx.done)
+    {
+      taskEXIT_CRITICAL();
+      break;
+    }
+    packet = eth_.tx.packet[eth_.tx.head];
+    eth_.tx.head = (eth_.tx.head + 1U) % ETH_TX_DESC_CNT;
+    eth_.tx.count--;
+    eth_.tx.done--;
+    eth_.tx.descs -= packet.descs;
+    taskEXIT_CRITICAL();
+
+    HAL_ETH_TxFreeCallback((uint32_t *)packet.data);
+  }
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ETH_ReadPHYRegister(ETH_HandleTypeDef *handle, uint32_t PHYAddr, uint32_t PHYReg,
+                                          uint32_t *pRegValue)
+{
+  (void)handle;
+  (void)PHYAddr;
+
+  switch (PHYReg)
+  {
+    case PHY_BSR_:
+      *pRegValue = eth_.link ? (PHY_BSR_LINK_ | PHY_BSR_AUTONEG_DONE_) : 0U;
+      break;
+    case PHY_SCSR_:
+      *pRegValue = eth_.link ? PHY_SCSR_100_FULL_ : 0U;
+      break;
+    default:
+      *pRegValue = 0U;
+      break;
+  }
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ETH_GetMACConfig(ETH_HandleTypeDef *handle, ETH_MACConfigTypeDef *macconf)
+{
+  (void)handle;
+  *macconf = eth_.mac;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ETH_SetMACConfig(ETH_HandleTypeDef *handle, ETH_MACConfigTypeDef *macconf)
+{
+  (void)handle;
+  eth_.mac = *macconf;
+  return HAL_OK;
+}
+
+/* The stand-in raises its interrupts itself */
+void HAL_ETH_IRQHandler(ETH_HandleTypeDef *handle)
+{
+  (void)handle;
+}
+
+/********************** end of file ******************************************/
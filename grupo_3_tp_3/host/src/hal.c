@@ -0,0 +1,155 @@
+/**
+ * @file hal.c
+ * @brief Host stand-in for the STM32F4 HAL: GPIO ports, TIM5, the DWT and NVIC
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+/********************** inclusions *******************************************/
+#include "main.h"
+#include "cmsis_os.h"
+
+#include "sim.h"
+
+/********************** macros and definitions *******************************/
+#define US_PER_TICK_            (1000000U / configTICK_RATE_HZ)
+#define LEDS_                   (sizeof(leds_) / sizeof(leds_[0]))
+
+/********************** internal data declaration ****************************/
+typedef struct
+{
+  GPIO_TypeDef *port;
+  uint16_t     pin;
+  const char   *name;
+} led_t;
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+static const led_t leds_[] =
+{
+  { LD1_GPIO_Port, LD1_Pin, "LD1" },
+  { LD2_GPIO_Port, LD2_Pin, "LD2" },
+  { LD3_GPIO_Port, LD3_Pin, "LD3" },
+};
+
+static TIM_TypeDef tim5_;
+static DWT_Type dwt_;
+
+static struct
+{
+  FILE     *out;
+  uint32_t count;
+} trace_;
+
+/********************** external data definition *****************************/
+GPIO_TypeDef hal_shim_gpio[HAL_SHIM_GPIO_PORTS];
+CoreDebug_Type hal_shim_core_debug;
+uint32_t SystemCoreClock = 180000000U;
+
+/********************** internal functions definition ************************/
+
+/********************** external functions definition ************************/
+
+uint32_t sim_now_us(void)
+{
+  return (uint32_t)xTaskGetTickCount() * US_PER_TICK_;
+}
+
+void sim_trace_open(FILE *out)
+{
+  trace_.out = out;
+}
+
+uint32_t sim_trace_count(void)
+{
+  return trace_.count;
+}
+
+void sim_gpio_write(GPIO_TypeDef *port, uint32_t bsrr, uint32_t at_us)
+{
+  uint32_t before = port->ODR;
+
+  // BSRR: a pin both set and reset is set
+  port->ODR = (before & ~(bsrr >> 16)) | (bsrr & 0xFFFFU);
+
+  for (uint32_t i = 0; i < LEDS_; i++)
+  {
+    uint32_t now = port->ODR & leds_[i].pin;
+
+    if ((leds_[i].port == port) && (now != (before & leds_[i].pin)))
+    {
+      trace_.count++;
+      if (NULL != trace_.out)
+      {
+        fprintf(trace_.out, "%lu %s %s\n", (unsigned long)at_us, leds_[i].name,
+                (0U != now) ? "on" : "off");
+      }
+    }
+  }
+}
+
+void sim_gpio_input(GPIO_TypeDef *port, uint16_t pin, bool level)
+{
+  if (level)
+  {
+    port->IDR |= pin;
+  }
+  else
+  {
+    port->IDR &= ~(uint32_t)pin;
+  }
+}
+
+TIM_TypeDef *hal_shim_tim5(void)
+{
+  tim5_.CNT = sim_now_us();
+  return &tim5_;
+}
+
+DWT_Type *hal_shim_dwt(void)
+{
+  dwt_.CYCCNT = (uint32_t)xTaskGetTickCount() * (SystemCoreClock / configTICK_RATE_HZ);
+  return &dwt_;
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+  return (0U != (GPIOx->IDR & GPIO_Pin)) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState)
+{
+  sim_gpio_write(GPIOx, (GPIO_PIN_RESET != PinState) ? GPIO_Pin : ((uint32_t)GPIO_Pin << 16),
+                 sim_now_us());
+}
+
+void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+  uint32_t on = GPIOx->ODR & GPIO_Pin;
+
+  sim_gpio_write(GPIOx, ((uint32_t)on << 16) | (~on & GPIO_Pin), sim_now_us());
+}
+
+uint32_t HAL_GetTick(void)
+{
+  return (uint32_t)xTaskGetTickCount();
+}
+
+/* The stand-ins raise their interrupts themselves, see eth_pcap.c */
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority)
+{
+  (void)IRQn;
+  (void)PreemptPriority;
+  (void)SubPriority;
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+  (void)IRQn;
+}
+
+/********************** end of file ******************************************/
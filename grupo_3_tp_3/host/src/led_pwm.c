@@ -0,0 +1,190 @@
+/**
+ * @file led_pwm.c
+ * @brief Host stand-in for the LED PWM brightness and fades, on software timers
+ *
+ * The trace only has pin levels, so a LED is on whenever its level is above
+ * 0: from the start of a fade up, until the end of a fade down. A fade ends
+ * when a one-shot timer of its length expires, as the DMA transfer does on
+ * the target, and the level reached so far moves linearly in between.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+/********************** inclusions *******************************************/
+#include "main.h"
+#include "cmsis_os.h"
+#include "timers.h"
+
+#include "sim.h"
+#include "led_pwm.h"
+
+/********************** macros and definitions *******************************/
+
+/********************** internal data declaration ****************************/
+typedef struct
+{
+  uint16_t          pin;
+  uint8_t           from;
+  uint8_t           target;
+  TickType_t        start;
+  TickType_t        ticks;
+  bool              fading;
+  TimerHandle_t     htimer;
+  SemaphoreHandle_t hdone;
+} led_t;
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+static led_t leds_[LED_PWM__N] =
+{
+  [LED_PWM_LD1] = { .pin = LD1_Pin },
+  [LED_PWM_LD2] = { .pin = LD2_Pin },
+  [LED_PWM_LD3] = { .pin = LD3_Pin },
+};
+
+static bool enabled_;
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+static void output_(led_t *l, uint8_t level)
+{
+  sim_gpio_write(GPIOB, (0U != level) ? l->pin : ((uint32_t)l->pin << 16), sim_now_us());
+}
+
+static void stop_(led_t *l)
+{
+  (void)xTimerStop(l->htimer, 0);
+  l->fading = false;
+}
+
+static void timer_cb_(TimerHandle_t htimer)
+{
+  led_t *l = pvTimerGetTimerID(htimer);
+
+  taskENTER_CRITICAL();
+  if (l->fading)
+  {
+    l->fading = false;
+    output_(l, l->target);
+    xSemaphoreGive(l->hdone);
+  }
+  taskEXIT_CRITICAL();
+}
+
+/********************** external functions definition ************************/
+
+void led_pwm_init(void)
+{
+#if 1 == LED_PWM_CONFIG_ENABLE
+  for (uint32_t i = 0; i < LED_PWM__N; i++)
+  {
+    leds_[i].hdone = xSemaphoreCreateBinary();
+    configASSERT(NULL != leds_[i].hdone);
+    leds_[i].htimer = xTimerCreate("led_pwm", 1, pdFALSE, &leds_[i], timer_cb_);
+    configASSERT(NULL != leds_[i].htimer);
+  }
+#endif
+}
+
+void led_pwm_enable(bool enable)
+{
+  if (!enable)
+  {
+    for (uint32_t i = 0; i < LED_PWM__N; i++)
+    {
+      led_pwm_set((led_pwm_led_t)i, 0U);
+    }
+  }
+  enabled_ = enable;
+}
+
+bool led_pwm_enabled(void)
+{
+  return enabled_;
+}
+
+void led_pwm_set(led_pwm_led_t led, uint8_t level)
+{
+  led_t *l = &leds_[led];
+
+  taskENTER_CRITICAL();
+  if (l->fading)
+  {
+    stop_(l);
+    xSemaphoreGive(l->hdone);
+  }
+  l->from = level;
+  l->target = level;
+  output_(l, level);
+  taskEXIT_CRITICAL();
+}
+
+void led_pwm_fade(led_pwm_led_t led, uint8_t level, uint32_t duration_ms)
+{
+  led_t *l = &leds_[led];
+  TickType_t ticks = (TickType_t)(duration_ms / portTICK_PERIOD_MS);
+
+  if (0U == ticks)
+  {
+    led_pwm_set(led, level);
+    return;
+  }
+
+  taskENTER_CRITICAL();
+  l->from = led_pwm_get(led);
+  stop_(l);
+  taskEXIT_CRITICAL();
+  // drop the completion of the fade just replaced
+  (void)xSemaphoreTake(l->hdone, 0);
+
+  taskENTER_CRITICAL();
+  l->target = level;
+  l->start = xTaskGetTickCount();
+  l->ticks = ticks;
+  l->fading = true;
+  if (0U != level)
+  {
+    output_(l, level);
+  }
+  (void)xTimerChangePeriod(l->htimer, ticks, 0);
+  taskEXIT_CRITICAL();
+}
+
+bool led_pwm_wait(led_pwm_led_t led, TickType_t timeout)
+{
+  return (pdTRUE == xSemaphoreTake(leds_[led].hdone, timeout));
+}
+
+uint8_t led_pwm_get(led_pwm_led_t led)
+{
+  const led_t *l = &leds_[led];
+  int32_t elapsed;
+
+  if (!l->fading)
+  {
+    return l->target;
+  }
+  elapsed = (int32_t)(xTaskGetTickCount() - l->start);
+  elapsed = ((int32_t)l->ticks < elapsed) ? (int32_t)l->ticks : elapsed;
+  return (uint8_t)(l->from + ((((int32_t)l->target - (int32_t)l->from) * elapsed) / (int32_t)l->ticks));
+}
+
+void led_pwm_stream0_irq_handler(void)
+{
+}
+
+void led_pwm_stream2_irq_handler(void)
+{
+}
+
+void led_pwm_stream6_irq_handler(void)
+{
+}
+
+/********************** end of file ******************************************/
@@ -0,0 +1,214 @@
+/**
+ * @file led_wave.c
+ * @brief Host stand-in for the LED waveform engine, on a software timer
+ *
+ * Builds the same BSRR words as app/src/led_wave.c and plays them at the
+ * same times: word k at start + k * step, the first one right away, and
+ * after the last repetition of a finite pattern the word turning its LEDs
+ * off. A one-shot timer expires at the tick of the next word due; each word
+ * goes to the trace with the exact time it is due, which for steps shorter
+ * than a tick falls between ticks.
+ *
+ * The timer task runs above the AO tasks, as the DMA interrupt does on the
+ * target.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+/********************** inclusions *******************************************/
+#include "main.h"
+#include "cmsis_os.h"
+#include "timers.h"
+
+#include "sim.h"
+#include "led_wave.h"
+
+/********************** macros and definitions *******************************/
+#define LEDS_MASK_              (LD1_Pin | LD2_Pin | LD3_Pin)
+#define US_PER_TICK_            (1000000U / configTICK_RATE_HZ)
+
+/********************** internal data declaration ****************************/
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+static uint32_t buffer_[LED_WAVE_CONFIG_MAX_STEPS + 1U];
+
+static struct
+{
+  uint32_t          mask;        /**< LEDs of the pattern playing */
+  uint32_t          length;
+  uint32_t          repeat;      /**< Times played, 0 forever */
+  uint32_t          step_us;
+  uint32_t          start_us;
+  uint64_t          next;        /**< Index of the next word due, from the start */
+  bool              playing;
+  TimerHandle_t     htimer;
+  SemaphoreHandle_t hdone;
+} wave_;
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+static uint32_t build_(const led_wave_pattern_t *pattern)
+{
+  uint32_t mask = 0U;
+
+  for (uint32_t c = 0; c < pattern->channels; c++)
+  {
+    mask |= pattern->channel[c].pin;
+  }
+
+  for (uint32_t s = 0; s < pattern->length; s++)
+  {
+    uint32_t word = 0U;
+
+    for (uint32_t c = 0; c < pattern->channels; c++)
+    {
+      const led_wave_channel_t *ch = &pattern->channel[c];
+      bool on = false;
+
+      if (0U != ch->period)
+      {
+        on = (((s + ch->period - (ch->phase % ch->period)) % ch->period) < ch->on);
+      }
+      // BSRR: low half sets, high half resets
+      word |= on ? ch->pin : ((uint32_t)ch->pin << 16);
+    }
+    buffer_[s] = word;
+  }
+  buffer_[pattern->length] = mask << 16;
+  return mask;
+}
+
+static uint32_t due_us_(uint64_t k)
+{
+  return wave_.start_us + (uint32_t)(k * wave_.step_us);
+}
+
+/* Writes the words due by now, then waits for the next one. */
+static void play_due_(void)
+{
+  uint64_t total = (uint64_t)wave_.length * wave_.repeat;
+  uint32_t now = sim_now_us();
+  uint32_t wait_us;
+
+  while (wave_.playing && ((int32_t)(now - due_us_(wave_.next)) >= 0))
+  {
+    if ((0U != wave_.repeat) && (total == wave_.next))
+    {
+      sim_gpio_write(GPIOB, buffer_[wave_.length], due_us_(wave_.next));
+      wave_.playing = false;
+      xSemaphoreGive(wave_.hdone);
+      return;
+    }
+    sim_gpio_write(GPIOB, buffer_[wave_.next % wave_.length], due_us_(wave_.next));
+    wave_.next++;
+  }
+
+  wait_us = due_us_(wave_.next) - now;
+  (void)xTimerChangePeriod(wave_.htimer, (TickType_t)((wait_us + US_PER_TICK_ - 1U) / US_PER_TICK_), 0);
+}
+
+static void timer_cb_(TimerHandle_t htimer)
+{
+  (void)htimer;
+  play_due_();
+}
+
+static void stop_(void)
+{
+  (void)xTimerStop(wave_.htimer, 0);
+  sim_gpio_write(GPIOB, wave_.mask << 16, sim_now_us());
+  if (wave_.playing)
+  {
+    wave_.playing = false;
+    xSemaphoreGive(wave_.hdone);
+  }
+}
+
+/********************** external functions definition ************************/
+
+void led_wave_init(void)
+{
+#if 1 == LED_WAVE_CONFIG_ENABLE
+  wave_.hdone = xSemaphoreCreateBinary();
+  configASSERT(NULL != wave_.hdone);
+  wave_.htimer = xTimerCreate("led_wave", 1, pdFALSE, NULL, timer_cb_);
+  configASSERT(NULL != wave_.htimer);
+#endif
+}
+
+bool led_wave_valid(const led_wave_pattern_t *pattern)
+{
+  if ((LED_WAVE_STEP_MIN_US > pattern->step_us) || (LED_WAVE_STEP_MAX_US < pattern->step_us)
+      || (0U == pattern->length) || (LED_WAVE_CONFIG_MAX_STEPS < pattern->length)
+      || (LED_WAVE_MAX_CHANNELS < pattern->channels))
+  {
+    return false;
+  }
+  for (uint32_t c = 0; c < pattern->channels; c++)
+  {
+    const led_wave_channel_t *ch = &pattern->channel[c];
+
+    if ((0U == ch->pin) || (0U != (ch->pin & ~LEDS_MASK_)) || (ch->on > ch->period))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool led_wave_play(const led_wave_pattern_t *pattern)
+{
+  if (!led_wave_valid(pattern))
+  {
+    return false;
+  }
+
+  taskENTER_CRITICAL();
+  stop_();
+  taskEXIT_CRITICAL();
+  // drop the completion of the pattern just replaced
+  (void)xSemaphoreTake(wave_.hdone, 0);
+
+  wave_.mask = build_(pattern);
+  wave_.length = pattern->length;
+  wave_.repeat = pattern->repeat;
+  wave_.step_us = pattern->step_us;
+  wave_.start_us = sim_now_us();
+  wave_.next = 0U;
+  wave_.playing = true;
+
+  taskENTER_CRITICAL();
+  play_due_();
+  taskEXIT_CRITICAL();
+  return true;
+}
+
+void led_wave_stop(void)
+{
+  taskENTER_CRITICAL();
+  stop_();
+  taskEXIT_CRITICAL();
+}
+
+bool led_wave_wait(TickType_t timeout)
+{
+  return (pdTRUE == xSemaphoreTake(wave_.hdone, timeout));
+}
+
+uint64_t led_wave_duration_us(const led_wave_pattern_t *pattern)
+{
+  return (uint64_t)pattern->step_us * pattern->length * pattern->repeat;
+}
+
+void led_wave_dma_irq_handler(void)
+{
+}
+
+/********************** end of file ******************************************/
@@ -0,0 +1,467 @@
+/**
+ * @file main.c
+ * @brief Host simulation: runs app_init() on the POSIX port against a script
+ *
+ * Usage: sim [-t trace] [-r report] [-j journal] [-s] <script>
+ *
+ *   -t  writes the LED changes, see sim.h
+ *   -r  writes the report of the run, see report.h, stdout by default
+ *   -j  writes the journal left at the end, a journal dump as below
+ *   -s  counts every tick instead of jumping over the idle time, to check
+ *       both give the same run
+ *
+ * The script drives the user button, one command per line, '#' starting a
+ * comment, times in milliseconds from the start and in increasing order:
+ *
+ *     press <at_ms> <length_ms>        holds the button down that long
+ *     traffic <from_ms> <to_ms> <seed> presses of random lengths, 50 ms to
+ *                                      3 s, and gaps, 50 ms to 5 s, until
+ *                                      to_ms; the same seed, the same ones
+ *     replay <at_ms> <file>            replays a journal dump, see journal.h
+ *     end <at_ms>                      stops the run
+ *
+ * A journal dump is a stream of journal_record_t, oldest first, as the
+ * records of REMOTE_CMD_READ_JOURNAL responses: the target is little endian
+ * and packs them as the host does. Its path is relative to the script. The
+ * replay runs in journal.c's own task, the button and remote records
+ * injected into the AOs with their recorded spacing, from at_ms on.
+ *
+ * The log goes to stdout. A stimulus task above every application task
+ * drives the pin, so a press lands exactly on its tick.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+/********************** inclusions *******************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "main.h"
+#include "cmsis_os.h"
+#include "board.h"
+
+#include "app.h"
+#include "journal.h"
+#include "monoclock.h"
+#include "sim.h"
+#include "report.h"
+
+/********************** macros and definitions *******************************/
+#define MAX_COMMANDS_           (1024U)
+#define MAX_REPLAYS_            (4U)
+#define LINE_LEN_               (128U)
+#define PATH_LEN_               (256U)
+#define STIMULUS_PRIORITY_      (configMAX_PRIORITIES - 1)
+#define STIMULUS_STACK_         (256)
+
+#define TRAFFIC_PRESS_MIN_MS_   (50U)
+#define TRAFFIC_PRESS_MAX_MS_   (3000U)
+#define TRAFFIC_GAP_MIN_MS_     (50U)
+#define TRAFFIC_GAP_MAX_MS_     (5000U)
+
+/********************** internal data declaration ****************************/
+typedef enum
+{
+  COMMAND_PRESS,
+  COMMAND_TRAFFIC,
+  COMMAND_REPLAY,
+  COMMAND_END,
+} command_type_t;
+
+typedef struct
+{
+  command_type_t type;
+  uint32_t       at_ms;
+  uint32_t       arg;        /**< Press length, traffic end or replay */
+  uint32_t       seed;
+} command_t;
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+static struct
+{
+  command_t commands[MAX_COMMANDS_];
+  uint32_t  count;
+  uint32_t  free_ms;         /**< When the button is released for good */
+} script_;
+
+static struct
+{
+  journal_record_t records[JOURNAL_CONFIG_RECORDS];
+  uint32_t         count;
+} replays_[MAX_REPLAYS_];
+
+static uint32_t replay_count_;
+
+static struct
+{
+  TickType_t last_wake;
+  uint32_t   at_ms;
+  uint32_t   presses;
+  uint32_t   random;
+} stimulus_;
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+static bool add_(command_type_t type, uint32_t at_ms, uint32_t arg, uint32_t seed)
+{
+  if ((MAX_COMMANDS_ <= script_.count) || (script_.free_ms > at_ms)
+      || ((0U != script_.count) && (COMMAND_END == script_.commands[script_.count - 1U].type)))
+  {
+    return false;
+  }
+  script_.commands[script_.count].type = type;
+  script_.commands[script_.count].at_ms = at_ms;
+  script_.commands[script_.count].arg = arg;
+  script_.commands[script_.count].seed = seed;
+  script_.count++;
+  script_.free_ms = (COMMAND_PRESS == type) ? (at_ms + arg) : ((COMMAND_TRAFFIC == type) ? arg : at_ms);
+  return true;
+}
+
+static bool load_journal_(const char *script, const char *name)
+{
+  const char *slash = strrchr(script, '/');
+  char path[2U * PATH_LEN_];
+  FILE *in;
+  long size = 0;
+  bool ok;
+
+  if (MAX_REPLAYS_ <= replay_count_)
+  {
+    return false;
+  }
+  if (('/' == name[0]) || (NULL == slash))
+  {
+    (void)snprintf(path, sizeof(path), "%s", name);
+  }
+  else
+  {
+    (void)snprintf(path, sizeof(path), "%.*s/%s", (int)(slash - script), script, name);
+  }
+
+  in = fopen(path, "rb");
+  if (NULL == in)
+  {
+    fprintf(stderr, "%s: cannot open\n", path);
+    return false;
+  }
+  // whole records, and no more than the journal holds
+  ok = (0 == fseek(in, 0, SEEK_END)) && (0 < (size = ftell(in)))
+       && (0 == (size % (long)sizeof(journal_record_t)))
+       && ((long)(JOURNAL_CONFIG_RECORDS * sizeof(journal_record_t)) >= size) && (0 == fseek(in, 0, SEEK_SET));
+  if (ok)
+  {
+    replays_[replay_count_].count = (uint32_t)(size / (long)sizeof(journal_record_t));
+    ok = (replays_[replay_count_].count
+          == fread(replays_[replay_count_].records, sizeof(journal_record_t), replays_[replay_count_].count, in));
+  }
+  fclose(in);
+  if (!ok)
+  {
+    fprintf(stderr, "%s: not a journal dump\n", path);
+    return false;
+  }
+  replay_count_++;
+  return true;
+}
+
+static bool dump_journal_(const char *path)
+{
+  FILE *out = fopen(path, "wb");
+  journal_record_t records[JOURNAL_CONFIG_RECORDS];
+  uint32_t first;
+  uint32_t count;
+
+  if (NULL == out)
+  {
+    fprintf(stderr, "%s: cannot create\n", path);
+    return false;
+  }
+  count = journal_read(0U, records, JOURNAL_CONFIG_RECORDS, &first);
+  (void)fwrite(records, sizeof(journal_record_t), count, out);
+  fclose(out);
+  return true;
+}
+
+static bool load_(const char *path)
+{
+  FILE *in = fopen(path, "r");
+  char line[LINE_LEN_];
+  uint32_t number = 0U;
+  bool ok = (NULL != in);
+
+  if (NULL == in)
+  {
+    fprintf(stderr, "%s: cannot open\n", path);
+    return false;
+  }
+
+  while (ok && (NULL != fgets(line, sizeof(line), in)))
+  {
+    unsigned long a;
+    unsigned long b;
+    unsigned long c;
+    char word[2];
+    char name[PATH_LEN_];
+    char *comment = strchr(line, '#');
+
+    number++;
+    if (NULL != comment)
+    {
+      *comment = '\0';
+    }
+    if (2 == sscanf(line, " press %lu %lu", &a, &b))
+    {
+      ok = (0UL != b) && add_(COMMAND_PRESS, (uint32_t)a, (uint32_t)b, 0U);
+    }
+    else if (3 == sscanf(line, " traffic %lu %lu %lu", &a, &b, &c))
+    {
+      ok = (a < b) && add_(COMMAND_TRAFFIC, (uint32_t)a, (uint32_t)b, (uint32_t)c);
+    }
+    else if (2 == sscanf(line, " replay %lu %255s", &a, name))
+    {
+      ok = load_journal_(path, name) && add_(COMMAND_REPLAY, (uint32_t)a, replay_count_ - 1U, 0U);
+    }
+    else if (1 == sscanf(line, " end %lu", &a))
+    {
+      ok = add_(COMMAND_END, (uint32_t)a, 0U, 0U);
+    }
+    else
+    {
+      // blank
+      ok = (1 != sscanf(line, " %1s", word));
+    }
+    if (!ok)
+    {
+      fprintf(stderr, "%s:%lu: bad command\n", path, (unsigned long)number);
+    }
+  }
+  fclose(in);
+
+  if (ok && ((0U == script_.count) || (COMMAND_END != script_.commands[script_.count - 1U].type)))
+  {
+    fprintf(stderr, "%s: no end\n", path);
+    ok = false;
+  }
+  return ok;
+}
+
+/* xorshift32: the same sequence on every host */
+static uint32_t random_(uint32_t min, uint32_t max)
+{
+  uint32_t x = stimulus_.random;
+
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  stimulus_.random = x;
+  return min + (x % (max - min));
+}
+
+static void wait_until_(uint32_t at_ms)
+{
+  TickType_t ticks = (TickType_t)((at_ms - stimulus_.at_ms) / portTICK_PERIOD_MS);
+
+  if (0U != ticks)
+  {
+    vTaskDelayUntil(&stimulus_.last_wake, ticks);
+  }
+  stimulus_.at_ms = at_ms;
+}
+
+static void press_(uint32_t at_ms, uint32_t length_ms)
+{
+  wait_until_(at_ms);
+  sim_gpio_input(BUTTON_PORT, BUTTON_PIN, (BUTTON_PRESSED == GPIO_PIN_SET));
+  stimulus_.presses++;
+  wait_until_(at_ms + length_ms);
+  sim_gpio_input(BUTTON_PORT, BUTTON_PIN, (BUTTON_HOVER == GPIO_PIN_SET));
+  // the sends of the previous press are in the journal by now
+  report_journal();
+}
+
+static void traffic_(uint32_t from_ms, uint32_t to_ms, uint32_t seed)
+{
+  uint32_t at = from_ms;
+
+  stimulus_.random = (0U != seed) ? seed : 1U;
+  while (true)
+  {
+    uint32_t length = random_(TRAFFIC_PRESS_MIN_MS_, TRAFFIC_PRESS_MAX_MS_);
+
+    if (at + length > to_ms)
+    {
+      break;
+    }
+    press_(at, length);
+    at += length + random_(TRAFFIC_GAP_MIN_MS_, TRAFFIC_GAP_MAX_MS_);
+  }
+}
+
+static void task_stimulus_(void *argument)
+{
+  (void)argument;
+  stimulus_.last_wake = xTaskGetTickCount();
+
+  for (uint32_t i = 0; i < script_.count; i++)
+  {
+    const command_t *cmd = &script_.commands[i];
+
+    switch (cmd->type)
+    {
+      case COMMAND_PRESS:
+        press_(cmd->at_ms, cmd->arg);
+        break;
+
+      case COMMAND_TRAFFIC:
+        traffic_(cmd->at_ms, cmd->arg, cmd->seed);
+        break;
+
+      case COMMAND_REPLAY:
+      {
+        bool started;
+
+        wait_until_(cmd->at_ms);
+        started = journal_replay_records(replays_[cmd->arg].records, replays_[cmd->arg].count);
+        // a script error, e.g. a replay before the previous one ended
+        configASSERT(started);
+        break;
+      }
+
+      case COMMAND_END:
+      default:
+        wait_until_(cmd->at_ms);
+        break;
+    }
+  }
+
+  report_journal();
+  vTaskEndScheduler();
+}
+
+static const char *name_(const char *path)
+{
+  const char *slash = strrchr(path, '/');
+
+  return (NULL != slash) ? (slash + 1) : path;
+}
+
+/********************** external functions definition ************************/
+
+int main(int argc, char *argv[])
+{
+  FILE *trace = NULL;
+  FILE *report = stdout;
+  const char *journal = NULL;
+  BaseType_t status;
+  int opt;
+
+  while (-1 != (opt = getopt(argc, argv, "t:r:j:s")))
+  {
+    switch (opt)
+    {
+      case 't':
+        trace = fopen(optarg, "w");
+        if (NULL == trace)
+        {
+          fprintf(stderr, "%s: cannot create\n", optarg);
+          return EXIT_FAILURE;
+        }
+        break;
+
+      case 'r':
+        report = fopen(optarg, "w");
+        if (NULL == report)
+        {
+          fprintf(stderr, "%s: cannot create\n", optarg);
+          return EXIT_FAILURE;
+        }
+        break;
+
+      case 'j':
+        journal = optarg;
+        break;
+
+      case 's':
+        vPortSetTickless(pdFALSE);
+        break;
+
+      default:
+        fprintf(stderr, "usage: %s [-t trace] [-r report] [-j journal] [-s] <script>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+  }
+  if ((optind + 1 != argc) || !load_(argv[optind]))
+  {
+    if (optind + 1 != argc)
+    {
+      fprintf(stderr, "usage: %s [-t trace] [-r report] [-j journal] [-s] <script>\n", argv[0]);
+    }
+    return EXIT_FAILURE;
+  }
+
+  sim_trace_open(trace);
+  sim_gpio_input(BUTTON_PORT, BUTTON_PIN, (BUTTON_HOVER == GPIO_PIN_SET));
+
+  app_init();
+
+  status = xTaskCreate(task_stimulus_, "task_stimulus", STIMULUS_STACK_, NULL, STIMULUS_PRIORITY_, NULL);
+  configASSERT(pdPASS == status);
+
+  vTaskStartScheduler();
+
+  fflush(stdout);
+  report_write(report, name_(argv[optind]), stimulus_.presses);
+  if ((NULL != journal) && !dump_journal_(journal))
+  {
+    return EXIT_FAILURE;
+  }
+  if (NULL != trace)
+  {
+    fclose(trace);
+  }
+  if (stdout != report)
+  {
+    fclose(report);
+  }
+  return EXIT_SUCCESS;
+}
+
+void Error_Handler(void)
+{
+  fprintf(stderr, "Error_Handler at %lu us\n", (unsigned long)sim_now_us());
+  abort();
+}
+
+void vAssertCalled(const char *file, int line)
+{
+  fprintf(stderr, "%s:%d: assert failed at %lu us\n", file, line, (unsigned long)sim_now_us());
+  abort();
+}
+
+/* Run time stats share the monoclock timebase, virtual here */
+void configureTimerForRunTimeStats(void)
+{
+}
+
+unsigned long getRunTimeCounterValue(void)
+{
+  return now_us32();
+}
+
+/* Time passes here, when no task can run, see port.c */
+void vApplicationIdleHook(void)
+{
+  vPortIdleTick();
+}
+
+/********************** end of file ******************************************/
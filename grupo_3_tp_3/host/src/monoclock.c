@@ -0,0 +1,55 @@
+/**
+ * @file monoclock.c
+ * @brief Host stand-in for the unified monotonic clock, on the virtual tick
+ *
+ * Both counts follow the tick of the simulation, see port.c: the clock only
+ * advances while every task is blocked, one tick period at a time.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+/********************** inclusions *******************************************/
+#include "main.h"
+#include "cmsis_os.h"
+
+#include "monoclock.h"
+
+/********************** macros and definitions *******************************/
+#define US_PER_TICK_            (1000000U / configTICK_RATE_HZ)
+
+/********************** internal data declaration ****************************/
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+
+/********************** external data definition *****************************/
+TIM_HandleTypeDef htim5;
+
+/********************** internal functions definition ************************/
+
+/********************** external functions definition ************************/
+
+void monoclock_init(void)
+{
+  htim5.Instance = TIM5;
+}
+
+uint64_t now_us(void)
+{
+  return (uint64_t)xTaskGetTickCount() * US_PER_TICK_;
+}
+
+uint64_t now_cycles(void)
+{
+  return (uint64_t)xTaskGetTickCount() * (SystemCoreClock / configTICK_RATE_HZ);
+}
+
+void monoclock_irq_handler(void)
+{
+}
+
+/********************** end of file ******************************************/
@@ -0,0 +1,119 @@
+/**
+ * @file report.c
+ * @brief Host simulation: per-scenario report of queues, latencies and drops
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+/********************** inclusions *******************************************/
+#include "main.h"
+#include "cmsis_os.h"
+
+#include "ao_ui.h"
+#include "ao_led.h"
+#include "blockpool.h"
+#include "journal.h"
+#include "overload.h"
+#include "sim.h"
+#include "report.h"
+
+/********************** macros and definitions *******************************/
+#define BATCH_                  (16U)
+
+/********************** internal data declaration ****************************/
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+static const char *const buckets_[AO_LED_LATENCY_BUCKETS] =
+{
+  "<100us", "<1ms", "<10ms", "<100ms", "<1s", "<10s", ">=10s",
+};
+
+static struct
+{
+  uint32_t seq;                               /**< Next journal record */
+  uint32_t lost;                              /**< Overwritten before counted */
+  uint32_t sent[JOURNAL_QUEUE__N];
+  uint32_t dropped[JOURNAL_QUEUE__N];
+} journal_;
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+/********************** external functions definition ************************/
+
+void report_journal(void)
+{
+  journal_record_t records[BATCH_];
+  uint32_t first;
+  uint32_t count;
+
+  do
+  {
+    count = journal_read(journal_.seq, records, BATCH_, &first);
+    journal_.lost += first - journal_.seq;
+    for (uint32_t i = 0; i < count; i++)
+    {
+      if (JOURNAL_QUEUE__N > records[i].queue)
+      {
+        if (0U != records[i].accepted)
+        {
+          journal_.sent[records[i].queue]++;
+        }
+        else
+        {
+          journal_.dropped[records[i].queue]++;
+        }
+      }
+    }
+    journal_.seq = first + count;
+  } while (BATCH_ == count);
+}
+
+void report_write(FILE *out, const char *name, uint32_t presses)
+{
+  ao_led_stats_t led;
+  overload_stats_t overload;
+  blockpool_stats_t pool;
+
+  ao_led_get_stats(&ao_led, &led);
+  overload_get_stats(&overload);
+  blockpool_get_stats(&pool);
+
+  fprintf(out, "scenario %s\n", name);
+  fprintf(out, "virtual_ms %lu\n", (unsigned long)(sim_now_us() / 1000U));
+  fprintf(out, "presses %lu\n", (unsigned long)presses);
+  fprintf(out, "led_changes %lu\n", (unsigned long)sim_trace_count());
+
+  fprintf(out, "ui_sent %lu\n", (unsigned long)journal_.sent[JOURNAL_QUEUE_UI]);
+  fprintf(out, "ui_dropped %lu\n", (unsigned long)journal_.dropped[JOURNAL_QUEUE_UI]);
+  fprintf(out, "ui_queue_max %lu\n", (unsigned long)ao_ui.queue.count_max);
+
+  fprintf(out, "led_sent %lu\n", (unsigned long)journal_.sent[JOURNAL_QUEUE_LED]);
+  fprintf(out, "led_dropped %lu\n", (unsigned long)led.dropped);
+  fprintf(out, "led_queue_max %lu\n", (unsigned long)led.queue_max);
+  fprintf(out, "led_served %lu\n", (unsigned long)led.events);
+  fprintf(out, "latency_max_us %lu\n", (unsigned long)led.latency_max_us);
+  for (uint32_t b = 0; b < AO_LED_LATENCY_BUCKETS; b++)
+  {
+    fprintf(out, "latency%s %lu\n", buckets_[b], (unsigned long)led.latency[b]);
+  }
+
+  fprintf(out, "overload_shed_low %lu\n", (unsigned long)overload.dropped_low);
+  fprintf(out, "deadline_misses %lu\n", (unsigned long)overload.deadline_misses);
+  for (uint32_t l = OVERLOAD_LEVEL_DROP_LOW; l < OVERLOAD_LEVEL__N; l++)
+  {
+    fprintf(out, "overload_level%lu_entered %lu\n", (unsigned long)l, (unsigned long)overload.entered[l]);
+  }
+
+  fprintf(out, "pool_used_max %lu\n", (unsigned long)pool.used_max);
+  fprintf(out, "pool_exhausted %lu\n", (unsigned long)pool.exhausted);
+  fprintf(out, "journal_lost %lu\n", (unsigned long)journal_.lost);
+}
+
+/********************** end of file ******************************************/
@@ -0,0 +1,147 @@
+/**
+ * @file stubs.c
+ * @brief Host stand-ins for the modules app_init() starts but the simulation
+ *        has no hardware for
+ *
+ * The network, the serial link, the flash, the CRC and DMA units and the
+ * boot profiler are left out: nothing of the button to LED path goes
+ * through them. Their init does nothing, telemetry drops what it is given
+ * and the cyclic executive never runs, so task_button polls on its own as
+ * it does whenever the executive is off.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+/********************** inclusions *******************************************/
+#include "main.h"
+#include "cmsis_os.h"
+
+#include "boot.h"
+#include "crc.h"
+#include "cyclic.h"
+#include "deferred.h"
+#include "dmacopy.h"
+#include "fpu_bench.h"
+#include "hrtimer.h"
+#include "kvstore.h"
+#include "perf_bench.h"
+#include "remote.h"
+#include "telemetry.h"
+#include "uart_rx.h"
+#include "udp.h"
+#include "warmboot.h"
+
+/********************** macros and definitions *******************************/
+
+/********************** internal data declaration ****************************/
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+/********************** external functions definition ************************/
+
+void boot_mark(boot_phase_t phase)
+{
+  (void)phase;
+}
+
+void boot_background_init(void)
+{
+}
+
+void crc_init(void)
+{
+}
+
+void cyclic_init(void)
+{
+}
+
+bool cyclic_register(cyclic_job_t job, cyclic_job_fn_t fn, void *arg)
+{
+  (void)job;
+  (void)fn;
+  (void)arg;
+  return false;
+}
+
+bool cyclic_running(void)
+{
+  return false;
+}
+
+void deferred_init(void)
+{
+}
+
+void dmacopy_init(void)
+{
+}
+
+void fpu_bench_init(void)
+{
+}
+
+void hrtimer_service_init(void)
+{
+}
+
+void kvstore_init(void)
+{
+}
+
+void perf_bench_init(void)
+{
+}
+
+void remote_init(void)
+{
+}
+
+void telemetry_init(void)
+{
+}
+
+void telemetry_log(const char *text, size_t len)
+{
+  (void)text;
+  (void)len;
+}
+
+void telemetry_trace(uint32_t id, uint32_t arg0, uint32_t arg1)
+{
+  (void)id;
+  (void)arg0;
+  (void)arg1;
+}
+
+void uart_rx_init(void)
+{
+}
+
+void udp_init(void)
+{
+}
+
+void warmboot_init(void)
+{
+}
+
+bool warmboot_is_warm(void)
+{
+  return false;
+}
+
+void warmboot_restore(void)
+{
+}
+
+/********************** end of file ******************************************/
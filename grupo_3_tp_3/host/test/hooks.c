@@ -0,0 +1,64 @@
+/**
+ * @file hooks.c
+ * @brief Kernel hooks of the unit tests running the scheduler, the ones
+ *        main.c gives the sim
+ *
+ * Any failure aborts, so the test fails on it.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+/********************** inclusions *******************************************/
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "main.h"
+#include "cmsis_os.h"
+
+#include "sim.h"
+
+/********************** macros and definitions *******************************/
+
+/********************** internal data declaration ****************************/
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+/********************** external functions definition ************************/
+
+void Error_Handler(void)
+{
+  fprintf(stderr, "Error_Handler at %lu us\n", (unsigned long)sim_now_us());
+  abort();
+}
+
+void vAssertCalled(const char *file, int line)
+{
+  fprintf(stderr, "%s:%d: assert failed at %lu us\n", file, line, (unsigned long)sim_now_us());
+  abort();
+}
+
+void configureTimerForRunTimeStats(void)
+{
+}
+
+unsigned long getRunTimeCounterValue(void)
+{
+  return (unsigned long)sim_now_us();
+}
+
+/* Time passes here, when no task can run, see port.c */
+void vApplicationIdleHook(void)
+{
+  vPortIdleTick();
+}
+
+/********************** end of file ******************************************/
@@ -0,0 +1,121 @@
+/**
+ * @file test_crc.c
+ * @brief Host reference test of crc_sw.c against known vectors
+ *
+ * crc_sw.c is what crc.c falls back to and what the hardware results are
+ * checked against on target, so it is checked here against the published
+ * vectors: the CRC-32 check values of zlib, and the native CRC of the unit
+ * (CRC-32/MPEG-2 over each word, most significant byte first) as given in
+ * ST's application note for 0x12345678.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+/********************** inclusions *******************************************/
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "crc.h"
+
+/********************** macros and definitions *******************************/
+#define CHECK_(cond)  check_((cond), #cond, __LINE__)
+
+/********************** internal data declaration ****************************/
+typedef struct
+{
+  const char *text;
+  uint32_t    crc;
+} vector_t;
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+static const vector_t vectors_[] =
+{
+  {"",                                            0x00000000U},
+  {"a",                                           0xE8B7BE43U},
+  {"abc",                                         0x352441C2U},
+  {"123456789",                                   CRC32_CHECK},
+  {"The quick brown fox jumps over the lazy dog", 0x414FA339U},
+};
+
+static unsigned failed_;
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+static void check_(int cond, const char *what, int line)
+{
+  if (!cond)
+  {
+    failed_++;
+    fprintf(stderr, "test_crc.c:%d: %s\n", line, what);
+  }
+}
+
+static void update32_(void)
+{
+  for (size_t i = 0; i < (sizeof(vectors_) / sizeof(vectors_[0])); i++)
+  {
+    const vector_t *v = &vectors_[i];
+    size_t len = strlen(v->text);
+
+    CHECK_(v->crc == crc_update32_sw(0U, v->text, len));
+    // fed in two parts, at every split, gives the same
+    for (size_t split = 0; split <= len; split++)
+    {
+      uint32_t crc = crc_update32_sw(0U, v->text, split);
+
+      CHECK_(v->crc == crc_update32_sw(crc, v->text + split, len - split));
+    }
+  }
+}
+
+static void stm32_(void)
+{
+  const uint32_t one[] = {0x12345678U};
+  const uint32_t two[] = {0x31323334U, 0x35363738U};
+
+  CHECK_(0xFFFFFFFFU == crc_stm32_sw(one, 0U));
+  CHECK_(0xDF8A8A2BU == crc_stm32_sw(one, 1U));
+  CHECK_(0x49E3C2FBU == crc_stm32_sw(two, 2U));
+}
+
+static void reflect_(void)
+{
+  CHECK_(0x00000000U == crc_reflect32(0x00000000U));
+  CHECK_(0x80000000U == crc_reflect32(0x00000001U));
+  CHECK_(0x1E6A2C48U == crc_reflect32(0x12345678U));
+  CHECK_(0xEDB88320U == crc_reflect32(0x04C11DB7U));
+  CHECK_(0x80U == crc_reflect8(0x01U));
+  CHECK_(0x0FU == crc_reflect8(0xF0U));
+  CHECK_(0xA5U == crc_reflect8(0xA5U));
+  for (uint32_t i = 0; i < 256U; i++)
+  {
+    CHECK_(i == crc_reflect8(crc_reflect8((uint8_t)i)));
+  }
+}
+
+/********************** external functions definition ************************/
+
+int main(void)
+{
+  update32_();
+  stm32_();
+  reflect_();
+  if (0U != failed_)
+  {
+    fprintf(stderr, "%u checks failed\n", failed_);
+    return EXIT_FAILURE;
+  }
+  printf("crc_sw: all vectors match\n");
+  return EXIT_SUCCESS;
+}
+
+/********************** end of file ******************************************/
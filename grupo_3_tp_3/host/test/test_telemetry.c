@@ -0,0 +1,260 @@
+/**
+ * @file test_telemetry.c
+ * @brief Host test of the telemetry streams through udp.c, eth_frame.c and
+ *        the loopback bridge
+ *
+ * telemetry.c, udp.c and eth_frame.c run unchanged on the scheduler, over
+ * the pcap stand-in of the MAC bridged to this process's loopback sockets,
+ * see eth_loopback.h. The peer is a unicast address, so the first datagram
+ * waits for udp.c to resolve it over ARP.
+ *
+ * The test logs numbered lines and traces numbered records in bursts, and
+ * receives the datagrams on two loopback sockets: the log must come whole
+ * and in order, the trace in whole records, in order, their time never
+ * going back. Every datagram must have passed the bridge's checks of the
+ * IPv4 header and UDP checksums. Last, with the checksum offload turned
+ * off in TxConfig, the bridge must refuse what is sent.
+ *
+ * @authors
+ * - Marco Rolón Radcenco
+ * - Pablo Eduardo Gimenez
+ * - Iván Podoroska
+ */
+
+/********************** inclusions *******************************************/
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "main.h"
+#include "cmsis_os.h"
+
+#include "eth_frame.h"
+#include "eth_loopback.h"
+#include "eth_pcap.h"
+#include "telemetry.h"
+#include "udp.h"
+
+/********************** macros and definitions *******************************/
+#define CHECK_(cond)  check_((cond), #cond, __LINE__)
+
+#define TX_CAPTURE_             "telemetry.pcap"
+#define PEER_                   UDP_IP4(192, 168, 1, 2)
+
+#define TASK_TEST_PRIORITY_     (tskIDLE_PRIORITY + 2)
+#define TASK_TEST_STACK_        (256)
+
+#define LINES_                  (200U)
+#define RECORDS_                (300U)
+#define BURST_                  (20U)      /**< Lines or records between pauses */
+#define BURST_GAP_MS_           (5U)
+#define RECEIVE_MS_             (2000U)
+#define LOG_MAX_                (16384U)
+
+/********************** internal data declaration ****************************/
+
+/********************** internal functions declaration ***********************/
+
+/********************** internal data definition *****************************/
+static unsigned failed_;
+
+static struct
+{
+  int      log;                     /**< Sockets */
+  int      trace;
+  char     sent[LOG_MAX_];          /**< What the test logged */
+  uint32_t sent_len;
+  char     log_rx[LOG_MAX_];
+  uint32_t log_rx_len;
+  uint32_t records;                 /**< Received, in order */
+  uint32_t last_us;
+  uint32_t datagrams;
+  uint32_t wrong;
+} test_;
+
+/********************** external data definition *****************************/
+
+/********************** internal functions definition ************************/
+
+static void check_(int cond, const char *what, int line)
+{
+  if (!cond)
+  {
+    failed_++;
+    fprintf(stderr, "test_telemetry.c:%d: %s\n", line, what);
+  }
+}
+
+static int open_socket_(uint16_t *port)
+{
+  struct sockaddr_in addr;
+  socklen_t len = sizeof(addr);
+  int sock = socket(AF_INET, SOCK_DGRAM, 0);
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if ((0 > sock) || (0 != bind(sock, (struct sockaddr *)&addr, sizeof(addr)))
+      || (0 != getsockname(sock, (struct sockaddr *)&addr, &len)))
+  {
+    return -1;
+  }
+  *port = ntohs(addr.sin_port);
+  return sock;
+}
+
+/* Whatever the loopback sockets got so far */
+static void receive_(void)
+{
+  static uint8_t buffer[UDP_PAYLOAD_MAX];
+  ssize_t len;
+
+  while (0 < (len = recv(test_.log, buffer, sizeof(buffer), MSG_DONTWAIT)))
+  {
+    if ((test_.log_rx_len + (uint32_t)len) <= LOG_MAX_)
+    {
+      memcpy(&test_.log_rx[test_.log_rx_len], buffer, (size_t)len);
+    }
+    test_.log_rx_len += (uint32_t)len;
+    test_.datagrams++;
+  }
+
+  while (0 < (len = recv(test_.trace, buffer, sizeof(buffer), MSG_DONTWAIT)))
+  {
+    test_.datagrams++;
+    if (0U != ((uint32_t)len % sizeof(telemetry_record_t)))
+    {
+      test_.wrong++;
+      continue;
+    }
+    for (ssize_t at = 0; at < len; at += (ssize_t)sizeof(telemetry_record_t))
+    {
+      telemetry_record_t record;
+
+      memcpy(&record, &buffer[at], sizeof(record));
+      if ((TELEMETRY_TRACE_BUTTON != record.id) || (test_.records != record.arg0)
+          || ((3U * record.arg0) != record.arg1) || (record.time_us < test_.last_us))
+      {
+        test_.wrong++;
+      }
+      test_.last_us = record.time_us;
+      test_.records++;
+    }
+  }
+}
+
+static void wait_(uint32_t ms)
+{
+  for (uint32_t i = 0; i < ms; i++)
+  {
+    receive_();
+    vTaskDelay(pdMS_TO_TICKS(1));
+  }
+  receive_();
+}
+
+static void task_test_(void *argument)
+{
+  telemetry_stats_t telemetry;
+  eth_loopback_stats_t bridge;
+  udp_stats_t udp;
+
+  (void)argument;
+  wait_(100U);
+
+  for (uint32_t i = 0; i < LINES_; i++)
+  {
+    char line[32];
+    int len = snprintf(line, sizeof(line), "line %03lu of the log\n", (unsigned long)i);
+
+    telemetry_log(line, (size_t)len);
+    memcpy(&test_.sent[test_.sent_len], line, (size_t)len);
+    test_.sent_len += (uint32_t)len;
+    if ((BURST_ - 1U) == (i % BURST_))
+    {
+      wait_(BURST_GAP_MS_);
+    }
+  }
+  for (uint32_t i = 0; i < RECORDS_; i++)
+  {
+    telemetry_trace(TELEMETRY_TRACE_BUTTON, i, 3U * i);
+    if ((BURST_ - 1U) == (i % BURST_))
+    {
+      wait_(BURST_GAP_MS_);
+    }
+  }
+  wait_(RECEIVE_MS_);
+
+  telemetry_get_stats(&telemetry);
+  eth_loopback_get_stats(&bridge);
+  udp_get_stats(&udp);
+  CHECK_((0U == telemetry.log_dropped) && (0U == telemetry.trace_dropped));
+  CHECK_(test_.log_rx_len == telemetry.log_bytes);
+  CHECK_(NULL != memmem(test_.log_rx, test_.log_rx_len, test_.sent, test_.sent_len));
+  CHECK_(NULL != memmem(test_.log_rx, test_.log_rx_len, "Link up", 7U));
+  CHECK_((RECORDS_ == test_.records) && (0U == test_.wrong));
+  CHECK_((test_.datagrams == telemetry.datagrams) && (test_.datagrams == bridge.forwarded));
+  CHECK_(0U == bridge.bad_checksum);
+  CHECK_((1U <= bridge.arp_replies) && (1U <= udp.tx_arp) && (1U <= udp.tx_unresolved));
+
+  // without the offload the checksums are left at zero: refused
+  TxConfig.Attributes &= ~ETH_TX_PACKETS_FEATURES_CSUM;
+  telemetry_log("unchecked\n", 10U);
+  wait_(100U);
+  eth_loopback_get_stats(&bridge);
+  CHECK_((1U == bridge.bad_checksum) && (test_.datagrams == bridge.forwarded));
+
+  vTaskEndScheduler();
+}
+
+/********************** external functions definition ************************/
+
+int main(void)
+{
+  BaseType_t status;
+  uint16_t log_port = 0U;
+  uint16_t trace_port = 0U;
+
+  test_.log = open_socket_(&log_port);
+  test_.trace = open_socket_(&trace_port);
+  if ((0 > test_.log) || (0 > test_.trace))
+  {
+    fprintf(stderr, "no loopback socket\n");
+    return EXIT_FAILURE;
+  }
+
+  MX_ETH_Init();
+  eth_pcap_set_link(true);
+  CHECK_(eth_pcap_record(TX_CAPTURE_));
+  eth_frame_init();
+  udp_init();
+  CHECK_(eth_loopback_init(PEER_));
+  CHECK_(eth_loopback_map(TELEMETRY_CONFIG_LOG_PORT, log_port));
+  CHECK_(eth_loopback_map(TELEMETRY_CONFIG_TRACE_PORT, trace_port));
+  telemetry_set_peer(PEER_);
+  telemetry_init();
+
+  status = xTaskCreate(task_test_, "task_test", TASK_TEST_STACK_, NULL, TASK_TEST_PRIORITY_, NULL);
+  configASSERT(pdPASS == status);
+  vTaskStartScheduler();
+
+  (void)eth_pcap_record(NULL);
+  close(test_.log);
+  close(test_.trace);
+  if (0U != failed_)
+  {
+    fprintf(stderr, "%u checks failed\n", failed_);
+    return EXIT_FAILURE;
+  }
+  printf("telemetry: %lu datagrams, log and trace whole, checksums valid\n",
+         (unsigned long)test_.datagrams);
+  return EXIT_SUCCESS;
+}
+
+/********************** end of file ******************************************/